@@ -884,6 +884,46 @@ void JUCE_CALLTYPE FloatVectorOperations::convertFixedToFloat (float* dest, cons
    #endif
 }
 
+void JUCE_CALLTYPE FloatVectorOperations::convert (float* dest, const double* src, int num) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    for (auto numVectors = num / 4; --numVectors >= 0;)
+    {
+        auto lo = _mm_cvtpd_ps (_mm_loadu_pd (src));
+        auto hi = _mm_cvtpd_ps (_mm_loadu_pd (src + 2));
+        _mm_storeu_ps (dest, _mm_movelh_ps (lo, hi));
+
+        src += 4;
+        dest += 4;
+    }
+
+    num &= 3;
+   #endif
+
+    for (int i = 0; i < num; ++i)
+        dest[i] = (float) src[i];
+}
+
+void JUCE_CALLTYPE FloatVectorOperations::convert (double* dest, const float* src, int num) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    for (auto numVectors = num / 4; --numVectors >= 0;)
+    {
+        auto s = _mm_loadu_ps (src);
+        _mm_storeu_pd (dest,     _mm_cvtps_pd (s));
+        _mm_storeu_pd (dest + 2, _mm_cvtps_pd (_mm_movehl_ps (s, s)));
+
+        src += 4;
+        dest += 4;
+    }
+
+    num &= 3;
+   #endif
+
+    for (int i = 0; i < num; ++i)
+        dest[i] = (double) src[i];
+}
+
 void JUCE_CALLTYPE FloatVectorOperations::min (float* dest, const float* src, float comp, int num) noexcept
 {
     JUCE_PERFORM_VEC_OP_SRC_DEST (dest[i] = jmin (src[i], comp), Mode::min (s, cmp),
@@ -1229,6 +1269,9 @@ public:
             fillRandomly (random, int1, num);
             doConversionTest (u, data1, data2, int1, num);
 
+            fillRandomly (random, data1, num);
+            doPrecisionConversionTest (u, data1, data2, num);
+
             FloatVectorOperations::fill (data1, (ValueType) 2, num);
             FloatVectorOperations::fill (data2, (ValueType) 3, num);
             FloatVectorOperations::addWithMultiply (data1, data1, data2, num);
@@ -1244,6 +1287,23 @@ public:
 
         static void doConversionTest (UnitTest&, double*, double*, int*, int) {}
 
+        static void doPrecisionConversionTest (UnitTest& u, float* data1, float* data2, int num)
+        {
+            HeapBlock<double> doubles (num);
+            FloatVectorOperations::convert (doubles.get(), data1, num);
+            FloatVectorOperations::convert (data2, doubles.get(), num);
+            u.expect (buffersMatch (data1, data2, num));
+        }
+
+        static void doPrecisionConversionTest (UnitTest& u, double* data1, double*, int num)
+        {
+            HeapBlock<float> floats (num);
+            FloatVectorOperations::convert (floats.get(), data1, num);
+
+            for (int i = 0; i < num; ++i)
+                u.expect (floats[i] == (float) data1[i]);
+        }
+
         static void fillRandomly (Random& random, ValueType* d, int num)
         {
             while (--num >= 0)
@@ -71,12 +71,10 @@ namespace MidiBufferHelpers
         return 0;
     }
 
-    static uint8* findEventAfter (uint8* d, uint8* endData, int samplePosition) noexcept
+    inline int getMaxNumEvents (size_t numBytes) noexcept
     {
-        while (d < endData && getEventTime (d) <= samplePosition)
-            d += getEventTotalSize (d);
-
-        return d;
+        // the smallest possible event holds a single byte of midi data
+        return (int) (numBytes / (sizeof (int32) + sizeof (uint16) + 1));
     }
 }
 
@@ -107,19 +105,239 @@ MidiBuffer::MidiBuffer (const MidiMessage& message) noexcept
     addEvent (message, 0);
 }
 
-void MidiBuffer::swapWith (MidiBuffer& other) noexcept      { data.swapWith (other.data); }
-void MidiBuffer::clear() noexcept                           { data.clearQuick(); }
-void MidiBuffer::ensureSize (size_t minimumNumBytes)        { data.ensureStorageAllocated ((int) minimumNumBytes); }
+MidiBuffer::MidiBuffer (const MidiBuffer& other)
+    : data (other.data),
+      eventOffsets (other.eventOffsets),
+      fixedCapacity (other.fixedCapacity),
+      overflowPolicy (other.overflowPolicy),
+      statistics (other.statistics)
+{
+    if (fixedCapacity > 0)
+        setStorageCapacity (fixedCapacity);
+}
+
+MidiBuffer& MidiBuffer::operator= (const MidiBuffer& other)
+{
+    if (this != &other)
+    {
+        fixedCapacity  = other.fixedCapacity;
+        overflowPolicy = other.overflowPolicy;
+        statistics     = other.statistics;
+
+        if (fixedCapacity > 0)
+            setStorageCapacity (jmax (fixedCapacity, (size_t) other.data.size()));
+
+        data.clearQuick();
+        data.addArray (other.data.begin(), other.data.size());
+        eventOffsets.clearQuick();
+        eventOffsets.addArray (other.eventOffsets.begin(), other.eventOffsets.size());
+    }
+
+    return *this;
+}
+
+MidiBuffer::MidiBuffer (MidiBuffer&&) noexcept = default;
+MidiBuffer& MidiBuffer::operator= (MidiBuffer&&) noexcept = default;
+
 bool MidiBuffer::isEmpty() const noexcept                   { return data.size() == 0; }
 
+void MidiBuffer::clear() noexcept
+{
+    data.clearQuick();
+    eventOffsets.clearQuick();
+}
+
+void MidiBuffer::swapWith (MidiBuffer& other) noexcept
+{
+    data.swapWith (other.data);
+    spareData.swapWith (other.spareData);
+    eventOffsets.swapWith (other.eventOffsets);
+    spareEventOffsets.swapWith (other.spareEventOffsets);
+    std::swap (fixedCapacity, other.fixedCapacity);
+    std::swap (overflowPolicy, other.overflowPolicy);
+    std::swap (statistics, other.statistics);
+}
+
+void MidiBuffer::ensureSize (size_t minimumNumBytes)
+{
+    if (fixedCapacity > 0)
+    {
+        fixedCapacity = jmax (fixedCapacity, minimumNumBytes);
+        setStorageCapacity (fixedCapacity);
+    }
+    else
+    {
+        data.ensureStorageAllocated ((int) minimumNumBytes);
+        eventOffsets.ensureStorageAllocated (MidiBufferHelpers::getMaxNumEvents (minimumNumBytes));
+    }
+}
+
 void MidiBuffer::clear (int startSample, int numSamples)
 {
-    auto start = MidiBufferHelpers::findEventAfter (data.begin(), data.end(), startSample - 1);
-    auto end   = MidiBufferHelpers::findEventAfter (start,        data.end(), startSample + numSamples - 1);
+    ensureIndexMatchesData();
+
+    auto startIndex = getIndexOfFirstEventAtOrAfter (startSample);
+    auto endIndex   = getIndexOfFirstEventAtOrAfter (startSample + numSamples);
+
+    if (endIndex <= startIndex)
+        return;
+
+    auto start = getOffsetOfEvent (startIndex);
+    auto end   = getOffsetOfEvent (endIndex);
+    auto numBytesRemoved = end - start;
+
+    if (fixedCapacity > 0)
+    {
+        // Array::removeRange may shrink the allocation, so the remaining events are
+        // gathered into the spare storage instead, which is then swapped in
+        spareData.clearQuick();
+        spareData.addArray (data.begin(), start);
+        spareData.addArray (data.begin() + end, data.size() - end);
+        data.swapWith (spareData);
+
+        spareEventOffsets.clearQuick();
+        spareEventOffsets.addArray (eventOffsets.begin(), startIndex);
+
+        for (int i = endIndex; i < eventOffsets.size(); ++i)
+            spareEventOffsets.add (eventOffsets.getUnchecked (i) - numBytesRemoved);
+
+        eventOffsets.swapWith (spareEventOffsets);
+        return;
+    }
+
+    data.removeRange (start, numBytesRemoved);
+
+    for (int i = endIndex; i < eventOffsets.size(); ++i)
+        eventOffsets.getReference (i) -= numBytesRemoved;
+
+    eventOffsets.removeRange (startIndex, endIndex - startIndex);
+}
+
+//==============================================================================
+void MidiBuffer::setFixedCapacity (size_t numBytes, OverflowPolicy policy)
+{
+    // The events that are already in the buffer won't fit into this capacity!
+    jassert (numBytes == 0 || numBytes >= (size_t) data.size());
 
-    data.removeRange ((int) (start - data.begin()), (int) (end - data.begin()));
+    fixedCapacity = numBytes > 0 ? jmax (numBytes, (size_t) data.size()) : 0;
+    overflowPolicy = policy;
+    statistics = {};
+
+    if (fixedCapacity > 0)
+    {
+        setStorageCapacity (fixedCapacity);
+        updatePeakUsage();
+    }
+    else
+    {
+        spareData.clear();
+        spareEventOffsets.clear();
+    }
 }
 
+void MidiBuffer::setStorageCapacity (size_t numBytes)
+{
+    auto maxNumEvents = MidiBufferHelpers::getMaxNumEvents (numBytes);
+
+    data.ensureStorageAllocated ((int) numBytes);
+    spareData.ensureStorageAllocated ((int) numBytes);
+    eventOffsets.ensureStorageAllocated (maxNumEvents);
+    spareEventOffsets.ensureStorageAllocated (maxNumEvents);
+}
+
+void MidiBuffer::updatePeakUsage() noexcept
+{
+    statistics.peakNumBytesUsed = jmax (statistics.peakNumBytesUsed, (size_t) data.size());
+}
+
+bool MidiBuffer::makeRoomForNewBytes (size_t numBytesToAdd)
+{
+    if (fixedCapacity == 0)
+        return true;
+
+    auto numBytesNeeded = (size_t) data.size() + numBytesToAdd;
+
+    if (numBytesNeeded > fixedCapacity)
+    {
+        if (overflowPolicy == OverflowPolicy::discardNewEvents)
+        {
+            ++statistics.numEventsDiscarded;
+            return false;
+        }
+
+        ++statistics.numReallocations;
+        fixedCapacity = jmax (numBytesNeeded, fixedCapacity * 2);
+        setStorageCapacity (fixedCapacity);
+    }
+
+    ++statistics.numEventsAdded;
+    statistics.peakNumBytesUsed = jmax (statistics.peakNumBytesUsed, numBytesNeeded);
+    return true;
+}
+
+//==============================================================================
+bool MidiBuffer::indexMatchesData() const noexcept
+{
+    if (eventOffsets.isEmpty())
+        return data.isEmpty();
+
+    auto lastOffset = eventOffsets.getLast();
+
+    return lastOffset >= 0
+        && lastOffset + (int) getNumHeaderBytesPerEvent() <= data.size()
+        && lastOffset + MidiBufferHelpers::getEventTotalSize (data.begin() + lastOffset) == data.size();
+}
+
+void MidiBuffer::ensureIndexMatchesData()
+{
+    // If this fails, something has modified the data array directly, so the index
+    // needs to be rebuilt
+    if (indexMatchesData())
+        return;
+
+    eventOffsets.clearQuick();
+
+    for (auto d = data.begin(); d < data.end(); d += MidiBufferHelpers::getEventTotalSize (d))
+        eventOffsets.add ((int) (d - data.begin()));
+}
+
+int MidiBuffer::getOffsetOfEvent (int index) const noexcept
+{
+    return index < eventOffsets.size() ? eventOffsets.getUnchecked (index) : data.size();
+}
+
+int MidiBuffer::getIndexOfFirstEventAtOrAfter (int samplePosition) const noexcept
+{
+    auto* d = data.begin();
+
+    return (int) (std::lower_bound (eventOffsets.begin(), eventOffsets.end(), samplePosition,
+                                    [d] (int offset, int time) { return MidiBufferHelpers::getEventTime (d + offset) < time; })
+                    - eventOffsets.begin());
+}
+
+int MidiBuffer::getIndexOfFirstEventAfter (int samplePosition) const noexcept
+{
+    auto* d = data.begin();
+
+    return (int) (std::upper_bound (eventOffsets.begin(), eventOffsets.end(), samplePosition,
+                                    [d] (int time, int offset) { return time < MidiBufferHelpers::getEventTime (d + offset); })
+                    - eventOffsets.begin());
+}
+
+int MidiBuffer::findOffsetOfFirstEventAtOrAfter (int samplePosition) const noexcept
+{
+    if (indexMatchesData())
+        return getOffsetOfEvent (getIndexOfFirstEventAtOrAfter (samplePosition));
+
+    auto d = data.begin();
+
+    while (d < data.end() && MidiBufferHelpers::getEventTime (d) < samplePosition)
+        d += MidiBufferHelpers::getEventTotalSize (d);
+
+    return (int) (d - data.begin());
+}
+
+//==============================================================================
 void MidiBuffer::addEvent (const MidiMessage& m, int sampleNumber)
 {
     addEvent (m.getRawData(), m.getRawDataSize(), sampleNumber);
@@ -131,10 +349,21 @@ void MidiBuffer::addEvent (const void* newData, int maxBytes, int sampleNumber)
 
     if (numBytes > 0)
     {
-        auto newItemSize = (size_t) numBytes + sizeof (int32) + sizeof (uint16);
-        auto offset = (int) (MidiBufferHelpers::findEventAfter (data.begin(), data.end(), sampleNumber) - data.begin());
+        auto newItemSize = (int) ((size_t) numBytes + getNumHeaderBytesPerEvent());
 
-        data.insertMultiple (offset, 0, (int) newItemSize);
+        if (! makeRoomForNewBytes ((size_t) newItemSize))
+            return;
+
+        ensureIndexMatchesData();
+
+        auto index = getIndexOfFirstEventAfter (sampleNumber);
+        auto offset = getOffsetOfEvent (index);
+
+        data.insertMultiple (offset, 0, newItemSize);
+        eventOffsets.insert (index, offset);
+
+        for (int i = index + 1; i < eventOffsets.size(); ++i)
+            eventOffsets.getReference (i) += newItemSize;
 
         auto* d = data.begin() + offset;
         writeUnaligned<int32>  (d, sampleNumber);
@@ -148,19 +377,184 @@ void MidiBuffer::addEvent (const void* newData, int maxBytes, int sampleNumber)
 void MidiBuffer::addEvents (const MidiBuffer& otherBuffer,
                             int startSample, int numSamples, int sampleDeltaToAdd)
 {
-    for (auto i = otherBuffer.findNextSamplePosition (startSample); i != otherBuffer.cend(); ++i)
+    const EventRange range { &otherBuffer, startSample, numSamples, sampleDeltaToAdd };
+    mergeEventsFrom (&range, 1);
+}
+
+void MidiBuffer::mergeEventsFrom (const MidiBuffer* const* otherBuffers, int numOtherBuffers)
+{
+    constexpr int rangesPerCall = 16;
+    EventRange ranges[rangesPerCall];
+
+    for (int firstBuffer = 0; firstBuffer < numOtherBuffers; firstBuffer += rangesPerCall)
     {
-        const auto metadata = *i;
+        auto numRanges = jmin (rangesPerCall, numOtherBuffers - firstBuffer);
 
-        if (metadata.samplePosition >= startSample + numSamples && numSamples >= 0)
-            break;
+        for (int i = 0; i < numRanges; ++i)
+            ranges[i].buffer = otherBuffers[firstBuffer + i];
 
-        addEvent (metadata.data, metadata.numBytes, metadata.samplePosition + sampleDeltaToAdd);
+        mergeEventsFrom (ranges, numRanges);
+    }
+}
+
+void MidiBuffer::mergeEventsFrom (const EventRange* ranges, int numRanges)
+{
+    // Each step of the merge picks the earliest event from a small set of sources,
+    // so a very large number of ranges gets merged over several passes
+    constexpr int maxSourcesPerPass = 16;
+
+    struct Source
+    {
+        const MidiBuffer* buffer;
+        int start, end, sampleDeltaToAdd;
+    };
+
+    for (int firstRange = 0; firstRange < numRanges; firstRange += maxSourcesPerPass - 1)
+    {
+        ensureIndexMatchesData();
+
+        Source sources[maxSourcesPerPass] = { { this, 0, data.size(), 0 } };
+        int numSources = 1;
+        auto totalNumBytes = (size_t) data.size();
+
+        for (int i = firstRange; i < jmin (numRanges, firstRange + maxSourcesPerPass - 1); ++i)
+        {
+            auto& range = ranges[i];
+            jassert (range.buffer != nullptr);
+
+            auto start = range.buffer->findOffsetOfFirstEventAtOrAfter (range.startSample);
+            auto end = range.numSamples < 0 ? range.buffer->data.size()
+                                            : jmax (start, range.buffer->findOffsetOfFirstEventAtOrAfter (range.startSample + range.numSamples));
+
+            if (end > start)
+            {
+                sources[numSources++] = { range.buffer, start, end, range.sampleDeltaToAdd };
+                totalNumBytes += (size_t) (end - start);
+            }
+        }
+
+        if (numSources == 1)
+            continue;
+
+        if (fixedCapacity > 0 && totalNumBytes > fixedCapacity && overflowPolicy == OverflowPolicy::growStorage)
+        {
+            ++statistics.numReallocations;
+            fixedCapacity = jmax (totalNumBytes, fixedCapacity * 2);
+            setStorageCapacity (fixedCapacity);
+        }
+
+        auto byteLimit = fixedCapacity > 0 ? fixedCapacity : totalNumBytes;
+
+        // When a single range starts after the last event already in the buffer, its events
+        // can just be appended, which is what happens when a buffer is split into sub-blocks
+        if (numSources == 2 && sources[1].buffer != this && totalNumBytes <= byteLimit)
+        {
+            auto& source = sources[1];
+            auto* src = source.buffer->data.begin();
+
+            if (isEmpty() || getLastEventTime() <= MidiBufferHelpers::getEventTime (src + source.start) + source.sampleDeltaToAdd)
+            {
+                auto firstNewOffset = data.size();
+                data.addArray (src + source.start, source.end - source.start);
+
+                for (auto offset = firstNewOffset; offset < data.size();)
+                {
+                    auto* d = data.begin() + offset;
+
+                    if (source.sampleDeltaToAdd != 0)
+                        writeUnaligned<int32> (d, MidiBufferHelpers::getEventTime (d) + source.sampleDeltaToAdd);
+
+                    eventOffsets.add (offset);
+                    offset += MidiBufferHelpers::getEventTotalSize (d);
+
+                    if (fixedCapacity > 0)
+                        ++statistics.numEventsAdded;
+                }
+
+                if (fixedCapacity > 0)
+                    updatePeakUsage();
+
+                continue;
+            }
+        }
+
+        const uint8* positions[maxSourcesPerPass];
+        const uint8* ends[maxSourcesPerPass];
+
+        for (int i = 0; i < numSources; ++i)
+        {
+            positions[i] = sources[i].buffer->data.begin() + sources[i].start;
+            ends[i]      = sources[i].buffer->data.begin() + sources[i].end;
+        }
+
+        // The events that are already in this buffer are always kept, so the space
+        // they need is reserved before any of the new events are allowed in
+        auto numBytesReserved = (size_t) data.size();
+
+        spareData.clearQuick();
+        spareData.ensureStorageAllocated ((int) jmin (totalNumBytes, byteLimit));
+        spareEventOffsets.clearQuick();
+
+        for (;;)
+        {
+            int next = -1;
+            int nextTime = 0;
+
+            for (int i = 0; i < numSources; ++i)
+            {
+                if (positions[i] < ends[i])
+                {
+                    auto time = MidiBufferHelpers::getEventTime (positions[i]) + sources[i].sampleDeltaToAdd;
+
+                    if (next < 0 || time < nextTime)
+                    {
+                        next = i;
+                        nextTime = time;
+                    }
+                }
+            }
+
+            if (next < 0)
+                break;
+
+            auto eventSize = MidiBufferHelpers::getEventTotalSize (positions[next]);
+
+            if (next == 0)
+                numBytesReserved -= eventSize;
+
+            if (next == 0 || (size_t) spareData.size() + numBytesReserved + eventSize <= byteLimit)
+            {
+                auto offset = spareData.size();
+                spareData.addArray (positions[next], (int) eventSize);
+                spareEventOffsets.add (offset);
+
+                if (sources[next].sampleDeltaToAdd != 0)
+                    writeUnaligned<int32> (spareData.begin() + offset, nextTime);
+
+                if (next != 0 && fixedCapacity > 0)
+                    ++statistics.numEventsAdded;
+            }
+            else
+            {
+                ++statistics.numEventsDiscarded;
+            }
+
+            positions[next] += eventSize;
+        }
+
+        data.swapWith (spareData);
+        eventOffsets.swapWith (spareEventOffsets);
+
+        if (fixedCapacity > 0)
+            updatePeakUsage();
     }
 }
 
 int MidiBuffer::getNumEvents() const noexcept
 {
+    if (indexMatchesData())
+        return eventOffsets.size();
+
     int n = 0;
     auto end = data.end();
 
@@ -180,6 +574,9 @@ int MidiBuffer::getLastEventTime() const noexcept
     if (data.size() == 0)
         return 0;
 
+    if (indexMatchesData())
+        return MidiBufferHelpers::getEventTime (data.begin() + eventOffsets.getLast());
+
     auto endData = data.end();
 
     for (auto d = data.begin();;)
@@ -195,10 +592,7 @@ int MidiBuffer::getLastEventTime() const noexcept
 
 MidiBufferIterator MidiBuffer::findNextSamplePosition (int samplePosition) const noexcept
 {
-    return std::find_if (cbegin(), cend(), [&] (const MidiMessageMetadata& metadata) noexcept
-    {
-        return metadata.samplePosition >= samplePosition;
-    });
+    return MidiBufferIterator (data.begin() + findOffsetOfFirstEventAtOrAfter (samplePosition));
 }
 
 //==============================================================================
@@ -237,4 +631,143 @@ bool MidiBuffer::Iterator::getNextEvent (MidiMessage& result, int& samplePositio
     return true;
 }
 
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class MidiBufferTest  : public UnitTest
+{
+public:
+    MidiBufferTest()
+        : UnitTest ("MidiBuffer", UnitTestCategories::midi)
+    {}
+
+    void runTest() override
+    {
+        beginTest ("Merging buffers gives the same result as adding them in turn");
+        {
+            Random r (getRandom());
+            MidiBuffer sources[5];
+
+            for (auto& b : sources)
+                for (int i = r.nextInt (20); --i >= 0;)
+                    b.addEvent (MidiMessage::noteOn (1 + r.nextInt (16), r.nextInt (128), (uint8) 100), r.nextInt (64));
+
+            MidiBuffer expected (sources[0]), merged (sources[0]);
+
+            for (int i = 1; i < 5; ++i)
+                expected.addEvents (sources[i], 0, -1, 0);
+
+            const MidiBuffer* others[] = { sources + 1, sources + 2, sources + 3, sources + 4 };
+            merged.mergeEventsFrom (others, 4);
+
+            expect (merged.data == expected.data);
+        }
+
+        beginTest ("Indexed lookups and ranged merges match linear scans");
+        {
+            Random r (getRandom());
+            MidiBuffer source, other;
+
+            for (int i = 0; i < 200; ++i)
+            {
+                source.addEvent (MidiMessage::controllerEvent (1, r.nextInt (128), r.nextInt (128)), r.nextInt (512));
+                other .addEvent (MidiMessage::controllerEvent (2, r.nextInt (128), r.nextInt (128)), r.nextInt (512));
+            }
+
+            for (int i = 0; i < 50; ++i)
+            {
+                auto position = r.nextInt (530) - 10;
+                auto expected = std::find_if (source.cbegin(), source.cend(),
+                                              [&] (const MidiMessageMetadata& m) { return m.samplePosition >= position; });
+
+                expect (source.findNextSamplePosition (position) == expected);
+            }
+
+            for (int i = 0; i < 20; ++i)
+            {
+                auto start = r.nextInt (512), num = r.nextInt (128), delta = r.nextInt (64) - 32;
+
+                MidiBuffer merged (source), expected (source);
+                merged.addEvents (other, start, num, delta);
+
+                for (const auto metadata : other)
+                    if (metadata.samplePosition >= start && metadata.samplePosition < start + num)
+                        expected.addEvent (metadata.data, metadata.numBytes, metadata.samplePosition + delta);
+
+                expect (merged.data == expected.data);
+                expectEquals (merged.getNumEvents(), (int) std::distance (merged.begin(), merged.end()));
+
+                merged.clear (start, num);
+
+                for (const auto metadata : merged)
+                    expect (metadata.samplePosition < start || metadata.samplePosition >= start + num);
+            }
+
+            MidiBuffer chunk;
+
+            for (int start = 0; start < 512; start += 100)
+            {
+                chunk.clear();
+                chunk.addEvents (source, start, 100, -start);
+
+                int numExpected = 0;
+
+                for (const auto metadata : source)
+                    if (metadata.samplePosition >= start && metadata.samplePosition < start + 100)
+                        ++numExpected;
+
+                expectEquals (chunk.getNumEvents(), numExpected);
+                expect (chunk.isEmpty() || (chunk.getFirstEventTime() >= 0 && chunk.getLastEventTime() < 100));
+            }
+        }
+
+        beginTest ("A buffer with a fixed capacity discards events that don't fit");
+        {
+            const auto eventSize = MidiBuffer::getNumHeaderBytesPerEvent() + 3;
+
+            MidiBuffer buffer;
+            buffer.setFixedCapacity (eventSize * 4);
+
+            for (int i = 0; i < 6; ++i)
+                buffer.addEvent (MidiMessage::noteOn (1, 60 + i, (uint8) 100), i);
+
+            expectEquals (buffer.getNumEvents(), 4);
+            expectEquals (buffer.getLastEventTime(), 3);
+            expectEquals (buffer.getFixedCapacityStatistics().numEventsAdded, 4);
+            expectEquals (buffer.getFixedCapacityStatistics().numEventsDiscarded, 2);
+            expectEquals ((int) buffer.getFixedCapacityStatistics().peakNumBytesUsed, (int) eventSize * 4);
+
+            MidiBuffer other (MidiMessage::noteOff (1, 60));
+            const MidiBuffer* others[] = { &other };
+            buffer.mergeEventsFrom (others, 1);
+
+            expectEquals (buffer.getNumEvents(), 4);
+            expectEquals (buffer.getFixedCapacityStatistics().numEventsDiscarded, 3);
+
+            buffer.clear (1, 2);
+            expectEquals (buffer.getNumEvents(), 2);
+            expectEquals (buffer.getLastEventTime(), 3);
+        }
+
+        beginTest ("A buffer with a fixed capacity can be allowed to grow");
+        {
+            MidiBuffer buffer;
+            buffer.setFixedCapacity (MidiBuffer::getNumHeaderBytesPerEvent() + 3, MidiBuffer::OverflowPolicy::growStorage);
+
+            for (int i = 0; i < 3; ++i)
+                buffer.addEvent (MidiMessage::noteOn (1, 60 + i, (uint8) 100), i);
+
+            expectEquals (buffer.getNumEvents(), 3);
+            expectEquals (buffer.getFixedCapacityStatistics().numEventsDiscarded, 0);
+            expectEquals (buffer.getFixedCapacityStatistics().numReallocations, 2);
+            expect (buffer.getFixedCapacity() >= (size_t) buffer.data.size());
+        }
+    }
+};
+
+static MidiBufferTest midiBufferTest;
+
+#endif
+
 } // namespace juce
@@ -151,6 +151,20 @@ public:
     /** Creates a MidiBuffer containing a single midi message. */
     explicit MidiBuffer (const MidiMessage& message) noexcept;
 
+    /** Creates a copy of another buffer.
+        If the other buffer has a fixed capacity, the copy will preallocate the same capacity.
+    */
+    MidiBuffer (const MidiBuffer&);
+
+    /** Replaces the contents of this buffer with a copy of another one.
+        This re-uses the existing storage where possible, so copying into a buffer which
+        has already been given enough space won't allocate any memory.
+    */
+    MidiBuffer& operator= (const MidiBuffer&);
+
+    MidiBuffer (MidiBuffer&&) noexcept;
+    MidiBuffer& operator= (MidiBuffer&&) noexcept;
+
     //==============================================================================
     /** Removes all events from the buffer. */
     void clear() noexcept;
@@ -169,9 +183,8 @@ public:
 
     /** Counts the number of events in the buffer.
 
-        This is actually quite a slow operation, as it has to iterate through all
-        the events, so you might prefer to call isEmpty() if that's all you need
-        to know.
+        The buffer keeps an index of its events, so this is a quick operation
+        unless the raw data has been modified directly.
     */
     int getNumEvents() const noexcept;
 
@@ -221,12 +234,51 @@ public:
                                     startSample will be taken.
         @param sampleDeltaToAdd     a value which will be added to the source timestamps of the events
                                     that are added to this buffer
+
+        The range of source events is found with a binary search, and the events are merged
+        into this buffer in a single pass. When they all come after this buffer's last event
+        (for example, when splitting a buffer into sub-blocks), they're simply appended.
     */
     void addEvents (const MidiBuffer& otherBuffer,
                     int startSample,
                     int numSamples,
                     int sampleDeltaToAdd);
 
+    /** Describes a range of events from another buffer, for use with mergeEventsFrom().
+        The members have the same meanings as the parameters to addEvents().
+    */
+    struct EventRange
+    {
+        const MidiBuffer* buffer = nullptr;     /**< The buffer containing the events. */
+        int startSample = 0;                    /**< Events before this position are ignored. */
+        int numSamples = -1;                    /**< Events at or after startSample + numSamples are ignored,
+                                                     unless this is less than 0. */
+        int sampleDeltaToAdd = 0;               /**< A value to add to the timestamps of the events. */
+    };
+
+    /** Adds all the events from several other buffers in a single pass.
+
+        This gives the same result as calling addEvents (buffer, 0, -1, 0) for each of the
+        buffers in turn - so events with equal timestamps end up in the order of the buffers
+        in the list - but instead of searching for an insertion position for each event, it
+        walks each buffer just once, merging them into this buffer's spare storage.
+
+        If this buffer has a fixed capacity, no memory will be allocated (see setFixedCapacity()).
+
+        @param otherBuffers         an array of pointers to the buffers to merge into this one
+        @param numOtherBuffers      the number of pointers in the otherBuffers array
+    */
+    void mergeEventsFrom (const MidiBuffer* const* otherBuffers, int numOtherBuffers);
+
+    /** Adds ranges of events from several other buffers in a single k-way merge.
+
+        This gives the same result as calling addEvents() for each of the ranges in turn,
+        but each source range is located with a binary search and walked just once.
+
+        @see EventRange
+    */
+    void mergeEventsFrom (const EventRange* ranges, int numRanges);
+
     /** Returns the sample number of the first event in the buffer.
         If the buffer's empty, this will just return 0.
     */
@@ -248,9 +300,73 @@ public:
     /** Preallocates some memory for the buffer to use.
         This helps to avoid needing to reallocate space when the buffer has messages
         added to it.
+
+        If the buffer has a fixed capacity that's smaller than this, the capacity
+        will be increased to match.
     */
     void ensureSize (size_t minimumNumBytes);
 
+    //==============================================================================
+    /** Describes what happens when an event is added to a buffer that has a fixed
+        capacity, but there's not enough room left for it.
+
+        @see setFixedCapacity
+    */
+    enum class OverflowPolicy
+    {
+        discardNewEvents,   /**< Events that don't fit are dropped, and counted in the statistics. */
+        growStorage         /**< The storage is reallocated to make room, and the reallocation
+                                 is counted in the statistics. This isn't real-time safe, but
+                                 means that no events can be lost. */
+    };
+
+    /** Some counters that are updated while a buffer has a fixed capacity.
+        @see getFixedCapacityStatistics
+    */
+    struct FixedCapacityStatistics
+    {
+        int numEventsAdded = 0;         /**< The number of events successfully added. */
+        int numEventsDiscarded = 0;     /**< The number of events dropped because the buffer was full. */
+        int numReallocations = 0;       /**< The number of times the storage had to be grown. */
+        size_t peakNumBytesUsed = 0;    /**< The largest number of bytes that the events have occupied. */
+    };
+
+    /** Puts the buffer into a real-time mode where all of its storage is preallocated.
+
+        Once this has been called, adding, merging, copying or clearing events won't allocate
+        any memory as long as the events fit into the given number of bytes. What happens if
+        they don't fit is determined by the overflow policy.
+
+        Each event takes up its MIDI data size plus getNumHeaderBytesPerEvent() bytes.
+
+        Call this from a non-realtime thread (e.g. in prepareToPlay), as it allocates the
+        storage. Passing a capacity of 0 returns the buffer to its normal behaviour, where the
+        storage grows on demand.
+
+        @see getFixedCapacity, getFixedCapacityStatistics
+    */
+    void setFixedCapacity (size_t numBytes, OverflowPolicy policy = OverflowPolicy::discardNewEvents);
+
+    /** Returns the number of bytes that the buffer was given by setFixedCapacity(), or 0
+        if it doesn't have a fixed capacity.
+    */
+    size_t getFixedCapacity() const noexcept                        { return fixedCapacity; }
+
+    /** Returns the policy that's used when a buffer with a fixed capacity fills up. */
+    OverflowPolicy getOverflowPolicy() const noexcept               { return overflowPolicy; }
+
+    /** Returns the counters that have been gathered since the buffer was given a fixed
+        capacity, or since resetFixedCapacityStatistics() was last called.
+    */
+    const FixedCapacityStatistics& getFixedCapacityStatistics() const noexcept   { return statistics; }
+
+    /** Resets the counters returned by getFixedCapacityStatistics(). */
+    void resetFixedCapacityStatistics() noexcept                    { statistics = {}; }
+
+    /** Returns the number of bytes of storage that each event needs in addition to its MIDI data. */
+    static constexpr size_t getNumHeaderBytesPerEvent() noexcept    { return sizeof (int32) + sizeof (uint16); }
+
+    //==============================================================================
     /** Get a read-only iterator pointing to the beginning of this buffer. */
     MidiBufferIterator begin()  const noexcept { return cbegin(); }
 
@@ -265,6 +381,9 @@ public:
 
     /** Get an iterator pointing to the first event with a timestamp greater-than or
         equal-to `samplePosition`.
+
+        This uses a binary search of the buffer's event index, so it can be used to split
+        the buffer into sub-blocks without having to scan it from the start each time.
     */
     MidiBufferIterator findNextSamplePosition (int samplePosition) const noexcept;
 
@@ -336,10 +455,32 @@ public:
     /** The raw data holding this buffer.
         Obviously access to this data is provided at your own risk. Its internal format could
         change in future, so don't write code that relies on it!
+
+        If the data is modified directly, the buffer's event index is rebuilt the next
+        time that events are added or removed, and lookups fall back to linear scans
+        until then.
     */
     Array<uint8> data;
 
 private:
+    //==============================================================================
+    Array<uint8> spareData;
+    Array<int> eventOffsets, spareEventOffsets;
+    size_t fixedCapacity = 0;
+    OverflowPolicy overflowPolicy = OverflowPolicy::discardNewEvents;
+    FixedCapacityStatistics statistics;
+
+    bool makeRoomForNewBytes (size_t numBytesToAdd);
+    void setStorageCapacity (size_t numBytes);
+    void updatePeakUsage() noexcept;
+
+    bool indexMatchesData() const noexcept;
+    void ensureIndexMatchesData();
+    int getOffsetOfEvent (int index) const noexcept;
+    int getIndexOfFirstEventAtOrAfter (int samplePosition) const noexcept;
+    int getIndexOfFirstEventAfter (int samplePosition) const noexcept;
+    int findOffsetOfFirstEventAtOrAfter (int samplePosition) const noexcept;
+
     JUCE_LEAK_DETECTOR (MidiBuffer)
 };
 
@@ -27,8 +27,35 @@ namespace
 {
     const uint8 noLSBValueReceived = 0xff;
     const Range<int> allChannels { 1, 17 };
+
+    /** Takes an instrument's lock, unless the instrument has had locking disabled. */
+    struct ScopedInstrumentLock
+    {
+        ScopedInstrumentLock (const CriticalSection& l, bool shouldLock) noexcept
+            : lockToUse (shouldLock ? &l : nullptr)
+        {
+            if (lockToUse != nullptr)
+                lockToUse->enter();
+        }
+
+        ~ScopedInstrumentLock() noexcept
+        {
+            if (lockToUse != nullptr)
+                lockToUse->exit();
+        }
+
+        const CriticalSection* lockToUse;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedInstrumentLock)
+    };
 }
 
+//==============================================================================
+struct MPEInstrument::ListenerArray
+{
+    Array<Listener*> listeners;
+};
+
 //==============================================================================
 MPEInstrument::MPEInstrument() noexcept
 {
@@ -46,6 +73,11 @@ MPEInstrument::MPEInstrument() noexcept
     legacyMode.isEnabled = false;
     legacyMode.pitchbendRange = 2;
     legacyMode.channelRange = allChannels;
+
+    for (auto& channel : channels)
+        std::fill_n (channel.noteIndex, 128, (int16) -1);
+
+    updateChannelZones();
 }
 
 MPEInstrument::~MPEInstrument()
@@ -62,9 +94,10 @@ void MPEInstrument::setZoneLayout (MPEZoneLayout newLayout)
 {
     releaseAllNotes();
 
-    const ScopedLock sl (lock);
+    const ScopedInstrumentLock sl (lock, lockingEnabled);
     legacyMode.isEnabled = false;
     zoneLayout = newLayout;
+    updateChannelZones();
 }
 
 //==============================================================================
@@ -72,11 +105,12 @@ void MPEInstrument::enableLegacyMode (int pitchbendRange, Range<int> channelRang
 {
     releaseAllNotes();
 
-    const ScopedLock sl (lock);
+    const ScopedInstrumentLock sl (lock, lockingEnabled);
     legacyMode.isEnabled = true;
     legacyMode.pitchbendRange = pitchbendRange;
     legacyMode.channelRange = channelRange;
     zoneLayout.clearAllZones();
+    updateChannelZones();
 }
 
 bool MPEInstrument::isLegacyModeEnabled() const noexcept
@@ -94,8 +128,9 @@ void MPEInstrument::setLegacyModeChannelRange (Range<int> channelRange)
     jassert (allChannels.contains (channelRange));
 
     releaseAllNotes();
-    const ScopedLock sl (lock);
+    const ScopedInstrumentLock sl (lock, lockingEnabled);
     legacyMode.channelRange = channelRange;
+    updateChannelZones();
 }
 
 int MPEInstrument::getLegacyModePitchbendRange() const noexcept
@@ -108,7 +143,7 @@ void MPEInstrument::setLegacyModePitchbendRange (int pitchbendRange)
     jassert (pitchbendRange >= 0 && pitchbendRange <= 96);
 
     releaseAllNotes();
-    const ScopedLock sl (lock);
+    const ScopedInstrumentLock sl (lock, lockingEnabled);
     legacyMode.pitchbendRange = pitchbendRange;
 }
 
@@ -131,18 +166,78 @@ void MPEInstrument::setTimbreTrackingMode (TrackingMode modeToUse)
 //==============================================================================
 void MPEInstrument::addListener (Listener* listenerToAdd)
 {
-    listeners.add (listenerToAdd);
+    // Listeners can't be null pointers!
+    jassert (listenerToAdd != nullptr);
+
+    updateListenerArray (listenerToAdd, true);
 }
 
 void MPEInstrument::removeListener (Listener* listenerToRemove)
 {
-    listeners.remove (listenerToRemove);
+    updateListenerArray (listenerToRemove, false);
+}
+
+void MPEInstrument::updateListenerArray (Listener* listener, bool shouldAdd)
+{
+    auto newArray = std::make_shared<ListenerArray>();
+
+    const ScopedLock sl (listenerLock);
+
+    if (listenerArray != nullptr)
+        newArray->listeners = listenerArray->listeners;
+
+    if (shouldAdd)
+        newArray->listeners.addIfNotAlreadyThere (listener);
+    else
+        newArray->listeners.removeFirstMatchingValue (listener);
+
+    listenerArray = std::move (newArray);
+}
+
+template <typename Callback>
+void MPEInstrument::callListeners (Callback&& callback)
+{
+    // The arrays are never modified once they've been published, so the callbacks can
+    // be made from a copy of the pointer without holding the lock
+    std::shared_ptr<const ListenerArray> array;
+
+    {
+        const ScopedLock sl (listenerLock);
+        array = listenerArray;
+    }
+
+    if (array == nullptr)
+        return;
+
+    for (auto* listener : array->listeners)
+    {
+        // If the listeners were changed by one of the callbacks, make sure that
+        // we don't call any that have since been removed
+        {
+            const ScopedLock sl (listenerLock);
+
+            if (listenerArray != array && (listenerArray == nullptr || ! listenerArray->listeners.contains (listener)))
+                continue;
+        }
+
+        callback (*listener);
+    }
 }
 
 //==============================================================================
 void MPEInstrument::processNextMidiEvent (const MidiMessage& message)
 {
-    zoneLayout.processNextMidiEvent (message);
+    // zone layouts can only be changed by RPN messages
+    if (message.isController())
+    {
+        const auto oldLowerZone = zoneLayout.getLowerZone();
+        const auto oldUpperZone = zoneLayout.getUpperZone();
+
+        zoneLayout.processNextMidiEvent (message);
+
+        if (zoneLayout.getLowerZone() != oldLowerZone || zoneLayout.getUpperZone() != oldUpperZone)
+            updateChannelZones();
+    }
 
     if (message.isNoteOn (true))              processMidiNoteOnMessage (message);
     else if (message.isNoteOff (false))       processMidiNoteOffMessage (message);
@@ -228,8 +323,8 @@ void MPEInstrument::processMidiResetAllControllersMessage (const MidiMessage& me
             {
                 note.keyState = MPENote::off;
                 note.noteOffVelocity = MPEValue::from7BitInt (64); // some reasonable number
-                listeners.call ([&] (Listener& l) { l.noteReleased (note); });
-                notes.remove (i);
+                callListeners ([&] (Listener& l) { l.noteReleased (note); });
+                removeNote (i);
             }
         }
     }
@@ -246,8 +341,8 @@ void MPEInstrument::processMidiResetAllControllersMessage (const MidiMessage& me
             {
                 note.keyState = MPENote::off;
                 note.noteOffVelocity = MPEValue::from7BitInt (64); // some reasonable number
-                listeners.call ([&] (Listener& l) { l.noteReleased (note); });
-                notes.remove (i);
+                callListeners ([&] (Listener& l) { l.noteReleased (note); });
+                removeNote (i);
             }
         }
     }
@@ -297,6 +392,12 @@ void MPEInstrument::noteOn (int midiChannel,
     if (! isUsingChannel (midiChannel))
         return;
 
+    if (! isPositiveAndBelow (midiNoteNumber, 128))
+    {
+        jassertfalse;
+        return;
+    }
+
     MPENote newNote (midiChannel,
                      midiNoteNumber,
                      midiNoteOnVelocity,
@@ -305,20 +406,23 @@ void MPEInstrument::noteOn (int midiChannel,
                      getInitialValueForNewNote (midiChannel, timbreDimension),
                      isMemberChannelSustained[midiChannel - 1] ? MPENote::keyDownAndSustained : MPENote::keyDown);
 
-    const ScopedLock sl (lock);
+    const ScopedInstrumentLock sl (lock, lockingEnabled);
     updateNoteTotalPitchbend (newNote);
 
-    if (auto* alreadyPlayingNote = getNotePtr (midiChannel, midiNoteNumber))
+    auto alreadyPlayingIndex = getNoteIndex (midiChannel, midiNoteNumber);
+
+    if (alreadyPlayingIndex >= 0)
     {
         // pathological case: second note-on received for same note -> retrigger it
-        alreadyPlayingNote->keyState = MPENote::off;
-        alreadyPlayingNote->noteOffVelocity = MPEValue::from7BitInt (64); // some reasonable number
-        listeners.call ([=] (Listener& l) { l.noteReleased (*alreadyPlayingNote); });
-        notes.remove (alreadyPlayingNote);
+        auto& alreadyPlayingNote = notes.getReference (alreadyPlayingIndex);
+        alreadyPlayingNote.keyState = MPENote::off;
+        alreadyPlayingNote.noteOffVelocity = MPEValue::from7BitInt (64); // some reasonable number
+        callListeners ([&] (Listener& l) { l.noteReleased (alreadyPlayingNote); });
+        removeNote (alreadyPlayingIndex);
     }
 
-    notes.add (newNote);
-    listeners.call ([&] (Listener& l) { l.noteAdded (newNote); });
+    addNote (newNote);
+    callListeners ([&] (Listener& l) { l.noteAdded (newNote); });
 }
 
 //==============================================================================
@@ -329,10 +433,13 @@ void MPEInstrument::noteOff (int midiChannel,
     if (notes.isEmpty() || ! isUsingChannel (midiChannel))
         return;
 
-    const ScopedLock sl (lock);
+    const ScopedInstrumentLock sl (lock, lockingEnabled);
 
-    if (auto* note = getNotePtr (midiChannel, midiNoteNumber))
+    auto index = getNoteIndex (midiChannel, midiNoteNumber);
+
+    if (index >= 0)
     {
+        auto* note = &notes.getReference (index);
         note->keyState = (note->keyState == MPENote::keyDownAndSustained) ? MPENote::sustained : MPENote::off;
         note->noteOffVelocity = midiNoteOffVelocity;
 
@@ -346,12 +453,12 @@ void MPEInstrument::noteOff (int midiChannel,
 
         if (note->keyState == MPENote::off)
         {
-            listeners.call ([=] (Listener& l) { l.noteReleased (*note); });
-            notes.remove (note);
+            callListeners ([=] (Listener& l) { l.noteReleased (*note); });
+            removeNote (index);
         }
         else
         {
-            listeners.call ([=] (Listener& l) { l.noteKeyStateChanged (*note); });
+            callListeners ([=] (Listener& l) { l.noteKeyStateChanged (*note); });
         }
     }
 }
@@ -359,33 +466,33 @@ void MPEInstrument::noteOff (int midiChannel,
 //==============================================================================
 void MPEInstrument::pitchbend (int midiChannel, MPEValue value)
 {
-    const ScopedLock sl (lock);
+    const ScopedInstrumentLock sl (lock, lockingEnabled);
     updateDimension (midiChannel, pitchbendDimension, value);
 }
 
 void MPEInstrument::pressure (int midiChannel, MPEValue value)
 {
-    const ScopedLock sl (lock);
+    const ScopedInstrumentLock sl (lock, lockingEnabled);
     updateDimension (midiChannel, pressureDimension, value);
 }
 
 void MPEInstrument::timbre (int midiChannel, MPEValue value)
 {
-    const ScopedLock sl (lock);
+    const ScopedInstrumentLock sl (lock, lockingEnabled);
     updateDimension (midiChannel, timbreDimension, value);
 }
 
 void MPEInstrument::polyAftertouch (int midiChannel, int midiNoteNumber, MPEValue value)
 {
-    const ScopedLock sl (lock);
+    const ScopedInstrumentLock sl (lock, lockingEnabled);
 
-    for (auto i = notes.size(); --i >= 0;)
+    auto index = getNoteIndex (midiChannel, midiNoteNumber);
+
+    if (index >= 0)
     {
-        auto& note = notes.getReference (i);
+        auto& note = notes.getReference (index);
 
-        if (note.midiChannel == midiChannel
-            && note.initialNote == midiNoteNumber
-            && pressureDimension.getValue (note) != value)
+        if (pressureDimension.getValue (note) != value)
         {
             pressureDimension.getValue (note) = value;
             callListenersDimensionChanged (note, pressureDimension);
@@ -413,13 +520,11 @@ void MPEInstrument::updateDimension (int midiChannel, MPEDimension& dimension, M
     {
         if (dimension.trackingMode == allNotesOnChannel)
         {
-            for (auto i = notes.size(); --i >= 0;)
-            {
-                auto& note = notes.getReference (i);
+            auto& channel = channels[midiChannel - 1];
 
-                if (note.midiChannel == midiChannel)
-                    updateDimensionForNote (note, dimension, value);
-            }
+            for (auto i = channel.numNotes; --i >= 0;)
+                updateDimensionForNote (notes.getReference (channel.noteIndex[channel.notesInOrderAdded[i]]),
+                                        dimension, value);
         }
         else
         {
@@ -454,7 +559,7 @@ void MPEInstrument::updateDimensionMaster (bool isLowerZone, MPEDimension& dimen
             // master pitchbend is a special case: we don't change the note's own pitchbend,
             // instead we have to update its total (master + note) pitchbend.
             updateNoteTotalPitchbend (note);
-            listeners.call ([&] (Listener& l) { l.notePitchbendChanged (note); });
+            callListeners ([&] (Listener& l) { l.notePitchbendChanged (note); });
         }
         else if (dimension.getValue (note) != value)
         {
@@ -481,9 +586,9 @@ void MPEInstrument::updateDimensionForNote (MPENote& note, MPEDimension& dimensi
 //==============================================================================
 void MPEInstrument::callListenersDimensionChanged (const MPENote& note, const MPEDimension& dimension)
 {
-    if (&dimension == &pressureDimension)  { listeners.call ([&] (Listener& l) { l.notePressureChanged  (note); }); return; }
-    if (&dimension == &timbreDimension)    { listeners.call ([&] (Listener& l) { l.noteTimbreChanged    (note); }); return; }
-    if (&dimension == &pitchbendDimension) { listeners.call ([&] (Listener& l) { l.notePitchbendChanged (note); }); return; }
+    if (&dimension == &pressureDimension)  { callListeners ([&] (Listener& l) { l.notePressureChanged  (note); }); return; }
+    if (&dimension == &timbreDimension)    { callListeners ([&] (Listener& l) { l.noteTimbreChanged    (note); }); return; }
+    if (&dimension == &pitchbendDimension) { callListeners ([&] (Listener& l) { l.notePitchbendChanged (note); }); return; }
 }
 
 //==============================================================================
@@ -529,13 +634,13 @@ void MPEInstrument::updateNoteTotalPitchbend (MPENote& note)
 //==============================================================================
 void MPEInstrument::sustainPedal (int midiChannel, bool isDown)
 {
-    const ScopedLock sl (lock);
+    const ScopedInstrumentLock sl (lock, lockingEnabled);
     handleSustainOrSostenuto (midiChannel, isDown, false);
 }
 
 void MPEInstrument::sostenutoPedal (int midiChannel, bool isDown)
 {
-    const ScopedLock sl (lock);
+    const ScopedInstrumentLock sl (lock, lockingEnabled);
     handleSustainOrSostenuto (midiChannel, isDown, true);
 }
 
@@ -566,12 +671,12 @@ void MPEInstrument::handleSustainOrSostenuto (int midiChannel, bool isDown, bool
 
             if (note.keyState == MPENote::off)
             {
-                listeners.call ([&] (Listener& l) { l.noteReleased (note); });
-                notes.remove (i);
+                callListeners ([&] (Listener& l) { l.noteReleased (note); });
+                removeNote (i);
             }
             else
             {
-                listeners.call ([&] (Listener& l) { l.noteKeyStateChanged (note); });
+                callListeners ([&] (Listener& l) { l.noteKeyStateChanged (note); });
             }
         }
     }
@@ -595,32 +700,45 @@ void MPEInstrument::handleSustainOrSostenuto (int midiChannel, bool isDown, bool
 //==============================================================================
 bool MPEInstrument::isMemberChannel (int midiChannel) const noexcept
 {
-    if (legacyMode.isEnabled)
-        return legacyMode.channelRange.contains (midiChannel);
-
-    return zoneLayout.getLowerZone().isUsingChannelAsMemberChannel (midiChannel)
-            || zoneLayout.getUpperZone().isUsingChannelAsMemberChannel (midiChannel);
+    return isPositiveAndBelow (midiChannel - 1, 16) && channels[midiChannel - 1].isMemberChannel;
 }
 
 bool MPEInstrument::isMasterChannel (int midiChannel) const noexcept
 {
-    if (legacyMode.isEnabled)
-        return false;
+    return isPositiveAndBelow (midiChannel - 1, 16) && channels[midiChannel - 1].isMasterChannel;
+}
 
+bool MPEInstrument::isUsingChannel (int midiChannel) const noexcept
+{
+    return isPositiveAndBelow (midiChannel - 1, 16) && channels[midiChannel - 1].isUsingChannel;
+}
+
+void MPEInstrument::updateChannelZones() noexcept
+{
     const auto lowerZone = zoneLayout.getLowerZone();
     const auto upperZone = zoneLayout.getUpperZone();
 
-    return (lowerZone.isActive() && midiChannel == lowerZone.getMasterChannel())
-            || (upperZone.isActive() && midiChannel == upperZone.getMasterChannel());
-}
+    for (int midiChannel = 1; midiChannel <= 16; ++midiChannel)
+    {
+        auto& channel = channels[midiChannel - 1];
 
-bool MPEInstrument::isUsingChannel (int midiChannel) const noexcept
-{
-    if (legacyMode.isEnabled)
-        return legacyMode.channelRange.contains (midiChannel);
+        if (legacyMode.isEnabled)
+        {
+            channel.isMemberChannel = legacyMode.channelRange.contains (midiChannel);
+            channel.isMasterChannel = false;
+            channel.isUsingChannel = channel.isMemberChannel;
+        }
+        else
+        {
+            channel.isMemberChannel = lowerZone.isUsingChannelAsMemberChannel (midiChannel)
+                                       || upperZone.isUsingChannelAsMemberChannel (midiChannel);
+
+            channel.isMasterChannel = (lowerZone.isActive() && midiChannel == lowerZone.getMasterChannel())
+                                       || (upperZone.isActive() && midiChannel == upperZone.getMasterChannel());
 
-    return zoneLayout.getLowerZone().isUsing (midiChannel)
-            || zoneLayout.getUpperZone().isUsing (midiChannel);
+            channel.isUsingChannel = lowerZone.isUsing (midiChannel) || upperZone.isUsing (midiChannel);
+        }
+    }
 }
 
 //==============================================================================
@@ -665,17 +783,18 @@ MPENote MPEInstrument::getMostRecentNoteOtherThan (MPENote otherThanThisNote) co
 }
 
 //==============================================================================
-const MPENote* MPEInstrument::getNotePtr (int midiChannel, int midiNoteNumber) const noexcept
+int MPEInstrument::getNoteIndex (int midiChannel, int midiNoteNumber) const noexcept
 {
-    for (int i = 0; i < notes.size(); ++i)
-    {
-        auto& note = notes.getReference (i);
+    if (! isPositiveAndBelow (midiChannel - 1, 16) || ! isPositiveAndBelow (midiNoteNumber, 128))
+        return -1;
 
-        if (note.midiChannel == midiChannel && note.initialNote == midiNoteNumber)
-            return &note;
-    }
+    return channels[midiChannel - 1].noteIndex[midiNoteNumber];
+}
 
-    return nullptr;
+const MPENote* MPEInstrument::getNotePtr (int midiChannel, int midiNoteNumber) const noexcept
+{
+    auto index = getNoteIndex (midiChannel, midiNoteNumber);
+    return index >= 0 ? &notes.getReference (index) : nullptr;
 }
 
 MPENote* MPEInstrument::getNotePtr (int midiChannel, int midiNoteNumber) noexcept
@@ -705,12 +824,16 @@ MPENote* MPEInstrument::getNotePtr (int midiChannel, TrackingMode mode) noexcept
 //==============================================================================
 const MPENote* MPEInstrument::getLastNotePlayedPtr (int midiChannel) const noexcept
 {
-    for (auto i = notes.size(); --i >= 0;)
+    if (! isPositiveAndBelow (midiChannel - 1, 16))
+        return nullptr;
+
+    auto& channel = channels[midiChannel - 1];
+
+    for (auto i = channel.numNotes; --i >= 0;)
     {
-        auto& note = notes.getReference (i);
+        auto& note = notes.getReference (channel.noteIndex[channel.notesInOrderAdded[i]]);
 
-        if (note.midiChannel == midiChannel
-             && (note.keyState == MPENote::keyDown || note.keyState == MPENote::keyDownAndSustained))
+        if ((note.keyState == MPENote::keyDown || note.keyState == MPENote::keyDownAndSustained))
             return &note;
     }
 
@@ -728,12 +851,16 @@ const MPENote* MPEInstrument::getHighestNotePtr (int midiChannel) const noexcept
     int initialNoteMax = -1;
     const MPENote* result = nullptr;
 
-    for (auto i = notes.size(); --i >= 0;)
+    if (! isPositiveAndBelow (midiChannel - 1, 16))
+        return result;
+
+    auto& channel = channels[midiChannel - 1];
+
+    for (auto i = channel.numNotes; --i >= 0;)
     {
-        auto& note = notes.getReference (i);
+        auto& note = notes.getReference (channel.noteIndex[channel.notesInOrderAdded[i]]);
 
-        if (note.midiChannel == midiChannel
-             && (note.keyState == MPENote::keyDown || note.keyState == MPENote::keyDownAndSustained)
+        if ((note.keyState == MPENote::keyDown || note.keyState == MPENote::keyDownAndSustained)
              && note.initialNote > initialNoteMax)
         {
             result = &note;
@@ -754,12 +881,16 @@ const MPENote* MPEInstrument::getLowestNotePtr (int midiChannel) const noexcept
     int initialNoteMin = 128;
     const MPENote* result = nullptr;
 
-    for (auto i = notes.size(); --i >= 0;)
+    if (! isPositiveAndBelow (midiChannel - 1, 16))
+        return result;
+
+    auto& channel = channels[midiChannel - 1];
+
+    for (auto i = channel.numNotes; --i >= 0;)
     {
-        auto& note = notes.getReference (i);
+        auto& note = notes.getReference (channel.noteIndex[channel.notesInOrderAdded[i]]);
 
-        if (note.midiChannel == midiChannel
-             && (note.keyState == MPENote::keyDown || note.keyState == MPENote::keyDownAndSustained)
+        if ((note.keyState == MPENote::keyDown || note.keyState == MPENote::keyDownAndSustained)
              && note.initialNote < initialNoteMin)
         {
             result = &note;
@@ -778,14 +909,55 @@ MPENote* MPEInstrument::getLowestNotePtr (int midiChannel) noexcept
 //==============================================================================
 void MPEInstrument::releaseAllNotes()
 {
-    const ScopedLock sl (lock);
+    const ScopedInstrumentLock sl (lock, lockingEnabled);
 
     for (auto i = notes.size(); --i >= 0;)
     {
         auto& note = notes.getReference (i);
         note.keyState = MPENote::off;
         note.noteOffVelocity = MPEValue::from7BitInt (64); // some reasonable number
-        listeners.call ([&] (Listener& l) { l.noteReleased (note); });
+        callListeners ([&] (Listener& l) { l.noteReleased (note); });
+    }
+
+    removeAllNotes();
+}
+
+//==============================================================================
+void MPEInstrument::addNote (const MPENote& note)
+{
+    auto& channel = channels[note.midiChannel - 1];
+
+    channel.noteIndex[note.initialNote] = (int16) notes.size();
+    channel.notesInOrderAdded[channel.numNotes++] = (uint8) note.initialNote;
+    notes.add (note);
+}
+
+void MPEInstrument::removeNote (int index)
+{
+    auto& note = notes.getReference (index);
+    auto& channel = channels[note.midiChannel - 1];
+
+    channel.noteIndex[note.initialNote] = -1;
+    std::remove (channel.notesInOrderAdded, channel.notesInOrderAdded + channel.numNotes, (uint8) note.initialNote);
+    --channel.numNotes;
+
+    notes.remove (index);
+
+    // the notes after this one have all moved down a place
+    for (int i = index; i < notes.size(); ++i)
+    {
+        auto& laterNote = notes.getReference (i);
+        channels[laterNote.midiChannel - 1].noteIndex[laterNote.initialNote] = (int16) i;
+    }
+}
+
+void MPEInstrument::removeAllNotes()
+{
+    for (auto& note : notes)
+    {
+        auto& channel = channels[note.midiChannel - 1];
+        channel.noteIndex[note.initialNote] = -1;
+        channel.numNotes = 0;
     }
 
     notes.clear();
@@ -2122,6 +2294,127 @@ public:
                 expectEquals (test.getNumPlayingNotes(), 0);
             }
         }
+
+        beginTest ("note lookups stay consistent when notes are removed");
+        {
+            MPEInstrument test;
+            test.setZoneLayout (testLayout);
+
+            for (int channel = 2; channel <= 5; ++channel)
+                for (int note = 60; note < 64; ++note)
+                    test.noteOn (channel, note, MPEValue::from7BitInt (100));
+
+            test.noteOff (3, 61, MPEValue::from7BitInt (64));
+            test.noteOff (2, 60, MPEValue::from7BitInt (64));
+            test.noteOff (5, 63, MPEValue::from7BitInt (64));
+            expectEquals (test.getNumPlayingNotes(), 13);
+
+            for (int i = 0; i < test.getNumPlayingNotes(); ++i)
+            {
+                auto note = test.getNote (i);
+                expect (test.getNote (note.midiChannel, note.initialNote) == note);
+            }
+
+            expect (! test.getNote (3, 61).isValid());
+            expectEquals ((int) test.getMostRecentNote (5).initialNote, 62);
+
+            // pitchbend should only affect the most recent note on its channel
+            test.pitchbend (3, MPEValue::from14BitInt (4000));
+            expectEquals (test.getNote (3, 63).pitchbend.as14BitInt(), 4000);
+            expectEquals (test.getNote (3, 62).pitchbend.as14BitInt(), 8192);
+        }
+
+        beginTest ("listeners can remove themselves during a callback");
+        {
+            struct RemovingListener  : public MPEInstrument::Listener
+            {
+                RemovingListener (MPEInstrument& i) : instrument (i) {}
+
+                void noteAdded (MPENote) override
+                {
+                    ++numCallbacks;
+                    instrument.removeListener (this);
+                }
+
+                MPEInstrument& instrument;
+                int numCallbacks = 0;
+            };
+
+            MPEInstrument test;
+            test.setZoneLayout (testLayout);
+
+            RemovingListener first (test), second (test);
+            test.addListener (&first);
+            test.addListener (&second);
+
+            test.noteOn (3, 60, MPEValue::from7BitInt (100));
+            test.noteOn (3, 61, MPEValue::from7BitInt (100));
+
+            expectEquals (first.numCallbacks, 1);
+            expectEquals (second.numCallbacks, 1);
+        }
+
+        beginTest ("removing a listener doesn't wait for callbacks on other threads");
+        {
+            struct SlowListener  : public MPEInstrument::Listener
+            {
+                void noteAdded (MPENote) override
+                {
+                    ++numCallbacks;
+                    started.signal();
+                    canFinish.wait (5000);
+                }
+
+                WaitableEvent started, canFinish;
+                std::atomic<int> numCallbacks { 0 };
+            };
+
+            struct NoteThread  : public Thread
+            {
+                NoteThread (MPEInstrument& i) : Thread ("MPE listener test"), instrument (i) {}
+                void run() override   { instrument.noteOn (3, 60, MPEValue::from7BitInt (100)); }
+                MPEInstrument& instrument;
+            };
+
+            MPEInstrument test;
+            test.setZoneLayout (testLayout);
+
+            SlowListener slowListener;
+            test.addListener (&slowListener);
+
+            NoteThread thread (test);
+            thread.startThread();
+            expect (slowListener.started.wait (5000));
+
+            // this would deadlock if it waited for the other thread's callback
+            test.removeListener (&slowListener);
+            slowListener.canFinish.signal();
+            expect (thread.waitForThreadToExit (5000));
+
+            test.noteOn (3, 61, MPEValue::from7BitInt (100));
+            expectEquals (slowListener.numCallbacks.load(), 1);
+        }
+
+        beginTest ("only zone layout changes update the channel zones");
+        {
+            MPEInstrument test;
+            test.setZoneLayout (testLayout);
+
+            // an unrelated controller doesn't change which channels are member channels
+            test.processNextMidiEvent (MidiMessage::controllerEvent (1, 7, 100));
+            test.noteOn (3, 60, MPEValue::from7BitInt (100));
+            expectEquals (test.getNumPlayingNotes(), 1);
+
+            // moving the lower zone to a single member channel takes channel 3 out of it
+            for (const auto m : MPEMessages::setLowerZone (1))
+                test.processNextMidiEvent (m.getMessage());
+
+            test.noteOn (3, 62, MPEValue::from7BitInt (100));
+            expectEquals (test.getNumPlayingNotes(), 1);
+
+            test.noteOn (2, 62, MPEValue::from7BitInt (100));
+            expectEquals (test.getNumPlayingNotes(), 2);
+        }
     }
 
 private:
@@ -303,9 +303,32 @@ public:
     /** Adds a listener. */
     void addListener (Listener* listenerToAdd);
 
-    /** Removes a listener. */
+    /** Removes a listener.
+
+        Listeners can be added and removed while another thread is sending midi to the
+        instrument, as the callbacks are made from a copy of the listener list rather than
+        while holding a lock. A callback that another thread has already started may
+        still reach the listener that was removed, so make sure that no other thread is
+        sending midi to the instrument before deleting a listener.
+    */
     void removeListener (Listener* listenerToRemove);
 
+    //==============================================================================
+    /** Enables or disables the use of the instrument's lock.
+
+        By default, all the methods that change the note state take the instrument's lock, so
+        that notes can be triggered from several threads at once. If all your notes arrive on
+        the same thread (e.g. because they all come from the MidiBuffer that an MPESynthesiser
+        is rendering), you can disable the lock so that processing MPE messages never has to
+        wait for another thread.
+    */
+    void setLockingEnabled (bool shouldUseLock) noexcept        { lockingEnabled = shouldUseLock; }
+
+    /** Returns true if the instrument's lock is being used.
+        @see setLockingEnabled
+    */
+    bool isLockingEnabled() const noexcept                      { return lockingEnabled; }
+
     //==============================================================================
     /** Puts the instrument into legacy mode.
         As a side effect, this will discard all currently playing notes,
@@ -352,7 +375,24 @@ private:
     //==============================================================================
     Array<MPENote> notes;
     MPEZoneLayout zoneLayout;
-    ListenerList<Listener> listeners;
+    bool lockingEnabled = true;
+
+    /** An index of the notes that are playing on a midi channel, so that finding the note
+        that a message applies to doesn't need to search through every playing note.
+    */
+    struct ChannelState
+    {
+        int16 noteIndex[128];           // index in the notes array of each note number, or -1
+        uint8 notesInOrderAdded[128];   // the note numbers playing on this channel, oldest first
+        int numNotes = 0;
+        bool isMemberChannel = false, isMasterChannel = false, isUsingChannel = false;
+    };
+
+    ChannelState channels[16];
+
+    struct ListenerArray;
+    std::shared_ptr<const ListenerArray> listenerArray;
+    CriticalSection listenerLock;
 
     uint8 lastPressureLowerBitReceivedOnChannel[16];
     uint8 lastTimbreLowerBitReceivedOnChannel[16];
@@ -407,6 +447,17 @@ private:
     MPENote* getLowestNotePtr (int midiChannel) noexcept;
     void updateNoteTotalPitchbend (MPENote&);
 
+    void addNote (const MPENote&);
+    void removeNote (int index);
+    void removeAllNotes();
+    int getNoteIndex (int midiChannel, int midiNoteNumber) const noexcept;
+    void updateChannelZones() noexcept;
+
+    void updateListenerArray (Listener*, bool shouldAdd);
+
+    template <typename Callback>
+    void callListeners (Callback&&);
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MPEInstrument)
 };
 
@@ -146,6 +146,12 @@ void MPESynthesiser::setCurrentPlaybackSampleRate (const double newRate)
         voices.getUnchecked (i)->setCurrentSampleRate (newRate);
 }
 
+void MPESynthesiser::setVoiceRenderThreadPool (VoiceRenderThreadPool* poolToUse)
+{
+    const ScopedLock sl (voicesLock);
+    renderThreadPool = poolToUse;
+}
+
 void MPESynthesiser::handleMidiEvent (const MidiMessage& m)
 {
     if (m.isController())
@@ -260,12 +266,16 @@ void MPESynthesiser::addVoice (MPESynthesiserVoice* const newVoice)
 {
     const ScopedLock sl (voicesLock);
     newVoice->setCurrentSampleRate (getSampleRate());
+
+    // make sure that rendering never has to allocate, even if every voice is playing
+    voicesToRender.reserve ((size_t) voices.size() + 1);
     voices.add (newVoice);
 }
 
 void MPESynthesiser::clearVoices()
 {
     const ScopedLock sl (voicesLock);
+    voicesToRender.clear();
     voices.clear();
 }
 
@@ -315,24 +325,51 @@ void MPESynthesiser::turnOffAllVoices (bool allowTailOff)
 //==============================================================================
 void MPESynthesiser::renderNextSubBlock (AudioBuffer<float>& buffer, int startSample, int numSamples)
 {
-    const ScopedLock sl (voicesLock);
-
-    for (auto* voice : voices)
-    {
-        if (voice->isActive())
-            voice->renderNextBlock (buffer, startSample, numSamples);
-    }
+    renderActiveVoices (buffer, startSample, numSamples);
 }
 
 void MPESynthesiser::renderNextSubBlock (AudioBuffer<double>& buffer, int startSample, int numSamples)
+{
+    renderActiveVoices (buffer, startSample, numSamples);
+}
+
+template <typename floatType>
+void MPESynthesiser::renderActiveVoices (AudioBuffer<floatType>& buffer, int startSample, int numSamples)
 {
     const ScopedLock sl (voicesLock);
 
-    for (auto* voice : voices)
+    if (renderThreadPool == nullptr)
     {
+        for (auto* voice : voices)
+        {
+            if (voice->isActive())
+                voice->renderNextBlock (buffer, startSample, numSamples);
+        }
+
+        return;
+    }
+
+    voicesToRender.clear();
+
+    for (auto* voice : voices)
         if (voice->isActive())
+            voicesToRender.push_back (voice);
+
+    struct ParallelRenderJob  : public VoiceRenderThreadPool::Job
+    {
+        ParallelRenderJob (MPESynthesiserVoice* const* v) noexcept  : voicesToRender (v) {}
+
+        void renderItem (int index, AudioBuffer<float>& b, int start, int num) override    { voicesToRender[index]->renderNextBlock (b, start, num); }
+        void renderItem (int index, AudioBuffer<double>& b, int start, int num) override   { voicesToRender[index]->renderNextBlock (b, start, num); }
+
+        MPESynthesiserVoice* const* voicesToRender;
+    };
+
+    ParallelRenderJob job (voicesToRender.data());
+
+    if (! renderThreadPool->render (job, (int) voicesToRender.size(), buffer, startSample, numSamples))
+        for (auto* voice : voicesToRender)
             voice->renderNextBlock (buffer, startSample, numSamples);
-    }
 }
 
 } // namespace juce
@@ -127,6 +127,25 @@ public:
     /** Returns true if note-stealing is enabled. */
     bool isVoiceStealingEnabled() const noexcept                { return shouldStealVoices; }
 
+    //==============================================================================
+    /** Gives the synth a pool of worker threads to render its voices with.
+
+        When a pool is set, the active voices for each sub-block are shared out between the
+        pool's threads and the audio thread, with every worker rendering into its own buffer.
+        MPE and MIDI messages are still handled between the sub-blocks in the usual way, so
+        the timing of notes isn't affected.
+
+        The synth doesn't take ownership of the pool, which must stay alive until it has been
+        removed again by passing nullptr to this method. Your voices must be safe to render
+        concurrently with each other.
+
+        @see VoiceRenderThreadPool
+    */
+    void setVoiceRenderThreadPool (VoiceRenderThreadPool* poolToUse);
+
+    /** Returns the pool that was set with setVoiceRenderThreadPool(), or nullptr. */
+    VoiceRenderThreadPool* getVoiceRenderThreadPool() const noexcept    { return renderThreadPool; }
+
     //==============================================================================
     /** Tells the synthesiser what the sample rate is for the audio it's being used to render.
 
@@ -306,6 +325,12 @@ private:
     bool shouldStealVoices = false;
     uint32 lastNoteOnCounter = 0;
 
+    VoiceRenderThreadPool* renderThreadPool = nullptr;
+    std::vector<MPESynthesiserVoice*> voicesToRender;
+
+    template <typename floatType>
+    void renderActiveVoices (AudioBuffer<floatType>&, int startSample, int numSamples);
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MPESynthesiser)
 };
 
@@ -0,0 +1,329 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+class BackgroundReadScheduler::Worker  : public Thread
+{
+public:
+    Worker (BackgroundReadScheduler& s, const String& name)
+        : Thread (name), owner (s)
+    {
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+            if (! owner.serviceNextGroup())
+                owner.workAvailable.wait (idleWaitMs);
+    }
+
+private:
+    // how often the clients' buffer levels are polled when there's nothing to do
+    static constexpr int idleWaitMs = 5;
+
+    BackgroundReadScheduler& owner;
+
+    JUCE_DECLARE_NON_COPYABLE (Worker)
+};
+
+//==============================================================================
+BackgroundReadScheduler::BackgroundReadScheduler (int numWorkerThreads, const String& threadName, int workerThreadPriority)
+{
+    jassert (numWorkerThreads > 0);
+
+    for (int i = 0; i < jmax (1, numWorkerThreads); ++i)
+        workers.add (new Worker (*this, threadName))->startThread (workerThreadPriority);
+}
+
+BackgroundReadScheduler::~BackgroundReadScheduler()
+{
+    // remove all the clients before deleting the scheduler!
+    jassert (clients.isEmpty());
+
+    for (auto* w : workers)
+        w->signalThreadShouldExit();
+
+    for (auto* w : workers)
+        w->stopThread (2000);
+}
+
+void BackgroundReadScheduler::addClient (Client* client)
+{
+    if (client != nullptr)
+    {
+        const ScopedLock sl (lock);
+        clients.addIfNotAlreadyThere (client);
+    }
+
+    notify();
+}
+
+void BackgroundReadScheduler::removeClient (Client* client)
+{
+    const ScopedLock sl (lock);
+    clients.removeFirstMatchingValue (client);
+
+    while (clientsInProgress.contains (client))
+    {
+        const ScopedUnlock ul (lock);
+        clientFinished.wait (20);
+    }
+}
+
+int BackgroundReadScheduler::getNumClients() const
+{
+    const ScopedLock sl (lock);
+    return clients.size();
+}
+
+void BackgroundReadScheduler::notify()
+{
+    workAvailable.signal();
+}
+
+//==============================================================================
+BackgroundReadScheduler::Client* BackgroundReadScheduler::findMostUrgentClient (bool onlyFromGroup, int64 group)
+{
+    Client* mostUrgent = nullptr;
+    auto earliestDeadline = (int) Client::nothingToRead;
+
+    for (auto* c : clients)
+    {
+        if (clientsInProgress.contains (c))
+            continue;
+
+        auto clientGroup = c->getReadGroup();
+
+        if (onlyFromGroup ? (clientGroup != group) : groupsInProgress.contains (clientGroup))
+            continue;
+
+        auto deadline = c->getMillisecondsUntilUnderrun();
+
+        if (deadline < earliestDeadline)
+        {
+            earliestDeadline = deadline;
+            mostUrgent = c;
+        }
+    }
+
+    return mostUrgent;
+}
+
+bool BackgroundReadScheduler::serviceNextGroup()
+{
+    // the maximum number of chunks read for a group before going back to
+    // look at the other groups' deadlines
+    constexpr int maxChunksPerGroup = 8;
+
+    Client* client = nullptr;
+    int64 group = 0;
+
+    {
+        const ScopedLock sl (lock);
+        client = findMostUrgentClient (false, 0);
+
+        if (client == nullptr)
+            return false;
+
+        group = client->getReadGroup();
+        groupsInProgress.add (group);
+        clientsInProgress.add (client);
+    }
+
+    bool anythingRead = false;
+
+    for (int numChunks = 1;; ++numChunks)
+    {
+        anythingRead = client->readNextChunk() || anythingRead;
+
+        {
+            const ScopedLock sl (lock);
+            clientsInProgress.removeFirstMatchingValue (client);
+
+            client = numChunks < maxChunksPerGroup ? findMostUrgentClient (true, group) : nullptr;
+
+            if (client != nullptr)
+                clientsInProgress.add (client);
+            else
+                groupsInProgress.removeFirstMatchingValue (group);
+        }
+
+        clientFinished.signal();
+
+        if (client == nullptr)
+            break;
+    }
+
+    return anythingRead;
+}
+
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class BackgroundReadSchedulerTests  : public UnitTest
+{
+public:
+    BackgroundReadSchedulerTests()
+        : UnitTest ("BackgroundReadScheduler", UnitTestCategories::audio)
+    {}
+
+    void runTest() override
+    {
+        beginTest ("Clients closest to underrun are read first");
+        {
+            TestState state;
+            OwnedArray<TestClient> testClients;
+
+            for (auto deadline : { 40, 10, 30, 20 })
+                testClients.add (new TestClient (state, deadline, deadline, 1));
+
+            readAll (state, testClients, 1);
+
+            expect (state.readOrder == std::vector<int> { 10, 20, 30, 40 });
+        }
+
+        beginTest ("Clients in the same read group are never read concurrently");
+        {
+            TestState state;
+            OwnedArray<TestClient> testClients;
+
+            for (int i = 0; i < 16; ++i)
+                testClients.add (new TestClient (state, i, i % 2, 3));
+
+            readAll (state, testClients, 4);
+
+            expectEquals ((int) state.readOrder.size(), 16 * 3);
+            expectEquals (state.maxConcurrentReads[0].load(), 1);
+            expectEquals (state.maxConcurrentReads[1].load(), 1);
+        }
+
+        beginTest ("BufferingAudioSource can read through a scheduler");
+        {
+            constexpr int numSamples = 44100;
+            AudioBuffer<float> sourceData (2, numSamples);
+            auto random = getRandom();
+
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < numSamples; ++i)
+                    sourceData.setSample (ch, i, random.nextFloat());
+
+            BackgroundReadScheduler scheduler (2);
+            BufferingAudioSource bufferingSource (new MemoryAudioSource (sourceData, true), scheduler, true, 8192);
+            bufferingSource.prepareToPlay (512, 44100.0);
+
+            AudioBuffer<float> block (2, 512);
+            bool allBlocksMatched = true;
+
+            for (int pos = 0; pos + block.getNumSamples() <= numSamples; pos += block.getNumSamples())
+            {
+                AudioSourceChannelInfo info (block);
+
+                expect (bufferingSource.waitForNextAudioBlockReady (info, 2000));
+                bufferingSource.getNextAudioBlock (info);
+
+                for (int ch = 0; ch < 2; ++ch)
+                    allBlocksMatched = allBlocksMatched
+                                        && std::memcmp (block.getReadPointer (ch), sourceData.getReadPointer (ch, pos),
+                                                        sizeof (float) * 512) == 0;
+            }
+
+            expect (allBlocksMatched);
+        }
+    }
+
+private:
+    struct TestState
+    {
+        std::atomic<bool> started { false };
+        CriticalSection lock;
+        std::vector<int> readOrder;
+        std::atomic<int> concurrentReads[2] { { 0 }, { 0 } }, maxConcurrentReads[2] { { 0 }, { 0 } };
+    };
+
+    struct TestClient  : public BackgroundReadScheduler::Client
+    {
+        TestClient (TestState& s, int d, int64 g, int chunks)
+            : state (s), deadline (d), group (g), numChunksToRead (chunks)
+        {}
+
+        int getMillisecondsUntilUnderrun() override
+        {
+            return (state.started && numChunksRead < numChunksToRead) ? deadline : nothingToRead;
+        }
+
+        int64 getReadGroup() override       { return group; }
+
+        bool readNextChunk() override
+        {
+            auto& concurrentReads = state.concurrentReads[group & 1];
+            auto& maxConcurrentReads = state.maxConcurrentReads[group & 1];
+
+            auto numReading = ++concurrentReads;
+            maxConcurrentReads = jmax (maxConcurrentReads.load(), numReading);
+            Thread::sleep (1);
+            --concurrentReads;
+
+            {
+                const ScopedLock sl (state.lock);
+                state.readOrder.push_back (deadline);
+            }
+
+            ++numChunksRead;
+            return true;
+        }
+
+        TestState& state;
+        const int deadline;
+        const int64 group;
+        const int numChunksToRead;
+        std::atomic<int> numChunksRead { 0 };
+    };
+
+    static void readAll (TestState& state, OwnedArray<TestClient>& testClients, int numWorkers)
+    {
+        BackgroundReadScheduler scheduler (numWorkers);
+
+        for (auto* c : testClients)
+            scheduler.addClient (c);
+
+        state.started = true;
+        scheduler.notify();
+
+        auto timeout = Time::getMillisecondCounter() + 5000;
+
+        for (auto* c : testClients)
+            while (c->numChunksRead < c->numChunksToRead && Time::getMillisecondCounter() < timeout)
+                Thread::sleep (1);
+
+        for (auto* c : testClients)
+            scheduler.removeClient (c);
+    }
+};
+
+static BackgroundReadSchedulerTests backgroundReadSchedulerTests;
+
+#endif
+
+} // namespace juce
@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+//==============================================================================
+/**
+    A pool of threads which does the background reading for a set of streaming
+    clients, such as BufferingAudioSource and BufferingAudioReader.
+
+    Unlike a TimeSliceThread, which calls each of its clients in turn, the scheduler
+    always services whichever client is closest to running out of buffered audio,
+    and it can spread the reading over several worker threads. Clients which read
+    from the same underlying source (e.g. the same file) are given the same read
+    group: a group is only ever serviced by one worker at a time, and that worker
+    reads a run of chunks for the group's clients back-to-back, so that accesses to
+    one file aren't interleaved with reads from other files.
+
+    @see BufferingAudioSource, TimeSliceThread
+
+    @tags{Audio}
+*/
+class JUCE_API  BackgroundReadScheduler
+{
+public:
+    //==============================================================================
+    /** Creates a scheduler with the given number of worker threads, and starts them. */
+    explicit BackgroundReadScheduler (int numWorkerThreads = 2,
+                                      const String& threadName = "Background read scheduler",
+                                      int workerThreadPriority = 5);
+
+    /** Destructor.
+
+        All the clients must have been removed before the scheduler is deleted.
+    */
+    ~BackgroundReadScheduler();
+
+    //==============================================================================
+    /** A stream which the scheduler reads ahead for. */
+    class JUCE_API  Client
+    {
+    public:
+        /** Destructor. */
+        virtual ~Client() = default;
+
+        /** The value to return from getMillisecondsUntilUnderrun() when a client's
+            buffer is full.
+        */
+        enum { nothingToRead = 0x7fffffff };
+
+        /** Returns how many milliseconds of audio the client has buffered ahead of the
+            position that it's being played from, or nothingToRead if there's currently
+            no reading for it to do.
+
+            This is called often, and while the scheduler holds its lock, so it must be
+            quick and mustn't block.
+        */
+        virtual int getMillisecondsUntilUnderrun() = 0;
+
+        /** Reads the next chunk of data. This is called on one of the worker threads.
+
+            Returns true if anything was read.
+        */
+        virtual bool readNextChunk() = 0;
+
+        /** Returns an identifier for the source that this client reads from.
+
+            Clients with the same group are never serviced concurrently, and their reads
+            are batched together. By default each client is in a group of its own.
+        */
+        virtual int64 getReadGroup()            { return (int64) (pointer_sized_int) this; }
+    };
+
+    //==============================================================================
+    /** Adds a client to the scheduler. */
+    void addClient (Client* client);
+
+    /** Removes a client from the scheduler.
+
+        If one of the worker threads is currently reading for the client, this will
+        block until it has finished.
+    */
+    void removeClient (Client* client);
+
+    /** Returns the number of clients that have been added. */
+    int getNumClients() const;
+
+    /** Returns the number of worker threads. */
+    int getNumWorkerThreads() const noexcept                { return workers.size(); }
+
+    /** Wakes up the workers, so that a client that has just started (or been moved to
+        a new position) gets serviced without waiting for the next poll.
+    */
+    void notify();
+
+private:
+    //==============================================================================
+    class Worker;
+
+    OwnedArray<Worker> workers;
+    CriticalSection lock;
+    Array<Client*> clients, clientsInProgress;
+    Array<int64> groupsInProgress;
+    WaitableEvent workAvailable, clientFinished;
+
+    bool serviceNextGroup();
+    Client* findMostUrgentClient (bool onlyFromGroup, int64 group);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BackgroundReadScheduler)
+};
+
+} // namespace juce
@@ -30,7 +30,27 @@ BufferingAudioSource::BufferingAudioSource (PositionableAudioSource* s,
                                             int numChannels,
                                             bool prefillBufferOnPrepareToPlay)
     : source (s, deleteSourceWhenDeleted),
-      backgroundThread (thread),
+      backgroundThread (&thread),
+      numberOfSamplesToBuffer (jmax (1024, bufferSizeSamples)),
+      numberOfChannels (numChannels),
+      prefillBuffer (prefillBufferOnPrepareToPlay)
+{
+    jassert (source != nullptr);
+
+    jassert (numberOfSamplesToBuffer > 1024); // not much point using this class if you're
+                                              //  not using a larger buffer..
+}
+
+BufferingAudioSource::BufferingAudioSource (PositionableAudioSource* s,
+                                            BackgroundReadScheduler& scheduler,
+                                            bool deleteSourceWhenDeleted,
+                                            int bufferSizeSamples,
+                                            int numChannels,
+                                            bool prefillBufferOnPrepareToPlay,
+                                            int64 group)
+    : source (s, deleteSourceWhenDeleted),
+      readScheduler (&scheduler),
+      readGroup (group),
       numberOfSamplesToBuffer (jmax (1024, bufferSizeSamples)),
       numberOfChannels (numChannels),
       prefillBuffer (prefillBufferOnPrepareToPlay)
@@ -55,7 +75,7 @@ void BufferingAudioSource::prepareToPlay (int samplesPerBlockExpected, double ne
          || bufferSizeNeeded != buffer.getNumSamples()
          || ! isPrepared)
     {
-        backgroundThread.removeTimeSliceClient (this);
+        stopBackgroundReading();
 
         isPrepared = true;
         sampleRate = newSampleRate;
@@ -68,11 +88,11 @@ void BufferingAudioSource::prepareToPlay (int samplesPerBlockExpected, double ne
         bufferValidStart = 0;
         bufferValidEnd = 0;
 
-        backgroundThread.addTimeSliceClient (this);
+        startBackgroundReading();
 
         do
         {
-            backgroundThread.moveToFrontOfQueue (this);
+            prioritiseBackgroundReading();
             Thread::sleep (5);
         }
         while (prefillBuffer
@@ -83,7 +103,7 @@ void BufferingAudioSource::prepareToPlay (int samplesPerBlockExpected, double ne
 void BufferingAudioSource::releaseResources()
 {
     isPrepared = false;
-    backgroundThread.removeTimeSliceClient (this);
+    stopBackgroundReading();
 
     buffer.setSize (numberOfChannels, 0);
 
@@ -214,7 +234,7 @@ void BufferingAudioSource::setNextReadPosition (int64 newPosition)
     const ScopedLock sl (bufferStartPosLock);
 
     nextPlayPos = newPosition;
-    backgroundThread.moveToFrontOfQueue (this);
+    prioritiseBackgroundReading();
 }
 
 bool BufferingAudioSource::readNextBufferChunk()
@@ -307,9 +327,61 @@ void BufferingAudioSource::readBufferSection (int64 start, int length, int buffe
     source->getNextAudioBlock (info);
 }
 
+void BufferingAudioSource::startBackgroundReading()
+{
+    if (readScheduler != nullptr)
+        readScheduler->addClient (this);
+    else
+        backgroundThread->addTimeSliceClient (this);
+}
+
+void BufferingAudioSource::stopBackgroundReading()
+{
+    if (readScheduler != nullptr)
+        readScheduler->removeClient (this);
+    else
+        backgroundThread->removeTimeSliceClient (this);
+}
+
+void BufferingAudioSource::prioritiseBackgroundReading()
+{
+    // the scheduler works out for itself that a stream which has just been moved is
+    // urgent, so it only needs waking up
+    if (readScheduler != nullptr)
+        readScheduler->notify();
+    else
+        backgroundThread->moveToFrontOfQueue (this);
+}
+
 int BufferingAudioSource::useTimeSlice()
 {
     return readNextBufferChunk() ? 1 : 100;
 }
 
+int BufferingAudioSource::getMillisecondsUntilUnderrun()
+{
+    auto start = bufferValidStart.load();
+    auto end   = bufferValidEnd.load();
+    auto pos   = jmax ((int64) 0, nextPlayPos.load());
+
+    if (pos < start || pos >= end)
+        return 0;
+
+    // this mirrors the threshold below which readNextBufferChunk() doesn't bother reading
+    if (end - pos >= (int64) buffer.getNumSamples() - 4 - 512)
+        return nothingToRead;
+
+    return sampleRate > 0 ? (int) (((double) (end - pos) * 1000.0) / sampleRate) : 0;
+}
+
+bool BufferingAudioSource::readNextChunk()
+{
+    return readNextBufferChunk();
+}
+
+int64 BufferingAudioSource::getReadGroup()
+{
+    return readGroup != 0 ? readGroup : (int64) (pointer_sized_int) this;
+}
+
 } // namespace juce
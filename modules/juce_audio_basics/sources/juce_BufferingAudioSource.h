@@ -31,12 +31,16 @@ namespace juce
     a background thread to smooth out playback. You can either create one of these
     directly, or use it indirectly using an AudioTransportSource.
 
-    @see PositionableAudioSource, AudioTransportSource
+    The reading can be done either by a TimeSliceThread, or by a BackgroundReadScheduler,
+    which is a better choice when there are lots of streams playing at once.
+
+    @see PositionableAudioSource, AudioTransportSource, BackgroundReadScheduler
 
     @tags{Audio}
 */
 class JUCE_API  BufferingAudioSource  : public PositionableAudioSource,
-                                        private TimeSliceClient
+                                        private TimeSliceClient,
+                                        private BackgroundReadScheduler::Client
 {
 public:
     //==============================================================================
@@ -61,6 +65,31 @@ public:
                           int numberOfChannels = 2,
                           bool prefillBufferOnPrepareToPlay = true);
 
+    /** Creates a BufferingAudioSource which does its reading with a BackgroundReadScheduler.
+
+        @param source                       the input source to read from
+        @param readScheduler                the scheduler that will do the background read-ahead.
+                                            This object must not be deleted until after any
+                                            BufferingAudioSources that are using it have been deleted!
+        @param deleteSourceWhenDeleted      if true, then the input source object will
+                                            be deleted when this object is deleted
+        @param numberOfSamplesToBuffer      the size of buffer to use for reading ahead
+        @param numberOfChannels             the number of channels that will be played
+        @param prefillBufferOnPrepareToPlay if true, then calling prepareToPlay on this object will
+                                            block until the buffer has been filled
+        @param readGroup                    BufferingAudioSources whose sources read from the same
+                                            file should be given the same read group, so that the
+                                            scheduler can batch their reads together. If this is 0,
+                                            the source gets a group of its own
+    */
+    BufferingAudioSource (PositionableAudioSource* source,
+                          BackgroundReadScheduler& readScheduler,
+                          bool deleteSourceWhenDeleted,
+                          int numberOfSamplesToBuffer,
+                          int numberOfChannels = 2,
+                          bool prefillBufferOnPrepareToPlay = true,
+                          int64 readGroup = 0);
+
     /** Destructor.
 
         The input source may be deleted depending on whether the deleteSourceWhenDeleted
@@ -100,7 +129,9 @@ public:
 private:
     //==============================================================================
     OptionalScopedPointer<PositionableAudioSource> source;
-    TimeSliceThread& backgroundThread;
+    TimeSliceThread* backgroundThread = nullptr;
+    BackgroundReadScheduler* readScheduler = nullptr;
+    int64 readGroup = 0;
     int numberOfSamplesToBuffer, numberOfChannels;
     AudioBuffer<float> buffer;
     CriticalSection bufferStartPosLock;
@@ -111,7 +142,14 @@ private:
 
     bool readNextBufferChunk();
     void readBufferSection (int64 start, int length, int bufferOffset);
+    void startBackgroundReading();
+    void stopBackgroundReading();
+    void prioritiseBackgroundReading();
+
     int useTimeSlice() override;
+    int getMillisecondsUntilUnderrun() override;
+    bool readNextChunk() override;
+    int64 getReadGroup() override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BufferingAudioSource)
 };
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+PolyphaseResamplingAudioSource::PolyphaseResamplingAudioSource (AudioSource* const inputSource,
+                                                                const bool deleteInputWhenDeleted,
+                                                                const int channels,
+                                                                const PolyphaseResampler::Quality qualityToUse)
+    : input (inputSource, deleteInputWhenDeleted),
+      numChannels (channels),
+      quality (qualityToUse)
+{
+    jassert (input != nullptr);
+    jassert (numChannels > 0);
+}
+
+PolyphaseResamplingAudioSource::~PolyphaseResamplingAudioSource() {}
+
+void PolyphaseResamplingAudioSource::setResamplingRatio (const double samplesInPerOutputSample)
+{
+    jassert (samplesInPerOutputSample > 0);
+
+    const SpinLock::ScopedLockType sl (ratioLock);
+    ratio = jmax (0.0, samplesInPerOutputSample);
+}
+
+int PolyphaseResamplingAudioSource::getLatencyInInputSamples() const noexcept
+{
+    return resampler.getLatencyInInputSamples();
+}
+
+void PolyphaseResamplingAudioSource::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+{
+    const SpinLock::ScopedLockType sl (ratioLock);
+
+    auto scaledBlockSize = roundToInt (samplesPerBlockExpected * ratio);
+    input->prepareToPlay (scaledBlockSize, sampleRate * ratio);
+
+    inputBuffer.setSize (numChannels, scaledBlockSize + 32);
+    destBuffers.calloc (numChannels);
+    resampler.prepare (numChannels, quality);
+    lastRatio = ratio;
+
+    flushBuffers();
+}
+
+void PolyphaseResamplingAudioSource::flushBuffers()
+{
+    const ScopedLock sl (callbackLock);
+
+    inputBuffer.clear();
+    resampler.reset();
+}
+
+void PolyphaseResamplingAudioSource::releaseResources()
+{
+    input->releaseResources();
+    inputBuffer.setSize (numChannels, 0);
+}
+
+void PolyphaseResamplingAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& info)
+{
+    const ScopedLock sl (callbackLock);
+
+    double localRatio;
+
+    {
+        const SpinLock::ScopedLockType ratioSl (ratioLock);
+        localRatio = ratio;
+    }
+
+    auto numInputSamples = resampler.getNumInputSamplesNeeded (lastRatio, localRatio, info.numSamples);
+
+    // this will only reallocate if the ratio has grown a lot since prepareToPlay() was called
+    inputBuffer.setSize (numChannels, jmax (1, numInputSamples), false, false, true);
+
+    if (numInputSamples > 0)
+    {
+        AudioSourceChannelInfo readInfo (&inputBuffer, 0, numInputSamples);
+        input->getNextAudioBlock (readInfo);
+    }
+
+    // any channels that the destination doesn't have are still resampled, so that
+    // their history stays continuous, but their output is thrown away
+    for (int channel = 0; channel < numChannels; ++channel)
+        destBuffers[channel] = channel < info.buffer->getNumChannels() ? info.buffer->getWritePointer (channel, info.startSample)
+                                                                       : nullptr;
+
+    resampler.process (lastRatio, localRatio, inputBuffer.getArrayOfReadPointers(), destBuffers, info.numSamples);
+    lastRatio = localRatio;
+
+    for (int channel = numChannels; channel < info.buffer->getNumChannels(); ++channel)
+        info.buffer->clear (channel, info.startSample, info.numSamples);
+}
+
+} // namespace juce
@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+//==============================================================================
+/**
+    A type of AudioSource that takes an input source and changes its sample rate,
+    using a PolyphaseResampler.
+
+    This works in the same way as a ResamplingAudioSource, but instead of a simple
+    low-pass filter followed by linear interpolation, it uses a band-limited polyphase
+    filter, which gives much better quality at a selectable CPU cost.
+
+    Note that the resampler delays its input by PolyphaseResampler::getLatencyInInputSamples()
+    samples (at the input sample rate).
+
+    @see ResamplingAudioSource, PolyphaseResampler, AudioSource
+
+    @tags{Audio}
+*/
+class JUCE_API  PolyphaseResamplingAudioSource  : public AudioSource
+{
+public:
+    //==============================================================================
+    /** Creates a PolyphaseResamplingAudioSource for a given input source.
+
+        @param inputSource              the input source to read from
+        @param deleteInputWhenDeleted   if true, the input source will be deleted when
+                                        this object is deleted
+        @param numChannels              the number of channels to process
+        @param quality                  the quality of resampler to use
+    */
+    PolyphaseResamplingAudioSource (AudioSource* inputSource,
+                                    bool deleteInputWhenDeleted,
+                                    int numChannels = 2,
+                                    PolyphaseResampler::Quality quality = PolyphaseResampler::Quality::standard);
+
+    /** Destructor. */
+    ~PolyphaseResamplingAudioSource() override;
+
+    /** Changes the resampling ratio.
+
+        This value can be changed at any time, even while the source is running. When it
+        changes, the ratio will be ramped smoothly to its new value over the next block.
+
+        @param samplesInPerOutputSample     if set to 1.0, the input is passed through; higher
+                                            values will speed it up; lower values will slow it
+                                            down. The ratio must be greater than 0
+    */
+    void setResamplingRatio (double samplesInPerOutputSample);
+
+    /** Returns the current resampling ratio.
+
+        This is the value that was set by setResamplingRatio().
+    */
+    double getResamplingRatio() const noexcept                  { return ratio; }
+
+    /** Returns the resampler's latency, in samples at the input sample rate. */
+    int getLatencyInInputSamples() const noexcept;
+
+    /** Clears any buffers that the resampler is using. */
+    void flushBuffers();
+
+    //==============================================================================
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock (const AudioSourceChannelInfo&) override;
+
+private:
+    //==============================================================================
+    OptionalScopedPointer<AudioSource> input;
+    const int numChannels;
+    const PolyphaseResampler::Quality quality;
+
+    double ratio = 1.0, lastRatio = 1.0;
+    SpinLock ratioLock;
+    CriticalSection callbackLock;
+
+    PolyphaseResampler resampler;
+    AudioBuffer<float> inputBuffer;
+    HeapBlock<float*> destBuffers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PolyphaseResamplingAudioSource)
+};
+
+} // namespace juce
@@ -27,7 +27,11 @@ namespace juce
 /**
     A type of AudioSource that takes an input source and changes its sample rate.
 
-    @see AudioSource, LagrangeInterpolator, CatmullRomInterpolator
+    This uses a simple low-pass filter and linear interpolation, which is cheap and has
+    no latency, but lets through a fair amount of aliasing. If you need better quality,
+    use a PolyphaseResamplingAudioSource instead.
+
+    @see AudioSource, PolyphaseResamplingAudioSource, LagrangeInterpolator, CatmullRomInterpolator
 
     @tags{Audio}
 */
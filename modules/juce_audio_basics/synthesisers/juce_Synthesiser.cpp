@@ -72,6 +72,28 @@ void SynthesiserVoice::renderNextBlock (AudioBuffer<double>& outputBuffer,
     subBuffer.makeCopyOf (tempBuffer, true);
 }
 
+//==============================================================================
+/** Takes a synth's lock, unless the synth has had locking disabled. */
+struct ScopedSynthesiserLock
+{
+    ScopedSynthesiserLock (const CriticalSection& l, bool shouldLock) noexcept
+        : lockToUse (shouldLock ? &l : nullptr)
+    {
+        if (lockToUse != nullptr)
+            lockToUse->enter();
+    }
+
+    ~ScopedSynthesiserLock() noexcept
+    {
+        if (lockToUse != nullptr)
+            lockToUse->exit();
+    }
+
+    const CriticalSection* lockToUse;
+
+    JUCE_DECLARE_NON_COPYABLE (ScopedSynthesiserLock)
+};
+
 //==============================================================================
 Synthesiser::Synthesiser()
 {
@@ -86,44 +108,58 @@ Synthesiser::~Synthesiser()
 //==============================================================================
 SynthesiserVoice* Synthesiser::getVoice (const int index) const
 {
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
     return voices [index];
 }
 
 void Synthesiser::clearVoices()
 {
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
+    activeVoices.clear();
+    voiceBatch.clear();
+    batchStarts.clear();
     voices.clear();
 }
 
 SynthesiserVoice* Synthesiser::addVoice (SynthesiserVoice* const newVoice)
 {
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
     newVoice->setCurrentPlaybackSampleRate (sampleRate);
+
+    // reserve enough space for every voice to be playing, so that starting
+    // notes never needs to allocate
+    activeVoices.reserve ((size_t) voices.size() + 1);
+    voiceBatch.reserve ((size_t) voices.size() + 1);
+    batchStarts.reserve ((size_t) voices.size() + 2);
+
+    if (newVoice->isVoiceActive())
+        addToActiveVoices (newVoice);
+
     return voices.add (newVoice);
 }
 
 void Synthesiser::removeVoice (const int index)
 {
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
+    removeFromActiveVoices (voices[index]);
     voices.remove (index);
 }
 
 void Synthesiser::clearSounds()
 {
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
     sounds.clear();
 }
 
 SynthesiserSound* Synthesiser::addSound (const SynthesiserSound::Ptr& newSound)
 {
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
     return sounds.add (newSound);
 }
 
 void Synthesiser::removeSound (const int index)
 {
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
     sounds.remove (index);
 }
 
@@ -139,12 +175,72 @@ void Synthesiser::setMinimumRenderingSubdivisionSize (int numSamples, bool shoul
     subBlockSubdivisionIsStrict = shouldBeStrict;
 }
 
+void Synthesiser::setLockingEnabled (bool shouldUseLock) noexcept
+{
+    lockingEnabled = shouldUseLock;
+}
+
+void Synthesiser::setBatchRenderingEnabled (bool shouldRenderInBatches) noexcept
+{
+    batchRenderingEnabled = shouldRenderInBatches;
+}
+
+void Synthesiser::setVoiceRenderThreadPool (VoiceRenderThreadPool* poolToUse)
+{
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
+    renderThreadPool = poolToUse;
+}
+
+//==============================================================================
+void Synthesiser::addToActiveVoices (SynthesiserVoice* voice)
+{
+    jassert (voice != nullptr);
+
+    if (! voice->isInActiveVoiceList)
+    {
+        voice->isInActiveVoiceList = true;
+        activeVoices.push_back (voice);
+    }
+}
+
+void Synthesiser::removeFromActiveVoices (SynthesiserVoice* voice)
+{
+    if (voice != nullptr && voice->isInActiveVoiceList)
+    {
+        activeVoices.erase (std::find (activeVoices.begin(), activeVoices.end(), voice));
+        voice->isInActiveVoiceList = false;
+    }
+}
+
+void Synthesiser::addUnlistedActiveVoices()
+{
+    // Picks up any voices that a subclass has started without going through startVoice(),
+    // so that they still get rendered and receive controller events.
+    for (auto* voice : voices)
+        if (! voice->isInActiveVoiceList && voice->isVoiceActive())
+            addToActiveVoices (voice);
+}
+
+void Synthesiser::removeInactiveVoices()
+{
+    activeVoices.erase (std::remove_if (activeVoices.begin(), activeVoices.end(),
+                                        [] (SynthesiserVoice* voice)
+                                        {
+                                            if (voice->isVoiceActive())
+                                                return false;
+
+                                            voice->isInActiveVoiceList = false;
+                                            return true;
+                                        }),
+                        activeVoices.end());
+}
+
 //==============================================================================
 void Synthesiser::setCurrentPlaybackSampleRate (const double newRate)
 {
     if (sampleRate != newRate)
     {
-        const ScopedLock sl (lock);
+        const ScopedSynthesiserLock sl (lock, lockingEnabled);
         allNotesOff (0, false);
         sampleRate = newRate;
 
@@ -167,14 +263,19 @@ void Synthesiser::processNextBlock (AudioBuffer<floatType>& outputAudio,
 
     bool firstEvent = true;
 
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
+
+    addUnlistedActiveVoices();
 
     for (; numSamples > 0; ++midiIterator)
     {
         if (midiIterator == midiData.cend())
         {
             if (targetChannels > 0)
+            {
                 renderVoices (outputAudio, startSample, numSamples);
+                removeInactiveVoices();
+            }
 
             return;
         }
@@ -185,7 +286,10 @@ void Synthesiser::processNextBlock (AudioBuffer<floatType>& outputAudio,
         if (samplesToNextMidiMessage >= numSamples)
         {
             if (targetChannels > 0)
+            {
                 renderVoices (outputAudio, startSample, numSamples);
+                removeInactiveVoices();
+            }
 
             handleMidiEvent (metadata.getMessage());
             break;
@@ -200,7 +304,10 @@ void Synthesiser::processNextBlock (AudioBuffer<floatType>& outputAudio,
         firstEvent = false;
 
         if (targetChannels > 0)
+        {
             renderVoices (outputAudio, startSample, samplesToNextMidiMessage);
+            removeInactiveVoices();
+        }
 
         handleMidiEvent (metadata.getMessage());
         startSample += samplesToNextMidiMessage;
@@ -230,14 +337,127 @@ void Synthesiser::renderNextBlock (AudioBuffer<double>& outputAudio, const MidiB
 
 void Synthesiser::renderVoices (AudioBuffer<float>& buffer, int startSample, int numSamples)
 {
-    for (auto* voice : voices)
-        voice->renderNextBlock (buffer, startSample, numSamples);
+    renderActiveVoices (buffer, startSample, numSamples);
 }
 
 void Synthesiser::renderVoices (AudioBuffer<double>& buffer, int startSample, int numSamples)
 {
-    for (auto* voice : voices)
-        voice->renderNextBlock (buffer, startSample, numSamples);
+    renderActiveVoices (buffer, startSample, numSamples);
+}
+
+template <typename floatType>
+void Synthesiser::renderActiveVoices (AudioBuffer<floatType>& buffer, int startSample, int numSamples)
+{
+    // voices can be stopped or started between blocks, so bring the list up to date first
+    addUnlistedActiveVoices();
+    removeInactiveVoices();
+
+    if (! batchRenderingEnabled)
+    {
+        auto numVoices = (int) activeVoices.size();
+
+        if (! renderWorkItemsInParallel (numVoices, buffer, startSample, numSamples))
+            for (auto* voice : activeVoices)
+                voice->renderNextBlock (buffer, startSample, numSamples);
+
+        return;
+    }
+
+    // Group the voices by sound, keeping each group in the order in which its notes were started.
+    // NB: Using a functor rather than a lambda here due to scare-stories about
+    // compilers generating code containing heap allocations..
+    struct SoundSorter
+    {
+        bool operator() (const SynthesiserVoice* a, const SynthesiserVoice* b) const noexcept
+        {
+            auto* soundA = a->currentlyPlayingSound.get();
+            auto* soundB = b->currentlyPlayingSound.get();
+
+            return soundA != soundB ? std::less<SynthesiserSound*>() (soundA, soundB)
+                                    : a->wasStartedBefore (*b);
+        }
+    };
+
+    voiceBatch.assign (activeVoices.begin(), activeVoices.end());
+    std::sort (voiceBatch.begin(), voiceBatch.end(), SoundSorter());
+
+    batchStarts.clear();
+
+    for (size_t start = 0; start < voiceBatch.size();)
+    {
+        auto* sound = voiceBatch[start]->currentlyPlayingSound.get();
+        auto end = start + 1;
+
+        while (end < voiceBatch.size() && voiceBatch[end]->currentlyPlayingSound.get() == sound)
+            ++end;
+
+        batchStarts.push_back ((int) start);
+        start = end;
+    }
+
+    auto numBatches = (int) batchStarts.size();
+    batchStarts.push_back ((int) voiceBatch.size());
+
+    if (! renderWorkItemsInParallel (numBatches, buffer, startSample, numSamples))
+        for (int i = 0; i < numBatches; ++i)
+            renderWorkItem (i, buffer, startSample, numSamples);
+}
+
+template <typename floatType>
+void Synthesiser::renderWorkItem (int itemIndex, AudioBuffer<floatType>& buffer, int startSample, int numSamples)
+{
+    if (! batchRenderingEnabled)
+    {
+        activeVoices[(size_t) itemIndex]->renderNextBlock (buffer, startSample, numSamples);
+        return;
+    }
+
+    auto start = batchStarts[(size_t) itemIndex];
+    auto end = batchStarts[(size_t) itemIndex + 1];
+
+    if (auto* sound = voiceBatch[(size_t) start]->currentlyPlayingSound.get())
+    {
+        renderVoiceBatch (*sound, voiceBatch.data() + start, end - start, buffer, startSample, numSamples);
+        return;
+    }
+
+    // voices that were started without a sound can't be batched
+    for (auto i = start; i < end; ++i)
+        voiceBatch[(size_t) i]->renderNextBlock (buffer, startSample, numSamples);
+}
+
+template <typename floatType>
+bool Synthesiser::renderWorkItemsInParallel (int numItems, AudioBuffer<floatType>& buffer, int startSample, int numSamples)
+{
+    if (renderThreadPool == nullptr)
+        return false;
+
+    struct ParallelRenderJob  : public VoiceRenderThreadPool::Job
+    {
+        ParallelRenderJob (Synthesiser& s) noexcept  : synth (s) {}
+
+        void renderItem (int index, AudioBuffer<float>& b, int start, int num) override    { synth.renderWorkItem (index, b, start, num); }
+        void renderItem (int index, AudioBuffer<double>& b, int start, int num) override   { synth.renderWorkItem (index, b, start, num); }
+
+        Synthesiser& synth;
+    };
+
+    ParallelRenderJob job (*this);
+    return renderThreadPool->render (job, numItems, buffer, startSample, numSamples);
+}
+
+void Synthesiser::renderVoiceBatch (SynthesiserSound&, SynthesiserVoice* const* voicesToRender, int numVoicesToRender,
+                                    AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    for (int i = 0; i < numVoicesToRender; ++i)
+        voicesToRender[i]->renderNextBlock (buffer, startSample, numSamples);
+}
+
+void Synthesiser::renderVoiceBatch (SynthesiserSound&, SynthesiserVoice* const* voicesToRender, int numVoicesToRender,
+                                    AudioBuffer<double>& buffer, int startSample, int numSamples)
+{
+    for (int i = 0; i < numVoicesToRender; ++i)
+        voicesToRender[i]->renderNextBlock (buffer, startSample, numSamples);
 }
 
 void Synthesiser::handleMidiEvent (const MidiMessage& m)
@@ -285,7 +505,7 @@ void Synthesiser::noteOn (const int midiChannel,
                           const int midiNoteNumber,
                           const float velocity)
 {
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
 
     for (auto* sound : sounds)
     {
@@ -293,7 +513,7 @@ void Synthesiser::noteOn (const int midiChannel,
         {
             // If hitting a note that's still ringing, stop it first (it could be
             // still playing because of the sustain or sostenuto pedal).
-            for (auto* voice : voices)
+            for (auto* voice : activeVoices)
                 if (voice->getCurrentlyPlayingNote() == midiNoteNumber && voice->isPlayingChannel (midiChannel))
                     stopVoice (voice, 1.0f, true);
 
@@ -322,6 +542,8 @@ void Synthesiser::startVoice (SynthesiserVoice* const voice,
         voice->setSostenutoPedalDown (false);
         voice->setSustainPedalDown (sustainPedalsDown[midiChannel]);
 
+        addToActiveVoices (voice);
+
         voice->startNote (midiNoteNumber, velocity, sound,
                           lastPitchWheelValues [midiChannel - 1]);
     }
@@ -342,9 +564,9 @@ void Synthesiser::noteOff (const int midiChannel,
                            const float velocity,
                            const bool allowTailOff)
 {
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
 
-    for (auto* voice : voices)
+    for (auto* voice : activeVoices)
     {
         if (voice->getCurrentlyPlayingNote() == midiNoteNumber
               && voice->isPlayingChannel (midiChannel))
@@ -368,22 +590,38 @@ void Synthesiser::noteOff (const int midiChannel,
 
 void Synthesiser::allNotesOff (const int midiChannel, const bool allowTailOff)
 {
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
 
-    for (auto* voice : voices)
-        if (midiChannel <= 0 || voice->isPlayingChannel (midiChannel))
+    if (midiChannel <= 0)
+    {
+        for (auto* voice : voices)
             voice->stopNote (1.0f, allowTailOff);
+    }
+    else
+    {
+        for (auto* voice : activeVoices)
+            if (voice->isPlayingChannel (midiChannel))
+                voice->stopNote (1.0f, allowTailOff);
+    }
 
     sustainPedalsDown.clear();
 }
 
 void Synthesiser::handlePitchWheel (const int midiChannel, const int wheelValue)
 {
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
 
-    for (auto* voice : voices)
-        if (midiChannel <= 0 || voice->isPlayingChannel (midiChannel))
+    if (midiChannel <= 0)
+    {
+        for (auto* voice : voices)
             voice->pitchWheelMoved (wheelValue);
+    }
+    else
+    {
+        for (auto* voice : activeVoices)
+            if (voice->isPlayingChannel (midiChannel))
+                voice->pitchWheelMoved (wheelValue);
+    }
 }
 
 void Synthesiser::handleController (const int midiChannel,
@@ -398,18 +636,26 @@ void Synthesiser::handleController (const int midiChannel,
         default:    break;
     }
 
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
 
-    for (auto* voice : voices)
-        if (midiChannel <= 0 || voice->isPlayingChannel (midiChannel))
+    if (midiChannel <= 0)
+    {
+        for (auto* voice : voices)
             voice->controllerMoved (controllerNumber, controllerValue);
+    }
+    else
+    {
+        for (auto* voice : activeVoices)
+            if (voice->isPlayingChannel (midiChannel))
+                voice->controllerMoved (controllerNumber, controllerValue);
+    }
 }
 
 void Synthesiser::handleAftertouch (int midiChannel, int midiNoteNumber, int aftertouchValue)
 {
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
 
-    for (auto* voice : voices)
+    for (auto* voice : activeVoices)
         if (voice->getCurrentlyPlayingNote() == midiNoteNumber
               && (midiChannel <= 0 || voice->isPlayingChannel (midiChannel)))
             voice->aftertouchChanged (aftertouchValue);
@@ -417,29 +663,37 @@ void Synthesiser::handleAftertouch (int midiChannel, int midiNoteNumber, int aft
 
 void Synthesiser::handleChannelPressure (int midiChannel, int channelPressureValue)
 {
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
 
-    for (auto* voice : voices)
-        if (midiChannel <= 0 || voice->isPlayingChannel (midiChannel))
+    if (midiChannel <= 0)
+    {
+        for (auto* voice : voices)
             voice->channelPressureChanged (channelPressureValue);
+    }
+    else
+    {
+        for (auto* voice : activeVoices)
+            if (voice->isPlayingChannel (midiChannel))
+                voice->channelPressureChanged (channelPressureValue);
+    }
 }
 
 void Synthesiser::handleSustainPedal (int midiChannel, bool isDown)
 {
     jassert (midiChannel > 0 && midiChannel <= 16);
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
 
     if (isDown)
     {
         sustainPedalsDown.setBit (midiChannel);
 
-        for (auto* voice : voices)
+        for (auto* voice : activeVoices)
             if (voice->isPlayingChannel (midiChannel) && voice->isKeyDown())
                 voice->setSustainPedalDown (true);
     }
     else
     {
-        for (auto* voice : voices)
+        for (auto* voice : activeVoices)
         {
             if (voice->isPlayingChannel (midiChannel))
             {
@@ -457,9 +711,9 @@ void Synthesiser::handleSustainPedal (int midiChannel, bool isDown)
 void Synthesiser::handleSostenutoPedal (int midiChannel, bool isDown)
 {
     jassert (midiChannel > 0 && midiChannel <= 16);
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
 
-    for (auto* voice : voices)
+    for (auto* voice : activeVoices)
     {
         if (voice->isPlayingChannel (midiChannel))
         {
@@ -488,7 +742,7 @@ SynthesiserVoice* Synthesiser::findFreeVoice (SynthesiserSound* soundToPlay,
                                               int midiChannel, int midiNoteNumber,
                                               const bool stealIfNoneAvailable) const
 {
-    const ScopedLock sl (lock);
+    const ScopedSynthesiserLock sl (lock, lockingEnabled);
 
     for (auto* voice : voices)
         if ((! voice->isVoiceActive()) && voice->canPlaySound (soundToPlay))
@@ -526,15 +780,6 @@ SynthesiserVoice* Synthesiser::findVoiceToSteal (SynthesiserSound* soundToPlay,
 
             usableVoices.add (voice);
 
-            // NB: Using a functor rather than a lambda here due to scare-stories about
-            // compilers generating code containing heap allocations..
-            struct Sorter
-            {
-                bool operator() (const SynthesiserVoice* a, const SynthesiserVoice* b) const noexcept { return a->wasStartedBefore (*b); }
-            };
-
-            std::sort (usableVoices.begin(), usableVoices.end(), Sorter());
-
             if (! voice->isPlayingButReleased()) // Don't protect released notes
             {
                 auto note = voice->getCurrentlyPlayingNote();
@@ -548,6 +793,15 @@ SynthesiserVoice* Synthesiser::findVoiceToSteal (SynthesiserSound* soundToPlay,
         }
     }
 
+    // NB: Using a functor rather than a lambda here due to scare-stories about
+    // compilers generating code containing heap allocations..
+    struct Sorter
+    {
+        bool operator() (const SynthesiserVoice* a, const SynthesiserVoice* b) const noexcept { return a->wasStartedBefore (*b); }
+    };
+
+    std::sort (usableVoices.begin(), usableVoices.end(), Sorter());
+
     // Eliminate pathological cases (ie: only 1 note playing): we always give precedence to the lowest note(s)
     if (top == low)
         top = nullptr;
@@ -582,4 +836,207 @@ SynthesiserVoice* Synthesiser::findVoiceToSteal (SynthesiserSound* soundToPlay,
     return low;
 }
 
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class SynthesiserTests  : public UnitTest
+{
+public:
+    SynthesiserTests()
+        : UnitTest ("Synthesiser", UnitTestCategories::audio)
+    {}
+
+    void runTest() override
+    {
+        beginTest ("Only playing voices are rendered");
+        {
+            TestSynth synth (4);
+            synth.noteOn (1, 60, 1.0f);
+            synth.noteOn (1, 64, 1.0f);
+
+            expectEquals (render (synth), 2.0f);
+            expectEquals (synth.getTestVoice (2).numBlocksRendered, 0);
+            expectEquals (synth.getTestVoice (3).numBlocksRendered, 0);
+
+            synth.noteOff (1, 60, 1.0f, false);
+            expectEquals (render (synth), 1.0f);
+            expectEquals (synth.getTestVoice (0).numBlocksRendered, 1);
+            expectEquals (synth.getTestVoice (1).numBlocksRendered, 2);
+
+            synth.allNotesOff (0, false);
+            expectEquals (render (synth), 0.0f);
+            expectEquals (synth.getTestVoice (1).numBlocksRendered, 2);
+        }
+
+        beginTest ("Stolen voices keep rendering their new notes");
+        {
+            TestSynth synth (2);
+            synth.noteOn (1, 60, 1.0f);
+            synth.noteOn (1, 64, 1.0f);
+            synth.noteOn (1, 62, 1.0f);
+
+            expectEquals (render (synth), 2.0f);
+            expectEquals (synth.getVoice (0)->getCurrentlyPlayingNote(), 60);
+            expectEquals (synth.getVoice (1)->getCurrentlyPlayingNote(), 62);
+
+            synth.noteOff (1, 64, 1.0f, false);
+            expectEquals (render (synth), 2.0f);
+
+            synth.noteOff (1, 62, 1.0f, false);
+            expectEquals (render (synth), 1.0f);
+            expectEquals (synth.getVoice (1)->getCurrentlyPlayingNote(), -1);
+
+            synth.noteOn (1, 67, 1.0f);
+            expectEquals (render (synth), 2.0f);
+            expectEquals (synth.getVoice (1)->getCurrentlyPlayingNote(), 67);
+        }
+
+        beginTest ("Voices started without startVoice() are still rendered");
+        {
+            for (auto batched : { false, true })
+            {
+                TestSynth synth (2);
+                synth.setBatchRenderingEnabled (batched);
+
+                synth.getTestVoice (1).isActiveWithoutNote = true;
+                expectEquals (render (synth), 1.0f);
+
+                synth.noteOn (1, 60, 1.0f);
+                expectEquals (render (synth), 2.0f);
+                expectEquals (synth.getVoice (0)->getCurrentlyPlayingNote(), 60);
+
+                synth.getTestVoice (1).isActiveWithoutNote = false;
+                expectEquals (render (synth), 1.0f);
+                expectEquals (synth.getTestVoice (1).numBlocksRendered, 2);
+            }
+        }
+
+        beginTest ("Batch rendering groups the playing voices by sound");
+        {
+            TestSynth synth (6);
+            synth.setBatchRenderingEnabled (true);
+
+            auto* highSound = synth.addSound (new TestSound (72, 127));
+
+            synth.noteOn (1, 60, 1.0f);
+            synth.noteOn (1, 80, 1.0f);
+            synth.noteOn (1, 62, 1.0f);
+            synth.noteOn (1, 64, 1.0f);
+
+            expectEquals (render (synth), 4.0f);
+            expectEquals ((int) synth.batches.size(), 2);
+
+            for (auto& batch : synth.batches)
+            {
+                auto isHigh = (batch.sound == highSound);
+                expectEquals ((int) batch.notes.size(), isHigh ? 1 : 3);
+
+                if (isHigh)
+                    expectEquals (batch.notes[0], 80);
+                else
+                    expect (batch.notes == std::vector<int> { 60, 62, 64 });
+            }
+
+            synth.noteOff (1, 80, 1.0f, false);
+            synth.batches.clear();
+
+            expectEquals (render (synth), 3.0f);
+            expectEquals ((int) synth.batches.size(), 1);
+
+            synth.setBatchRenderingEnabled (false);
+            synth.batches.clear();
+
+            expectEquals (render (synth), 3.0f);
+            expect (synth.batches.empty());
+        }
+    }
+
+private:
+    //==============================================================================
+    struct TestSound  : public SynthesiserSound
+    {
+        TestSound (int lowest, int highest)  : lowestNote (lowest), highestNote (highest) {}
+
+        bool appliesToNote (int note) override      { return note >= lowestNote && note <= highestNote; }
+        bool appliesToChannel (int) override        { return true; }
+
+        const int lowestNote, highestNote;
+    };
+
+    // Adds 1.0 to every sample of its output while it's playing.
+    struct TestVoice  : public SynthesiserVoice
+    {
+        bool canPlaySound (SynthesiserSound*) override          { return true; }
+        bool isVoiceActive() const override                     { return isActiveWithoutNote || SynthesiserVoice::isVoiceActive(); }
+
+        void startNote (int, float, SynthesiserSound*, int) override {}
+        void stopNote (float, bool) override                    { clearCurrentNote(); }
+        void pitchWheelMoved (int) override                     {}
+        void controllerMoved (int, int) override                {}
+
+        void renderNextBlock (AudioBuffer<float>& buffer, int startSample, int numSamples) override
+        {
+            ++numBlocksRendered;
+
+            for (int i = startSample; i < startSample + numSamples; ++i)
+                buffer.addSample (0, i, 1.0f);
+        }
+
+        using SynthesiserVoice::renderNextBlock;
+
+        bool isActiveWithoutNote = false;
+        int numBlocksRendered = 0;
+    };
+
+    struct TestSynth  : public Synthesiser
+    {
+        TestSynth (int numVoices)
+        {
+            for (int i = 0; i < numVoices; ++i)
+                addVoice (new TestVoice());
+
+            addSound (new TestSound (0, 71));
+            setCurrentPlaybackSampleRate (44100.0);
+        }
+
+        TestVoice& getTestVoice (int index)     { return *dynamic_cast<TestVoice*> (getVoice (index)); }
+
+        struct Batch
+        {
+            SynthesiserSound* sound;
+            std::vector<int> notes;
+        };
+
+        void renderVoiceBatch (SynthesiserSound& sound, SynthesiserVoice* const* voicesToRender, int numVoicesToRender,
+                               AudioBuffer<float>& buffer, int startSample, int numSamples) override
+        {
+            Batch batch { &sound, {} };
+
+            for (int i = 0; i < numVoicesToRender; ++i)
+                batch.notes.push_back (voicesToRender[i]->getCurrentlyPlayingNote());
+
+            batches.push_back (batch);
+            Synthesiser::renderVoiceBatch (sound, voicesToRender, numVoicesToRender, buffer, startSample, numSamples);
+        }
+
+        using Synthesiser::renderVoiceBatch;
+
+        std::vector<Batch> batches;
+    };
+
+    // Renders a block, and returns the number of voices that were heard.
+    static float render (Synthesiser& synth)
+    {
+        AudioBuffer<float> buffer (1, 16);
+        buffer.clear();
+        synth.renderNextBlock (buffer, {}, 0, buffer.getNumSamples());
+        return buffer.getSample (0, 0);
+    }
+};
+
+static SynthesiserTests synthesiserTests;
+
+#endif
+
 } // namespace juce
@@ -271,6 +271,7 @@ private:
     uint32 noteOnTime = 0;
     SynthesiserSound::Ptr currentlyPlayingSound;
     bool keyIsDown = false, sustainPedalDown = false, sostenutoPedalDown = false;
+    bool isInActiveVoiceList = false;
 
     AudioBuffer<float> tempBuffer;
 
@@ -557,11 +558,69 @@ public:
     */
     void setMinimumRenderingSubdivisionSize (int numSamples, bool shouldBeStrict = false) noexcept;
 
+    //==============================================================================
+    /** Enables or disables the use of the synth's lock.
+
+        By default, renderNextBlock() and the note and controller methods all take the synth's
+        lock, so that notes can safely be triggered from other threads while it's rendering.
+
+        If all of your note events arrive through the MidiBuffer passed to renderNextBlock(), or
+        you only ever call noteOn(), noteOff(), etc. from the audio thread, you can disable the
+        lock, so that the audio thread never has to wait for another thread while it dispatches
+        midi events.
+    */
+    void setLockingEnabled (bool shouldUseLock) noexcept;
+
+    /** Returns true if the synth's lock is being used.
+        @see setLockingEnabled
+    */
+    bool isLockingEnabled() const noexcept                      { return lockingEnabled; }
+
+    /** Enables or disables batch rendering.
+
+        When this is enabled, the default renderVoices() method groups the active voices by the
+        sound that they're playing, and renders each group with a single call to renderVoiceBatch(),
+        so that a subclass can render voices which share a sound together, e.g. with one voice in
+        each SIMD lane.
+
+        @see renderVoiceBatch
+    */
+    void setBatchRenderingEnabled (bool shouldRenderInBatches) noexcept;
+
+    /** Returns true if batch rendering has been enabled.
+        @see setBatchRenderingEnabled
+    */
+    bool isBatchRenderingEnabled() const noexcept               { return batchRenderingEnabled; }
+
+    /** Gives the synth a pool of worker threads to render its voices with.
+
+        When a pool is set, each sub-block's active voices (or, with batch rendering enabled,
+        each batch of voices) are shared out between the pool's threads and the audio thread,
+        with every worker rendering into its own buffer. Midi events are still handled between
+        the sub-blocks in the usual way, so the timing of notes isn't affected.
+
+        The synth doesn't take ownership of the pool, which must stay alive until it has been
+        removed again by passing nullptr to this method. Your voices (and any renderVoiceBatch()
+        override) must be safe to render concurrently with each other.
+
+        @see VoiceRenderThreadPool
+    */
+    void setVoiceRenderThreadPool (VoiceRenderThreadPool* poolToUse);
+
+    /** Returns the pool that was set with setVoiceRenderThreadPool(), or nullptr. */
+    VoiceRenderThreadPool* getVoiceRenderThreadPool() const noexcept    { return renderThreadPool; }
+
 protected:
     //==============================================================================
-    /** This is used to control access to the rendering callback and the note trigger methods. */
+    /** This is used to control access to the rendering callback and the note trigger methods.
+        @see setLockingEnabled
+    */
     CriticalSection lock;
 
+    /** The synth's voices.
+        These should only be changed with addVoice(), removeVoice() and clearVoices(), as
+        the synth also keeps a list of the voices that are currently playing.
+    */
     OwnedArray<SynthesiserVoice> voices;
     ReferenceCountedArray<SynthesiserSound> sounds;
 
@@ -569,14 +628,36 @@ protected:
     int lastPitchWheelValues [16];
 
     /** Renders the voices for the given range.
-        By default this just calls renderNextBlock() on each voice, but you may need
-        to override it to handle custom cases.
+
+        By default this calls renderNextBlock() on each of the voices that are currently
+        playing (or, if batch rendering is enabled, calls renderVoiceBatch() for each
+        group of playing voices that share a sound), but you may need to override it to
+        handle custom cases.
     */
     virtual void renderVoices (AudioBuffer<float>& outputAudio,
                                int startSample, int numSamples);
     virtual void renderVoices (AudioBuffer<double>& outputAudio,
                                int startSample, int numSamples);
 
+    /** Renders a group of voices which are all playing the same sound.
+
+        This is called by renderVoices() when batch rendering is enabled. The voices are all
+        active and are in the order in which they were started. The default implementation
+        just calls renderNextBlock() on each voice, but you can override it to render the
+        voices together, e.g. by processing several voices at once in SIMD registers.
+
+        Like SynthesiserVoice::renderNextBlock(), this must add its output to the contents
+        of the buffer, and any voices that finish must call clearCurrentNote().
+
+        @see setBatchRenderingEnabled
+    */
+    virtual void renderVoiceBatch (SynthesiserSound& sound,
+                                   SynthesiserVoice* const* voicesToRender, int numVoicesToRender,
+                                   AudioBuffer<float>& outputAudio, int startSample, int numSamples);
+    virtual void renderVoiceBatch (SynthesiserSound& sound,
+                                   SynthesiserVoice* const* voicesToRender, int numVoicesToRender,
+                                   AudioBuffer<double>& outputAudio, int startSample, int numSamples);
+
     /** Searches through the voices to find one that's not currently playing, and
         which can play the given sound.
 
@@ -602,6 +683,12 @@ protected:
     /** Starts a specified voice playing a particular sound.
         You'll probably never need to call this, it's used internally by noteOn(), but
         may be needed by subclasses for custom behaviours.
+
+        The synth only renders and sends controller events to the voices in its list of
+        active voices, and this method is what adds a voice to that list. If a subclass
+        starts a voice in some other way, it should call addToActiveVoices() for it - the
+        synth will still find the voice when it next renders, but until then it won't
+        receive any controller events.
     */
     void startVoice (SynthesiserVoice* voice,
                      SynthesiserSound* sound,
@@ -616,6 +703,16 @@ protected:
     */
     void stopVoice (SynthesiserVoice*, float velocity, bool allowTailOff);
 
+    /** Adds a voice that was started without calling startVoice() to the list of voices
+        that get rendered and receive controller events.
+
+        The voice is taken off the list again once it stops being active. Calling this for
+        a voice that's already in the list has no effect.
+
+        @see startVoice
+    */
+    void addToActiveVoices (SynthesiserVoice*);
+
     /** Can be overridden to do custom handling of incoming midi events. */
     virtual void handleMidiEvent (const MidiMessage&);
 
@@ -626,11 +723,29 @@ private:
     int minimumSubBlockSize = 32;
     bool subBlockSubdivisionIsStrict = false;
     bool shouldStealNotes = true;
+    bool lockingEnabled = true, batchRenderingEnabled = false;
     BigInteger sustainPedalsDown;
 
+    std::vector<SynthesiserVoice*> activeVoices, voiceBatch;
+    std::vector<int> batchStarts;
+    VoiceRenderThreadPool* renderThreadPool = nullptr;
+
     template <typename floatType>
     void processNextBlock (AudioBuffer<floatType>&, const MidiBuffer&, int startSample, int numSamples);
 
+    template <typename floatType>
+    void renderActiveVoices (AudioBuffer<floatType>&, int startSample, int numSamples);
+
+    template <typename floatType>
+    void renderWorkItem (int itemIndex, AudioBuffer<floatType>&, int startSample, int numSamples);
+
+    template <typename floatType>
+    bool renderWorkItemsInParallel (int numItems, AudioBuffer<floatType>&, int startSample, int numSamples);
+
+    void addUnlistedActiveVoices();
+    void removeInactiveVoices();
+    void removeFromActiveVoices (SynthesiserVoice*);
+
    #if JUCE_CATCH_DEPRECATED_CODE_MISUSE
     // Note the new parameters for these methods.
     virtual int findFreeVoice (const bool) const { return 0; }
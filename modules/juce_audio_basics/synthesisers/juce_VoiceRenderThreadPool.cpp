@@ -0,0 +1,296 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+struct VoiceRenderThreadPool::Worker  : public Thread
+{
+    Worker (VoiceRenderThreadPool& p, int index)
+        : Thread ("Voice Render Worker " + String (index + 1)), owner (p)
+    {
+    }
+
+    ~Worker() override
+    {
+        signalThreadShouldExit();
+        startEvent.signal();
+        stopThread (2000);
+    }
+
+    void run() override
+    {
+        for (;;)
+        {
+            startEvent.wait (-1);
+
+            if (threadShouldExit())
+                return;
+
+            if (owner.currentJobIsDouble)
+                renderItems (doubleBuffer);
+            else
+                renderItems (floatBuffer);
+
+            owner.numWorkersBusy.fetch_sub (1, std::memory_order_release);
+        }
+    }
+
+    template <typename floatType>
+    void renderItems (AudioBuffer<floatType>& buffer)
+    {
+        hasRenderedItems = false;
+
+        for (;;)
+        {
+            auto index = owner.nextItemIndex.fetch_add (1);
+
+            if (index >= owner.currentNumItems)
+                break;
+
+            // Only clear the buffer once this worker actually gets something to do, so
+            // that idle workers don't cost anything when the sums are added up
+            if (! hasRenderedItems)
+            {
+                buffer.clear (owner.currentStartSample, owner.currentNumSamples);
+                hasRenderedItems = true;
+            }
+
+            owner.currentJob->renderItem (index, buffer, owner.currentStartSample, owner.currentNumSamples);
+        }
+    }
+
+    AudioBuffer<float>&  getBuffer (float) noexcept     { return floatBuffer; }
+    AudioBuffer<double>& getBuffer (double) noexcept    { return doubleBuffer; }
+
+    VoiceRenderThreadPool& owner;
+    WaitableEvent startEvent;
+    AudioBuffer<float> floatBuffer;
+    AudioBuffer<double> doubleBuffer;
+    bool hasRenderedItems = false;
+
+    JUCE_DECLARE_NON_COPYABLE (Worker)
+};
+
+//==============================================================================
+VoiceRenderThreadPool::VoiceRenderThreadPool (int numWorkerThreads, int workerThreadPriority)
+{
+    jassert (numWorkerThreads > 0);
+
+    for (int i = 0; i < numWorkerThreads; ++i)
+        workers.add (new Worker (*this, i))->startThread (workerThreadPriority);
+}
+
+VoiceRenderThreadPool::~VoiceRenderThreadPool()
+{
+    // Make sure no synths are still rendering with this pool when it gets deleted!
+    jassert (! isRendering.load());
+
+    workers.clear();
+}
+
+void VoiceRenderThreadPool::prepare (int maximumNumChannels, int maximumBlockSize)
+{
+    // This mustn't be called while the pool is being used to render!
+    jassert (! isRendering.load());
+
+    preparedNumChannels = jmax (0, maximumNumChannels);
+    preparedBlockSize = jmax (0, maximumBlockSize);
+
+    for (auto* worker : workers)
+    {
+        worker->floatBuffer.setSize (preparedNumChannels, preparedBlockSize);
+        worker->doubleBuffer.setSize (preparedNumChannels, preparedBlockSize);
+    }
+}
+
+void VoiceRenderThreadPool::releaseResources()
+{
+    prepare (0, 0);
+}
+
+//==============================================================================
+bool VoiceRenderThreadPool::render (Job& job, int numItems, AudioBuffer<float>& outputAudio, int startSample, int numSamples)
+{
+    return renderJob (job, numItems, outputAudio, startSample, numSamples);
+}
+
+bool VoiceRenderThreadPool::render (Job& job, int numItems, AudioBuffer<double>& outputAudio, int startSample, int numSamples)
+{
+    return renderJob (job, numItems, outputAudio, startSample, numSamples);
+}
+
+template <typename floatType>
+bool VoiceRenderThreadPool::renderJob (Job& job, int numItems, AudioBuffer<floatType>& outputAudio,
+                                       int startSample, int numSamples)
+{
+    auto numChannels = outputAudio.getNumChannels();
+
+    // There's no point waking up any workers unless there's something to share out
+    if (numItems < 2 || numSamples <= 0 || workers.isEmpty())
+        return false;
+
+    if (numChannels > preparedNumChannels || outputAudio.getNumSamples() > preparedBlockSize)
+        return false;
+
+    if (isRendering.exchange (true))
+        return false;
+
+    currentJob = &job;
+    currentNumItems = numItems;
+    currentStartSample = startSample;
+    currentNumSamples = numSamples;
+    currentJobIsDouble = std::is_same<floatType, double>::value;
+    nextItemIndex.store (0);
+
+    // The calling thread takes a share of the items too, so one fewer worker than items is enough
+    auto numWorkersToUse = jmin (workers.size(), numItems - 1);
+    numWorkersBusy.store (numWorkersToUse);
+
+    for (int i = 0; i < numWorkersToUse; ++i)
+    {
+        auto& worker = *workers.getUnchecked (i);
+
+        // the buffers were allocated in prepare(), so this won't reallocate
+        worker.getBuffer (floatType()).setSize (numChannels, outputAudio.getNumSamples(), false, false, true);
+        worker.startEvent.signal();
+    }
+
+    // The calling thread can render straight into the output, as nobody else writes to it
+    for (;;)
+    {
+        auto index = nextItemIndex.fetch_add (1);
+
+        if (index >= numItems)
+            break;
+
+        job.renderItem (index, outputAudio, startSample, numSamples);
+    }
+
+    for (int spins = 0; numWorkersBusy.load (std::memory_order_acquire) > 0; ++spins)
+        if (spins > 64)
+            Thread::yield();
+
+    for (int i = 0; i < numWorkersToUse; ++i)
+    {
+        auto& worker = *workers.getUnchecked (i);
+
+        if (worker.hasRenderedItems)
+        {
+            auto& buffer = worker.getBuffer (floatType());
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                outputAudio.addFrom (channel, startSample, buffer, channel, startSample, numSamples);
+        }
+    }
+
+    currentJob = nullptr;
+    isRendering.store (false);
+    return true;
+}
+
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+struct VoiceRenderThreadPoolTests  : public UnitTest
+{
+    VoiceRenderThreadPoolTests()
+        : UnitTest ("VoiceRenderThreadPool", UnitTestCategories::audio)
+    {}
+
+    struct ConstantJob  : public VoiceRenderThreadPool::Job
+    {
+        template <typename floatType>
+        void addItem (int index, AudioBuffer<floatType>& b, int start, int num)
+        {
+            for (int channel = 0; channel < b.getNumChannels(); ++channel)
+                for (int i = start; i < start + num; ++i)
+                    b.getWritePointer (channel)[i] += (floatType) (index + 1);
+
+            ++numTimesRendered[index];
+        }
+
+        void renderItem (int index, AudioBuffer<float>& b, int start, int num) override    { addItem (index, b, start, num); }
+        void renderItem (int index, AudioBuffer<double>& b, int start, int num) override   { addItem (index, b, start, num); }
+
+        std::atomic<int> numTimesRendered[16] {};
+    };
+
+    template <typename floatType>
+    void checkRender (VoiceRenderThreadPool& pool, int numItems)
+    {
+        AudioBuffer<floatType> buffer (2, 64);
+        buffer.clear();
+        ConstantJob job;
+
+        expect (pool.render (job, numItems, buffer, 8, 32));
+
+        auto expectedSum = (floatType) (numItems * (numItems + 1) / 2);
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                auto expected = (i >= 8 && i < 40) ? expectedSum : (floatType) 0;
+                expectEquals (buffer.getSample (channel, i), expected);
+            }
+        }
+
+        for (int i = 0; i < numItems; ++i)
+            expectEquals (job.numTimesRendered[i].load(), 1);
+    }
+
+    void runTest() override
+    {
+        VoiceRenderThreadPool pool (3);
+
+        beginTest ("Rendering needs a prepared pool and more than one item");
+        {
+            AudioBuffer<float> buffer (2, 64);
+            ConstantJob job;
+
+            expect (! pool.render (job, 4, buffer, 0, 64));
+
+            pool.prepare (2, 64);
+            expect (! pool.render (job, 1, buffer, 0, 64));
+
+            AudioBuffer<float> tooManyChannels (3, 64);
+            expect (! pool.render (job, 4, tooManyChannels, 0, 64));
+        }
+
+        beginTest ("Every item is rendered exactly once and summed into the output");
+        {
+            for (int repeat = 0; repeat < 50; ++repeat)
+            {
+                checkRender<float>  (pool, 2 + repeat % 14);
+                checkRender<double> (pool, 2 + repeat % 14);
+            }
+        }
+    }
+};
+
+static VoiceRenderThreadPoolTests voiceRenderThreadPoolTests;
+
+#endif
+
+} // namespace juce
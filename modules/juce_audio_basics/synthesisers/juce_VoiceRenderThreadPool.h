@@ -0,0 +1,130 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+//==============================================================================
+/**
+    A pool of real-time worker threads that a Synthesiser or MPESynthesiser can use
+    to render its voices in parallel.
+
+    When a synth has been given a pool with Synthesiser::setVoiceRenderThreadPool() or
+    MPESynthesiser::setVoiceRenderThreadPool(), each sub-block of voices is shared out
+    between the pool's worker threads and the audio thread. Every worker renders into
+    its own accumulation buffer, and these are added to the synth's output once all
+    the voices for the sub-block have finished, so the synth still handles its midi
+    events at exactly the same sample positions as when it renders serially.
+
+    Because the voices are rendered concurrently, they must not share any mutable state
+    with each other (or with the synth) while rendering.
+
+    Before using the pool, call prepare() with the largest channel count and block size
+    that it'll be asked to render. The pool never allocates on the audio thread: if it's
+    asked to render a block that doesn't fit into the buffers it has prepared, or if it's
+    already in use by another synth, render() returns false and the synth just renders its
+    voices serially instead.
+
+    A single pool can be shared between several synths, as long as they're all rendered
+    from the same thread.
+
+    @tags{Audio}
+*/
+class JUCE_API  VoiceRenderThreadPool
+{
+public:
+    //==============================================================================
+    /** Creates a pool with the given number of worker threads.
+
+        The thread that calls render() also renders voices, so a pool with N workers
+        will render on up to N + 1 threads at once.
+    */
+    explicit VoiceRenderThreadPool (int numWorkerThreads,
+                                    int workerThreadPriority = Thread::realtimeAudioPriority);
+
+    /** Destructor. */
+    ~VoiceRenderThreadPool();
+
+    //==============================================================================
+    /** Returns the number of worker threads in the pool. */
+    int getNumWorkerThreads() const noexcept                { return workers.size(); }
+
+    /** Allocates the accumulation buffers that the worker threads render into.
+
+        This must be called before rendering, and must not be called while any synth is
+        using the pool.
+    */
+    void prepare (int maximumNumChannels, int maximumBlockSize);
+
+    /** Frees the accumulation buffers. */
+    void releaseResources();
+
+    //==============================================================================
+    /** A set of work items which can be rendered in any order, on any thread. */
+    struct JUCE_API  Job
+    {
+        virtual ~Job() = default;
+
+        /** Renders one of the items, adding its output to the given range of the buffer. */
+        virtual void renderItem (int itemIndex, AudioBuffer<float>& buffer, int startSample, int numSamples) = 0;
+
+        /** Renders one of the items, adding its output to the given range of the buffer. */
+        virtual void renderItem (int itemIndex, AudioBuffer<double>& buffer, int startSample, int numSamples) = 0;
+    };
+
+    /** Renders items 0 to numItems - 1 of a job, spread between the calling thread and
+        the worker threads, and adds the result to the given range of outputAudio.
+
+        Returns false without rendering anything if the pool can't be used for this block,
+        in which case the caller should render the items itself.
+    */
+    bool render (Job& job, int numItems, AudioBuffer<float>& outputAudio, int startSample, int numSamples);
+
+    /** Renders items 0 to numItems - 1 of a job, spread between the calling thread and
+        the worker threads, and adds the result to the given range of outputAudio.
+
+        Returns false without rendering anything if the pool can't be used for this block,
+        in which case the caller should render the items itself.
+    */
+    bool render (Job& job, int numItems, AudioBuffer<double>& outputAudio, int startSample, int numSamples);
+
+private:
+    //==============================================================================
+    struct Worker;
+
+    OwnedArray<Worker> workers;
+    int preparedNumChannels = 0, preparedBlockSize = 0;
+
+    Job* currentJob = nullptr;
+    int currentNumItems = 0, currentStartSample = 0, currentNumSamples = 0;
+    bool currentJobIsDouble = false;
+
+    std::atomic<int> nextItemIndex { 0 }, numWorkersBusy { 0 };
+    std::atomic<bool> isRendering { false };
+
+    template <typename floatType>
+    bool renderJob (Job&, int numItems, AudioBuffer<floatType>&, int startSample, int numSamples);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoiceRenderThreadPool)
+};
+
+} // namespace juce
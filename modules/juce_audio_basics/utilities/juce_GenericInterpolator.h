@@ -497,4 +497,277 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GenericInterpolator)
 };
 
+//==============================================================================
+/**
+    A multichannel version of GenericInterpolator, which resamples all the channels
+    of a stream in a single pass.
+
+    Rather than running an independent interpolator per channel, this class keeps
+    the history of every channel interleaved, so that the read position and the
+    interpolation weights are only calculated once per output sample and then
+    applied to all of the channels at once with FloatVectorOperations, i.e. with
+    the channels occupying the SIMD lanes. When the speed ratio is a multiple of
+    1/16 (e.g. 0.5, 1.0, 1.5, 2.0) the sub-sample offsets repeat, so the weights
+    for each phase are calculated once and then reused.
+
+    The results are the same as running one GenericInterpolator per channel, to
+    within floating-point rounding.
+
+    The InterpolatorTraits class must provide, in addition to what GenericInterpolator
+    needs, a static weightsAtOffset (float offset, float* weights) function which
+    writes the memorySize coefficients that valueAtOffset would apply to the history,
+    oldest sample first.
+
+    Call prepare() with the number of channels before processing, as that's where the
+    internal buffers get allocated; the processing methods themselves don't allocate.
+
+    @see GenericInterpolator, Interpolators
+
+    @tags{Audio}
+*/
+template <class InterpolatorTraits, int memorySize>
+class JUCE_API  GenericMultichannelInterpolator
+{
+public:
+    /** Creates an interpolator. You'll need to call prepare() before using it. */
+    GenericMultichannelInterpolator() noexcept          { reset(); }
+
+    /** Creates an interpolator and prepares it for the given number of channels. */
+    explicit GenericMultichannelInterpolator (int numChannelsToUse)    { prepare (numChannelsToUse); }
+
+    GenericMultichannelInterpolator (GenericMultichannelInterpolator&&) noexcept = default;
+    GenericMultichannelInterpolator& operator= (GenericMultichannelInterpolator&&) noexcept = default;
+
+    /** Returns the latency of the interpolation algorithm in isolation.
+
+        @see GenericInterpolator::getBaseLatency
+    */
+    static constexpr float getBaseLatency() noexcept
+    {
+        return InterpolatorTraits::algorithmicLatency;
+    }
+
+    /** Allocates the internal buffers for the given number of channels, and resets
+        the interpolator.
+    */
+    void prepare (int numChannelsToUse)
+    {
+        jassert (numChannelsToUse >= 0);
+
+        numChannels = numChannelsToUse;
+        stride = (numChannels + numLanes - 1) & ~(numLanes - 1);
+
+        history.allocate ((size_t) (2 * memorySize * stride), true);
+        frame.allocate ((size_t) stride, true);
+        weights.allocate ((size_t) (maxNumCachedPhases * memorySize), true);
+
+        reset();
+    }
+
+    /** Returns the number of channels that the interpolator was prepared for. */
+    int getNumChannels() const noexcept         { return numChannels; }
+
+    /** Resets the state of the interpolator.
+
+        Call this when there's a break in the continuity of the input data stream.
+    */
+    void reset() noexcept
+    {
+        writeIndex = 0;
+        subSamplePos = 1.0;
+
+        if (history != nullptr)
+            FloatVectorOperations::clear (history, 2 * memorySize * stride);
+
+        std::fill (std::begin (cachedOffsets), std::end (cachedOffsets), -1.0f);
+    }
+
+    /** Resamples a multichannel stream of samples.
+
+        @param speedRatio                   the number of input samples to use for each output sample
+        @param inputChannels                an array of getNumChannels() channels to read from. Each must
+                                            contain at least (speedRatio * numOutputSamplesToProduce) samples.
+        @param outputChannels               an array of getNumChannels() channels to write the results into
+        @param numOutputSamplesToProduce    the number of output samples that should be created per channel
+
+        @returns the actual number of input samples per channel that were used
+    */
+    int process (double speedRatio,
+                 const float* const* inputChannels,
+                 float* const* outputChannels,
+                 int numOutputSamplesToProduce) noexcept
+    {
+        return interpolate (speedRatio, inputChannels, 0, outputChannels, 0, numOutputSamplesToProduce, false, 1.0f);
+    }
+
+    /** Resamples a section of an AudioBuffer into another one.
+
+        Both buffers must have at least getNumChannels() channels.
+
+        @returns the actual number of input samples per channel that were used
+    */
+    int process (double speedRatio,
+                 const AudioBuffer<float>& input, int inputStartSample,
+                 AudioBuffer<float>& output, int outputStartSample,
+                 int numOutputSamplesToProduce) noexcept
+    {
+        jassert (input.getNumChannels() >= numChannels && output.getNumChannels() >= numChannels);
+        jassert (outputStartSample + numOutputSamplesToProduce <= output.getNumSamples());
+
+        return interpolate (speedRatio, input.getArrayOfReadPointers(), inputStartSample,
+                            output.getArrayOfWritePointers(), outputStartSample,
+                            numOutputSamplesToProduce, false, 1.0f);
+    }
+
+    /** Resamples a multichannel stream of samples, adding the results to the output
+        data with a gain.
+
+        @returns the actual number of input samples per channel that were used
+        @see process
+    */
+    int processAdding (double speedRatio,
+                       const float* const* inputChannels,
+                       float* const* outputChannels,
+                       int numOutputSamplesToProduce,
+                       float gain) noexcept
+    {
+        return interpolate (speedRatio, inputChannels, 0, outputChannels, 0, numOutputSamplesToProduce, true, gain);
+    }
+
+    /** Resamples a section of an AudioBuffer, adding the results to another one
+        with a gain.
+
+        @returns the actual number of input samples per channel that were used
+        @see process
+    */
+    int processAdding (double speedRatio,
+                       const AudioBuffer<float>& input, int inputStartSample,
+                       AudioBuffer<float>& output, int outputStartSample,
+                       int numOutputSamplesToProduce,
+                       float gain) noexcept
+    {
+        jassert (input.getNumChannels() >= numChannels && output.getNumChannels() >= numChannels);
+        jassert (outputStartSample + numOutputSamplesToProduce <= output.getNumSamples());
+
+        return interpolate (speedRatio, input.getArrayOfReadPointers(), inputStartSample,
+                            output.getArrayOfWritePointers(), outputStartSample,
+                            numOutputSamplesToProduce, true, gain);
+    }
+
+private:
+    //==============================================================================
+    // The history is stored twice over, so that the memorySize frames ending at the
+    // most recent one are always contiguous, whatever the write position.
+    forcedinline void pushInterpolationFrame (const float* const* inputs, int index) noexcept
+    {
+        auto* row = history.get() + writeIndex * stride;
+        auto* mirror = row + memorySize * stride;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            row[ch] = mirror[ch] = inputs[ch][index];
+
+        if (++writeIndex == memorySize)
+            writeIndex = 0;
+    }
+
+    forcedinline const float* getWeights (float offset, int phase) noexcept
+    {
+        auto* w = weights.get() + phase * memorySize;
+
+        if (cachedOffsets[phase] != offset)
+        {
+            InterpolatorTraits::weightsAtOffset (offset, w);
+            cachedOffsets[phase] = offset;
+        }
+
+        return w;
+    }
+
+    forcedinline void calculateFrame (const float* w) noexcept
+    {
+        const auto* rows = history.get() + writeIndex * stride;
+
+        FloatVectorOperations::clear (frame, stride);
+
+        for (int i = 0; i < memorySize; ++i)
+            if (w[i] != 0.0f)
+                FloatVectorOperations::addWithMultiply (frame.get(), rows + i * stride, w[i], stride);
+    }
+
+    // If the ratio is a multiple of 1 / maxNumCachedPhases, the sub-sample offset
+    // cycles with this period, so each phase can keep its own weights.
+    static int getPhasePeriod (double speedRatio) noexcept
+    {
+        auto scaledRatio = speedRatio * maxNumCachedPhases;
+
+        if (scaledRatio <= 0.0 || scaledRatio > 1.0e6 || scaledRatio != std::floor (scaledRatio))
+            return 1;
+
+        auto numerator = (int) scaledRatio;
+        int period = maxNumCachedPhases;
+
+        while (period > 1 && (numerator & 1) == 0)
+        {
+            numerator >>= 1;
+            period >>= 1;
+        }
+
+        return period;
+    }
+
+    int interpolate (double speedRatio,
+                     const float* const* inputs, int inputStart,
+                     float* const* outputs, int outputStart,
+                     int numOutputSamplesToProduce,
+                     bool isAdding, float gain) noexcept
+    {
+        jassert (history != nullptr || numChannels == 0); // you need to call prepare() first!
+
+        const auto period = getPhasePeriod (speedRatio);
+        auto pos = subSamplePos;
+        int numUsed = 0;
+        int phase = 0;
+
+        for (int i = 0; i < numOutputSamplesToProduce; ++i)
+        {
+            while (pos >= 1.0)
+            {
+                pushInterpolationFrame (inputs, inputStart + numUsed++);
+                pos -= 1.0;
+            }
+
+            calculateFrame (getWeights ((float) pos, phase));
+
+            if (++phase == period)
+                phase = 0;
+
+            if (isAdding)
+            {
+                for (int ch = 0; ch < numChannels; ++ch)
+                    outputs[ch][outputStart + i] += gain * frame[ch];
+            }
+            else
+            {
+                for (int ch = 0; ch < numChannels; ++ch)
+                    outputs[ch][outputStart + i] = frame[ch];
+            }
+
+            pos += speedRatio;
+        }
+
+        subSamplePos = pos;
+        return numUsed;
+    }
+
+    //==============================================================================
+    enum { numLanes = 4, maxNumCachedPhases = 16 };
+
+    HeapBlock<float> history, frame, weights;
+    float cachedOffsets[maxNumCachedPhases];
+    double subSamplePos = 1.0;
+    int numChannels = 0, stride = 0, writeIndex = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GenericMultichannelInterpolator)
+};
+
 } // namespace juce
@@ -174,6 +174,76 @@ private:
         }
     }
 
+    template <typename MultichannelType, typename InterpolatorType>
+    void runMultichannelTests (const String& interpolatorName)
+    {
+        constexpr int numChannels = 5;
+        constexpr int numInputSamples = 2000;
+
+        auto random = getRandom();
+        AudioBuffer<float> input (numChannels, numInputSamples);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < numInputSamples; ++i)
+                input.setSample (ch, i, random.nextFloat() * 2.0f - 1.0f);
+
+        for (auto speedRatio : { 0.5, 0.8263, 1.0, 1.5, 2.0 })
+        {
+            beginTest (interpolatorName + " multichannel matches single channel, ratio " + String (speedRatio));
+
+            constexpr int numBlocks = 4;
+            const auto blockSize = (int) ((numInputSamples - 10) / (numBlocks * speedRatio));
+
+            AudioBuffer<float> expected (numChannels, blockSize * numBlocks);
+            AudioBuffer<float> output (numChannels, blockSize * numBlocks);
+            constexpr float addingGain = 0.6f;
+
+            for (auto adding : { false, true })
+            {
+                MultichannelType multichannel (numChannels);
+                InterpolatorType singleChannel[numChannels];
+                int multichannelInputPos = 0;
+                int singleChannelInputPos = 0;
+
+                expected.clear();
+                output.clear();
+
+                for (int block = 0; block < numBlocks; ++block)
+                {
+                    int numUsed = 0;
+
+                    for (int ch = 0; ch < numChannels; ++ch)
+                    {
+                        auto* in = input.getReadPointer (ch, singleChannelInputPos);
+                        auto* out = expected.getWritePointer (ch, block * blockSize);
+
+                        numUsed = adding ? singleChannel[ch].processAdding (speedRatio, in, out, blockSize, addingGain)
+                                         : singleChannel[ch].process (speedRatio, in, out, blockSize);
+                    }
+
+                    singleChannelInputPos += numUsed;
+
+                    multichannelInputPos += adding ? multichannel.processAdding (speedRatio, input, multichannelInputPos,
+                                                                                 output, block * blockSize, blockSize, addingGain)
+                                                   : multichannel.process (speedRatio, input, multichannelInputPos,
+                                                                           output, block * blockSize, blockSize);
+
+                    expectEquals (multichannelInputPos, singleChannelInputPos);
+                }
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    auto maxError = 0.0f;
+
+                    for (int i = 0; i < output.getNumSamples(); ++i)
+                        maxError = jmax (maxError, std::abs (output.getSample (ch, i) - expected.getSample (ch, i)));
+
+                    expectLessThan (maxError, 1.0e-4f);
+                }
+            }
+        }
+    }
+
 public:
     void runTest() override
     {
@@ -181,6 +251,12 @@ public:
         runInterplatorTests<LagrangeInterpolator>     ("LagrangeInterpolator");
         runInterplatorTests<CatmullRomInterpolator>   ("CatmullRomInterpolator");
         runInterplatorTests<LinearInterpolator>       ("LinearInterpolator");
+
+        runMultichannelTests<Interpolators::MultichannelWindowedSinc,  WindowedSincInterpolator>  ("WindowedSincInterpolator");
+        runMultichannelTests<Interpolators::MultichannelLagrange,      LagrangeInterpolator>      ("LagrangeInterpolator");
+        runMultichannelTests<Interpolators::MultichannelCatmullRom,    CatmullRomInterpolator>    ("CatmullRomInterpolator");
+        runMultichannelTests<Interpolators::MultichannelLinear,        LinearInterpolator>        ("LinearInterpolator");
+        runMultichannelTests<Interpolators::MultichannelZeroOrderHold, ZeroOrderHoldInterpolator> ("ZeroOrderHoldInterpolator");
     }
 };
 
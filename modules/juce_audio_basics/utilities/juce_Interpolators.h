@@ -29,8 +29,12 @@ namespace juce
 /**
     A collection of different interpolators for resampling streams of floats.
 
-    @see GenericInterpolator, WindowedSincInterpolator, LagrangeInterpolator,
-         CatmullRomInterpolator, LinearInterpolator, ZeroOrderHoldInterpolator
+    The Multichannel variants resample all the channels of a buffer in a single
+    pass - see GenericMultichannelInterpolator.
+
+    @see GenericInterpolator, GenericMultichannelInterpolator, WindowedSincInterpolator,
+         LagrangeInterpolator, CatmullRomInterpolator, LinearInterpolator,
+         ZeroOrderHoldInterpolator
 
     @tags{Audio}
 */
@@ -91,6 +95,32 @@ private:
             return result;
         }
 
+        static forcedinline void weightsAtOffset (const float offset, float* const weights) noexcept
+        {
+            const int numCrossings = 100;
+            const float floatCrossings = (float) numCrossings;
+
+            for (int i = 0; i < numCrossings * 2; ++i)
+            {
+                auto sincPosition = (1.0f - offset) + (float) (i - numCrossings);
+
+                if (sincPosition == 0.0f)
+                {
+                    weights[i] = 1.0f;
+                }
+                else if (sincPosition < floatCrossings && sincPosition > -floatCrossings)
+                {
+                    auto indexFloat = (sincPosition >= 0.f ? sincPosition : -sincPosition) * 100.0f;
+                    auto indexFloored = std::floor (indexFloat);
+                    weights[i] = windowedSinc (indexFloat - indexFloored, jmin ((int) indexFloored, numCrossings * 100 - 1));
+                }
+                else
+                {
+                    weights[i] = 0.0f;
+                }
+            }
+        }
+
         static const float lookupTable[10001];
     };
 
@@ -99,6 +129,7 @@ private:
         static constexpr float algorithmicLatency = 2.0f;
 
         static float valueAtOffset (const float*, float, int) noexcept;
+        static void weightsAtOffset (float, float*) noexcept;
     };
 
     struct CatmullRomTraits
@@ -120,6 +151,17 @@ private:
                       + (offset * (((y0 + 2.0f * y2) - (halfY3 + 2.5f * y1))
                       + (offset * ((halfY3 + 1.5f * y1) - (halfY0 + 1.5f * y2))))));
         }
+
+        static forcedinline void weightsAtOffset (const float offset, float* const weights) noexcept
+        {
+            auto offset2 = offset * offset;
+            auto offset3 = offset2 * offset;
+
+            weights[0] = -0.5f * offset + offset2 - 0.5f * offset3;
+            weights[1] = 1.0f - 2.5f * offset2 + 1.5f * offset3;
+            weights[2] = 0.5f * offset + 2.0f * offset2 - 1.5f * offset3;
+            weights[3] = -0.5f * offset2 + 0.5f * offset3;
+        }
     };
 
     struct LinearTraits
@@ -133,6 +175,12 @@ private:
 
             return y1 * offset + y0 * (1.0f - offset);
         }
+
+        static forcedinline void weightsAtOffset (const float offset, float* const weights) noexcept
+        {
+            weights[0] = 1.0f - offset;
+            weights[1] = offset;
+        }
     };
 
     struct ZeroOrderHoldTraits
@@ -143,6 +191,11 @@ private:
         {
             return inputs[0];
         }
+
+        static forcedinline void weightsAtOffset (const float, float* const weights) noexcept
+        {
+            weights[0] = 1.0f;
+        }
     };
 
 public:
@@ -151,6 +204,12 @@ public:
     using CatmullRom    = GenericInterpolator<CatmullRomTraits,    4>;
     using Linear        = GenericInterpolator<LinearTraits,        2>;
     using ZeroOrderHold = GenericInterpolator<ZeroOrderHoldTraits, 1>;
+
+    using MultichannelWindowedSinc  = GenericMultichannelInterpolator<WindowedSincTraits,  200>;
+    using MultichannelLagrange      = GenericMultichannelInterpolator<LagrangeTraits,      5>;
+    using MultichannelCatmullRom    = GenericMultichannelInterpolator<CatmullRomTraits,    4>;
+    using MultichannelLinear        = GenericMultichannelInterpolator<LinearTraits,        2>;
+    using MultichannelZeroOrderHold = GenericMultichannelInterpolator<ZeroOrderHoldTraits, 1>;
 };
 
 //==============================================================================
@@ -59,4 +59,13 @@ float Interpolators::LagrangeTraits::valueAtOffset (const float* inputs, float o
     return result;
 }
 
+void Interpolators::LagrangeTraits::weightsAtOffset (float offset, float* weights) noexcept
+{
+    weights[0] = calcCoefficient<0> (1.0f, offset);
+    weights[1] = calcCoefficient<1> (1.0f, offset);
+    weights[2] = calcCoefficient<2> (1.0f, offset);
+    weights[3] = calcCoefficient<3> (1.0f, offset);
+    weights[4] = calcCoefficient<4> (1.0f, offset);
+}
+
 } // namespace juce
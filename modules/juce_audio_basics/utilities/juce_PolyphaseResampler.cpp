@@ -0,0 +1,507 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+namespace PolyphaseResamplerHelpers
+{
+    // The filter bank only gets rebuilt when the cutoff moves into a different one
+    // of these steps, so that smoothly varying ratios don't rebuild it on every block
+    constexpr double cutoffStepsPerOctave = 32.0;
+
+    constexpr int historyChunkSize = 2048;
+
+    struct QualitySettings
+    {
+        int numTaps, numPhases;
+        double kaiserBeta;
+    };
+
+    static QualitySettings getSettings (PolyphaseResampler::Quality quality) noexcept
+    {
+        switch (quality)
+        {
+            case PolyphaseResampler::Quality::fast:     return { 8,  64,  5.0 };
+            case PolyphaseResampler::Quality::high:     return { 32, 256, 8.0 };
+            case PolyphaseResampler::Quality::best:     return { 64, 512, 9.5 };
+            case PolyphaseResampler::Quality::standard:
+            default:                                    return { 16, 128, 6.5 };
+        }
+    }
+
+    // zeroth-order modified Bessel function of the first kind, used for the Kaiser window
+    static double besselI0 (double x) noexcept
+    {
+        double sum = 1.0, term = 1.0, halfX = x * 0.5;
+
+        for (int k = 1; k < 64 && term > sum * 1.0e-12; ++k)
+        {
+            auto t = halfX / k;
+            term *= t * t;
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    // NB: the number of taps is always a multiple of 8
+    static forcedinline float dotProduct (const float* a, const float* b, int num) noexcept
+    {
+       #if JUCE_USE_SSE_INTRINSICS
+        auto sum0 = _mm_setzero_ps();
+        auto sum1 = _mm_setzero_ps();
+
+        for (int i = 0; i < num; i += 8)
+        {
+            sum0 = _mm_add_ps (sum0, _mm_mul_ps (_mm_loadu_ps (a + i),     _mm_loadu_ps (b + i)));
+            sum1 = _mm_add_ps (sum1, _mm_mul_ps (_mm_loadu_ps (a + i + 4), _mm_loadu_ps (b + i + 4)));
+        }
+
+        auto sum = _mm_add_ps (sum0, sum1);
+        sum = _mm_add_ps (sum, _mm_movehl_ps (sum, sum));
+        sum = _mm_add_ss (sum, _mm_shuffle_ps (sum, sum, 1));
+        return _mm_cvtss_f32 (sum);
+       #elif JUCE_USE_ARM_NEON
+        auto sum0 = vdupq_n_f32 (0.0f);
+        auto sum1 = vdupq_n_f32 (0.0f);
+
+        for (int i = 0; i < num; i += 8)
+        {
+            sum0 = vmlaq_f32 (sum0, vld1q_f32 (a + i),     vld1q_f32 (b + i));
+            sum1 = vmlaq_f32 (sum1, vld1q_f32 (a + i + 4), vld1q_f32 (b + i + 4));
+        }
+
+        auto sum = vaddq_f32 (sum0, sum1);
+        auto pair = vadd_f32 (vget_low_f32 (sum), vget_high_f32 (sum));
+        return vget_lane_f32 (vpadd_f32 (pair, pair), 0);
+       #else
+        float sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+
+        for (int i = 0; i < num; i += 4)
+        {
+            sum0 += a[i]     * b[i];
+            sum1 += a[i + 1] * b[i + 1];
+            sum2 += a[i + 2] * b[i + 2];
+            sum3 += a[i + 3] * b[i + 3];
+        }
+
+        return (sum0 + sum1) + (sum2 + sum3);
+       #endif
+    }
+}
+
+//==============================================================================
+PolyphaseResampler::PolyphaseResampler() {}
+PolyphaseResampler::~PolyphaseResampler() {}
+
+void PolyphaseResampler::prepare (int numChannelsToUse, Quality qualityToUse)
+{
+    using namespace PolyphaseResamplerHelpers;
+
+    jassert (numChannelsToUse > 0);
+
+    auto settings = getSettings (qualityToUse);
+
+    numChannels = jmax (1, numChannelsToUse);
+    quality = qualityToUse;
+    numTaps = settings.numTaps;
+    numPhases = settings.numPhases;
+    kaiserBeta = settings.kaiserBeta;
+
+    auto numCoefficients = (size_t) ((numPhases + 1) * numTaps);
+    windowTable.malloc (numCoefficients);
+    filterBank.malloc (numCoefficients);
+    interpolatedFilter.calloc ((size_t) numTaps);
+
+    // The window only depends on each coefficient's distance from the centre of the
+    // filter, so it can be shared by every filter bank that gets built
+    auto halfTaps = numTaps / 2;
+    auto windowScale = 1.0 / besselI0 (kaiserBeta);
+
+    for (int phase = 0; phase <= numPhases; ++phase)
+    {
+        auto frac = phase / (double) numPhases;
+
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            auto x = (tap - (halfTaps - 1) - frac) / halfTaps;
+            windowTable[phase * numTaps + tap] = (float) (besselI0 (kaiserBeta * std::sqrt (jmax (0.0, 1.0 - x * x))) * windowScale);
+        }
+    }
+
+    history.setSize (numChannels, numTaps + historyChunkSize);
+
+    filterCutoff = 0;
+    updateFilterBank (1.0);
+    reset();
+}
+
+void PolyphaseResampler::reset() noexcept
+{
+    history.clear();
+    historyPos = numTaps;
+    subSamplePos = 1.0;
+}
+
+//==============================================================================
+void PolyphaseResampler::updateFilterBank (double maxSpeedRatio) noexcept
+{
+    using namespace PolyphaseResamplerHelpers;
+
+    // when down-sampling, the filter needs to remove everything above the new Nyquist frequency
+    auto cutoff = jmin (1.0, 1.0 / maxSpeedRatio);
+
+    if (cutoff < 1.0)
+        cutoff = std::exp2 (std::floor (std::log2 (cutoff) * cutoffStepsPerOctave) / cutoffStepsPerOctave);
+
+    if (cutoff == filterCutoff)
+        return;
+
+    filterCutoff = cutoff;
+    auto halfTaps = numTaps / 2;
+
+    for (int phase = 0; phase <= numPhases; ++phase)
+    {
+        auto frac = phase / (double) numPhases;
+        auto* filter = filterBank + phase * numTaps;
+        auto* window = windowTable + phase * numTaps;
+        double sum = 0;
+
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            auto x = MathConstants<double>::pi * cutoff * (tap - (halfTaps - 1) - frac);
+            auto value = window[tap] * (x == 0.0 ? 1.0 : std::sin (x) / x);
+
+            filter[tap] = (float) value;
+            sum += value;
+        }
+
+        // normalise each phase to unity gain at DC, so there's no ripple as the phase changes
+        auto scale = (float) (1.0 / sum);
+
+        for (int tap = 0; tap < numTaps; ++tap)
+            filter[tap] *= scale;
+    }
+}
+
+void PolyphaseResampler::pushSample (const float* const* inputChannels, int index) noexcept
+{
+    auto** channels = history.getArrayOfWritePointers();
+
+    if (historyPos == history.getNumSamples())
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            memmove (channels[channel], channels[channel] + historyPos - numTaps, (size_t) numTaps * sizeof (float));
+
+        historyPos = numTaps;
+    }
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        channels[channel][historyPos] = inputChannels[channel][index];
+
+    ++historyPos;
+}
+
+//==============================================================================
+int PolyphaseResampler::getNumInputSamplesNeeded (double speedRatio, int numOutputSamples) const noexcept
+{
+    return getNumInputSamplesNeeded (speedRatio, speedRatio, numOutputSamples);
+}
+
+int PolyphaseResampler::getNumInputSamplesNeeded (double startSpeedRatio, double endSpeedRatio, int numOutputSamples) const noexcept
+{
+    // This has to step through the positions in exactly the same way as process(),
+    // so that any rounding errors add up identically
+    auto ratioIncrement = numOutputSamples > 0 ? (endSpeedRatio - startSpeedRatio) / numOutputSamples : 0.0;
+    auto ratio = startSpeedRatio;
+    auto pos = subSamplePos;
+    int numUsed = 0;
+
+    for (int i = 0; i < numOutputSamples; ++i)
+    {
+        while (pos >= 1.0)
+        {
+            ++numUsed;
+            pos -= 1.0;
+        }
+
+        pos += ratio;
+        ratio += ratioIncrement;
+    }
+
+    return numUsed;
+}
+
+int PolyphaseResampler::process (double speedRatio, const float* const* inputChannels,
+                                 float* const* outputChannels, int numOutputSamples) noexcept
+{
+    return process (speedRatio, speedRatio, inputChannels, outputChannels, numOutputSamples);
+}
+
+int PolyphaseResampler::process (double startSpeedRatio, double endSpeedRatio,
+                                 const float* const* inputChannels,
+                                 float* const* outputChannels,
+                                 int numOutputSamples) noexcept
+{
+    jassert (numTaps > 0); // you need to call prepare() before using the resampler!
+    jassert (startSpeedRatio > 0 && endSpeedRatio > 0);
+
+    updateFilterBank (jmax (startSpeedRatio, endSpeedRatio));
+
+    auto ratioIncrement = numOutputSamples > 0 ? (endSpeedRatio - startSpeedRatio) / numOutputSamples : 0.0;
+    auto ratio = startSpeedRatio;
+    auto** channels = history.getArrayOfWritePointers();
+    int numUsed = 0;
+
+    for (int i = 0; i < numOutputSamples; ++i)
+    {
+        while (subSamplePos >= 1.0)
+        {
+            pushSample (inputChannels, numUsed++);
+            subSamplePos -= 1.0;
+        }
+
+        // blend the two nearest phases once, and then use the result for every channel
+        auto phase = subSamplePos * numPhases;
+        auto phaseIndex = jmin ((int) phase, numPhases - 1);
+        auto alpha = (float) (phase - phaseIndex);
+        auto* filter0 = filterBank + phaseIndex * numTaps;
+        auto* filter1 = filter0 + numTaps;
+
+        for (int tap = 0; tap < numTaps; ++tap)
+            interpolatedFilter[tap] = filter0[tap] + alpha * (filter1[tap] - filter0[tap]);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            if (auto* output = outputChannels[channel])
+                output[i] = PolyphaseResamplerHelpers::dotProduct (channels[channel] + historyPos - numTaps,
+                                                                   interpolatedFilter, numTaps);
+
+        subSamplePos += ratio;
+        ratio += ratioIncrement;
+    }
+
+    return numUsed;
+}
+
+
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class PolyphaseResamplerTests  : public UnitTest
+{
+public:
+    PolyphaseResamplerTests()
+        : UnitTest ("PolyphaseResampler", UnitTestCategories::audio)
+    {}
+
+    static AudioBuffer<float> makeNoise (int numChannels, int numSamples, Random& random)
+    {
+        AudioBuffer<float> buffer (numChannels, numSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                buffer.setSample (channel, i, random.nextFloat() * 2.0f - 1.0f);
+
+        return buffer;
+    }
+
+    static AudioBuffer<float> makeSine (double frequency, int numSamples)
+    {
+        AudioBuffer<float> buffer (1, numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+            buffer.setSample (0, i, (float) std::sin (MathConstants<double>::twoPi * frequency * i));
+
+        return buffer;
+    }
+
+    // resamples the whole of the input, in chunks of the given size
+    static AudioBuffer<float> resample (PolyphaseResampler& resampler, const AudioBuffer<float>& input,
+                                        double ratio, int numOutputSamples, int chunkSize)
+    {
+        AudioBuffer<float> output (input.getNumChannels(), numOutputSamples);
+        HeapBlock<const float*> inputs (input.getNumChannels());
+        HeapBlock<float*> outputs (input.getNumChannels());
+        int inputPos = 0;
+
+        for (int outputPos = 0; outputPos < numOutputSamples; outputPos += chunkSize)
+        {
+            auto numToDo = jmin (chunkSize, numOutputSamples - outputPos);
+            jassert (inputPos + resampler.getNumInputSamplesNeeded (ratio, numToDo) <= input.getNumSamples());
+
+            for (int channel = 0; channel < input.getNumChannels(); ++channel)
+            {
+                inputs[channel] = input.getReadPointer (channel, inputPos);
+                outputs[channel] = output.getWritePointer (channel, outputPos);
+            }
+
+            inputPos += resampler.process (ratio, inputs, outputs, numToDo);
+        }
+
+        return output;
+    }
+
+    // returns the peak error in decibels of a resampled sine wave, ignoring the start-up transient
+    static float getSineErrorDecibels (PolyphaseResampler::Quality quality, double frequency, double ratio)
+    {
+        PolyphaseResampler resampler;
+        resampler.prepare (1, quality);
+
+        const int numOutputSamples = 4000;
+        auto input = makeSine (frequency, (int) (numOutputSamples * ratio) + 256);
+        auto output = resample (resampler, input, ratio, numOutputSamples, 256);
+        auto latency = resampler.getLatencyInInputSamples();
+
+        float maxError = 0;
+
+        for (int i = 0; i < numOutputSamples; ++i)
+        {
+            auto inputTime = i * ratio - latency;
+
+            if (inputTime > 2 * resampler.getNumTaps())
+            {
+                auto expected = (float) std::sin (MathConstants<double>::twoPi * frequency * inputTime);
+                maxError = jmax (maxError, std::abs (output.getSample (0, i) - expected));
+            }
+        }
+
+        return Decibels::gainToDecibels (maxError);
+    }
+
+    void runTest() override
+    {
+        auto random = getRandom();
+        const PolyphaseResampler::Quality qualities[] = { PolyphaseResampler::Quality::fast,
+                                                          PolyphaseResampler::Quality::standard,
+                                                          PolyphaseResampler::Quality::high,
+                                                          PolyphaseResampler::Quality::best };
+
+        // the worst errors and aliasing allowed for each quality, in decibels
+        const float maxSineErrors[] = { -50.0f, -60.0f, -75.0f, -90.0f };
+        const float maxAliasing[]   = { -20.0f, -55.0f, -75.0f, -85.0f };
+
+        beginTest ("A ratio of 1 delays the input by the latency");
+        {
+            for (auto quality : qualities)
+            {
+                PolyphaseResampler resampler;
+                resampler.prepare (2, quality);
+
+                auto input = makeNoise (2, 1000, random);
+                auto output = resample (resampler, input, 1.0, 1000, 100);
+                auto latency = resampler.getLatencyInInputSamples();
+
+                for (int channel = 0; channel < 2; ++channel)
+                    for (int i = latency; i < 1000; ++i)
+                        expectWithinAbsoluteError (output.getSample (channel, i), input.getSample (channel, i - latency), 1.0e-6f);
+            }
+        }
+
+        beginTest ("The output doesn't depend on the block size");
+        {
+            for (auto ratio : { 0.73, 1.61 })
+            {
+                PolyphaseResampler resampler;
+                resampler.prepare (2, PolyphaseResampler::Quality::high);
+
+                auto input = makeNoise (2, 5000, random);
+                auto wholeBlock = resample (resampler, input, ratio, 2500, 2500);
+
+                resampler.reset();
+                auto smallBlocks = resample (resampler, input, ratio, 2500, 1 + random.nextInt (100));
+
+                for (int channel = 0; channel < 2; ++channel)
+                    for (int i = 0; i < 2500; ++i)
+                        expectEquals (smallBlocks.getSample (channel, i), wholeBlock.getSample (channel, i));
+            }
+        }
+
+        beginTest ("Sine waves are resampled accurately");
+        {
+            for (int i = 0; i < numElementsInArray (qualities); ++i)
+                for (auto ratio : { 44100.0 / 48000.0, 48000.0 / 44100.0, 0.5, 2.0 })
+                    expectLessThan (getSineErrorDecibels (qualities[i], 1000.0 / 44100.0, ratio), maxSineErrors[i]);
+        }
+
+        beginTest ("Down-sampling removes frequencies above the new Nyquist frequency");
+        {
+            for (int i = 0; i < numElementsInArray (qualities); ++i)
+            {
+                PolyphaseResampler resampler;
+                resampler.prepare (1, qualities[i]);
+
+                // a tone at 80% of the input's Nyquist frequency, which is well above the output's
+                auto input = makeSine (0.4, 8400);
+                auto output = resample (resampler, input, 2.0, 4000, 512);
+
+                expectLessThan (Decibels::gainToDecibels (output.getMagnitude (0, 500, 3500)), maxAliasing[i]);
+            }
+        }
+
+        beginTest ("Benchmark against ResamplingAudioSource");
+        {
+            auto input = makeNoise (2, 44100, random);
+            const int blockSize = 512, numBlocks = 200;
+            const double ratio = 44100.0 / 48000.0;
+
+            auto timeSource = [&] (AudioSource& source)
+            {
+                AudioBuffer<float> output (2, blockSize);
+                source.prepareToPlay (blockSize, 48000.0);
+
+                auto startTime = Time::getHighResolutionTicks();
+
+                for (int i = 0; i < numBlocks; ++i)
+                    source.getNextAudioBlock (AudioSourceChannelInfo (output));
+
+                auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTime);
+                source.releaseResources();
+
+                return seconds * 1.0e9 / (blockSize * numBlocks);
+            };
+
+            {
+                ResamplingAudioSource source (new MemoryAudioSource (input, false, true), true, 2);
+                source.setResamplingRatio (ratio);
+                logMessage ("ResamplingAudioSource: " + String (timeSource (source), 1) + " ns per stereo sample");
+            }
+
+            const char* const qualityNames[] = { "fast", "standard", "high", "best" };
+
+            for (int i = 0; i < numElementsInArray (qualities); ++i)
+            {
+                PolyphaseResamplingAudioSource source (new MemoryAudioSource (input, false, true), true, 2, qualities[i]);
+                source.setResamplingRatio (ratio);
+                logMessage ("PolyphaseResamplingAudioSource (" + String (qualityNames[i]) + "): "
+                              + String (timeSource (source), 1) + " ns per stereo sample");
+            }
+        }
+    }
+};
+
+static PolyphaseResamplerTests polyphaseResamplerTests;
+
+#endif
+
+} // namespace juce
@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+//==============================================================================
+/**
+    A band-limited resampler for streams of multichannel audio, using a bank of
+    windowed-sinc filters.
+
+    For each output sample, the resampler picks the two filters whose phases are
+    closest to the fractional read position, interpolates between them, and convolves
+    the result with the most recent input samples of every channel. The filter bank is
+    built for the current resampling ratio, so that when down-sampling its cutoff
+    follows the new Nyquist frequency; it only needs rebuilding when the ratio moves
+    far enough to change the cutoff noticeably, so the ratio can be changed smoothly
+    from one block to the next.
+
+    Unlike the interpolators, a single PolyphaseResampler handles all the channels of a
+    stream, sharing the filter calculations between them.
+
+    Like the other resamplers, this is stateful, so when there's a break in the continuity
+    of the input stream, call reset() before feeding it any new data.
+
+    @see PolyphaseResamplingAudioSource, WindowedSincInterpolator, LagrangeInterpolator
+
+    @tags{Audio}
+*/
+class JUCE_API  PolyphaseResampler
+{
+public:
+    //==============================================================================
+    /** The quality settings that can be passed to prepare().
+
+        Higher qualities use longer filters with a finer set of phases, which gives a
+        sharper cutoff and less aliasing, at the expense of CPU and latency.
+    */
+    enum class Quality
+    {
+        fast,       /**< 8 taps per output sample. */
+        standard,   /**< 16 taps per output sample. */
+        high,       /**< 32 taps per output sample. */
+        best        /**< 64 taps per output sample. */
+    };
+
+    //==============================================================================
+    /** Creates a resampler. You'll need to call prepare() before using it. */
+    PolyphaseResampler();
+
+    /** Destructor. */
+    ~PolyphaseResampler();
+
+    /** Allocates the resampler's filter bank and history for a number of channels,
+        and resets its state.
+    */
+    void prepare (int numChannels, Quality quality = Quality::standard);
+
+    /** Resets the state of the resampler.
+        Call this when there's a break in the continuity of the input data stream.
+    */
+    void reset() noexcept;
+
+    //==============================================================================
+    /** Returns the number of channels that the resampler was prepared for. */
+    int getNumChannels() const noexcept                     { return numChannels; }
+
+    /** Returns the quality that the resampler was prepared with. */
+    Quality getQuality() const noexcept                     { return quality; }
+
+    /** Returns the number of input samples that each output sample is calculated from. */
+    int getNumTaps() const noexcept                         { return numTaps; }
+
+    /** Returns the delay, in input samples, that the resampler adds to the stream. */
+    int getLatencyInInputSamples() const noexcept           { return numTaps / 2; }
+
+    //==============================================================================
+    /** Returns the exact number of input samples that a call to process() with the
+        same arguments will consume.
+    */
+    int getNumInputSamplesNeeded (double speedRatio, int numOutputSamples) const noexcept;
+
+    /** Returns the exact number of input samples that a call to process() with the
+        same arguments will consume.
+    */
+    int getNumInputSamplesNeeded (double startSpeedRatio, double endSpeedRatio, int numOutputSamples) const noexcept;
+
+    /** Resamples a block of every channel.
+
+        @param speedRatio           the number of input samples to use for each output sample
+        @param inputChannels        the source data to read from, one pointer for each channel. Each
+                                    channel must contain getNumInputSamplesNeeded() samples.
+        @param outputChannels       the buffers to write the results into, one for each channel. If any
+                                    of these are nullptr, that channel's input is still consumed, but
+                                    its output is discarded.
+        @param numOutputSamples     the number of output samples that should be created
+        @returns the number of input samples that were used
+    */
+    int process (double speedRatio,
+                 const float* const* inputChannels,
+                 float* const* outputChannels,
+                 int numOutputSamples) noexcept;
+
+    /** Resamples a block of every channel, with a speed ratio that changes linearly
+        from startSpeedRatio to endSpeedRatio over the course of the block.
+
+        @see process
+    */
+    int process (double startSpeedRatio,
+                 double endSpeedRatio,
+                 const float* const* inputChannels,
+                 float* const* outputChannels,
+                 int numOutputSamples) noexcept;
+
+private:
+    //==============================================================================
+    Quality quality = Quality::standard;
+    int numChannels = 0, numTaps = 0, numPhases = 0;
+    double kaiserBeta = 0;
+
+    HeapBlock<float> windowTable, filterBank, interpolatedFilter;
+    double filterCutoff = 0;
+
+    AudioBuffer<float> history;
+    int historyPos = 0;
+    double subSamplePos = 1.0;
+
+    void updateFilterBank (double maxSpeedRatio) noexcept;
+    void pushSample (const float* const* inputChannels, int index) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PolyphaseResampler)
+};
+
+} // namespace juce
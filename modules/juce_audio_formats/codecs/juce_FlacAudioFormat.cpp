@@ -171,10 +171,13 @@ static const char* const flacFormatName = "FLAC file";
 class FlacReader  : public AudioFormatReader
 {
 public:
-    FlacReader (InputStream* in)  : AudioFormatReader (in, flacFormatName)
+    FlacReader (InputStream* in, const File& cacheDirectory)
+        : AudioFormatReader (in, flacFormatName),
+          seekIndexCacheDirectory (cacheDirectory)
     {
         lengthInSamples = 0;
         decoder = FlacNamespace::FLAC__stream_decoder_new();
+        FLAC__stream_decoder_set_metadata_respond (decoder, FlacNamespace::FLAC__METADATA_TYPE_SEEKTABLE);
 
         ok = FLAC__stream_decoder_init_stream (decoder,
                                                readCallback_, seekCallback_, tellCallback_, lengthCallback_,
@@ -198,6 +201,11 @@ public:
                 FLAC__stream_decoder_process_until_end_of_metadata (decoder);
                 lengthInSamples = tempLength;
             }
+
+            FlacNamespace::FLAC__uint64 position = 0;
+
+            if (FLAC__stream_decoder_get_decode_position (decoder, &position))
+                firstFramePosition = (int64) position;
         }
     }
 
@@ -212,8 +220,10 @@ public:
         bitsPerSample = info.bits_per_sample;
         lengthInSamples = (unsigned int) info.total_samples;
         numChannels = info.channels;
+        fixedBlockSize = info.min_blocksize == info.max_blocksize ? info.min_blocksize : 0;
 
         reservoir.setSize ((int) numChannels, 2 * (int) info.max_blocksize, false, false, true);
+        previousFrame.setSize ((int) numChannels, 2 * (int) info.max_blocksize, false, false, true);
     }
 
     // returns the number of samples read
@@ -225,18 +235,28 @@ public:
 
         while (numSamples > 0)
         {
-            if (startSampleInFile >= reservoirStart
-                 && startSampleInFile < reservoirStart + samplesInReservoir)
+            auto inReservoir = startSampleInFile >= reservoirStart
+                                && startSampleInFile < reservoirStart + samplesInReservoir;
+
+            // the previously-decoded frame is kept so that reading back across a frame boundary is cheap
+            auto inPreviousFrame = ! inReservoir
+                                    && startSampleInFile >= previousFrameStart
+                                    && startSampleInFile < previousFrameStart + samplesInPreviousFrame;
+
+            if (inReservoir || inPreviousFrame)
             {
-                auto num = (int) jmin ((int64) numSamples,
-                                       reservoirStart + samplesInReservoir - startSampleInFile);
+                auto& frame = inReservoir ? reservoir : previousFrame;
+                auto frameStart = inReservoir ? reservoirStart : previousFrameStart;
+                auto frameLength = inReservoir ? samplesInReservoir : samplesInPreviousFrame;
+
+                auto num = (int) jmin ((int64) numSamples, frameStart + frameLength - startSampleInFile);
 
                 jassert (num > 0);
 
-                for (int i = jmin (numDestChannels, reservoir.getNumChannels()); --i >= 0;)
+                for (int i = jmin (numDestChannels, frame.getNumChannels()); --i >= 0;)
                     if (destSamples[i] != nullptr)
                         memcpy (destSamples[i] + startOffsetInDestBuffer,
-                                reservoir.getReadPointer (i, (int) (startSampleInFile - reservoirStart)),
+                                frame.getReadPointer (i, (int) (startSampleInFile - frameStart)),
                                 (size_t) num * sizeof (int));
 
                 startOffsetInDestBuffer += num;
@@ -252,17 +272,22 @@ public:
                 else if (startSampleInFile < reservoirStart
                           || startSampleInFile > reservoirStart + jmax (samplesInReservoir, 511))
                 {
-                    // had some problems with flac crashing if the read pos is aligned more
-                    // accurately than this. Probably fixed in newer versions of the library, though.
-                    reservoirStart = (int) (startSampleInFile & ~511);
-                    samplesInReservoir = 0;
-                    FLAC__stream_decoder_seek_absolute (decoder, (FlacNamespace::FLAC__uint64) reservoirStart);
+                    if (! seekToFrameContaining (startSampleInFile))
+                    {
+                        // had some problems with flac crashing if the read pos is aligned more
+                        // accurately than this. Probably fixed in newer versions of the library, though.
+                        reservoirStart = startSampleInFile & ~511;
+                        samplesInReservoir = 0;
+                        FLAC__stream_decoder_seek_absolute (decoder, (FlacNamespace::FLAC__uint64) reservoirStart);
+                    }
                 }
                 else
                 {
-                    reservoirStart += samplesInReservoir;
-                    samplesInReservoir = 0;
+                    auto numFramesBefore = numFramesDecoded;
                     FLAC__stream_decoder_process_single (decoder);
+
+                    if (numFramesDecoded == numFramesBefore)
+                        samplesInReservoir = 0;
                 }
 
                 if (samplesInReservoir == 0)
@@ -280,7 +305,7 @@ public:
         return true;
     }
 
-    void useSamples (const FlacNamespace::FLAC__int32* const buffer[], int numSamples)
+    void useSamples (const FlacNamespace::FLAC__int32* const buffer[], int numSamples, int64 firstSample)
     {
         if (scanningForLength)
         {
@@ -288,6 +313,12 @@ public:
         }
         else
         {
+            std::swap (reservoir, previousFrame);
+            previousFrameStart = reservoirStart;
+            samplesInPreviousFrame = samplesInReservoir;
+            reservoirStart = firstSample;
+            ++numFramesDecoded;
+
             if (numSamples > reservoir.getNumSamples())
                 reservoir.setSize ((int) numChannels, numSamples, false, false, true);
 
@@ -314,6 +345,29 @@ public:
         }
     }
 
+    void useSeekTable (const FlacNamespace::FLAC__StreamMetadata_SeekTable& table)
+    {
+        seekTable.clear();
+
+        for (unsigned int i = 0; i < table.num_points; ++i)
+        {
+            auto& point = table.points[i];
+
+            if (point.sample_number == FlacNamespace::FLAC__STREAM_METADATA_SEEKPOINT_PLACEHOLDER
+                 || point.frame_samples == 0)
+                continue;
+
+            // the points have to be in order, so a table that isn't can't be trusted
+            if (! seekTable.isEmpty() && (int64) point.sample_number <= seekTable.getLast().sampleNumber)
+            {
+                seekTable.clear();
+                return;
+            }
+
+            seekTable.add ({ (int64) point.sample_number, (int64) point.stream_offset });
+        }
+    }
+
     //==============================================================================
     static FlacNamespace::FLAC__StreamDecoderReadStatus readCallback_ (const FlacNamespace::FLAC__StreamDecoder*, FlacNamespace::FLAC__byte buffer[], size_t* bytes, void* client_data)
     {
@@ -349,7 +403,8 @@ public:
                                                                          const FlacNamespace::FLAC__int32* const buffer[],
                                                                          void* client_data)
     {
-        static_cast<FlacReader*> (client_data)->useSamples (buffer, (int) frame->header.blocksize);
+        static_cast<FlacReader*> (client_data)->useSamples (buffer, (int) frame->header.blocksize,
+                                                            (int64) frame->header.number.sample_number);
         return FlacNamespace::FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
     }
 
@@ -357,7 +412,12 @@ public:
                                    const FlacNamespace::FLAC__StreamMetadata* metadata,
                                    void* client_data)
     {
-        static_cast<FlacReader*> (client_data)->useMetadata (metadata->data.stream_info);
+        auto* reader = static_cast<FlacReader*> (client_data);
+
+        if (metadata->type == FlacNamespace::FLAC__METADATA_TYPE_STREAMINFO)
+            reader->useMetadata (metadata->data.stream_info);
+        else if (metadata->type == FlacNamespace::FLAC__METADATA_TYPE_SEEKTABLE)
+            reader->useSeekTable (metadata->data.seek_table);
     }
 
     static void errorCallback_ (const FlacNamespace::FLAC__StreamDecoder*, FlacNamespace::FLAC__StreamDecoderErrorStatus, void*)
@@ -365,15 +425,291 @@ public:
     }
 
 private:
+    //==============================================================================
+    // This is only done when the reader first has to jump somewhere, so that opening a
+    // file or reading it from start to end never pays for it.
+    void createSeekIndex()
+    {
+        seekIndexCreated = true;
+
+        if (lengthInSamples <= 0 || firstFramePosition <= 0)
+            return;
+
+        auto* fileStream = dynamic_cast<FileInputStream*> (input);
+        auto sourceFile = fileStream != nullptr ? fileStream->getFile() : File();
+        auto useCache = seekIndexCacheDirectory != File() && sourceFile != File();
+
+        if (useCache && seekIndex.loadFromCache (seekIndexCacheDirectory, sourceFile))
+            return;
+
+        // if the encoder wrote a seek table, that's good enough to avoid scanning the stream
+        if (! seekTable.isEmpty())
+        {
+            for (auto& point : seekTable)
+                seekIndex.add (point.sampleNumber, firstFramePosition + point.byteOffset);
+
+            return;
+        }
+
+        auto oldPosition = input->getPosition();
+        scanFrames (firstFramePosition);
+        input->setPosition (oldPosition);
+
+        if (useCache)
+            seekIndex.saveToCache (seekIndexCacheDirectory, sourceFile);
+    }
+
+    // Frames don't say how long they are, so this hunts for each one's sync code. A header is
+    // only accepted if it carries on from where the previous frame ended, and the CRC-16 of
+    // everything since the previous header checks out, which means that the previous frame
+    // really did end there, rather than a sync code having turned up in the middle of it.
+    void scanFrames (int64 position)
+    {
+        const int bufferSize = 65536, maxHeaderSize = 16, crcSize = 2;
+        HeapBlock<uint8> buffer (bufferSize);
+        int64 frameStart = -1, frameOffset = 0, nextSample = 0;
+        int frameHeaderSize = 0;
+        unsigned int crc = 0;
+
+        input->setPosition (position);
+
+        for (;;)
+        {
+            auto numRead = input->read (buffer, bufferSize);
+            auto numToSearch = numRead < bufferSize ? numRead : numRead - maxHeaderSize;
+
+            if (numToSearch <= 0)
+                break;
+
+            for (int i = 0; i < numToSearch; ++i)
+            {
+                auto offset = position + i;
+
+                if (frameStart < 0 || (crc == 0 && offset >= frameOffset + frameHeaderSize + crcSize))
+                {
+                    int64 headerStart;
+                    int blockSize, headerSize;
+
+                    if (parseFrameHeader (buffer + i, numRead - i, headerStart, blockSize, headerSize)
+                         && headerStart == nextSample)
+                    {
+                        if (frameStart >= 0)
+                            seekIndex.add (frameStart, frameOffset);
+
+                        frameStart = headerStart;
+                        frameOffset = offset;
+                        frameHeaderSize = headerSize;
+                        nextSample = headerStart + blockSize;
+                        crc = 0;
+                    }
+                }
+
+                crc = ((crc << 8) ^ FlacNamespace::FLAC__crc16_table[(crc >> 8) ^ buffer[i]]) & 0xffff;
+
+                // there's no header after the last frame, so it has to end where its CRC checks out
+                if (frameStart >= 0 && nextSample >= lengthInSamples
+                     && crc == 0 && offset + 1 >= frameOffset + frameHeaderSize + crcSize)
+                {
+                    seekIndex.add (frameStart, frameOffset);
+                    return;
+                }
+            }
+
+            position += numToSearch;
+            input->setPosition (position);
+        }
+
+        // an index that doesn't cover the whole stream can't be trusted
+        seekIndex.clear();
+    }
+
+    bool parseFrameHeader (const uint8* data, int numBytes, int64& frameStart, int& blockSize, int& headerSize) const noexcept
+    {
+        if (numBytes < 6 || data[0] != 0xff || (data[1] & 0xfe) != 0xf8)
+            return false;
+
+        auto blockSizeCode = data[2] >> 4;
+        auto sampleRateCode = data[2] & 0x0f;
+        auto sampleSizeCode = (data[3] >> 1) & 0x07;
+
+        if (blockSizeCode == 0 || sampleRateCode == 15 || (data[3] >> 4) > 10
+             || sampleSizeCode == 3 || sampleSizeCode == 7 || (data[3] & 1) != 0)
+            return false;
+
+        // the frame or sample number is stored using the same variable-length scheme as UTF-8
+        auto numLeadingOnes = countLeadingOnes (data[4]);
+
+        if (numLeadingOnes == 1 || numLeadingOnes > 7)
+            return false;
+
+        auto numberLength = jmax (1, numLeadingOnes);
+        auto number = (uint64) (data[4] & (0x7f >> numLeadingOnes));
+        int pos = 5;
+
+        for (int i = 1; i < numberLength; ++i, ++pos)
+        {
+            if (pos >= numBytes || (data[pos] & 0xc0) != 0x80)
+                return false;
+
+            number = (number << 6) | (uint64) (data[pos] & 0x3f);
+        }
+
+        if (pos + 2 >= numBytes)
+            return false;
+
+        if      (blockSizeCode == 1)  blockSize = 192;
+        else if (blockSizeCode <= 5)  blockSize = 576 << (blockSizeCode - 2);
+        else if (blockSizeCode == 6)  blockSize = data[pos] + 1;
+        else if (blockSizeCode == 7)  blockSize = ((data[pos] << 8) | data[pos + 1]) + 1;
+        else                          blockSize = 256 << (blockSizeCode - 8);
+
+        pos += (blockSizeCode == 6 ? 1 : (blockSizeCode == 7 ? 2 : 0))
+             + (sampleRateCode == 12 ? 1 : ((sampleRateCode == 13 || sampleRateCode == 14) ? 2 : 0));
+
+        if (pos >= numBytes || calculateCRC8 (data, pos) != data[pos])
+            return false;
+
+        auto isVariableBlockSize = (data[1] & 1) != 0;
+
+        if (! isVariableBlockSize && fixedBlockSize == 0)
+            return false;
+
+        frameStart = (int64) (isVariableBlockSize ? number : number * fixedBlockSize);
+        headerSize = pos + 1;
+        return true;
+    }
+
+    static int countLeadingOnes (uint8 byte) noexcept
+    {
+        int n = 0;
+
+        while (n < 8 && (byte & (0x80 >> n)) != 0)
+            ++n;
+
+        return n;
+    }
+
+    static uint8 calculateCRC8 (const uint8* data, int numBytes) noexcept
+    {
+        uint8 crc = 0;
+
+        while (--numBytes >= 0)
+        {
+            crc ^= *data++;
+
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (uint8) ((crc & 0x80) != 0 ? ((crc << 1) ^ 0x07) : (crc << 1));
+        }
+
+        return crc;
+    }
+
+    bool seekToFrameContaining (int64 sample)
+    {
+        if (! seekIndexCreated)
+            createSeekIndex();
+
+        auto index = seekIndex.findEntryFor (sample);
+
+        if (index < 0)
+            return false;
+
+        // after a flush, the decoder just looks for the next frame sync, so it can be
+        // restarted at any frame boundary by moving the stream there
+        FLAC__stream_decoder_flush (decoder);
+        input->setPosition (seekIndex.getEntry (index).byteOffset);
+
+        // a seek table may only have a point every few seconds, so this may need to
+        // decode a few frames to get to the one that's wanted
+        for (;;)
+        {
+            auto numFramesBefore = numFramesDecoded;
+            FLAC__stream_decoder_process_single (decoder);
+
+            if (numFramesDecoded == numFramesBefore || sample < reservoirStart)
+                return false;
+
+            if (sample < reservoirStart + samplesInReservoir)
+                return true;
+        }
+    }
+
+    //==============================================================================
     FlacNamespace::FLAC__StreamDecoder* decoder;
-    AudioBuffer<float> reservoir;
-    int reservoirStart = 0, samplesInReservoir = 0;
-    bool ok = false, scanningForLength = false;
+    AudioBuffer<float> reservoir, previousFrame;
+    int64 reservoirStart = 0, previousFrameStart = 0;
+    int samplesInReservoir = 0, samplesInPreviousFrame = 0;
+    uint32 numFramesDecoded = 0;
+    AudioFormatSeekIndex seekIndex;
+    Array<AudioFormatSeekIndex::Entry> seekTable;   // the offsets are relative to the first frame
+    const File seekIndexCacheDirectory;
+    int64 firstFramePosition = 0;
+    uint32 fixedBlockSize = 0;
+    bool ok = false, scanningForLength = false, seekIndexCreated = false;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FlacReader)
 };
 
 
+//==============================================================================
+static void configureFlacEncoder (FlacNamespace::FLAC__StreamEncoder* encoder, double sampleRate,
+                                  unsigned int numChannels, unsigned int bitsPerSample, int qualityOptionIndex)
+{
+    if (qualityOptionIndex > 0)
+        FLAC__stream_encoder_set_compression_level (encoder, (uint32) jmin (8, qualityOptionIndex));
+
+    FLAC__stream_encoder_set_do_mid_side_stereo (encoder, numChannels == 2);
+    FLAC__stream_encoder_set_loose_mid_side_stereo (encoder, numChannels == 2);
+    FLAC__stream_encoder_set_channels (encoder, numChannels);
+    FLAC__stream_encoder_set_bits_per_sample (encoder, jmin ((unsigned int) 24, bitsPerSample));
+    FLAC__stream_encoder_set_sample_rate (encoder, (unsigned int) sampleRate);
+    FLAC__stream_encoder_set_blocksize (encoder, 0);
+    FLAC__stream_encoder_set_do_escape_coding (encoder, true);
+}
+
+static void packUint32 (FlacNamespace::FLAC__uint32 val, FlacNamespace::FLAC__byte* b, const int bytes)
+{
+    b += bytes;
+
+    for (int i = 0; i < bytes; ++i)
+    {
+        *(--b) = (FlacNamespace::FLAC__byte) (val & 0xff);
+        val >>= 8;
+    }
+}
+
+// Overwrites the STREAMINFO block of a stream that began at streamStartPos
+static void writeFlacStreamInfo (OutputStream& output, int64 streamStartPos,
+                                 const FlacNamespace::FLAC__StreamMetadata_StreamInfo& info)
+{
+    using namespace FlacNamespace;
+
+    unsigned char buffer[FLAC__STREAM_METADATA_STREAMINFO_LENGTH];
+    const unsigned int channelsMinus1 = info.channels - 1;
+    const unsigned int bitsMinus1 = info.bits_per_sample - 1;
+
+    packUint32 (info.min_blocksize, buffer, 2);
+    packUint32 (info.max_blocksize, buffer + 2, 2);
+    packUint32 (info.min_framesize, buffer + 4, 3);
+    packUint32 (info.max_framesize, buffer + 7, 3);
+    buffer[10] = (uint8) ((info.sample_rate >> 12) & 0xff);
+    buffer[11] = (uint8) ((info.sample_rate >> 4) & 0xff);
+    buffer[12] = (uint8) (((info.sample_rate & 0x0f) << 4) | (channelsMinus1 << 1) | (bitsMinus1 >> 4));
+    buffer[13] = (FLAC__byte) (((bitsMinus1 & 0x0f) << 4) | (unsigned int) ((info.total_samples >> 32) & 0x0f));
+    packUint32 ((FLAC__uint32) info.total_samples, buffer + 14, 4);
+    memcpy (buffer + 18, info.md5sum, 16);
+
+    const bool seekOk = output.setPosition (streamStartPos + 4);
+    ignoreUnused (seekOk);
+
+    // if this fails, you've given it an output stream that can't seek! It needs
+    // to be able to seek back to write the header
+    jassert (seekOk);
+
+    output.writeIntBigEndian (FLAC__STREAM_METADATA_STREAMINFO_LENGTH);
+    output.write (buffer, FLAC__STREAM_METADATA_STREAMINFO_LENGTH);
+}
+
 //==============================================================================
 class FlacWriter  : public AudioFormatWriter
 {
@@ -383,17 +719,7 @@ public:
           streamStartPos (output != nullptr ? jmax (output->getPosition(), 0ll) : 0ll)
     {
         encoder = FlacNamespace::FLAC__stream_encoder_new();
-
-        if (qualityOptionIndex > 0)
-            FLAC__stream_encoder_set_compression_level (encoder, (uint32) jmin (8, qualityOptionIndex));
-
-        FLAC__stream_encoder_set_do_mid_side_stereo (encoder, numChannels == 2);
-        FLAC__stream_encoder_set_loose_mid_side_stereo (encoder, numChannels == 2);
-        FLAC__stream_encoder_set_channels (encoder, numChannels);
-        FLAC__stream_encoder_set_bits_per_sample (encoder, jmin ((unsigned int) 24, bitsPerSample));
-        FLAC__stream_encoder_set_sample_rate (encoder, (unsigned int) sampleRate);
-        FLAC__stream_encoder_set_blocksize (encoder, 0);
-        FLAC__stream_encoder_set_do_escape_coding (encoder, true);
+        configureFlacEncoder (encoder, sampleRate, numChannels, bitsPerSample, qualityOptionIndex);
 
         ok = FLAC__stream_encoder_init_stream (encoder,
                                                encodeWriteCallback, encodeSeekCallback,
@@ -455,46 +781,9 @@ public:
         return output->write (data, (size_t) size);
     }
 
-    static void packUint32 (FlacNamespace::FLAC__uint32 val, FlacNamespace::FLAC__byte* b, const int bytes)
-    {
-        b += bytes;
-
-        for (int i = 0; i < bytes; ++i)
-        {
-            *(--b) = (FlacNamespace::FLAC__byte) (val & 0xff);
-            val >>= 8;
-        }
-    }
-
     void writeMetaData (const FlacNamespace::FLAC__StreamMetadata* metadata)
     {
-        using namespace FlacNamespace;
-        auto& info = metadata->data.stream_info;
-
-        unsigned char buffer[FLAC__STREAM_METADATA_STREAMINFO_LENGTH];
-        const unsigned int channelsMinus1 = info.channels - 1;
-        const unsigned int bitsMinus1 = info.bits_per_sample - 1;
-
-        packUint32 (info.min_blocksize, buffer, 2);
-        packUint32 (info.max_blocksize, buffer + 2, 2);
-        packUint32 (info.min_framesize, buffer + 4, 3);
-        packUint32 (info.max_framesize, buffer + 7, 3);
-        buffer[10] = (uint8) ((info.sample_rate >> 12) & 0xff);
-        buffer[11] = (uint8) ((info.sample_rate >> 4) & 0xff);
-        buffer[12] = (uint8) (((info.sample_rate & 0x0f) << 4) | (channelsMinus1 << 1) | (bitsMinus1 >> 4));
-        buffer[13] = (FLAC__byte) (((bitsMinus1 & 0x0f) << 4) | (unsigned int) ((info.total_samples >> 32) & 0x0f));
-        packUint32 ((FLAC__uint32) info.total_samples, buffer + 14, 4);
-        memcpy (buffer + 18, info.md5sum, 16);
-
-        const bool seekOk = output->setPosition (streamStartPos + 4);
-        ignoreUnused (seekOk);
-
-        // if this fails, you've given it an output stream that can't seek! It needs
-        // to be able to seek back to write the header
-        jassert (seekOk);
-
-        output->writeIntBigEndian (FLAC__STREAM_METADATA_STREAMINFO_LENGTH);
-        output->write (buffer, FLAC__STREAM_METADATA_STREAMINFO_LENGTH);
+        writeFlacStreamInfo (*output, streamStartPos, metadata->data.stream_info);
     }
 
     //==============================================================================
@@ -539,6 +828,367 @@ private:
 };
 
 
+#if JUCE_INCLUDE_FLAC_CODE || ! defined (JUCE_INCLUDE_FLAC_CODE)
+
+//==============================================================================
+/*  Splits the incoming audio into runs of whole blocks and encodes each run on a
+    ThreadPool with its own libFLAC encoder, then writes the frames out in order.
+
+    Every encoder numbers its frames from zero, so each frame header gets renumbered
+    (and its CRCs recalculated) before it's written. The MD5 signature covers the whole
+    stream, so that's accumulated here rather than by the encoders. This relies on
+    libFLAC internals, so it's only available when the bundled FLAC code is used.
+*/
+class ParallelFlacWriter  : public AudioFormatWriter
+{
+public:
+    ParallelFlacWriter (OutputStream* out, double rate, uint32 numChans, uint32 bits,
+                        int quality, std::shared_ptr<ThreadPool> poolToUse)
+        : AudioFormatWriter (out, flacFormatName, rate, numChans, bits),
+          qualityOptionIndex (quality),
+          pool (std::move (poolToUse)),
+          maxJobsInFlight ((size_t) (2 * pool->getNumThreads())),
+          streamStartPos (output != nullptr ? jmax (output->getPosition(), 0ll) : 0ll)
+    {
+        using namespace FlacNamespace;
+
+        // The stream header comes from an encoder that never gets given any audio. Its
+        // STREAMINFO is overwritten with the real values when the writer is deleted.
+        auto* headerEncoder = FLAC__stream_encoder_new();
+        configureFlacEncoder (headerEncoder, sampleRate, numChannels, bitsPerSample, qualityOptionIndex);
+
+        // this is the same choice libFLAC makes when it's left to pick the block size itself
+        blockSize = FLAC__stream_encoder_get_max_lpc_order (headerEncoder) == 0 ? 1152u : 4096u;
+        samplesPerJob = (int) blockSize * blocksPerJob;
+        configureEncoder (headerEncoder);
+
+        ok = FLAC__stream_encoder_init_stream (headerEncoder, headerWriteCallback, nullptr, nullptr, nullptr, this)
+               == FLAC__STREAM_ENCODER_INIT_STATUS_OK;
+
+        FLAC__stream_encoder_delete (headerEncoder);
+
+        FLAC__MD5Init (&md5);
+        pending.resize (numChannels * (size_t) samplesPerJob);
+    }
+
+    ~ParallelFlacWriter() override
+    {
+        using namespace FlacNamespace;
+
+        if (ok && ! failed && numPending > 0)
+            startJob();
+
+        writeFinishedJobs (true);
+
+        FLAC__StreamMetadata_StreamInfo info;
+        zerostruct (info);
+        FLAC__MD5Final (info.md5sum, &md5);
+
+        if (ok)
+        {
+            if (! failed)
+            {
+                info.min_blocksize = info.max_blocksize = blockSize;
+                info.min_framesize = numFramesWritten > 0 ? minFrameSize : 0;
+                info.max_framesize = maxFrameSize;
+                info.sample_rate = (unsigned int) sampleRate;
+                info.channels = numChannels;
+                info.bits_per_sample = jmin ((unsigned int) 24, bitsPerSample);
+                info.total_samples = (FLAC__uint64) totalSamples;
+
+                writeFlacStreamInfo (*output, streamStartPos, info);
+            }
+
+            output->flush();
+        }
+        else
+        {
+            output = nullptr; // to stop the base class deleting this, as it needs to be returned
+                              // to the caller of createWriter()
+        }
+    }
+
+    //==============================================================================
+    bool write (const int** samplesToWrite, int numSamples) override
+    {
+        if (! ok || failed)
+            return false;
+
+        auto bitsToShift = 32 - (int) bitsPerSample;
+
+        for (int done = 0; done < numSamples;)
+        {
+            auto num = jmin (numSamples - done, samplesPerJob - numPending);
+            bool reachedLastChannel = false;
+
+            for (unsigned int i = 0; i < numChannels; ++i)
+            {
+                auto* dest = pending.data() + i * (size_t) samplesPerJob + numPending;
+                reachedLastChannel = reachedLastChannel || samplesToWrite[i] == nullptr;
+
+                if (reachedLastChannel)
+                {
+                    zeromem (dest, (size_t) num * sizeof (*dest));
+                }
+                else
+                {
+                    auto* src = samplesToWrite[i] + done;
+
+                    for (int j = 0; j < num; ++j)
+                        dest[j] = (src[j] >> bitsToShift);
+                }
+            }
+
+            done += num;
+            numPending += num;
+
+            if (numPending == samplesPerJob && ! startJob())
+                return false;
+        }
+
+        return true;
+    }
+
+private:
+    //==============================================================================
+    struct EncodeJob  : public ThreadPoolJob
+    {
+        EncodeJob (const ParallelFlacWriter& w, std::vector<FlacNamespace::FLAC__int32>&& samplesToEncode,
+                   int numSamplesToEncode, uint32 firstFrameNumber)
+            : ThreadPoolJob ("FLAC encoder"),
+              owner (w),
+              samples (std::move (samplesToEncode)),
+              numSamples (numSamplesToEncode),
+              nextFrameNumber (firstFrameNumber)
+        {
+        }
+
+        JobStatus runJob() override
+        {
+            using namespace FlacNamespace;
+
+            auto* encoder = FLAC__stream_encoder_new();
+            owner.configureEncoder (encoder);
+
+            succeeded = FLAC__stream_encoder_init_stream (encoder, frameWriteCallback, nullptr, nullptr, nullptr, this)
+                          == FLAC__STREAM_ENCODER_INIT_STATUS_OK;
+
+            if (succeeded)
+            {
+                const FLAC__int32* channels[FLAC__MAX_CHANNELS] = {};
+
+                for (unsigned int i = 0; i < owner.numChannels; ++i)
+                    channels[i] = samples.data() + i * (size_t) owner.samplesPerJob;
+
+                succeeded = FLAC__stream_encoder_process (encoder, channels, (unsigned int) numSamples) != 0;
+                succeeded = FLAC__stream_encoder_finish (encoder) != 0 && succeeded;
+            }
+
+            FLAC__stream_encoder_delete (encoder);
+            samples = {};
+
+            return jobHasFinished;
+        }
+
+        // Rewrites the frame number in the header, which is followed by some optional
+        // blocksize and sample rate bytes and then a CRC-8. The frame ends with a CRC-16.
+        bool addFrame (const uint8* frame, size_t size)
+        {
+            if (size < 8)
+                return false;
+
+            auto oldNumberSize = getUTF8Length (frame[4]);
+            auto blockSizeCode = frame[2] >> 4;
+            auto sampleRateCode = frame[2] & 0x0f;
+            auto numExtraBytes = (blockSizeCode == 6 ? 1 : (blockSizeCode == 7 ? 2 : 0))
+                               + (sampleRateCode == 12 ? 1 : ((sampleRateCode == 13 || sampleRateCode == 14) ? 2 : 0));
+            auto oldHeaderSize = (size_t) (4 + oldNumberSize + numExtraBytes + 1);
+
+            if (size < oldHeaderSize + 2)
+                return false;
+
+            uint8 header[16];
+            memcpy (header, frame, 4);
+            auto headerSize = 4 + writeUTF8 (header + 4, nextFrameNumber++);
+            memcpy (header + headerSize, frame + 4 + oldNumberSize, (size_t) numExtraBytes);
+            headerSize += numExtraBytes;
+            header[headerSize] = FlacNamespace::FLAC__crc8 (header, (unsigned int) headerSize);
+            ++headerSize;
+
+            auto frameStart = encoded.getDataSize();
+            encoded.write (header, (size_t) headerSize);
+            encoded.write (frame + oldHeaderSize, size - oldHeaderSize - 2);
+
+            auto frameSize = encoded.getDataSize() - frameStart;
+            auto crc = FlacNamespace::FLAC__crc16 (static_cast<const uint8*> (encoded.getData()) + frameStart,
+                                                   (unsigned int) frameSize);
+            encoded.writeByte ((char) (crc >> 8));
+            encoded.writeByte ((char) (crc & 0xff));
+
+            minFrameSize = jmin (minFrameSize, (uint32) frameSize + 2);
+            maxFrameSize = jmax (maxFrameSize, (uint32) frameSize + 2);
+            ++numFrames;
+            return true;
+        }
+
+        static FlacNamespace::FLAC__StreamEncoderWriteStatus frameWriteCallback (const FlacNamespace::FLAC__StreamEncoder*,
+                                                                                 const FlacNamespace::FLAC__byte buffer[],
+                                                                                 size_t bytes,
+                                                                                 unsigned int samples,
+                                                                                 unsigned int /*current_frame*/,
+                                                                                 void* client_data)
+        {
+            // calls with no samples are the metadata blocks, which the owner has already written
+            return samples == 0 || static_cast<EncodeJob*> (client_data)->addFrame (buffer, bytes)
+                     ? FlacNamespace::FLAC__STREAM_ENCODER_WRITE_STATUS_OK
+                     : FlacNamespace::FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR;
+        }
+
+        const ParallelFlacWriter& owner;
+        std::vector<FlacNamespace::FLAC__int32> samples;
+        const int numSamples;
+        uint32 nextFrameNumber;
+
+        MemoryOutputStream encoded;
+        uint32 minFrameSize = std::numeric_limits<uint32>::max(), maxFrameSize = 0, numFrames = 0;
+        bool succeeded = false;
+
+        JUCE_DECLARE_NON_COPYABLE (EncodeJob)
+    };
+
+    //==============================================================================
+    void configureEncoder (FlacNamespace::FLAC__StreamEncoder* encoder) const
+    {
+        configureFlacEncoder (encoder, sampleRate, numChannels, bitsPerSample, qualityOptionIndex);
+        FLAC__stream_encoder_set_blocksize (encoder, blockSize);
+        FLAC__stream_encoder_set_do_md5 (encoder, false);
+    }
+
+    bool startJob()
+    {
+        using namespace FlacNamespace;
+
+        const FLAC__int32* channels[FLAC__MAX_CHANNELS] = {};
+
+        for (unsigned int i = 0; i < numChannels; ++i)
+            channels[i] = pending.data() + i * (size_t) samplesPerJob;
+
+        FLAC__MD5Accumulate (&md5, channels, numChannels, (unsigned int) numPending,
+                             (jmin ((unsigned int) 24, bitsPerSample) + 7) / 8);
+
+        jobsInFlight.push_back (std::make_unique<EncodeJob> (*this, std::move (pending), numPending, nextFrameNumber));
+        pool->addJob (jobsInFlight.back().get(), false);
+
+        totalSamples += numPending;
+        nextFrameNumber += (uint32) ((numPending + (int) blockSize - 1) / (int) blockSize);
+        numPending = 0;
+        pending = std::vector<FLAC__int32> (numChannels * (size_t) samplesPerJob);
+
+        return writeFinishedJobs (false);
+    }
+
+    bool writeFinishedJobs (bool waitForAllJobs)
+    {
+        while (! jobsInFlight.empty())
+        {
+            auto& job = *jobsInFlight.front();
+
+            if (pool->contains (&job))
+            {
+                if (! waitForAllJobs && jobsInFlight.size() <= maxJobsInFlight)
+                    break;
+
+                pool->waitForJobToFinish (&job, -1);
+            }
+
+            if (! failed && job.succeeded && output->write (job.encoded.getData(), job.encoded.getDataSize()))
+            {
+                minFrameSize = jmin (minFrameSize, job.minFrameSize);
+                maxFrameSize = jmax (maxFrameSize, job.maxFrameSize);
+                numFramesWritten += job.numFrames;
+            }
+            else
+            {
+                failed = true;
+            }
+
+            jobsInFlight.pop_front();
+        }
+
+        return ! failed;
+    }
+
+    //==============================================================================
+    static int getUTF8Length (uint8 firstByte) noexcept
+    {
+        int numLeadingOnes = 0;
+
+        while (numLeadingOnes < 7 && (firstByte & (0x80 >> numLeadingOnes)) != 0)
+            ++numLeadingOnes;
+
+        return jmax (1, numLeadingOnes);
+    }
+
+    static int writeUTF8 (uint8* dest, uint32 value) noexcept
+    {
+        if (value < 0x80)
+        {
+            dest[0] = (uint8) value;
+            return 1;
+        }
+
+        auto numBytes = value < 0x800 ? 2 : (value < 0x10000 ? 3 : (value < 0x200000 ? 4 : (value < 0x4000000 ? 5 : 6)));
+
+        for (int i = numBytes; --i > 0;)
+        {
+            dest[i] = (uint8) (0x80 | (value & 0x3f));
+            value >>= 6;
+        }
+
+        dest[0] = (uint8) ((0xff00u >> numBytes) | value);
+        return numBytes;
+    }
+
+    static FlacNamespace::FLAC__StreamEncoderWriteStatus headerWriteCallback (const FlacNamespace::FLAC__StreamEncoder*,
+                                                                              const FlacNamespace::FLAC__byte buffer[],
+                                                                              size_t bytes,
+                                                                              unsigned int /*samples*/,
+                                                                              unsigned int /*current_frame*/,
+                                                                              void* client_data)
+    {
+        return static_cast<ParallelFlacWriter*> (client_data)->output->write (buffer, bytes)
+                ? FlacNamespace::FLAC__STREAM_ENCODER_WRITE_STATUS_OK
+                : FlacNamespace::FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR;
+    }
+
+public:
+    bool ok = false;
+
+private:
+    static constexpr int blocksPerJob = 16;
+
+    const int qualityOptionIndex;
+    std::shared_ptr<ThreadPool> pool;
+    const size_t maxJobsInFlight;
+    int64 streamStartPos;
+    unsigned int blockSize = 0;
+    int samplesPerJob = 0;
+
+    std::vector<FlacNamespace::FLAC__int32> pending;
+    int numPending = 0;
+    std::deque<std::unique_ptr<EncodeJob>> jobsInFlight;
+
+    FlacNamespace::FLAC__MD5Context md5;
+    int64 totalSamples = 0;
+    uint32 nextFrameNumber = 0, numFramesWritten = 0;
+    uint32 minFrameSize = std::numeric_limits<uint32>::max(), maxFrameSize = 0;
+    bool failed = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParallelFlacWriter)
+};
+
+#endif
+
 //==============================================================================
 FlacAudioFormat::FlacAudioFormat()  : AudioFormat (flacFormatName, ".flac") {}
 FlacAudioFormat::~FlacAudioFormat() {}
@@ -560,7 +1210,7 @@ bool FlacAudioFormat::isCompressed()    { return true; }
 
 AudioFormatReader* FlacAudioFormat::createReaderFor (InputStream* in, const bool deleteStreamIfOpeningFails)
 {
-    std::unique_ptr<FlacReader> r (new FlacReader (in));
+    std::unique_ptr<FlacReader> r (new FlacReader (in, seekIndexCacheDirectory));
 
     if (r->sampleRate > 0)
         return r.release();
@@ -580,6 +1230,16 @@ AudioFormatWriter* FlacAudioFormat::createWriterFor (OutputStream* out,
 {
     if (out != nullptr && getPossibleBitDepths().contains (bitsPerSample))
     {
+       #if JUCE_INCLUDE_FLAC_CODE || ! defined (JUCE_INCLUDE_FLAC_CODE)
+        if (encoderThreadPool != nullptr)
+        {
+            std::unique_ptr<ParallelFlacWriter> w (new ParallelFlacWriter (out, sampleRate, numberOfChannels,
+                                                                           (uint32) bitsPerSample, qualityOptionIndex,
+                                                                           encoderThreadPool));
+            return w->ok ? w.release() : nullptr;
+        }
+       #endif
+
         std::unique_ptr<FlacWriter> w (new FlacWriter (out, sampleRate, numberOfChannels,
                                                      (uint32) bitsPerSample, qualityOptionIndex));
         if (w->ok)
@@ -589,11 +1249,116 @@ AudioFormatWriter* FlacAudioFormat::createWriterFor (OutputStream* out,
     return nullptr;
 }
 
+void FlacAudioFormat::setNumEncoderThreads (int numThreads)
+{
+    if (numThreads != getNumEncoderThreads())
+        encoderThreadPool = numThreads > 1 ? std::make_shared<ThreadPool> (numThreads) : nullptr;
+}
+
+int FlacAudioFormat::getNumEncoderThreads() const noexcept
+{
+    return encoderThreadPool != nullptr ? encoderThreadPool->getNumThreads() : 1;
+}
+
+void FlacAudioFormat::setSeekIndexCacheDirectory (const File& directory)
+{
+    seekIndexCacheDirectory = directory;
+}
+
+File FlacAudioFormat::getSeekIndexCacheDirectory() const
+{
+    return seekIndexCacheDirectory;
+}
+
 StringArray FlacAudioFormat::getQualityOptions()
 {
     return { "0 (Fastest)", "1", "2", "3", "4", "5 (Default)","6", "7", "8 (Highest quality)" };
 }
 
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS && (JUCE_INCLUDE_FLAC_CODE || ! defined (JUCE_INCLUDE_FLAC_CODE))
+
+struct FlacParallelEncodingTests  : public UnitTest
+{
+    FlacParallelEncodingTests()
+        : UnitTest ("FLAC parallel encoding", UnitTestCategories::audio)
+    {}
+
+    void runTest() override
+    {
+        for (auto bits : { 16, 24 })
+        {
+            beginTest ("Parallel encoding at " + String (bits) + " bits");
+
+            const int numSamples = 3 * 44100 + 123;
+            auto input = createTestSignal (numSamples, bits);
+
+            auto serial = encode (input, numSamples, bits, 1);
+            auto parallel = encode (input, numSamples, bits, 4);
+
+            // the MD5 signature in the STREAMINFO block covers the audio, so should match the serial encoder's
+            const int md5Offset = 26;
+            expect (parallel.getSize() > md5Offset + 16);
+            expect (memcmp (serial.begin() + md5Offset, parallel.begin() + md5Offset, 16) == 0);
+            expect (! MemoryBlock (16, true).matches (parallel.begin() + md5Offset, 16));
+
+            std::unique_ptr<AudioFormatReader> reader (FlacAudioFormat().createReaderFor (new MemoryInputStream (parallel, false), true));
+            expect (reader != nullptr);
+            expectEquals ((int) reader->lengthInSamples, numSamples);
+
+            HeapBlock<int> decoded ((size_t) (numChannels * numSamples), true);
+            int* decodedChannels[] = { decoded.get(), decoded.get() + numSamples };
+            reader->read (decodedChannels, numChannels, 0, numSamples, false);
+
+            expect (memcmp (decoded.get(), input.get(), (size_t) (numChannels * numSamples) * sizeof (int)) == 0);
+        }
+    }
+
+    static constexpr int numChannels = 2;
+
+    static HeapBlock<int> createTestSignal (int numSamples, int bits)
+    {
+        HeapBlock<int> samples ((size_t) (numChannels * numSamples));
+        Random r (0x1234);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto value = 0.5 * std::sin (0.01 * (ch + 1) * i) + 0.1 * (r.nextDouble() - 0.5);
+                samples[ch * numSamples + i] = roundToInt (value * (1 << (bits - 1))) << (32 - bits);
+            }
+        }
+
+        return samples;
+    }
+
+    static MemoryBlock encode (const HeapBlock<int>& input, int numSamples, int bits, int numThreads)
+    {
+        FlacAudioFormat format;
+        format.setNumEncoderThreads (numThreads);
+
+        MemoryBlock block;
+        std::unique_ptr<AudioFormatWriter> writer (format.createWriterFor (new MemoryOutputStream (block, false),
+                                                                           44100.0, numChannels, bits, {}, 5));
+
+        // write it in awkwardly-sized pieces, so they don't line up with the FLAC blocks
+        for (int pos = 0; pos < numSamples; pos += 1000)
+        {
+            const int* channels[] = { input.get() + pos, input.get() + numSamples + pos, nullptr };
+            writer->write (channels, jmin (1000, numSamples - pos));
+        }
+
+        writer.reset();
+        return block;
+    }
+};
+
+static FlacParallelEncodingTests flacParallelEncodingTests;
+
+#endif
+
 #endif
 
 } // namespace juce
@@ -65,7 +65,52 @@ public:
                                         int qualityOptionIndex) override;
     using AudioFormat::createWriterFor;
 
+    //==============================================================================
+    /** Makes the writers created by this format encode on several threads at once.
+
+        When this is more than 1, each writer collects its incoming audio into runs of
+        whole FLAC blocks and encodes them on a ThreadPool that's shared by all the
+        writers this format creates, writing the finished frames to the stream in order.
+        The result is an ordinary fixed-blocksize FLAC stream that decodes to exactly the
+        same audio, although its frames may not be bit-identical to the single-threaded
+        encoder's, and each writer holds on to a few seconds of audio before any of it
+        reaches the output stream.
+
+        This only affects writers created after it's called, and is ignored if
+        JUCE_INCLUDE_FLAC_CODE is disabled. The default is 1.
+    */
+    void setNumEncoderThreads (int numThreads);
+
+    /** Returns the number of threads set with setNumEncoderThreads(). */
+    int getNumEncoderThreads() const noexcept;
+
+    //==============================================================================
+    /** Sets a directory in which readers can cache the frame index they build for a file.
+
+        The first time a reader has to jump to a sample that doesn't follow on from the
+        last one it read, it builds an index of frame positions, so that it can jump
+        straight to any sample rather than searching the file for it. If the stream has a
+        SEEKTABLE, the index is made from that; otherwise the reader scans the whole stream
+        for the position of every frame. Readers that are only used to read a file's
+        metadata, or to read it from start to end, never build an index.
+
+        For readers of files, the scan is skipped if this directory holds an index for
+        the same version of the file, and the index is saved here if it doesn't.
+
+        By default no directory is set, so a file is scanned by each reader that needs
+        to jump around it.
+
+        @see AudioFormatSeekIndex
+    */
+    void setSeekIndexCacheDirectory (const File& directory);
+
+    /** Returns the directory set with setSeekIndexCacheDirectory(). */
+    File getSeekIndexCacheDirectory() const;
+
 private:
+    std::shared_ptr<ThreadPool> encoderThreadPool;
+    File seekIndexCacheDirectory;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FlacAudioFormat)
 };
 
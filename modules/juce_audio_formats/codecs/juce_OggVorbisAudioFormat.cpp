@@ -108,7 +108,7 @@ const char* const OggVorbisAudioFormat::id3trackNumber = "id3trackNumber";
 class OggReader : public AudioFormatReader
 {
 public:
-    OggReader (InputStream* inp)  : AudioFormatReader (inp, oggFormatName)
+    OggReader (InputStream* inp, const File& seekIndexCacheDirectory)  : AudioFormatReader (inp, oggFormatName)
     {
         sampleRate = 0;
         usesFloatingPointData = true;
@@ -140,6 +140,10 @@ public:
             sampleRate = (double) info->rate;
 
             reservoir.setSize ((int) numChannels, (int) jmin (lengthInSamples, (int64) 4096));
+
+            // chained streams restart their granule positions, so they're left to vorbisfile
+            if (ov_seekable (&ovFile) && ov_streams (&ovFile) == 1)
+                createSeekIndex (seekIndexCacheDirectory);
         }
     }
 
@@ -186,11 +190,20 @@ public:
                 || startSampleInFile + numSamples > reservoirStart + samplesInReservoir)
             {
                 // buffer miss, so refill the reservoir
-                reservoirStart = jmax (0, (int) startSampleInFile);
+                auto newStart = jmax ((int64) 0, startSampleInFile);
                 samplesInReservoir = reservoir.getNumSamples();
 
-                if (reservoirStart != (int) ov_pcm_tell (&ovFile))
-                    ov_pcm_seek (&ovFile, reservoirStart);
+                // when reading backwards, fill the block that ends where the current one begins,
+                // so that the reads that follow don't each need to seek again
+                if (startSampleInFile < reservoirStart
+                     && startSampleInFile + numSamples <= reservoirStart
+                     && startSampleInFile + samplesInReservoir > reservoirStart)
+                    newStart = jmax ((int64) 0, reservoirStart - samplesInReservoir);
+
+                reservoirStart = newStart;
+
+                if (reservoirStart != (int64) ov_pcm_tell (&ovFile))
+                    seekTo (reservoirStart);
 
                 int bitStream = 0;
                 int offset = 0;
@@ -258,10 +271,129 @@ public:
     }
 
 private:
+    //==============================================================================
+    void createSeekIndex (const File& cacheDirectory)
+    {
+        auto* fileStream = dynamic_cast<FileInputStream*> (input);
+        auto sourceFile = fileStream != nullptr ? fileStream->getFile() : File();
+        auto useCache = cacheDirectory != File() && sourceFile != File();
+
+        if (useCache && seekIndex.loadFromCache (cacheDirectory, sourceFile))
+            return;
+
+        auto oldPosition = input->getPosition();
+        scanPages();
+        input->setPosition (oldPosition);
+
+        if (useCache)
+            seekIndex.saveToCache (cacheDirectory, sourceFile);
+    }
+
+    // Each page records the granule position (i.e. the sample number) reached by the end of
+    // the last packet that finishes on it, so a page's audio starts after the previous
+    // page's granule position.
+    void scanPages()
+    {
+        struct Page { int64 samplesBefore, byteOffset; };
+        Array<Page> pages;
+
+        auto totalLength = input->getTotalLength();
+        int64 position = 0, granule = 0;
+        uint8 header[27 + 255];
+        int serialNumber = 0;
+
+        while (position < totalLength)
+        {
+            input->setPosition (position);
+
+            if (input->read (header, 27) != 27 || memcmp (header, "OggS", 4) != 0)
+                return;
+
+            auto numSegments = (int) header[26];
+
+            if (input->read (header + 27, numSegments) != numSegments)
+                return;
+
+            auto pageSerialNumber = (int) ByteOrder::littleEndianInt (header + 14);
+
+            if (position == 0)
+                serialNumber = pageSerialNumber;
+            else if (pageSerialNumber != serialNumber)
+                return;
+
+            auto pageGranule = (int64) ByteOrder::littleEndianInt64 (header + 6);
+
+            // the header pages have a granule position of 0, and pages on which no packet
+            // finishes have -1, so neither of those is somewhere audio can start
+            if (pageGranule > 0)
+            {
+                if (pages.isEmpty() || granule > pages.getLast().samplesBefore)
+                    pages.add ({ granule, position });
+
+                granule = pageGranule;
+            }
+
+            position += 27 + numSegments;
+
+            for (int i = 0; i < numSegments; ++i)
+                position += header[27 + i];
+        }
+
+        // vorbisfile counts samples from the start of the first audio packet, which isn't
+        // always at granule position 0
+        auto granuleOffset = granule - (int64) ov_pcm_total (&ovFile, -1);
+
+        for (auto& page : pages)
+        {
+            auto sampleNumber = jmax ((int64) 0, page.samplesBefore - granuleOffset);
+
+            if (seekIndex.isEmpty() || sampleNumber > seekIndex.getEntry (seekIndex.size() - 1).sampleNumber)
+                seekIndex.add (sampleNumber, page.byteOffset);
+        }
+    }
+
+    void seekTo (int64 sample)
+    {
+        // after a raw seek vorbisfile knows exactly which sample it's reached, so if that's
+        // past the target because the page's first packet couldn't be decoded, go back a page
+        for (auto index = seekIndex.findEntryFor (sample); index >= 0; --index)
+        {
+            if (ov_raw_seek (&ovFile, seekIndex.getEntry (index).byteOffset) != 0)
+                break;
+
+            auto position = (int64) ov_pcm_tell (&ovFile);
+
+            if (position <= sample && skipSamples (sample - position))
+                return;
+        }
+
+        ov_pcm_seek (&ovFile, sample);
+    }
+
+    bool skipSamples (int64 numToSkip)
+    {
+        while (numToSkip > 0)
+        {
+            float** dataIn = nullptr;
+            int bitStream = 0;
+            auto samps = ov_read_float (&ovFile, &dataIn, (int) jmin ((int64) 4096, numToSkip), &bitStream);
+
+            if (samps <= 0)
+                return false;
+
+            numToSkip -= samps;
+        }
+
+        return true;
+    }
+
+    //==============================================================================
     OggVorbisNamespace::OggVorbis_File ovFile;
     OggVorbisNamespace::ov_callbacks callbacks;
     AudioBuffer<float> reservoir;
-    int reservoirStart = 0, samplesInReservoir = 0;
+    int64 reservoirStart = 0;
+    int samplesInReservoir = 0;
+    AudioFormatSeekIndex seekIndex;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OggReader)
 };
@@ -445,7 +577,7 @@ bool OggVorbisAudioFormat::isCompressed()   { return true; }
 
 AudioFormatReader* OggVorbisAudioFormat::createReaderFor (InputStream* in, bool deleteStreamIfOpeningFails)
 {
-    std::unique_ptr<OggReader> r (new OggReader (in));
+    std::unique_ptr<OggReader> r (new OggReader (in, seekIndexCacheDirectory));
 
     if (r->sampleRate > 0)
         return r.release();
@@ -473,6 +605,16 @@ AudioFormatWriter* OggVorbisAudioFormat::createWriterFor (OutputStream* out,
     return w->ok ? w.release() : nullptr;
 }
 
+void OggVorbisAudioFormat::setSeekIndexCacheDirectory (const File& directory)
+{
+    seekIndexCacheDirectory = directory;
+}
+
+File OggVorbisAudioFormat::getSeekIndexCacheDirectory() const
+{
+    return seekIndexCacheDirectory;
+}
+
 StringArray OggVorbisAudioFormat::getQualityOptions()
 {
     return { "64 kbps", "80 kbps", "96 kbps", "112 kbps", "128 kbps", "160 kbps",
@@ -92,7 +92,26 @@ public:
                                         int qualityOptionIndex) override;
     using AudioFormat::createWriterFor;
 
+    //==============================================================================
+    /** Sets a directory in which readers can cache the page index they build for a file.
+
+        When a reader is opened it scans the stream for the position of every page, so
+        that it can jump straight to the page containing any sample rather than searching
+        the file for it. For readers of files, the scan is skipped if this directory holds
+        an index for the same version of the file, and the index is saved here if it doesn't.
+
+        By default no directory is set, so the scan happens every time a file is opened.
+
+        @see AudioFormatSeekIndex
+    */
+    void setSeekIndexCacheDirectory (const File& directory);
+
+    /** Returns the directory set with setSeekIndexCacheDirectory(). */
+    File getSeekIndexCacheDirectory() const;
+
 private:
+    File seekIndexCacheDirectory;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OggVorbisAudioFormat)
 };
 
@@ -123,11 +123,29 @@ AudioFormatReader* AudioFormatManager::createReaderFor (const File& file)
     // use them to open a file!
     jassert (getNumKnownFormats() > 0);
 
+    if (decodedSampleCacheDirectory != File())
+        if (auto* af = findFormatForFile (file))
+            if (af->isCompressed())
+                if (auto* r = createDecodedSampleCacheReader (file, *af))
+                    return r;
+
     for (auto* af : knownFormats)
+    {
         if (af->canHandleFile (file))
+        {
             if (auto in = file.createInputStream())
+            {
                 if (auto* r = af->createReaderFor (in.release(), true))
+                {
+                    if (decodedBlockCache != nullptr && af->isCompressed()
+                         && (int) r->numChannels <= decodedBlockCache->getBlockSizeInFloats())
+                        return new DecodedAudioBlockCache::Reader (r, decodedBlockCache, file);
+
                     return r;
+                }
+            }
+        }
+    }
 
     return nullptr;
 }
@@ -161,4 +179,325 @@ AudioFormatReader* AudioFormatManager::createReaderFor (std::unique_ptr<InputStr
     return nullptr;
 }
 
+MemoryMappedAudioFormatReader* AudioFormatManager::createMemoryMappedReaderFor (const File& file)
+{
+    if (auto* af = findFormatForFile (file))
+    {
+        if (af->isCompressed())
+            return decodedSampleCacheDirectory != File() ? createDecodedSampleCacheReader (file, *af)
+                                                         : nullptr;
+
+        std::unique_ptr<MemoryMappedAudioFormatReader> r (af->createMemoryMappedReader (file));
+
+        if (r != nullptr && r->mapEntireFile())
+            return r.release();
+    }
+
+    return nullptr;
+}
+
+AudioFormat* AudioFormatManager::findFormatForFile (const File& file) const
+{
+    for (auto* af : knownFormats)
+        if (af->canHandleFile (file))
+            return af;
+
+    return nullptr;
+}
+
+//==============================================================================
+void AudioFormatManager::setDecodedSampleCacheDirectory (const File& cacheDirectory, int64 maximumSizeInBytes)
+{
+    jassert (maximumSizeInBytes >= 0);
+
+    decodedSampleCacheDirectory = cacheDirectory;
+    decodedSampleCacheSizeLimit = maximumSizeInBytes;
+}
+
+void AudioFormatManager::setDecodedBlockCache (std::shared_ptr<DecodedAudioBlockCache> cacheToUse)
+{
+    decodedBlockCache = std::move (cacheToUse);
+}
+
+static constexpr int decodedSampleCacheHashLength = 16;
+
+static String getDecodedSampleCacheHash (const String& s)
+{
+    return String::toHexString (s.hashCode64()).paddedLeft ('0', decodedSampleCacheHashLength);
+}
+
+static String getDecodedSampleCacheFilePrefix (const File& audioFile)
+{
+    return audioFile.getFileNameWithoutExtension()
+            + "_" + getDecodedSampleCacheHash (audioFile.getFullPathName()) + "_";
+}
+
+// The cache may share its directory with other files, so only files whose names have the
+// same shape as the ones that getDecodedSampleCacheFile() returns are ever deleted.
+static bool isDecodedSampleCacheFile (const File& file)
+{
+    if (! file.hasFileExtension ("wav"))
+        return false;
+
+    auto name = file.getFileNameWithoutExtension();
+    auto hashes = name.getLastCharacters (2 * decodedSampleCacheHashLength + 2);
+
+    return hashes.length() == 2 * decodedSampleCacheHashLength + 2
+            && hashes[0] == '_'
+            && hashes[decodedSampleCacheHashLength + 1] == '_'
+            && hashes.substring (1, decodedSampleCacheHashLength + 1).containsOnly ("0123456789abcdef")
+            && hashes.substring (decodedSampleCacheHashLength + 2).containsOnly ("0123456789abcdef");
+}
+
+static Array<File> findDecodedSampleCacheFiles (const File& directory, const String& wildcard)
+{
+    auto files = directory.findChildFiles (File::findFiles, false, wildcard);
+    files.removeIf ([] (const File& f) { return ! isDecodedSampleCacheFile (f); });
+    return files;
+}
+
+File AudioFormatManager::getDecodedSampleCacheFile (const File& audioFile) const
+{
+    if (decodedSampleCacheDirectory == File())
+        return {};
+
+    auto version = String (audioFile.getSize()) + ":" + String (audioFile.getLastModificationTime().toMilliseconds());
+
+    return decodedSampleCacheDirectory.getChildFile (getDecodedSampleCacheFilePrefix (audioFile)
+                                                      + getDecodedSampleCacheHash (version) + ".wav");
+}
+
+MemoryMappedAudioFormatReader* AudioFormatManager::createDecodedSampleCacheReader (const File& file, AudioFormat& format)
+{
+    auto cacheFile = getDecodedSampleCacheFile (file);
+    WavAudioFormat wavFormat;
+
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        if (! cacheFile.existsAsFile() && ! writeDecodedSampleCacheFile (file, format, cacheFile))
+            return nullptr;
+
+        std::unique_ptr<MemoryMappedAudioFormatReader> r (wavFormat.createMemoryMappedReader (cacheFile));
+
+        if (r != nullptr)
+            return r->mapEntireFile() ? r.release() : nullptr;
+
+        // the cache entry is unreadable, so try decoding it again
+        cacheFile.deleteFile();
+    }
+
+    return nullptr;
+}
+
+bool AudioFormatManager::writeDecodedSampleCacheFile (const File& file, AudioFormat& format, const File& cacheFile)
+{
+    std::unique_ptr<AudioFormatReader> decoder;
+
+    if (auto in = file.createInputStream())
+        decoder.reset (format.createReaderFor (in.release(), true));
+
+    if (decoder == nullptr || ! cacheFile.getParentDirectory().createDirectory())
+        return false;
+
+    // remove any entries for older versions of this file
+    for (auto& oldEntry : findDecodedSampleCacheFiles (cacheFile.getParentDirectory(),
+                                                       getDecodedSampleCacheFilePrefix (file) + "*.wav"))
+        oldEntry.deleteFile();
+
+    TemporaryFile temp (cacheFile);
+
+    {
+        std::unique_ptr<OutputStream> out (temp.getFile().createOutputStream());
+
+        if (out == nullptr)
+            return false;
+
+        std::unique_ptr<AudioFormatWriter> writer (WavAudioFormat().createWriterFor (out.get(), decoder->sampleRate,
+                                                                                     decoder->numChannels, 32, {}, 0));
+
+        if (writer == nullptr)
+            return false;
+
+        out.release();
+
+        if (! writer->writeFromAudioReader (*decoder, 0, -1))
+            return false;
+    }
+
+    if (! temp.overwriteTargetFileWithTemporary())
+        return false;
+
+    trimDecodedSampleCache (cacheFile);
+    return true;
+}
+
+void AudioFormatManager::trimDecodedSampleCache (const File& entryToKeep)
+{
+    if (decodedSampleCacheSizeLimit <= 0)
+        return;
+
+    auto entries = findDecodedSampleCacheFiles (entryToKeep.getParentDirectory(), "*.wav");
+
+    std::sort (entries.begin(), entries.end(), [] (const File& a, const File& b)
+    {
+        return a.getLastModificationTime() < b.getLastModificationTime();
+    });
+
+    int64 totalSize = 0;
+
+    for (auto& entry : entries)
+        totalSize += entry.getSize();
+
+    for (auto& entry : entries)
+    {
+        if (totalSize <= decodedSampleCacheSizeLimit)
+            break;
+
+        auto size = entry.getSize();
+
+        if (entry != entryToKeep && entry.deleteFile())
+            totalSize -= size;
+    }
+}
+
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS && JUCE_USE_FLAC
+
+class DecodedSampleCacheTests  : public UnitTest
+{
+public:
+    DecodedSampleCacheTests()
+        : UnitTest ("Decoded sample cache", UnitTestCategories::audio)
+    {}
+
+    struct ScopedTestDirectory
+    {
+        ~ScopedTestDirectory()  { directory.deleteRecursively(); }
+
+        const File directory { File::getSpecialLocation (File::tempDirectory).getNonexistentChildFile ("DecodedSampleCacheTest", {}) };
+    };
+
+    void runTest() override
+    {
+        ScopedTestDirectory tempDirectory;
+        auto sourceDirectory = tempDirectory.directory.getChildFile ("source");
+        auto cacheDirectory = tempDirectory.directory.getChildFile ("cache");
+        auto flacFile = sourceDirectory.getChildFile ("test.flac");
+        sourceDirectory.createDirectory();
+
+        constexpr int numSamples = 10000;
+        AudioBuffer<float> original (2, numSamples);
+        auto random = getRandom();
+
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                original.setSample (ch, i, (float) (random.nextInt (65536) - 32768) / 32768.0f);
+
+        {
+            std::unique_ptr<OutputStream> out (flacFile.createOutputStream());
+            std::unique_ptr<AudioFormatWriter> writer (FlacAudioFormat().createWriterFor (out.get(), 44100.0, 2, 16, {}, 0));
+            out.release();
+            writer->writeFromAudioSampleBuffer (original, 0, numSamples);
+        }
+
+        // the cache should hold exactly what the FLAC decoder produces
+        AudioBuffer<float> decoded (2, numSamples);
+
+        {
+            std::unique_ptr<AudioFormatReader> flacReader (FlacAudioFormat().createReaderFor (flacFile.createInputStream().release(), true));
+            flacReader->read (&decoded, 0, numSamples, 0, true, true);
+        }
+
+        AudioFormatManager manager;
+        manager.registerBasicFormats();
+
+        beginTest ("Without a cache, compressed files aren't memory-mapped");
+        {
+            std::unique_ptr<AudioFormatReader> reader (manager.createReaderFor (flacFile));
+            expect (reader != nullptr);
+            expect (dynamic_cast<MemoryMappedAudioFormatReader*> (reader.get()) == nullptr);
+            expect (manager.createMemoryMappedReaderFor (flacFile) == nullptr);
+        }
+
+        manager.setDecodedSampleCacheDirectory (cacheDirectory);
+        auto cacheFile = manager.getDecodedSampleCacheFile (flacFile);
+
+        beginTest ("The first load creates the cache");
+        {
+            expect (! cacheFile.existsAsFile());
+
+            std::unique_ptr<AudioFormatReader> reader (manager.createReaderFor (flacFile));
+            expect (dynamic_cast<MemoryMappedAudioFormatReader*> (reader.get()) != nullptr);
+            expect (cacheFile.existsAsFile());
+            expectMatchesDecodedAudio (*reader, decoded);
+        }
+
+        beginTest ("Later loads map the cache");
+        {
+            auto cacheModificationTime = cacheFile.getLastModificationTime();
+
+            std::unique_ptr<MemoryMappedAudioFormatReader> reader (manager.createMemoryMappedReaderFor (flacFile));
+            expect (reader != nullptr);
+            expect (cacheFile.getLastModificationTime() == cacheModificationTime);
+            expectMatchesDecodedAudio (*reader, decoded);
+        }
+
+        beginTest ("Changing the source file replaces the cache entry");
+        {
+            flacFile.setLastModificationTime (flacFile.getLastModificationTime() + RelativeTime::seconds (10.0));
+            auto newCacheFile = manager.getDecodedSampleCacheFile (flacFile);
+            expect (newCacheFile != cacheFile);
+
+            std::unique_ptr<AudioFormatReader> reader (manager.createReaderFor (flacFile));
+            expect (newCacheFile.existsAsFile());
+            expect (! cacheFile.existsAsFile());
+        }
+
+        beginTest ("The cache's size limit is kept to");
+        {
+            auto secondFlacFile = sourceDirectory.getChildFile ("second.flac");
+            expect (flacFile.copyFileTo (secondFlacFile));
+
+            // other files in the cache directory must never be deleted, even if they're older
+            auto foreignFile = cacheDirectory.getChildFile ("kick_drum.wav");
+            auto foreignLookalike = cacheDirectory.getChildFile (manager.getDecodedSampleCacheFile (secondFlacFile)
+                                                                        .getFileNameWithoutExtension() + "_take2.wav");
+
+            for (auto& f : { foreignFile, foreignLookalike })
+            {
+                expect (f.replaceWithText ("not a cache entry"));
+                expect (f.setLastModificationTime (Time (2000, 0, 1, 0, 0)));
+            }
+
+            auto firstEntry = manager.getDecodedSampleCacheFile (flacFile);
+            manager.setDecodedSampleCacheDirectory (cacheDirectory, firstEntry.getSize() + 1);
+
+            std::unique_ptr<AudioFormatReader> reader (manager.createReaderFor (secondFlacFile));
+            expect (reader != nullptr);
+            expect (manager.getDecodedSampleCacheFile (secondFlacFile).existsAsFile());
+            expect (! firstEntry.existsAsFile());
+            expect (foreignFile.existsAsFile());
+            expect (foreignLookalike.existsAsFile());
+        }
+    }
+
+private:
+    void expectMatchesDecodedAudio (AudioFormatReader& reader, const AudioBuffer<float>& expected)
+    {
+        expectEquals ((int) reader.lengthInSamples, expected.getNumSamples());
+
+        AudioBuffer<float> result (expected.getNumChannels(), expected.getNumSamples());
+        reader.read (&result, 0, result.getNumSamples(), 0, true, true);
+
+        for (int ch = 0; ch < expected.getNumChannels(); ++ch)
+            expect (std::memcmp (result.getReadPointer (ch), expected.getReadPointer (ch),
+                                 sizeof (float) * (size_t) expected.getNumSamples()) == 0);
+    }
+};
+
+static DecodedSampleCacheTests decodedSampleCacheTests;
+
+#endif
+
 } // namespace juce
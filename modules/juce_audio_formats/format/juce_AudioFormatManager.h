@@ -120,6 +120,12 @@ public:
     /** Searches through the known formats to try to create a suitable reader for
         this file.
 
+        If a decoded sample cache has been enabled with setDecodedSampleCacheDirectory()
+        and the file is in a compressed format, this will return a memory-mapped reader
+        for its cached, decoded audio, decoding the file into the cache first if needed.
+        Otherwise, if a decoded block cache has been set with setDecodedBlockCache(),
+        readers for compressed files will read through that.
+
         If none of the registered formats can open the file, it'll return nullptr.
         It's the caller's responsibility to delete the reader that is returned.
     */
@@ -139,10 +145,85 @@ public:
     */
     AudioFormatReader* createReaderFor (std::unique_ptr<InputStream> audioFileStream);
 
+    /** Tries to create a memory-mapped reader for a file.
+
+        Formats which support memory-mapping (e.g. WAV and AIFF) map the file directly.
+        For compressed formats, this returns a reader for the decoded sample cache, so
+        it only works if a cache directory has been set.
+
+        The reader that is returned will already have mapped the entire file. It returns
+        nullptr if the file can't be opened or mapped, and it's the caller's responsibility
+        to delete the reader that is returned.
+    */
+    MemoryMappedAudioFormatReader* createMemoryMappedReaderFor (const File& audioFile);
+
+    //==============================================================================
+    /** Enables a cache of decoded audio for files in compressed formats.
+
+        The first time a compressed file (e.g. FLAC, Ogg-Vorbis or MP3) is opened with
+        createReaderFor() or createMemoryMappedReaderFor(), it's decoded in its entirety
+        into an uncompressed 32-bit float WAV file in this directory. After that, opening
+        the file memory-maps the decoded audio, which gives fast random access without
+        any decoding.
+
+        Cache files are named after the source file's path, size and modification time,
+        so editing a source file causes it to be decoded again, and the stale entry for it
+        is deleted. Only files with cache entry names are ever deleted, so any other files
+        in the directory are left alone.
+
+        Note that the decoding happens synchronously, inside the call that opens the file,
+        so the first time a long file is opened it may take a while. If that's a problem,
+        open your files on a background thread first to fill the cache.
+
+        Decoded audio takes up a lot more space than the compressed files, so you can give
+        the cache a maximum size in bytes. Whenever a new entry has been written, the
+        entries that were decoded longest ago are deleted until the total fits. Entries
+        that can't be deleted (e.g. because they're mapped on a platform that doesn't allow
+        that) are left alone. A limit of 0 means that the cache can grow without limit.
+
+        Pass File() to disable the cache.
+    */
+    void setDecodedSampleCacheDirectory (const File& cacheDirectory, int64 maximumSizeInBytes = 0);
+
+    /** Returns the directory set with setDecodedSampleCacheDirectory(). */
+    File getDecodedSampleCacheDirectory() const             { return decodedSampleCacheDirectory; }
+
+    /** Returns the file in which the decoded audio for a source file is cached.
+
+        The file may not exist yet. This returns File() if the cache isn't enabled.
+    */
+    File getDecodedSampleCacheFile (const File& audioFile) const;
+
+    //==============================================================================
+    /** Makes the readers that createReaderFor() returns for compressed files share a
+        cache of decoded audio.
+
+        Any number of managers can share the same cache, so a single cache for the whole
+        process means that no matter how many readers are opened on a file, each block
+        of it only gets decoded once while it stays in the cache.
+
+        Pass nullptr to stop using a cache. Readers that already exist keep using the
+        cache they were created with.
+
+        @see DecodedAudioBlockCache
+    */
+    void setDecodedBlockCache (std::shared_ptr<DecodedAudioBlockCache> cacheToUse);
+
+    /** Returns the cache set with setDecodedBlockCache(). */
+    std::shared_ptr<DecodedAudioBlockCache> getDecodedBlockCache() const    { return decodedBlockCache; }
+
 private:
     //==============================================================================
     OwnedArray<AudioFormat> knownFormats;
     int defaultFormatIndex = 0;
+    File decodedSampleCacheDirectory;
+    int64 decodedSampleCacheSizeLimit = 0;
+    std::shared_ptr<DecodedAudioBlockCache> decodedBlockCache;
+
+    AudioFormat* findFormatForFile (const File&) const;
+    MemoryMappedAudioFormatReader* createDecodedSampleCacheReader (const File&, AudioFormat&);
+    bool writeDecodedSampleCacheFile (const File& audioFile, AudioFormat&, const File& cacheFile);
+    void trimDecodedSampleCache (const File& entryToKeep);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioFormatManager)
 };
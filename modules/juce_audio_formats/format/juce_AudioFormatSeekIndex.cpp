@@ -0,0 +1,373 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   By using JUCE, you agree to the terms of both the JUCE 6 End-User License
+   Agreement and JUCE Privacy Policy (both effective as of the 16th June 2020).
+
+   End User License Agreement: www.juce.com/juce-6-licence
+   Privacy Policy: www.juce.com/juce-privacy-policy
+
+   Or: You may also use this code under the terms of the GPL v3 (see
+   www.gnu.org/licenses).
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+void AudioFormatSeekIndex::clear() noexcept
+{
+    entries.clear();
+    interval = -1;
+}
+
+void AudioFormatSeekIndex::add (int64 sampleNumber, int64 byteOffset)
+{
+    jassert (entries.empty() || sampleNumber > entries.back().sampleNumber);
+
+    if (! entries.empty())
+    {
+        auto gap = sampleNumber - entries.back().sampleNumber;
+
+        if (interval < 0)
+            interval = entries.front().sampleNumber == 0 ? gap : 0;
+        else if (gap != interval)
+            interval = 0;
+    }
+
+    entries.push_back ({ sampleNumber, byteOffset });
+}
+
+int AudioFormatSeekIndex::findEntryFor (int64 sampleNumber) const noexcept
+{
+    if (entries.empty() || sampleNumber < entries.front().sampleNumber)
+        return -1;
+
+    if (interval > 0)
+        return (int) jmin ((int64) entries.size() - 1, sampleNumber / interval);
+
+    auto next = std::upper_bound (entries.begin(), entries.end(), sampleNumber,
+                                  [] (int64 sample, const Entry& e) { return sample < e.sampleNumber; });
+
+    return (int) std::distance (entries.begin(), next) - 1;
+}
+
+//==============================================================================
+File AudioFormatSeekIndex::getCacheFile (const File& cacheDirectory, const File& sourceFile)
+{
+    return cacheDirectory.getChildFile (sourceFile.getFileName() + "_"
+                                          + String::toHexString (sourceFile.getFullPathName().hashCode64())
+                                          + ".seekindex");
+}
+
+String AudioFormatSeekIndex::getSourceVersion (const File& sourceFile)
+{
+    return String (sourceFile.getSize()) + ":" + String (sourceFile.getLastModificationTime().toMilliseconds());
+}
+
+static const int seekIndexCacheMagic = (int) ByteOrder::littleEndianInt ("JSIX");
+
+bool AudioFormatSeekIndex::loadFromCache (const File& cacheDirectory, const File& sourceFile)
+{
+    clear();
+
+    FileInputStream in (getCacheFile (cacheDirectory, sourceFile));
+
+    if (! in.openedOk()
+         || in.readInt() != seekIndexCacheMagic
+         || in.readString() != getSourceVersion (sourceFile))
+        return false;
+
+    auto numEntries = in.readInt64();
+
+    // each entry takes 16 bytes, so this catches truncated or corrupt files
+    if (numEntries <= 0 || numEntries * 16 != in.getNumBytesRemaining())
+        return false;
+
+    entries.reserve ((size_t) numEntries);
+
+    for (int64 i = 0; i < numEntries; ++i)
+    {
+        auto sampleNumber = in.readInt64();
+        auto byteOffset = in.readInt64();
+
+        if (! entries.empty() && sampleNumber <= entries.back().sampleNumber)
+        {
+            clear();
+            return false;
+        }
+
+        add (sampleNumber, byteOffset);
+    }
+
+    return true;
+}
+
+bool AudioFormatSeekIndex::saveToCache (const File& cacheDirectory, const File& sourceFile) const
+{
+    if (entries.empty() || ! cacheDirectory.createDirectory())
+        return false;
+
+    TemporaryFile temp (getCacheFile (cacheDirectory, sourceFile));
+
+    {
+        FileOutputStream out (temp.getFile());
+
+        if (! out.openedOk())
+            return false;
+
+        out.writeInt (seekIndexCacheMagic);
+        out.writeString (getSourceVersion (sourceFile));
+        out.writeInt64 ((int64) entries.size());
+
+        for (auto& e : entries)
+        {
+            out.writeInt64 (e.sampleNumber);
+            out.writeInt64 (e.byteOffset);
+        }
+
+        out.flush();
+
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+struct AudioFormatSeekIndexTests  : public UnitTest
+{
+    AudioFormatSeekIndexTests()
+        : UnitTest ("Audio format seek indexes", UnitTestCategories::audio)
+    {}
+
+    void runTest() override
+    {
+        beginTest ("Finding entries");
+        {
+            AudioFormatSeekIndex evenlySpaced, unevenlySpaced;
+
+            for (int i = 0; i < 10; ++i)
+            {
+                evenlySpaced.add (i * 4096, i * 1000);
+                unevenlySpaced.add (i * i * 100, i * 1000);
+            }
+
+            expectEquals (evenlySpaced.findEntryFor (0), 0);
+            expectEquals (evenlySpaced.findEntryFor (4095), 0);
+            expectEquals (evenlySpaced.findEntryFor (4096), 1);
+            expectEquals (evenlySpaced.findEntryFor (1000000), 9);
+            expectEquals (unevenlySpaced.findEntryFor (99), 0);
+            expectEquals (unevenlySpaced.findEntryFor (400), 2);
+            expectEquals (unevenlySpaced.findEntryFor (899), 2);
+            expectEquals (unevenlySpaced.findEntryFor (1000000), 9);
+            expectEquals (AudioFormatSeekIndex().findEntryFor (0), -1);
+        }
+
+       #if JUCE_USE_FLAC
+        {
+            FlacAudioFormat format;
+            beginTest ("Random access to FLAC");
+            testRandomAccess (format, createTestStream (format, 16));
+
+            beginTest ("Caching a FLAC index");
+            auto index = testCache (format);
+
+            beginTest ("Using a FLAC SEEKTABLE");
+            testSeekTable (format, index);
+        }
+       #endif
+
+       #if JUCE_USE_OGGVORBIS
+        {
+            OggVorbisAudioFormat format;
+            beginTest ("Random access to Ogg-Vorbis");
+            testRandomAccess (format, createTestStream (format, 5));
+        }
+       #endif
+    }
+
+    // long enough for the FLAC frame numbers to need more than one byte
+    static constexpr int numChannels = 2, numSamples = 600000;
+
+    static MemoryBlock createTestStream (AudioFormat& format, int qualityOptionIndex)
+    {
+        AudioBuffer<float> buffer (numChannels, numSamples);
+        Random r (0x5eed);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                buffer.setSample (ch, i, 0.5f * std::sin (0.003f * (float) (i * (ch + 1))) + 0.1f * (r.nextFloat() - 0.5f));
+
+        MemoryBlock block;
+        std::unique_ptr<AudioFormatWriter> writer (format.createWriterFor (new MemoryOutputStream (block, false),
+                                                                           44100.0, numChannels, 16, {}, qualityOptionIndex));
+        writer->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+        return block;
+    }
+
+    void testRandomAccess (AudioFormat& format, const MemoryBlock& stream)
+    {
+        std::unique_ptr<AudioFormatReader> sequentialReader (format.createReaderFor (new MemoryInputStream (stream, false), true));
+        std::unique_ptr<AudioFormatReader> randomReader (format.createReaderFor (new MemoryInputStream (stream, false), true));
+        expect (sequentialReader != nullptr && randomReader != nullptr);
+
+        auto length = (int) sequentialReader->lengthInSamples;
+        AudioBuffer<float> expected (numChannels, length), actual (numChannels, 3000);
+        sequentialReader->read (&expected, 0, length, 0, true, true);
+
+        auto check = [&] (int start, int num)
+        {
+            actual.clear();
+            randomReader->read (&actual, 0, num, start, true, true);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int i = 0; i < num; ++i)
+                    if (actual.getSample (ch, i) != expected.getSample (ch, start + i))
+                        return false;
+
+            return true;
+        };
+
+        Random r (0x1234);
+        bool allMatched = true;
+
+        for (int i = 0; i < 200; ++i)
+        {
+            auto num = 1 + r.nextInt (3000);
+            allMatched = check (r.nextInt (length - num), num) && allMatched;
+        }
+
+        expect (allMatched);
+
+        // reading backwards in small blocks, as a reversed sample playback would
+        for (int start = length - 300; start >= 0; start -= 300)
+            allMatched = check (start, 300) && allMatched;
+
+        expect (allMatched);
+    }
+
+   #if JUCE_USE_FLAC
+    struct ScopedTestDirectory
+    {
+        ~ScopedTestDirectory()  { directory.deleteRecursively(); }
+
+        const File directory { File::getSpecialLocation (File::tempDirectory).getNonexistentChildFile ("SeekIndexTest", {}) };
+    };
+
+    AudioFormatSeekIndex testCache (FlacAudioFormat& format)
+    {
+        TemporaryFile sourceFile (".flac");
+        ScopedTestDirectory tempDirectory;
+        auto cacheDirectory = tempDirectory.directory;
+
+        auto stream = createTestStream (format, 5);
+        sourceFile.getFile().replaceWithData (stream.getData(), stream.getSize());
+
+        AudioFormatSeekIndex index;
+        expect (! index.loadFromCache (cacheDirectory, sourceFile.getFile()));
+
+        format.setSeekIndexCacheDirectory (cacheDirectory);
+        std::unique_ptr<AudioFormatReader> reader (format.createReaderFor (sourceFile.getFile().createInputStream().release(), true));
+        format.setSeekIndexCacheDirectory ({});
+        expect (reader != nullptr);
+
+        // opening the file and reading it from the start doesn't need an index
+        AudioBuffer<float> buffer (numChannels, 1000);
+        reader->read (&buffer, 0, 1000, 0, true, true);
+        reader->read (&buffer, 0, 1000, 1000, true, true);
+        expect (! index.loadFromCache (cacheDirectory, sourceFile.getFile()));
+
+        reader->read (&buffer, 0, 1000, numSamples / 2, true, true);
+        expect (index.loadFromCache (cacheDirectory, sourceFile.getFile()));
+        expect (index.size() > 10);
+
+        return index;
+    }
+
+    // Makes a copy of a stream with a SEEKTABLE holding every few of the frames in an index
+    static MemoryBlock addSeekTable (const MemoryBlock& stream, const AudioFormatSeekIndex& index)
+    {
+        auto* data = static_cast<const uint8*> (stream.getData());
+        MemoryOutputStream out;
+        out.write (data, 4);
+
+        size_t position = 4;
+
+        for (bool isLastBlock = false; ! isLastBlock;)
+        {
+            isLastBlock = (data[position] & 0x80) != 0;
+            auto blockSize = 4 + (size_t) ((data[position + 1] << 16) | (data[position + 2] << 8) | data[position + 3]);
+
+            out.writeByte ((char) (data[position] & 0x7f));
+            out.write (data + position + 1, blockSize - 1);
+            position += blockSize;
+        }
+
+        const int pointSpacing = 7;
+        auto numPoints = (index.size() + pointSpacing - 1) / pointSpacing;
+        auto tableSize = numPoints * 18;
+
+        out.writeByte ((char) (0x80 | 3));
+        out.writeByte ((char) (tableSize >> 16));
+        out.writeByte ((char) (tableSize >> 8));
+        out.writeByte ((char) tableSize);
+
+        for (int i = 0; i < index.size(); i += pointSpacing)
+        {
+            auto& entry = index.getEntry (i);
+            auto nextSample = i + 1 < index.size() ? index.getEntry (i + 1).sampleNumber : (int64) numSamples;
+
+            out.writeInt64BigEndian (entry.sampleNumber);
+            out.writeInt64BigEndian (entry.byteOffset - (int64) position);
+            out.writeShortBigEndian ((short) (nextSample - entry.sampleNumber));
+        }
+
+        out.write (data + position, stream.getSize() - position);
+        return out.getMemoryBlock();
+    }
+
+    void testSeekTable (FlacAudioFormat& format, const AudioFormatSeekIndex& index)
+    {
+        auto stream = addSeekTable (createTestStream (format, 5), index);
+        testRandomAccess (format, stream);
+
+        // the seek table is used rather than scanning the stream, so no index gets cached
+        TemporaryFile sourceFile (".flac");
+        ScopedTestDirectory tempDirectory;
+        sourceFile.getFile().replaceWithData (stream.getData(), stream.getSize());
+
+        format.setSeekIndexCacheDirectory (tempDirectory.directory);
+        std::unique_ptr<AudioFormatReader> reader (format.createReaderFor (sourceFile.getFile().createInputStream().release(), true));
+        format.setSeekIndexCacheDirectory ({});
+        expect (reader != nullptr);
+
+        AudioBuffer<float> buffer (numChannels, 1000);
+        reader->read (&buffer, 0, 1000, numSamples / 2, true, true);
+
+        AudioFormatSeekIndex cachedIndex;
+        expect (! cachedIndex.loadFromCache (tempDirectory.directory, sourceFile.getFile()));
+    }
+   #endif
+};
+
+static AudioFormatSeekIndexTests audioFormatSeekIndexTests;
+
+#endif
+
+} // namespace juce
@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   By using JUCE, you agree to the terms of both the JUCE 6 End-User License
+   Agreement and JUCE Privacy Policy (both effective as of the 16th June 2020).
+
+   End User License Agreement: www.juce.com/juce-6-licence
+   Privacy Policy: www.juce.com/juce-privacy-policy
+
+   Or: You may also use this code under the terms of the GPL v3 (see
+   www.gnu.org/licenses).
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+//==============================================================================
+/**
+    A table of the positions of the frames (or pages) in a compressed audio stream.
+
+    A compressed stream can't tell you where a given sample is without searching for
+    it, which makes random access painfully slow. A reader can scan its stream once
+    to build one of these, and can then jump straight to the frame that contains any
+    sample.
+
+    Scanning means reading the whole stream, so the table can also be saved to a cache
+    directory and reloaded the next time the same file is opened.
+
+    @see FlacAudioFormat::setSeekIndexCacheDirectory,
+         OggVorbisAudioFormat::setSeekIndexCacheDirectory
+
+    @tags{Audio}
+*/
+class JUCE_API  AudioFormatSeekIndex
+{
+public:
+    //==============================================================================
+    /** Creates an empty index. */
+    AudioFormatSeekIndex() = default;
+
+    /** One position in the index. */
+    struct Entry
+    {
+        int64 sampleNumber;  /**< The first sample that the frame contains. */
+        int64 byteOffset;    /**< The position of the start of the frame in the stream. */
+    };
+
+    //==============================================================================
+    /** Removes all the entries. */
+    void clear() noexcept;
+
+    /** Adds an entry to the end of the index.
+        Entries must be added in order of increasing sample number.
+    */
+    void add (int64 sampleNumber, int64 byteOffset);
+
+    /** Returns the number of entries. */
+    int size() const noexcept                           { return (int) entries.size(); }
+
+    /** Returns true if there are no entries. */
+    bool isEmpty() const noexcept                       { return entries.empty(); }
+
+    /** Returns one of the entries. */
+    const Entry& getEntry (int index) const noexcept    { return entries[(size_t) index]; }
+
+    /** Returns the index of the last entry that starts at or before the given sample,
+        or -1 if there isn't one.
+
+        If the entries are all the same number of samples apart (as they are for a
+        fixed-blocksize FLAC stream), this is just a division rather than a search.
+    */
+    int findEntryFor (int64 sampleNumber) const noexcept;
+
+    //==============================================================================
+    /** Returns the file in which the index for the given source file would be cached. */
+    static File getCacheFile (const File& cacheDirectory, const File& sourceFile);
+
+    /** Tries to load the index from a cache file written by saveToCache().
+
+        This fails if the cache is missing or unreadable, or if the source file has
+        changed since the cache was written.
+    */
+    bool loadFromCache (const File& cacheDirectory, const File& sourceFile);
+
+    /** Writes the index to a cache file, replacing any older one. */
+    bool saveToCache (const File& cacheDirectory, const File& sourceFile) const;
+
+private:
+    //==============================================================================
+    std::vector<Entry> entries;
+    int64 interval = -1;
+
+    static String getSourceVersion (const File&);
+
+    JUCE_LEAK_DETECTOR (AudioFormatSeekIndex)
+};
+
+} // namespace juce
@@ -30,8 +30,33 @@ BufferingAudioReader::BufferingAudioReader (AudioFormatReader* sourceReader,
                                             TimeSliceThread& timeSliceThread,
                                             int samplesToBuffer)
     : AudioFormatReader (nullptr, sourceReader->getFormatName()),
-      source (sourceReader), thread (timeSliceThread),
+      source (sourceReader), thread (&timeSliceThread),
       numBlocks (1 + (samplesToBuffer / samplesPerBlock))
+{
+    initialise();
+    timeSliceThread.addTimeSliceClient (this);
+}
+
+BufferingAudioReader::BufferingAudioReader (AudioFormatReader* sourceReader,
+                                            BackgroundReadScheduler& scheduler,
+                                            int samplesToBuffer)
+    : AudioFormatReader (nullptr, sourceReader->getFormatName()),
+      source (sourceReader), readScheduler (&scheduler),
+      numBlocks (1 + (samplesToBuffer / samplesPerBlock))
+{
+    initialise();
+    scheduler.addClient (this);
+}
+
+BufferingAudioReader::~BufferingAudioReader()
+{
+    if (readScheduler != nullptr)
+        readScheduler->removeClient (this);
+    else
+        thread->removeTimeSliceClient (this);
+}
+
+void BufferingAudioReader::initialise()
 {
     sampleRate            = source->sampleRate;
     lengthInSamples       = source->lengthInSamples;
@@ -40,15 +65,13 @@ BufferingAudioReader::BufferingAudioReader (AudioFormatReader* sourceReader,
     bitsPerSample         = 32;
     usesFloatingPointData = true;
 
+    if (auto* fileStream = dynamic_cast<FileInputStream*> (source->input))
+        readGroup = fileStream->getFile().getFullPathName().hashCode64();
+    else
+        readGroup = (int64) (pointer_sized_int) this;
+
     for (int i = 3; --i >= 0;)
         readNextBufferChunk();
-
-    timeSliceThread.addTimeSliceClient (this);
-}
-
-BufferingAudioReader::~BufferingAudioReader()
-{
-    thread.removeTimeSliceClient (this);
 }
 
 void BufferingAudioReader::setReadTimeout (int timeoutMilliseconds) noexcept
@@ -132,6 +155,49 @@ int BufferingAudioReader::useTimeSlice()
     return readNextBufferChunk() ? 1 : 100;
 }
 
+int BufferingAudioReader::getMillisecondsUntilUnderrun()
+{
+    auto pos = nextReadPosition.load();
+    auto startPos = ((pos - 1024) / samplesPerBlock) * samplesPerBlock;
+    auto endPos = startPos + numBlocks * samplesPerBlock;
+    auto bufferedEnd = pos;
+    int numBlocksInRange = 0;
+
+    {
+        // The scheduler calls this while holding its own lock, so rather than waiting for
+        // a reader that's in the middle of copying samples, return the previous estimate
+        const ScopedTryLock sl (lock);
+
+        if (! sl.isLocked())
+            return lastUnderrunEstimate;
+
+        for (auto* b : blocks)
+            if (b->range.intersects (Range<int64> (startPos, endPos)))
+                ++numBlocksInRange;
+
+        while (auto* b = getBlockContaining (bufferedEnd))
+            bufferedEnd = b->range.getEnd();
+    }
+
+    // this is the same test that readNextBufferChunk() uses to decide whether to read
+    if (numBlocksInRange == numBlocks)
+        lastUnderrunEstimate = nothingToRead;
+    else
+        lastUnderrunEstimate = sampleRate > 0 ? (int) (((double) (bufferedEnd - pos) * 1000.0) / sampleRate) : 0;
+
+    return lastUnderrunEstimate;
+}
+
+bool BufferingAudioReader::readNextChunk()
+{
+    return readNextBufferChunk();
+}
+
+int64 BufferingAudioReader::getReadGroup()
+{
+    return readGroup;
+}
+
 bool BufferingAudioReader::readNextBufferChunk()
 {
     auto pos = nextReadPosition.load();
@@ -31,12 +31,16 @@ namespace juce
     An AudioFormatReader that uses a background thread to pre-read data from
     another reader.
 
-    @see AudioFormatReader
+    The reading can be done either by a TimeSliceThread, or by a BackgroundReadScheduler,
+    which is a better choice when there are lots of readers streaming at once.
+
+    @see AudioFormatReader, BackgroundReadScheduler
 
     @tags{Audio}
 */
 class JUCE_API  BufferingAudioReader  : public AudioFormatReader,
-                                        private TimeSliceClient
+                                        private TimeSliceClient,
+                                        private BackgroundReadScheduler::Client
 {
 public:
     /** Creates a reader.
@@ -53,6 +57,22 @@ public:
                           TimeSliceThread& timeSliceThread,
                           int samplesToBuffer);
 
+    /** Creates a reader which does its reading with a BackgroundReadScheduler.
+
+        @param sourceReader     the source reader to wrap. This BufferingAudioReader
+                                takes ownership of this object and will delete it later
+                                when no longer needed
+        @param readScheduler    the scheduler that should do the background reading. Make
+                                sure that it won't be deleted while the reader object still exists.
+        @param samplesToBuffer  the total number of samples to buffer ahead.
+
+        If the source reader is reading from a file, the scheduler will batch up its
+        reads with those of any other BufferingAudioReaders reading the same file.
+    */
+    BufferingAudioReader (AudioFormatReader* sourceReader,
+                          BackgroundReadScheduler& readScheduler,
+                          int samplesToBuffer);
+
     ~BufferingAudioReader() override;
 
     /** Sets a number of milliseconds that the reader can block for in its readSamples()
@@ -67,8 +87,11 @@ public:
 
 private:
     std::unique_ptr<AudioFormatReader> source;
-    TimeSliceThread& thread;
+    TimeSliceThread* thread = nullptr;
+    BackgroundReadScheduler* readScheduler = nullptr;
+    int64 readGroup = 0;
     std::atomic<int64> nextReadPosition { 0 };
+    std::atomic<int> lastUnderrunEstimate { 0 };
     const int numBlocks;
     int timeoutMs = 0;
 
@@ -86,9 +109,14 @@ private:
     OwnedArray<BufferedBlock> blocks;
 
     BufferedBlock* getBlockContaining (int64 pos) const noexcept;
+    void initialise();
     int useTimeSlice() override;
     bool readNextBufferChunk();
 
+    int getMillisecondsUntilUnderrun() override;
+    bool readNextChunk() override;
+    int64 getReadGroup() override;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BufferingAudioReader)
 };
 
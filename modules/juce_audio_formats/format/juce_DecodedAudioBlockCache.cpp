@@ -0,0 +1,444 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   By using JUCE, you agree to the terms of both the JUCE 6 End-User License
+   Agreement and JUCE Privacy Policy (both effective as of the 16th June 2020).
+
+   End User License Agreement: www.juce.com/juce-6-licence
+   Privacy Policy: www.juce.com/juce-privacy-policy
+
+   Or: You may also use this code under the terms of the GPL v3 (see
+   www.gnu.org/licenses).
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+// Each block can only live in one of this many slots, chosen by hashing its key, and
+// when they're all full the least-recently-used of them is evicted.
+static constexpr int decodedBlockCacheWays = 8;
+
+struct DecodedAudioBlockCache::Slot
+{
+    // This is odd while the slot is being rewritten. Readers copy the audio without
+    // taking a lock, and then check the sequence hasn't changed while they did so.
+    std::atomic<uint32> sequence { 0 };
+
+    std::atomic<uint64> sourceIdentity { 0 };
+    std::atomic<int64> blockIndex { -1 };
+    std::atomic<int> numChannels { 0 }, numSamples { 0 };
+    std::atomic<uint32> lastUsed { 0 };
+};
+
+//==============================================================================
+DecodedAudioBlockCache::DecodedAudioBlockCache (size_t maximumSizeInBytes, int blockSize)
+    : blockSizeInFloats (jmax (256, blockSize))
+{
+    auto bytesPerSet = (size_t) blockSizeInFloats * sizeof (float) * decodedBlockCacheWays;
+    numSets = jmax (1, (int) (maximumSizeInBytes / bytesPerSet));
+
+    auto numSlots = (size_t) numSets * decodedBlockCacheWays;
+    slots.reset (new Slot[numSlots]);
+    setLocks.reset (new SpinLock[(size_t) numSets]);
+    blockData.malloc (numSlots * (size_t) blockSizeInFloats);
+}
+
+DecodedAudioBlockCache::~DecodedAudioBlockCache() {}
+
+//==============================================================================
+double DecodedAudioBlockCache::Statistics::getHitRate() const noexcept
+{
+    auto numReads = numHits + numMisses;
+    return numReads > 0 ? (double) numHits / (double) numReads : 0.0;
+}
+
+DecodedAudioBlockCache::Statistics DecodedAudioBlockCache::getStatistics() const noexcept
+{
+    Statistics s;
+    s.numHits = numHits.load();
+    s.numMisses = numMisses.load();
+    s.numEvictions = numEvictions.load();
+    s.bytesInUse = bytesInUse.load();
+    s.bytesAllocated = (size_t) numSets * decodedBlockCacheWays * (size_t) blockSizeInFloats * sizeof (float);
+    return s;
+}
+
+void DecodedAudioBlockCache::resetStatistics() noexcept
+{
+    numHits = 0;
+    numMisses = 0;
+    numEvictions = 0;
+}
+
+void DecodedAudioBlockCache::clear()
+{
+    for (int set = 0; set < numSets; ++set)
+    {
+        const SpinLock::ScopedLockType sl (setLocks[(size_t) set]);
+
+        for (int way = 0; way < decodedBlockCacheWays; ++way)
+        {
+            auto& slot = slots[(size_t) (set * decodedBlockCacheWays + way)];
+            auto sequence = slot.sequence.load (std::memory_order_relaxed);
+
+            slot.sequence.store (sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence (std::memory_order_release);
+            slot.blockIndex.store (-1, std::memory_order_relaxed);
+            slot.sequence.store (sequence + 2, std::memory_order_release);
+        }
+    }
+
+    bytesInUse = 0;
+}
+
+//==============================================================================
+int DecodedAudioBlockCache::getSetIndex (uint64 sourceIdentity, int64 blockIndex) const noexcept
+{
+    auto hash = sourceIdentity ^ ((uint64) blockIndex * 0x9e3779b97f4a7c15ull);
+    hash ^= hash >> 29;
+    return (int) (hash % (uint64) numSets);
+}
+
+float* DecodedAudioBlockCache::getBlockData (int slotIndex) const noexcept
+{
+    return blockData.get() + (size_t) slotIndex * (size_t) blockSizeInFloats;
+}
+
+bool DecodedAudioBlockCache::readFromCache (uint64 sourceIdentity, int64 blockIndex, int numChannels, int numSamplesInBlock,
+                                            float* const* destChannels, int numDestChannels,
+                                            int startOffsetInBlock, int numSamples) noexcept
+{
+    auto firstSlot = getSetIndex (sourceIdentity, blockIndex) * decodedBlockCacheWays;
+    auto samplesPerBlock = blockSizeInFloats / numChannels;
+
+    for (int i = firstSlot; i < firstSlot + decodedBlockCacheWays; ++i)
+    {
+        auto& slot = slots[(size_t) i];
+        auto sequence = slot.sequence.load (std::memory_order_acquire);
+
+        if ((sequence & 1) != 0
+             || slot.blockIndex.load (std::memory_order_relaxed) != blockIndex
+             || slot.sourceIdentity.load (std::memory_order_relaxed) != sourceIdentity
+             || slot.numChannels.load (std::memory_order_relaxed) != numChannels
+             || slot.numSamples.load (std::memory_order_relaxed) != numSamplesInBlock)
+            continue;
+
+        auto* data = getBlockData (i);
+
+        for (int ch = 0; ch < numDestChannels; ++ch)
+            if (destChannels[ch] != nullptr)
+                memcpy (destChannels[ch], data + ch * samplesPerBlock + startOffsetInBlock, (size_t) numSamples * sizeof (float));
+
+        std::atomic_thread_fence (std::memory_order_acquire);
+
+        if (slot.sequence.load (std::memory_order_relaxed) == sequence)
+        {
+            slot.lastUsed.store (++useCounter, std::memory_order_relaxed);
+            ++numHits;
+            return true;
+        }
+
+        // the slot was rewritten while we were copying it, so this has to count as a miss
+        break;
+    }
+
+    ++numMisses;
+    return false;
+}
+
+void DecodedAudioBlockCache::addToCache (uint64 sourceIdentity, int64 blockIndex,
+                                         const AudioBuffer<float>& block, int numSamplesInBlock)
+{
+    auto set = getSetIndex (sourceIdentity, blockIndex);
+    auto firstSlot = set * decodedBlockCacheWays;
+    auto numChannels = block.getNumChannels();
+    auto samplesPerBlock = blockSizeInFloats / numChannels;
+
+    const SpinLock::ScopedLockType sl (setLocks[(size_t) set]);
+
+    auto now = useCounter.load();
+    int victim = -1;
+    uint32 oldestAge = 0;
+
+    for (int i = firstSlot; i < firstSlot + decodedBlockCacheWays; ++i)
+    {
+        auto& slot = slots[(size_t) i];
+        auto slotBlockIndex = slot.blockIndex.load (std::memory_order_relaxed);
+
+        // another reader may have decoded this block while we were doing the same
+        if (slotBlockIndex == blockIndex && slot.sourceIdentity.load (std::memory_order_relaxed) == sourceIdentity)
+            return;
+
+        auto age = slotBlockIndex < 0 ? std::numeric_limits<uint32>::max()
+                                      : now - slot.lastUsed.load (std::memory_order_relaxed);
+
+        if (victim < 0 || age > oldestAge)
+        {
+            victim = i;
+            oldestAge = age;
+        }
+    }
+
+    auto& slot = slots[(size_t) victim];
+
+    if (slot.blockIndex.load (std::memory_order_relaxed) >= 0)
+    {
+        ++numEvictions;
+        bytesInUse -= (size_t) (slot.numChannels.load() * slot.numSamples.load()) * sizeof (float);
+    }
+
+    auto sequence = slot.sequence.load (std::memory_order_relaxed);
+    slot.sequence.store (sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    auto* data = getBlockData (victim);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        memcpy (data + ch * samplesPerBlock, block.getReadPointer (ch), (size_t) numSamplesInBlock * sizeof (float));
+
+    slot.sourceIdentity.store (sourceIdentity, std::memory_order_relaxed);
+    slot.blockIndex.store (blockIndex, std::memory_order_relaxed);
+    slot.numChannels.store (numChannels, std::memory_order_relaxed);
+    slot.numSamples.store (numSamplesInBlock, std::memory_order_relaxed);
+    slot.lastUsed.store (++useCounter, std::memory_order_relaxed);
+    slot.sequence.store (sequence + 2, std::memory_order_release);
+
+    bytesInUse += (size_t) (numChannels * numSamplesInBlock) * sizeof (float);
+}
+
+//==============================================================================
+static uint64 getDecodedBlockCacheIdentity (const File& file)
+{
+    return (uint64) (file.getFullPathName()
+                      + ":" + String (file.getSize())
+                      + ":" + String (file.getLastModificationTime().toMilliseconds())).hashCode64();
+}
+
+DecodedAudioBlockCache::Reader::Reader (AudioFormatReader* sourceReader,
+                                        std::shared_ptr<DecodedAudioBlockCache> cacheToUse,
+                                        const File& sourceFile)
+    : AudioFormatReader (nullptr, sourceReader->getFormatName()),
+      source (sourceReader),
+      cache (std::move (cacheToUse)),
+      sourceIdentity (getDecodedBlockCacheIdentity (sourceFile)),
+      samplesPerBlock (cache->getBlockSizeInFloats() / (int) jmax (1u, sourceReader->numChannels))
+{
+    sampleRate            = source->sampleRate;
+    lengthInSamples       = source->lengthInSamples;
+    numChannels           = source->numChannels;
+    metadataValues        = source->metadataValues;
+    bitsPerSample         = 32;
+    usesFloatingPointData = true;
+
+    // a block has to have room for at least one sample from every channel!
+    jassert (samplesPerBlock > 0);
+
+    decodedBlock.setSize ((int) numChannels, samplesPerBlock);
+    destChannels.calloc (numChannels);
+}
+
+DecodedAudioBlockCache::Reader::~Reader() {}
+
+bool DecodedAudioBlockCache::Reader::readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                                                  int64 startSampleInFile, int numSamples)
+{
+    clearSamplesBeyondAvailableLength (destSamples, numDestChannels, startOffsetInDestBuffer,
+                                       startSampleInFile, numSamples, lengthInSamples);
+
+    auto numChannelsToCopy = jmin (numDestChannels, (int) numChannels);
+
+    while (numSamples > 0)
+    {
+        auto blockIndex = startSampleInFile / samplesPerBlock;
+        auto blockStart = blockIndex * samplesPerBlock;
+        auto offsetInBlock = (int) (startSampleInFile - blockStart);
+        auto numInBlock = (int) jmin ((int64) samplesPerBlock, lengthInSamples - blockStart);
+        auto numToCopy = jmin (numSamples, numInBlock - offsetInBlock);
+
+        for (int i = 0; i < numChannelsToCopy; ++i)
+            destChannels[i] = destSamples[i] != nullptr ? reinterpret_cast<float*> (destSamples[i]) + startOffsetInDestBuffer
+                                                        : nullptr;
+
+        if (! cache->readFromCache (sourceIdentity, blockIndex, (int) numChannels, numInBlock,
+                                    destChannels, numChannelsToCopy, offsetInBlock, numToCopy))
+        {
+            if (! source->read (decodedBlock.getArrayOfWritePointers(), (int) numChannels, blockStart, numInBlock))
+                return false;
+
+            cache->addToCache (sourceIdentity, blockIndex, decodedBlock, numInBlock);
+
+            for (int i = 0; i < numChannelsToCopy; ++i)
+                if (destChannels[i] != nullptr)
+                    memcpy (destChannels[i], decodedBlock.getReadPointer (i, offsetInBlock), (size_t) numToCopy * sizeof (float));
+        }
+
+        startSampleInFile += numToCopy;
+        startOffsetInDestBuffer += numToCopy;
+        numSamples -= numToCopy;
+    }
+
+    return true;
+}
+
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS && JUCE_USE_FLAC
+
+struct DecodedAudioBlockCacheTests  : public UnitTest
+{
+    DecodedAudioBlockCacheTests()
+        : UnitTest ("Decoded audio block cache", UnitTestCategories::audio)
+    {}
+
+    void runTest() override
+    {
+        TemporaryFile flacFile (".flac");
+        writeTestFile (flacFile.getFile());
+
+        AudioBuffer<float> expected;
+
+        {
+            std::unique_ptr<AudioFormatReader> reader (FlacAudioFormat().createReaderFor (flacFile.getFile().createInputStream().release(), true));
+            expected.setSize ((int) reader->numChannels, (int) reader->lengthInSamples);
+            reader->read (&expected, 0, expected.getNumSamples(), 0, true, true);
+        }
+
+        auto numBlocks = (expected.getNumSamples() + 8191) / 8192;
+
+        beginTest ("Readers share decoded blocks");
+        {
+            auto cache = std::make_shared<DecodedAudioBlockCache> ((size_t) 8 * 1024 * 1024);
+
+            AudioFormatManager manager;
+            manager.registerBasicFormats();
+            manager.setDecodedBlockCache (cache);
+
+            std::unique_ptr<AudioFormatReader> first (manager.createReaderFor (flacFile.getFile()));
+            std::unique_ptr<AudioFormatReader> second (manager.createReaderFor (flacFile.getFile()));
+            expect (dynamic_cast<DecodedAudioBlockCache::Reader*> (first.get()) != nullptr);
+
+            expect (readsCorrectly (*first, expected, 0, expected.getNumSamples()));
+            expectEquals ((int) cache->getStatistics().numMisses, numBlocks);
+            expectEquals ((int) cache->getStatistics().numHits, 0);
+
+            expect (readsCorrectly (*second, expected, 0, expected.getNumSamples()));
+            expectEquals ((int) cache->getStatistics().numHits, numBlocks);
+            expectEquals (cache->getStatistics().getHitRate(), 0.5);
+            expectEquals (cache->getStatistics().bytesInUse, (size_t) expected.getNumChannels() * (size_t) expected.getNumSamples() * sizeof (float));
+
+            cache->clear();
+            expectEquals (cache->getStatistics().bytesInUse, (size_t) 0);
+            expect (readsCorrectly (*second, expected, 1000, 20000));
+            expectEquals ((int) cache->getStatistics().numMisses, numBlocks + 3);
+        }
+
+        beginTest ("Eviction");
+        {
+            // room for 8 of the file's blocks
+            auto cache = std::make_shared<DecodedAudioBlockCache> ((size_t) 8 * 16384 * sizeof (float));
+
+            DecodedAudioBlockCache::Reader reader (FlacAudioFormat().createReaderFor (flacFile.getFile().createInputStream().release(), true),
+                                                   cache, flacFile.getFile());
+
+            expect (readsCorrectly (reader, expected, 0, expected.getNumSamples()));
+            expect (readsCorrectly (reader, expected, 0, expected.getNumSamples()));
+
+            auto stats = cache->getStatistics();
+            expectEquals ((int) stats.numEvictions, 2 * numBlocks - 8);
+            expectEquals ((int) stats.numHits, 0);
+            expect (stats.bytesInUse <= stats.bytesAllocated);
+        }
+
+        beginTest ("Concurrent readers");
+        {
+            auto cache = std::make_shared<DecodedAudioBlockCache> ((size_t) 8 * 16384 * sizeof (float));
+            std::atomic<int> numFailures { 0 };
+            OwnedArray<Thread> threads;
+
+            for (int i = 0; i < 4; ++i)
+            {
+                threads.add (new ReaderThread (flacFile.getFile(), cache, expected, numFailures, i));
+                threads.getLast()->startThread();
+            }
+
+            for (auto* t : threads)
+                t->stopThread (-1);
+
+            expectEquals (numFailures.load(), 0);
+            expect (cache->getStatistics().numHits > 0);
+        }
+    }
+
+    static void writeTestFile (const File& file)
+    {
+        AudioBuffer<float> buffer (2, 100000);
+        Random r (0x1234);
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample (ch, i, 0.5f * std::sin (0.01f * (float) (i * (ch + 1))) + 0.1f * (r.nextFloat() - 0.5f));
+
+        std::unique_ptr<AudioFormatWriter> writer (FlacAudioFormat().createWriterFor (file.createOutputStream().release(),
+                                                                                      44100.0, 2, 16, {}, 0));
+        writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+    }
+
+    static bool readsCorrectly (AudioFormatReader& reader, const AudioBuffer<float>& expected, int start, int num)
+    {
+        AudioBuffer<float> actual (expected.getNumChannels(), num);
+        reader.read (&actual, 0, num, start, true, true);
+
+        for (int ch = 0; ch < expected.getNumChannels(); ++ch)
+            if (memcmp (actual.getReadPointer (ch), expected.getReadPointer (ch, start), (size_t) num * sizeof (float)) != 0)
+                return false;
+
+        return true;
+    }
+
+    struct ReaderThread  : public Thread
+    {
+        ReaderThread (const File& f, std::shared_ptr<DecodedAudioBlockCache> c,
+                      const AudioBuffer<float>& e, std::atomic<int>& failures, int seed)
+            : Thread ("Cache test reader"), file (f), cache (std::move (c)), expected (e), numFailures (failures), random (seed)
+        {
+        }
+
+        void run() override
+        {
+            DecodedAudioBlockCache::Reader reader (FlacAudioFormat().createReaderFor (file.createInputStream().release(), true),
+                                                   cache, file);
+
+            for (int i = 0; i < 100; ++i)
+            {
+                auto num = 1 + random.nextInt (20000);
+
+                if (! readsCorrectly (reader, expected, random.nextInt (expected.getNumSamples() - num), num))
+                    ++numFailures;
+            }
+        }
+
+        File file;
+        std::shared_ptr<DecodedAudioBlockCache> cache;
+        const AudioBuffer<float>& expected;
+        std::atomic<int>& numFailures;
+        Random random;
+    };
+};
+
+static DecodedAudioBlockCacheTests decodedAudioBlockCacheTests;
+
+#endif
+
+} // namespace juce
@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   By using JUCE, you agree to the terms of both the JUCE 6 End-User License
+   Agreement and JUCE Privacy Policy (both effective as of the 16th June 2020).
+
+   End User License Agreement: www.juce.com/juce-6-licence
+   Privacy Policy: www.juce.com/juce-privacy-policy
+
+   Or: You may also use this code under the terms of the GPL v3 (see
+   www.gnu.org/licenses).
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+//==============================================================================
+/**
+    A fixed-size cache of decoded audio, shared between readers of the same files.
+
+    When several readers are playing the same compressed file, each of them would
+    normally decode it for itself. If they're created as DecodedAudioBlockCache::Reader
+    objects that share one of these caches, each block of audio only needs decoding
+    once, and is then copied from the cache until it's evicted to make room for
+    something more recently used.
+
+    The cache is split into blocks of a fixed number of floats, and the number of
+    samples in a block depends on how many channels its file has. Blocks are identified
+    by the path, size and modification time of their file, so editing a file makes its
+    old blocks unreachable, and they'll eventually be evicted.
+
+    Reading a block that's in the cache doesn't take any locks, so readers on different
+    threads never hold each other up on a cache hit. Adding a block takes a lock that
+    covers a small part of the cache.
+
+    An easy way to use one of these is with AudioFormatManager::setDecodedBlockCache().
+
+    @see AudioFormatManager::setDecodedBlockCache
+
+    @tags{Audio}
+*/
+class JUCE_API  DecodedAudioBlockCache
+{
+public:
+    //==============================================================================
+    /** Creates a cache that will use at most the given number of bytes for audio.
+
+        The blockSizeInFloats is the size of the unit in which audio is decoded and
+        evicted. For a stereo file, the default block holds 8192 samples.
+    */
+    explicit DecodedAudioBlockCache (size_t maximumSizeInBytes, int blockSizeInFloats = 16384);
+
+    /** Destructor. */
+    ~DecodedAudioBlockCache();
+
+    //==============================================================================
+    /** Some statistics about how well the cache is working. */
+    struct Statistics
+    {
+        int64 numHits = 0;          /**< The number of block reads that were found in the cache. */
+        int64 numMisses = 0;        /**< The number of block reads that had to be decoded. */
+        int64 numEvictions = 0;     /**< The number of blocks removed to make room for others. */
+        size_t bytesInUse = 0;      /**< The amount of decoded audio being held. */
+        size_t bytesAllocated = 0;  /**< The total space available for decoded audio. */
+
+        /** Returns the proportion of block reads that were found in the cache. */
+        double getHitRate() const noexcept;
+    };
+
+    /** Returns the current statistics. */
+    Statistics getStatistics() const noexcept;
+
+    /** Resets the hit, miss and eviction counts to zero. */
+    void resetStatistics() noexcept;
+
+    /** Removes all the blocks from the cache. */
+    void clear();
+
+    /** Returns the size of a block in floats. */
+    int getBlockSizeInFloats() const noexcept       { return blockSizeInFloats; }
+
+    //==============================================================================
+    /**
+        An AudioFormatReader that reads another reader's audio through a cache.
+
+        The cache is shared with any other Readers for the same file, so whichever of
+        them reads a block first decodes it for the others.
+
+        @tags{Audio}
+    */
+    class JUCE_API  Reader  : public AudioFormatReader
+    {
+    public:
+        /** Creates a reader that reads from sourceReader via the cache.
+
+            The sourceReader will be deleted by this object, and sourceFile must be the
+            file that it's reading.
+        */
+        Reader (AudioFormatReader* sourceReader,
+                std::shared_ptr<DecodedAudioBlockCache> cache,
+                const File& sourceFile);
+
+        /** Destructor. */
+        ~Reader() override;
+
+        //==============================================================================
+        bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                          int64 startSampleInFile, int numSamples) override;
+
+    private:
+        std::unique_ptr<AudioFormatReader> source;
+        std::shared_ptr<DecodedAudioBlockCache> cache;
+        const uint64 sourceIdentity;
+        const int samplesPerBlock;
+        AudioBuffer<float> decodedBlock;
+        HeapBlock<float*> destChannels;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Reader)
+    };
+
+private:
+    //==============================================================================
+    struct Slot;
+
+    const int blockSizeInFloats;
+    int numSets = 0;
+    std::unique_ptr<Slot[]> slots;
+    std::unique_ptr<SpinLock[]> setLocks;
+    HeapBlock<float> blockData;
+    std::atomic<uint32> useCounter { 0 };
+    std::atomic<int64> numHits { 0 }, numMisses { 0 }, numEvictions { 0 };
+    std::atomic<size_t> bytesInUse { 0 };
+
+    int getSetIndex (uint64 sourceIdentity, int64 blockIndex) const noexcept;
+    float* getBlockData (int slotIndex) const noexcept;
+
+    bool readFromCache (uint64 sourceIdentity, int64 blockIndex, int numChannels, int numSamplesInBlock,
+                        float* const* destChannels, int numDestChannels, int startOffsetInBlock, int numSamples) noexcept;
+
+    void addToCache (uint64 sourceIdentity, int64 blockIndex, const AudioBuffer<float>& block, int numSamplesInBlock);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DecodedAudioBlockCache)
+};
+
+} // namespace juce
@@ -0,0 +1,546 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   By using JUCE, you agree to the terms of both the JUCE 6 End-User License
+   Agreement and JUCE Privacy Policy (both effective as of the 16th June 2020).
+
+   End User License Agreement: www.juce.com/juce-6-licence
+   Privacy Policy: www.juce.com/juce-privacy-policy
+
+   Or: You may also use this code under the terms of the GPL v3 (see
+   www.gnu.org/licenses).
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+//==============================================================================
+/*  Collects whatever's written into blocks that end on a multiple of the block
+    size, so that the file is written in large aligned pieces. Seeking (which the
+    writers only do to update their headers) flushes the current block early.
+*/
+class MultiTrackAudioWriter::AlignedFileOutputStream  : public OutputStream
+{
+public:
+    AlignedFileOutputStream (const File& file, int blockSizeToUse, int64 bytesToPreallocate)
+        : blockSize ((int64) jmax (512, blockSizeToUse)),
+          block ((size_t) blockSize)
+    {
+        file.deleteFile();
+        stream = std::make_unique<FileOutputStream> (file, 0);
+
+        if (stream->failedToOpen())
+            return;
+
+        // extend the file to its full size up front, rather than writing anything into it
+        if (bytesToPreallocate > 0
+             && stream->setPosition (bytesToPreallocate)
+             && stream->truncate().wasOk())
+        {
+            wasPreallocated = true;
+        }
+
+        stream->setPosition (0);
+    }
+
+    ~AlignedFileOutputStream() override
+    {
+        if (stream->failedToOpen())
+            return;
+
+        writeBlock();
+
+        // trim off any of the preallocated space that wasn't needed
+        if (wasPreallocated && stream->setPosition (endOfData))
+            stream->truncate();
+    }
+
+    bool openedOk() const noexcept           { return stream->openedOk(); }
+
+    int64 getPosition() override             { return blockStart + (int64) bytesInBlock; }
+
+    bool setPosition (int64 newPosition) override
+    {
+        if (newPosition == getPosition())
+            return true;
+
+        if (! writeBlock() || ! stream->setPosition (newPosition))
+            return false;
+
+        blockStart = newPosition;
+        return true;
+    }
+
+    void flush() override
+    {
+        writeBlock();
+        stream->flush();
+    }
+
+    bool write (const void* data, size_t numBytes) override
+    {
+        auto* src = static_cast<const char*> (data);
+
+        while (numBytes > 0)
+        {
+            auto position = getPosition();
+
+            // when the position is aligned and there's at least a block to write,
+            // it can go straight to the file without being copied
+            if (bytesInBlock == 0 && position % blockSize == 0 && numBytes >= (size_t) blockSize)
+            {
+                auto numToWrite = (size_t) (((int64) numBytes / blockSize) * blockSize);
+
+                if (! stream->write (src, numToWrite))
+                    return false;
+
+                blockStart += (int64) numToWrite;
+                endOfData = jmax (endOfData, blockStart);
+                src += numToWrite;
+                numBytes -= numToWrite;
+                continue;
+            }
+
+            auto endOfBlock = (blockStart / blockSize + 1) * blockSize;
+            auto numToCopy = jmin (numBytes, (size_t) (endOfBlock - position));
+
+            memcpy (block + bytesInBlock, src, numToCopy);
+            bytesInBlock += numToCopy;
+            src += numToCopy;
+            numBytes -= numToCopy;
+
+            if (getPosition() == endOfBlock && ! writeBlock())
+                return false;
+        }
+
+        return true;
+    }
+
+private:
+    std::unique_ptr<FileOutputStream> stream;
+    const int64 blockSize;
+    HeapBlock<char> block;
+    int64 blockStart = 0, endOfData = 0;
+    size_t bytesInBlock = 0;
+    bool wasPreallocated = false;
+
+    bool writeBlock()
+    {
+        if (bytesInBlock == 0)
+            return true;
+
+        auto ok = stream->write (block, bytesInBlock);
+        blockStart += (int64) bytesInBlock;
+        endOfData = jmax (endOfData, blockStart);
+        bytesInBlock = 0;
+        return ok;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (AlignedFileOutputStream)
+};
+
+//==============================================================================
+struct MultiTrackAudioWriter::Track
+{
+    Track (AudioFormatWriter* w, int fifoSize)
+        : writer (w),
+          fifo (fifoSize + 1),
+          buffer ((int) w->getNumChannels(), fifoSize + 1)
+    {
+    }
+
+    float getFifoUsage (int numReady) const noexcept
+    {
+        return (float) numReady / (float) (fifo.getTotalSize() - 1);
+    }
+
+    std::unique_ptr<AudioFormatWriter> writer;
+    AbstractFifo fifo;
+    AudioBuffer<float> buffer;
+
+    // these are only modified by the thread that calls write()..
+    std::atomic<int64> numSamplesDropped { 0 }, numOverruns { 0 };
+    std::atomic<int> peakNumReady { 0 };
+
+    // ..and these by the disk thread
+    std::atomic<int64> numSamplesWritten { 0 }, numDiskWrites { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (Track)
+};
+
+//==============================================================================
+class MultiTrackAudioWriter::DiskThread  : public Thread
+{
+public:
+    DiskThread (MultiTrackAudioWriter& o)  : Thread ("Multi-track audio writer"), owner (o) {}
+
+    void run() override
+    {
+        // write() doesn't wake this thread up, as that could block the audio thread,
+        // so it just checks the FIFOs regularly instead
+        while (! threadShouldExit())
+            if (! owner.writeReadyData (false))
+                wait (5);
+    }
+
+private:
+    MultiTrackAudioWriter& owner;
+
+    JUCE_DECLARE_NON_COPYABLE (DiskThread)
+};
+
+//==============================================================================
+MultiTrackAudioWriter::MultiTrackAudioWriter()  : MultiTrackAudioWriter (Options())
+{
+}
+
+MultiTrackAudioWriter::MultiTrackAudioWriter (const Options& o)
+    : options (o)
+{
+    jassert (options.fifoSizeSamples > 0 && options.samplesPerWrite > 0);
+    options.samplesPerWrite = jlimit (1, jmax (1, options.fifoSizeSamples), options.samplesPerWrite);
+}
+
+MultiTrackAudioWriter::~MultiTrackAudioWriter()
+{
+    stop();
+}
+
+int MultiTrackAudioWriter::addTrack (AudioFormatWriter* writerToUse)
+{
+    jassert (! isRunning()); // tracks can't be added while the writer is running!
+
+    if (writerToUse == nullptr || isRunning())
+    {
+        delete writerToUse;
+        return -1;
+    }
+
+    tracks.add (new Track (writerToUse, options.fifoSizeSamples));
+    return tracks.size() - 1;
+}
+
+int MultiTrackAudioWriter::addTrack (const File& file, AudioFormat& format, double sampleRate,
+                                     int numChannels, int bitsPerSample,
+                                     const StringPairArray& metadataValues, int qualityOptionIndex)
+{
+    jassert (! isRunning()); // tracks can't be added while the writer is running!
+
+    if (isRunning())
+        return -1;
+
+    auto stream = std::make_unique<AlignedFileOutputStream> (file, options.diskBlockSize,
+                                                             options.preallocatedBytesPerFile);
+
+    if (! stream->openedOk())
+        return -1;
+
+    if (auto* writer = format.createWriterFor (stream.get(), sampleRate, (unsigned int) numChannels,
+                                               bitsPerSample, metadataValues, qualityOptionIndex))
+    {
+        stream.release();
+        return addTrack (writer);
+    }
+
+    return -1;
+}
+
+int MultiTrackAudioWriter::getNumTracks() const noexcept
+{
+    return tracks.size();
+}
+
+//==============================================================================
+void MultiTrackAudioWriter::start()
+{
+    if (isRunning())
+        return;
+
+    // once a writer has been stopped, its tracks are closed, so you'll need to
+    // call clearTracks() and add some new ones before starting it again
+    jassert (std::none_of (tracks.begin(), tracks.end(), [] (Track* t) { return t->writer == nullptr; }));
+
+    if (diskThread == nullptr)
+        diskThread = std::make_unique<DiskThread> (*this);
+
+    running = true;
+    diskThread->startThread (options.threadPriority);
+}
+
+void MultiTrackAudioWriter::stop()
+{
+    if (! running.exchange (false))
+        return;
+
+    diskThread->stopThread (-1);
+
+    writeReadyData (true);
+
+    for (auto* track : tracks)
+        track->writer.reset();
+}
+
+bool MultiTrackAudioWriter::isRunning() const noexcept
+{
+    return running;
+}
+
+void MultiTrackAudioWriter::clearTracks()
+{
+    stop();
+    tracks.clear();
+}
+
+//==============================================================================
+bool MultiTrackAudioWriter::write (int trackIndex, const float* const* data, int numSamples) noexcept
+{
+    if (! running.load (std::memory_order_acquire))
+        return false;
+
+    auto* track = tracks[trackIndex];
+
+    if (track == nullptr)
+    {
+        jassertfalse;
+        return false;
+    }
+
+    if (numSamples <= 0)
+        return true;
+
+    int start1, size1, start2, size2;
+    track->fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+    if (size1 + size2 < numSamples)
+    {
+        track->numOverruns.store (track->numOverruns.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        track->numSamplesDropped.store (track->numSamplesDropped.load (std::memory_order_relaxed) + numSamples, std::memory_order_relaxed);
+        return false;
+    }
+
+    for (int i = track->buffer.getNumChannels(); --i >= 0;)
+    {
+        track->buffer.copyFrom (i, start1, data[i], size1);
+
+        if (size2 > 0)
+            track->buffer.copyFrom (i, start2, data[i] + size1, size2);
+    }
+
+    track->fifo.finishedWrite (numSamples);
+
+    auto numReady = track->fifo.getNumReady();
+
+    if (numReady > track->peakNumReady.load (std::memory_order_relaxed))
+        track->peakNumReady.store (numReady, std::memory_order_relaxed);
+
+    return true;
+}
+
+float MultiTrackAudioWriter::getFifoUsage (int trackIndex) const noexcept
+{
+    if (auto* track = tracks[trackIndex])
+        return track->getFifoUsage (track->fifo.getNumReady());
+
+    return 0.0f;
+}
+
+bool MultiTrackAudioWriter::writeReadyData (bool writeEverything)
+{
+    bool anythingWritten = false;
+
+    for (auto* track : tracks)
+    {
+        if (track->writer == nullptr)
+            continue;
+
+        auto numReady = track->fifo.getNumReady();
+
+        if (numReady == 0 || (numReady < options.samplesPerWrite && ! writeEverything))
+            continue;
+
+        int start1, size1, start2, size2;
+        track->fifo.prepareToRead (numReady, start1, size1, start2, size2);
+
+        track->writer->writeFromAudioSampleBuffer (track->buffer, start1, size1);
+
+        if (size2 > 0)
+            track->writer->writeFromAudioSampleBuffer (track->buffer, start2, size2);
+
+        track->fifo.finishedRead (size1 + size2);
+
+        track->numSamplesWritten += size1 + size2;
+        ++(track->numDiskWrites);
+        anythingWritten = true;
+    }
+
+    return anythingWritten;
+}
+
+//==============================================================================
+MultiTrackAudioWriter::Statistics MultiTrackAudioWriter::getTrackStatistics (int trackIndex) const
+{
+    Statistics s;
+
+    if (auto* track = tracks[trackIndex])
+    {
+        s.numSamplesWritten = track->numSamplesWritten;
+        s.numSamplesDropped = track->numSamplesDropped;
+        s.numOverruns       = track->numOverruns;
+        s.numDiskWrites     = track->numDiskWrites;
+        s.peakFifoUsage     = track->getFifoUsage (track->peakNumReady);
+    }
+
+    return s;
+}
+
+MultiTrackAudioWriter::Statistics MultiTrackAudioWriter::getStatistics() const
+{
+    Statistics total;
+
+    for (int i = 0; i < tracks.size(); ++i)
+    {
+        auto s = getTrackStatistics (i);
+
+        total.numSamplesWritten += s.numSamplesWritten;
+        total.numSamplesDropped += s.numSamplesDropped;
+        total.numOverruns       += s.numOverruns;
+        total.numDiskWrites     += s.numDiskWrites;
+        total.peakFifoUsage      = jmax (total.peakFifoUsage, s.peakFifoUsage);
+    }
+
+    return total;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+struct MultiTrackAudioWriterTests  : public UnitTest
+{
+    MultiTrackAudioWriterTests()  : UnitTest ("MultiTrackAudioWriter", UnitTestCategories::audio) {}
+
+    static float getSample (int track, int channel, int64 index)
+    {
+        auto value = (int) ((index * 7919 + track * 104729 + channel * 1299709) % 8388608) - 4194304;
+        return (float) value / 8388608.0f;
+    }
+
+    struct ScopedTestDirectory
+    {
+        ~ScopedTestDirectory()  { directory.deleteRecursively(); }
+
+        const File directory { File::getSpecialLocation (File::tempDirectory).getNonexistentChildFile ("MultiTrackAudioWriterTest", {}) };
+    };
+
+    void runTest() override
+    {
+        const int numTracks = 8, numChannels = 2, blockSize = 256, numBlocks = 200;
+        const int64 totalSamples = (int64) blockSize * numBlocks;
+
+        MultiTrackAudioWriter::Options options;
+        options.fifoSizeSamples = 8192;
+        options.samplesPerWrite = 2048;
+        options.diskBlockSize = 4096;
+        options.preallocatedBytesPerFile = 1 << 20;
+
+        ScopedTestDirectory tempDir;
+        auto dir = tempDir.directory;
+        dir.createDirectory();
+
+        WavAudioFormat wav;
+        Array<File> files;
+
+        beginTest ("Recording many tracks");
+        {
+            MultiTrackAudioWriter writer (options);
+
+            for (int t = 0; t < numTracks; ++t)
+            {
+                files.add (dir.getChildFile ("track" + String (t) + ".wav"));
+                expectEquals (writer.addTrack (files.getLast(), wav, 44100.0, numChannels, 24), t);
+                expectEquals (files.getLast().getSize(), options.preallocatedBytesPerFile);
+            }
+
+            AudioBuffer<float> block (numChannels, blockSize);
+            expect (! writer.write (0, block.getArrayOfReadPointers(), blockSize));
+
+            writer.start();
+            expect (writer.isRunning());
+
+            for (int b = 0; b < numBlocks; ++b)
+            {
+                for (int t = 0; t < numTracks; ++t)
+                {
+                    for (int ch = 0; ch < numChannels; ++ch)
+                        for (int i = 0; i < blockSize; ++i)
+                            block.setSample (ch, i, getSample (t, ch, (int64) b * blockSize + i));
+
+                    while (writer.getFifoUsage (t) > 0.75f)
+                        Thread::sleep (1);
+
+                    expect (writer.write (t, block.getArrayOfReadPointers(), blockSize));
+                }
+            }
+
+            AudioBuffer<float> tooBig (numChannels, options.fifoSizeSamples + 1);
+            expect (! writer.write (0, tooBig.getArrayOfReadPointers(), tooBig.getNumSamples()));
+
+            writer.stop();
+            expect (! writer.isRunning());
+
+            auto stats = writer.getStatistics();
+            expectEquals (stats.numSamplesWritten, totalSamples * numTracks);
+            expectEquals (stats.numOverruns, (int64) 1);
+            expectEquals (stats.numSamplesDropped, (int64) tooBig.getNumSamples());
+            expect (stats.peakFifoUsage > 0.0f && stats.peakFifoUsage <= 1.0f);
+
+            // data should have gone to disk in batches rather than one block at a time
+            expect (stats.numDiskWrites < (int64) numBlocks * numTracks / 4);
+        }
+
+        beginTest ("Recorded files are intact and trimmed");
+        {
+            for (int t = 0; t < numTracks; ++t)
+            {
+                std::unique_ptr<AudioFormatReader> reader (wav.createReaderFor (files[t].createInputStream().release(), true));
+                expect (reader != nullptr);
+
+                if (reader == nullptr)
+                    continue;
+
+                expectEquals (reader->lengthInSamples, totalSamples);
+                expect (files[t].getSize() < options.preallocatedBytesPerFile);
+                expect (files[t].getSize() >= totalSamples * numChannels * 3);
+
+                AudioBuffer<float> result (numChannels, (int) totalSamples);
+                reader->read (&result, 0, (int) totalSamples, 0, true, true);
+
+                int numErrors = 0;
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                    for (int i = 0; i < (int) totalSamples; ++i)
+                        if (std::abs (result.getSample (ch, i) - getSample (t, ch, i)) > 1.0f / 8388607.0f)
+                            ++numErrors;
+
+                expectEquals (numErrors, 0);
+            }
+        }
+    }
+};
+
+static MultiTrackAudioWriterTests multiTrackAudioWriterTests;
+
+#endif
+
+} // namespace juce
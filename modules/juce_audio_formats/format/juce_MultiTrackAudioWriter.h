@@ -0,0 +1,196 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   By using JUCE, you agree to the terms of both the JUCE 6 End-User License
+   Agreement and JUCE Privacy Policy (both effective as of the 16th June 2020).
+
+   End User License Agreement: www.juce.com/juce-6-licence
+   Privacy Policy: www.juce.com/juce-privacy-policy
+
+   Or: You may also use this code under the terms of the GPL v3 (see
+   www.gnu.org/licenses).
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+//==============================================================================
+/**
+    Records many tracks of audio to disk from a single background thread.
+
+    AudioFormatWriter::ThreadedWriter gives each file its own FIFO and services it
+    from a TimeSliceThread, which is fine for a few files but means lots of small
+    writes when recording a large session. A MultiTrackAudioWriter holds a lock-free
+    FIFO for each track, and a single disk thread that waits until a track has built
+    up a reasonable amount of audio before writing it out in one go.
+
+    Tracks that are created from a File are written through a stream that only
+    issues writes in whole, aligned blocks, and which can set the file's size up front
+    so that it doesn't need to be grown as recording goes on.
+
+    To use it, add all your tracks, call start(), push audio into it from your audio
+    callback with write(), and then call stop() to write out whatever's left and close
+    the files. The getStatistics() method will tell you whether the disk thread has
+    been keeping up.
+
+    @see AudioFormatWriter::ThreadedWriter
+
+    @tags{Audio}
+*/
+class JUCE_API  MultiTrackAudioWriter
+{
+public:
+    //==============================================================================
+    /** Settings that control how a MultiTrackAudioWriter buffers its tracks. */
+    struct Options
+    {
+        /** The number of samples that each track's FIFO can hold. */
+        int fifoSizeSamples = 65536;
+
+        /** The disk thread waits until a track has at least this many samples before
+            writing it, unless the writer is stopping.
+        */
+        int samplesPerWrite = 16384;
+
+        /** For tracks created from a File, the size of the blocks in which the file
+            is written. Writes are aligned to multiples of this size within the file.
+        */
+        int diskBlockSize = 256 * 1024;
+
+        /** For tracks created from a File, the size to extend the file to when it is
+            opened. This only changes the file's length, so it doesn't write anything,
+            but it saves the file system from having to grow the file with every write.
+            Any of this that isn't used will be trimmed off when the track is closed.
+        */
+        int64 preallocatedBytesPerFile = 0;
+
+        /** The priority to give the disk thread, from 0 to 10. */
+        int threadPriority = 6;
+    };
+
+    //==============================================================================
+    /** Creates a writer with no tracks, using the default Options. */
+    MultiTrackAudioWriter();
+
+    /** Creates a writer with no tracks. */
+    explicit MultiTrackAudioWriter (const Options& options);
+
+    /** Destructor.
+        If the writer is still running, this will call stop() and block until all
+        the buffered audio has been written.
+    */
+    ~MultiTrackAudioWriter();
+
+    //==============================================================================
+    /** Adds a track that will be written to the given AudioFormatWriter.
+
+        The writer will be deleted when the track is closed. This can't be called
+        while the writer is running.
+
+        @returns the index of the new track, which you'll pass to write()
+    */
+    int addTrack (AudioFormatWriter* writerToUse);
+
+    /** Creates a new file and adds a track that will record into it.
+
+        Any existing file will be replaced. The file is written using a stream that
+        makes aligned writes and preallocates space according to this object's Options.
+        This can't be called while the writer is running.
+
+        @returns the index of the new track, or -1 if the file or writer couldn't
+                 be created
+    */
+    int addTrack (const File& file,
+                  AudioFormat& format,
+                  double sampleRate,
+                  int numChannels,
+                  int bitsPerSample,
+                  const StringPairArray& metadataValues = {},
+                  int qualityOptionIndex = 0);
+
+    /** Returns the number of tracks that have been added. */
+    int getNumTracks() const noexcept;
+
+    //==============================================================================
+    /** Starts the disk thread, after which write() can be called. */
+    void start();
+
+    /** Stops accepting audio, writes out everything that's buffered, and closes all
+        the tracks' files.
+
+        The tracks' statistics remain available until clearTracks() is called.
+    */
+    void stop();
+
+    /** Returns true if the writer has been started and not stopped. */
+    bool isRunning() const noexcept;
+
+    /** Removes all the tracks, stopping the writer first if necessary. */
+    void clearTracks();
+
+    //==============================================================================
+    /** Pushes a block of audio into one of the tracks.
+
+        This never blocks, allocates or signals another thread, so it's safe to call
+        from the audio thread. Each track must only be written to by one thread.
+
+        The data must contain as many channels as the track's AudioFormatWriter. If
+        there isn't room in the track's FIFO for the whole block, nothing is added,
+        the overrun is counted in the track's statistics, and this returns false.
+    */
+    bool write (int trackIndex, const float* const* data, int numSamples) noexcept;
+
+    /** Returns how full a track's FIFO is at the moment, from 0 to 1.
+        You could use this to detect that the disk isn't keeping up before the
+        FIFO actually overruns.
+    */
+    float getFifoUsage (int trackIndex) const noexcept;
+
+    //==============================================================================
+    /** Some statistics about how well the disk thread is keeping up. */
+    struct Statistics
+    {
+        int64 numSamplesWritten = 0;    /**< The number of samples passed on to the file. */
+        int64 numSamplesDropped = 0;    /**< The number of samples that were rejected because the FIFO was full. */
+        int64 numOverruns = 0;          /**< The number of calls to write() that failed because the FIFO was full. */
+        int64 numDiskWrites = 0;        /**< The number of blocks that the disk thread passed on to the file. */
+        float peakFifoUsage = 0;        /**< The fullest that the FIFO has been, from 0 to 1. */
+    };
+
+    /** Returns the statistics for one of the tracks. */
+    Statistics getTrackStatistics (int trackIndex) const;
+
+    /** Returns the statistics for all the tracks combined.
+        The peakFifoUsage is the highest of any of the tracks.
+    */
+    Statistics getStatistics() const;
+
+private:
+    //==============================================================================
+    struct Track;
+    class DiskThread;
+    class AlignedFileOutputStream;
+
+    Options options;
+    OwnedArray<Track> tracks;
+    std::unique_ptr<DiskThread> diskThread;
+    std::atomic<bool> running { false };
+
+    bool writeReadyData (bool writeEverything);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiTrackAudioWriter)
+};
+
+} // namespace juce
@@ -112,6 +112,9 @@
 //==============================================================================
 #include "format/juce_AudioFormatReader.h"
 #include "format/juce_AudioFormatWriter.h"
+#include "format/juce_AudioFormatSeekIndex.h"
+#include "format/juce_DecodedAudioBlockCache.h"
+#include "format/juce_MultiTrackAudioWriter.h"
 #include "format/juce_MemoryMappedAudioFormatReader.h"
 #include "format/juce_AudioFormat.h"
 #include "format/juce_AudioFormatManager.h"
@@ -42,6 +42,7 @@ SamplerSound::SamplerSound (const String& soundName,
     {
         length = jmin ((int) source.lengthInSamples,
                        (int) (maxSampleLengthSeconds * sourceSampleRate));
+        preloadLength = length;
 
         data.reset (new AudioBuffer<float> (jmin (2, (int) source.numChannels), length + 4));
 
@@ -52,10 +53,53 @@ SamplerSound::SamplerSound (const String& soundName,
     }
 }
 
+SamplerSound::SamplerSound (const String& soundName,
+                            std::unique_ptr<AudioFormatReader> source,
+                            const BigInteger& notes,
+                            int midiNoteForNormalPitch,
+                            double attackTimeSecs,
+                            double releaseTimeSecs,
+                            double preloadLengthSeconds)
+    : name (soundName),
+      sourceSampleRate (source != nullptr ? source->sampleRate : 0.0),
+      midiNotes (notes),
+      midiRootNote (midiNoteForNormalPitch)
+{
+    jassert (source != nullptr);
+
+    if (sourceSampleRate > 0 && source->lengthInSamples > 0)
+    {
+        length = (int) jmin (source->lengthInSamples, (int64) std::numeric_limits<int>::max() - 8);
+        preloadLength = jlimit (0, length, (int) (preloadLengthSeconds * sourceSampleRate));
+
+        data.reset (new AudioBuffer<float> (jmin (2, (int) source->numChannels), preloadLength + 4));
+
+        source->read (data.get(), 0, preloadLength + 4, 0, true, true);
+
+        params.attack  = static_cast<float> (attackTimeSecs);
+        params.release = static_cast<float> (releaseTimeSecs);
+
+        if (preloadLength < length)
+        {
+            if (auto* mappedReader = dynamic_cast<MemoryMappedAudioFormatReader*> (source.get()))
+                if (mappedReader->getMappedSection().isEmpty())
+                    mappedReader->mapEntireFile();
+
+            reader = std::move (source);
+        }
+    }
+}
+
 SamplerSound::~SamplerSound()
 {
 }
 
+void SamplerSound::readFromSource (AudioBuffer<float>& dest, int startSample, int numSamples, int64 sourceStartSample)
+{
+    const ScopedLock sl (readerLock);
+    reader->read (&dest, startSample, numSamples, sourceStartSample, true, true);
+}
+
 bool SamplerSound::appliesToNote (int midiNoteNumber)
 {
     return midiNotes[midiNoteNumber];
@@ -66,19 +110,152 @@ bool SamplerSound::appliesToChannel (int /*midiChannel*/)
     return true;
 }
 
+//==============================================================================
+/*  Keeps a voice's ring buffer filled with the streamed part of the sound it's playing.
+
+    The write position and a generation number are packed into a single atomic, so
+    that when the audio thread starts a new note, a chunk that the streaming thread
+    was in the middle of reading for the old one fails to get published.
+*/
+struct SamplerVoice::Streamer  : private TimeSliceClient
+{
+    Streamer (TimeSliceThread& threadToUse, int bufferSizeToUse)
+        : thread (threadToUse),
+          bufferSize (nextPowerOfTwo (jmax (bufferSizeToUse, 1024))),
+          buffer (2, bufferSize)
+    {
+        buffer.clear();
+        thread.addTimeSliceClient (this);
+
+        if (! thread.isThreadRunning())
+            thread.startThread();
+    }
+
+    ~Streamer() override
+    {
+        thread.removeTimeSliceClient (this);
+    }
+
+    // Called on the audio thread whenever the voice starts or stops playing a sound.
+    void setSound (SamplerSound* sound)
+    {
+        auto generation = ((state.load() >> positionBits) + 1) & generationMask;
+        auto startPosition = (sound != nullptr && sound->isStreaming()) ? sound->preloadLength : 0;
+
+        const SpinLock::ScopedLockType sl (lock);
+
+        readPosition.store (startPosition);
+        state.store ((generation << positionBits) | (uint64) startPosition);
+        currentSound = sound;
+    }
+
+    // Returns the end of the range of source samples that are ready in the buffer.
+    int64 getNumSamplesAvailable() const noexcept
+    {
+        return (int64) (state.load (std::memory_order_acquire) & positionMask);
+    }
+
+    void setReadPosition (int64 lowestSampleNeeded) noexcept
+    {
+        readPosition.store (lowestSampleNeeded);
+    }
+
+    const float* getReadPointer (int channel) const noexcept    { return buffer.getReadPointer (channel); }
+    int getBufferMask() const noexcept                           { return bufferSize - 1; }
+
+    std::atomic<int> numUnderruns { 0 };
+
+private:
+    int useTimeSlice() override
+    {
+        SynthesiserSound::Ptr sound;
+        uint64 expectedState;
+        int64 lowestSampleNeeded;
+
+        {
+            const SpinLock::ScopedLockType sl (lock);
+            sound = currentSound;
+            expectedState = state.load();
+            lowestSampleNeeded = readPosition.load();
+        }
+
+        auto* samplerSound = static_cast<SamplerSound*> (sound.get());
+
+        if (samplerSound == nullptr || ! samplerSound->isStreaming())
+            return 10;
+
+        auto writePosition = (int64) (expectedState & positionMask);
+        auto endPosition = jmin ((int64) samplerSound->length + 4, lowestSampleNeeded + bufferSize);
+
+        if (writePosition >= endPosition)
+            return 5;
+
+        auto numToRead = (int) jmin (endPosition - writePosition, (int64) maxChunkSize);
+        auto bufferStart = (int) (writePosition & (bufferSize - 1));
+        auto numBeforeWrap = jmin (numToRead, bufferSize - bufferStart);
+
+        samplerSound->readFromSource (buffer, bufferStart, numBeforeWrap, writePosition);
+
+        if (numBeforeWrap < numToRead)
+            samplerSound->readFromSource (buffer, 0, numToRead - numBeforeWrap, writePosition + numBeforeWrap);
+
+        state.compare_exchange_strong (expectedState, expectedState + (uint64) numToRead, std::memory_order_release);
+        return 0;
+    }
+
+    static constexpr int positionBits = 48;
+    static constexpr uint64 positionMask = (((uint64) 1) << positionBits) - 1;
+    static constexpr uint64 generationMask = (((uint64) 1) << (64 - positionBits)) - 1;
+    static constexpr int maxChunkSize = 16384;
+
+    TimeSliceThread& thread;
+    const int bufferSize;
+    AudioBuffer<float> buffer;
+
+    SpinLock lock;
+    SynthesiserSound::Ptr currentSound;
+    std::atomic<uint64> state { 0 };
+    std::atomic<int64> readPosition { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (Streamer)
+};
+
 //==============================================================================
 SamplerVoice::SamplerVoice() {}
+
+SamplerVoice::SamplerVoice (TimeSliceThread& streamingThread, int streamingBufferSize)
+    : streamer (new Streamer (streamingThread, streamingBufferSize))
+{
+}
+
 SamplerVoice::~SamplerVoice() {}
 
 bool SamplerVoice::canPlaySound (SynthesiserSound* sound)
 {
-    return dynamic_cast<const SamplerSound*> (sound) != nullptr;
+    if (auto* samplerSound = dynamic_cast<const SamplerSound*> (sound))
+        return streamer != nullptr || ! samplerSound->isStreaming();
+
+    return false;
+}
+
+int SamplerVoice::getNumUnderruns() const noexcept
+{
+    return streamer != nullptr ? streamer->numUnderruns.load() : 0;
+}
+
+void SamplerVoice::resetNumUnderruns() noexcept
+{
+    if (streamer != nullptr)
+        streamer->numUnderruns = 0;
 }
 
 void SamplerVoice::startNote (int midiNoteNumber, float velocity, SynthesiserSound* s, int /*currentPitchWheelPosition*/)
 {
-    if (auto* sound = dynamic_cast<const SamplerSound*> (s))
+    if (auto* sound = dynamic_cast<SamplerSound*> (s))
     {
+        if (streamer != nullptr)
+            streamer->setSound (sound);
+
         pitchRatio = std::pow (2.0, (midiNoteNumber - sound->midiRootNote) / 12.0)
                         * sound->sourceSampleRate / getSampleRate();
 
@@ -107,6 +284,9 @@ void SamplerVoice::stopNote (float /*velocity*/, bool allowTailOff)
     {
         clearCurrentNote();
         adsr.reset();
+
+        if (streamer != nullptr)
+            streamer->setSound (nullptr);
     }
 }
 
@@ -121,6 +301,15 @@ void SamplerVoice::renderNextBlock (AudioBuffer<float>& outputBuffer, int startS
         auto& data = *playingSound->data;
         const float* const inL = data.getReadPointer (0);
         const float* const inR = data.getNumChannels() > 1 ? data.getReadPointer (1) : nullptr;
+        const auto preloadLength = playingSound->preloadLength;
+
+        // past the preloaded section, the samples come from the streamer's ring buffer
+        const bool isStreaming = streamer != nullptr && playingSound->isStreaming();
+        const float* const streamL = isStreaming ? streamer->getReadPointer (0) : nullptr;
+        const float* const streamR = isStreaming && inR != nullptr ? streamer->getReadPointer (1) : nullptr;
+        const auto streamMask = isStreaming ? streamer->getBufferMask() : 0;
+        const auto numStreamedSamples = isStreaming ? streamer->getNumSamplesAvailable() : 0;
+        int numUnderruns = 0;
 
         float* outL = outputBuffer.getWritePointer (0, startSample);
         float* outR = outputBuffer.getNumChannels() > 1 ? outputBuffer.getWritePointer (1, startSample) : nullptr;
@@ -130,11 +319,28 @@ void SamplerVoice::renderNextBlock (AudioBuffer<float>& outputBuffer, int startS
             auto pos = (int) sourceSamplePosition;
             auto alpha = (float) (sourceSamplePosition - pos);
             auto invAlpha = 1.0f - alpha;
+            float l = 0.0f, r = 0.0f;
 
             // just using a very simple linear interpolation here..
-            float l = (inL[pos] * invAlpha + inL[pos + 1] * alpha);
-            float r = (inR != nullptr) ? (inR[pos] * invAlpha + inR[pos + 1] * alpha)
-                                       : l;
+            if (pos < preloadLength || ! isStreaming)
+            {
+                l = (inL[pos] * invAlpha + inL[pos + 1] * alpha);
+                r = (inR != nullptr) ? (inR[pos] * invAlpha + inR[pos + 1] * alpha)
+                                     : l;
+            }
+            else if (pos + 1 < numStreamedSamples)
+            {
+                auto index1 = pos & streamMask;
+                auto index2 = (pos + 1) & streamMask;
+
+                l = (streamL[index1] * invAlpha + streamL[index2] * alpha);
+                r = (streamR != nullptr) ? (streamR[index1] * invAlpha + streamR[index2] * alpha)
+                                         : l;
+            }
+            else
+            {
+                ++numUnderruns;
+            }
 
             auto envelopeValue = adsr.getNextSample();
 
@@ -159,7 +365,183 @@ void SamplerVoice::renderNextBlock (AudioBuffer<float>& outputBuffer, int startS
                 break;
             }
         }
+
+        if (isStreaming)
+        {
+            if (numUnderruns > 0)
+                streamer->numUnderruns += numUnderruns;
+
+            if (isVoiceActive())
+                streamer->setReadPosition (jmax ((int64) sourceSamplePosition, (int64) preloadLength));
+        }
     }
 }
 
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class SamplerStreamingTests  : public UnitTest
+{
+public:
+    SamplerStreamingTests()
+        : UnitTest ("Sampler streaming", UnitTestCategories::audio)
+    {}
+
+    void runTest() override
+    {
+        auto random = getRandom();
+        auto noteA = createWav (random);
+        auto noteB = createWav (random);
+
+        TimeSliceThread streamingThread ("Sampler streaming test");
+
+        auto reference = renderNote (new SamplerSound ("memory", *createReader (noteA), notes (60), 60, 0.0, 0.0, 10.0),
+                                     nullptr, new SamplerVoice(), 1);
+
+        {
+            beginTest ("Streamed sound matches in-memory sound");
+
+            auto* voice = new SamplerVoice (streamingThread);
+            auto streamed = renderNote (new SamplerSound ("streaming", createReader (noteA), notes (60), 60, 0.0, 0.0, preloadSeconds),
+                                        nullptr, voice, 1);
+
+            expectSameOutput (streamed, reference);
+        }
+
+        {
+            beginTest ("Stolen voices don't play stale data");
+
+            auto* voice = new SamplerVoice (streamingThread, 4096);
+            auto streamed = renderNote (new SamplerSound ("streaming", createReader (noteA), notes (60), 60, 0.0, 0.0, preloadSeconds),
+                                        new SamplerSound ("stolen", createReader (noteB), notes (72), 72, 0.0, 0.0, preloadSeconds),
+                                        voice, 1);
+
+            expectSameOutput (streamed, reference);
+        }
+
+        {
+            beginTest ("Only streaming voices can play streaming sounds");
+
+            SynthesiserSound::Ptr sound (new SamplerSound ("streaming", createReader (noteA), notes (60), 60, 0.0, 0.0, preloadSeconds));
+
+            expect (static_cast<SamplerSound*> (sound.get())->isStreaming());
+            expect (! SamplerVoice().canPlaySound (sound.get()));
+            expect (SamplerVoice (streamingThread).canPlaySound (sound.get()));
+        }
+
+        {
+            beginTest ("Underruns are counted");
+
+            TimeSliceThread idleThread ("Idle streaming thread");
+            Synthesiser synth;
+            auto* voice = new SamplerVoice (idleThread);
+            idleThread.stopThread (1000);
+
+            synth.addVoice (voice);
+            synth.addSound (new SamplerSound ("streaming", createReader (noteA), notes (60), 60, 0.0, 0.0, preloadSeconds));
+            synth.setCurrentPlaybackSampleRate (sampleRate);
+
+            AudioBuffer<float> output (2, numSourceSamples);
+            MidiBuffer midi;
+            midi.addEvent (MidiMessage::noteOn (1, 60, 1.0f), 0);
+            synth.renderNextBlock (output, midi, 0, numSourceSamples);
+
+            expectGreaterThan (voice->getNumUnderruns(), 0);
+
+            voice->resetNumUnderruns();
+            expectEquals (voice->getNumUnderruns(), 0);
+        }
+    }
+
+private:
+    static constexpr double sampleRate = 44100.0;
+    static constexpr int numSourceSamples = 20000;
+    static constexpr double preloadSeconds = 0.2;
+
+    static MemoryBlock createWav (Random& random)
+    {
+        AudioBuffer<float> source (2, numSourceSamples);
+
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < numSourceSamples; ++i)
+                source.setSample (ch, i, random.nextFloat() - 0.5f);
+
+        MemoryBlock wavData;
+        std::unique_ptr<AudioFormatWriter> writer (WavAudioFormat().createWriterFor (new MemoryOutputStream (wavData, false),
+                                                                                     sampleRate, 2, 32, {}, 0));
+        writer->writeFromAudioSampleBuffer (source, 0, numSourceSamples);
+        writer.reset();
+
+        return wavData;
+    }
+
+    static std::unique_ptr<AudioFormatReader> createReader (const MemoryBlock& wavData)
+    {
+        return std::unique_ptr<AudioFormatReader> (WavAudioFormat().createReaderFor (new MemoryInputStream (wavData, false), true));
+    }
+
+    static BigInteger notes (int note)
+    {
+        BigInteger result;
+        result.setBit (note);
+        return result;
+    }
+
+    // Plays note 60, optionally stealing the voice from a note 72 that was started first,
+    // and renders in small blocks so that the streaming thread can keep up.
+    static AudioBuffer<float> renderNote (SynthesiserSound* sound, SynthesiserSound* soundToSteal,
+                                          SynthesiserVoice* voice, int msToWaitPerBlock)
+    {
+        Synthesiser synth;
+        synth.addVoice (voice);
+        synth.addSound (sound);
+
+        if (soundToSteal != nullptr)
+            synth.addSound (soundToSteal);
+
+        synth.setCurrentPlaybackSampleRate (sampleRate);
+
+        AudioBuffer<float> output (2, numSourceSamples);
+        MidiBuffer midi;
+
+        if (soundToSteal != nullptr)
+        {
+            midi.addEvent (MidiMessage::noteOn (1, 72, 1.0f), 0);
+            synth.renderNextBlock (output, midi, 0, 1000);
+            Thread::sleep (50);
+            midi.clear();
+        }
+
+        output.clear();
+        midi.addEvent (MidiMessage::noteOn (1, 60, 1.0f), 0);
+
+        for (int start = 0; start < numSourceSamples; start += blockSize)
+        {
+            synth.renderNextBlock (output, midi, start, jmin (blockSize, numSourceSamples - start));
+            midi.clear();
+            Thread::sleep (msToWaitPerBlock);
+        }
+
+        return output;
+    }
+
+    void expectSameOutput (const AudioBuffer<float>& a, const AudioBuffer<float>& b)
+    {
+        auto maxDifference = 0.0f;
+
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < a.getNumSamples(); ++i)
+                maxDifference = jmax (maxDifference, std::abs (a.getSample (ch, i) - b.getSample (ch, i)));
+
+        expectEquals (maxDifference, 0.0f);
+        expectGreaterThan (a.getMagnitude (0, a.getNumSamples()), 0.0f);
+    }
+
+    static constexpr int blockSize = 256;
+};
+
+static SamplerStreamingTests samplerStreamingTests;
+
+#endif
+
 } // namespace juce
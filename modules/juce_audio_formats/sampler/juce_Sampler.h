@@ -30,8 +30,9 @@ namespace juce
 /**
     A subclass of SynthesiserSound that represents a sampled audio clip.
 
-    This is a pretty basic sampler, and just attempts to load the whole audio stream
-    into memory.
+    This is a pretty basic sampler, which can either load the whole audio stream
+    into memory, or keep just the start of it in memory and stream the rest from
+    disk while it's playing.
 
     To use it, create a Synthesiser, add some SamplerVoice objects to it, then
     give it some SampledSound objects to play.
@@ -70,6 +71,36 @@ public:
                   double releaseTimeSecs,
                   double maxSampleLengthSeconds);
 
+    /** Creates a sampled sound which streams its audio from disk.
+
+        Only the first preloadLengthSeconds of the audio are loaded into memory; the
+        rest is read from the source while the sound is playing, by SamplerVoices that
+        were created with a streaming thread. The preloaded section has to be long
+        enough to cover the time it takes the streaming thread to start delivering data,
+        otherwise the voices will run out of audio (see SamplerVoice::getNumUnderruns()).
+
+        If the source is a MemoryMappedAudioFormatReader, the whole file will be mapped,
+        so that streaming it doesn't involve any file reads.
+
+        @param name         a name for the sample
+        @param source       the audio to stream. The sound takes ownership of this reader, and
+                            will read from it on the voices' streaming threads
+        @param midiNotes    the set of midi keys that this sound should be played on
+        @param midiNoteForNormalPitch   the midi note at which the sample should be played
+                                        with its natural rate
+        @param attackTimeSecs   the attack (fade-in) time, in seconds
+        @param releaseTimeSecs  the decay (fade-out) time, in seconds
+        @param preloadLengthSeconds     the length of audio at the start of the sample that
+                                        is kept in memory, in seconds
+    */
+    SamplerSound (const String& name,
+                  std::unique_ptr<AudioFormatReader> source,
+                  const BigInteger& midiNotes,
+                  int midiNoteForNormalPitch,
+                  double attackTimeSecs,
+                  double releaseTimeSecs,
+                  double preloadLengthSeconds);
+
     /** Destructor. */
     ~SamplerSound() override;
 
@@ -78,10 +109,22 @@ public:
     const String& getName() const noexcept                  { return name; }
 
     /** Returns the audio sample data.
+        For a streaming sound, this only contains the preloaded section of the sample.
         This could return nullptr if there was a problem loading the data.
     */
     AudioBuffer<float>* getAudioData() const noexcept       { return data.get(); }
 
+    /** Returns true if this sound streams its audio rather than holding it all in memory. */
+    bool isStreaming() const noexcept                       { return reader != nullptr; }
+
+    /** Returns the length of the sample, in source samples. */
+    int getLength() const noexcept                          { return length; }
+
+    /** Returns the number of samples at the start of the sample that are held in memory.
+        Unless the sound is streaming, this is the same as getLength().
+    */
+    int getPreloadLength() const noexcept                   { return preloadLength; }
+
     //==============================================================================
     /** Changes the parameters of the ADSR envelope which will be applied to the sample. */
     void setEnvelopeParameters (ADSR::Parameters parametersToUse)    { params = parametersToUse; }
@@ -94,11 +137,15 @@ private:
     //==============================================================================
     friend class SamplerVoice;
 
+    void readFromSource (AudioBuffer<float>&, int startSample, int numSamples, int64 sourceStartSample);
+
     String name;
     std::unique_ptr<AudioBuffer<float>> data;
+    std::unique_ptr<AudioFormatReader> reader;
+    CriticalSection readerLock;
     double sourceSampleRate;
     BigInteger midiNotes;
-    int length = 0, midiRootNote = 0;
+    int length = 0, preloadLength = 0, midiRootNote = 0;
 
     ADSR::Parameters params;
 
@@ -113,6 +160,12 @@ private:
     To use it, create a Synthesiser, add some SamplerVoice objects to it, then
     give it some SampledSound objects to play.
 
+    To play streaming SamplerSounds, the voices need to be given a TimeSliceThread to
+    read the audio on. Each voice has its own ring buffer which the thread keeps
+    topped up ahead of the playback position, so the audio thread never touches the
+    disk. When a voice is stolen, any data being read for its previous note is
+    discarded.
+
     @see SamplerSound, Synthesiser, SynthesiserVoice
 
     @tags{Audio}
@@ -121,9 +174,22 @@ class JUCE_API  SamplerVoice    : public SynthesiserVoice
 {
 public:
     //==============================================================================
-    /** Creates a SamplerVoice. */
+    /** Creates a SamplerVoice which can only play sounds that are held in memory. */
     SamplerVoice();
 
+    /** Creates a SamplerVoice which can also play streaming sounds.
+
+        @param streamingThread          the thread to read the streamed audio on. This is
+                                        typically shared between all the voices of a synth,
+                                        and it must outlive the voice. The voice will start
+                                        the thread if it isn't already running
+        @param streamingBufferSize      the size of the voice's ring buffer, in source samples.
+                                        This must be big enough to hold the audio needed for
+                                        a block at the highest pitch that will be played, plus
+                                        whatever read-ahead is needed to cover disk latency
+    */
+    SamplerVoice (TimeSliceThread& streamingThread, int streamingBufferSize = 65536);
+
     /** Destructor. */
     ~SamplerVoice() override;
 
@@ -139,8 +205,22 @@ public:
     void renderNextBlock (AudioBuffer<float>&, int startSample, int numSamples) override;
     using SynthesiserVoice::renderNextBlock;
 
+    //==============================================================================
+    /** Returns the number of output samples that had to be rendered as silence because
+        the streamed audio hadn't been read in time.
+
+        This is a running total, which can be cleared with resetNumUnderruns().
+    */
+    int getNumUnderruns() const noexcept;
+
+    /** Resets the underrun counter. */
+    void resetNumUnderruns() noexcept;
+
 private:
     //==============================================================================
+    struct Streamer;
+    std::unique_ptr<Streamer> streamer;
+
     double pitchRatio = 0;
     double sourceSamplePosition = 0;
     float lgain = 0, rgain = 0;
@@ -51,6 +51,16 @@ AudioProcessor::AudioProcessor (const BusesProperties& ioConfig)
 
 AudioProcessor::~AudioProcessor()
 {
+    if (parameterNotificationQueue != nullptr)
+    {
+        // A processor with a parameter notification queue must be deleted on the message
+        // thread, otherwise the queue's timer could be dispatching notifications to the
+        // parameters while they're deleted.
+        JUCE_ASSERT_MESSAGE_THREAD
+
+        parameterNotificationQueue.reset();
+    }
+
     {
         const ScopedLock sl (activeEditorLock);
 
@@ -211,13 +221,121 @@ bool AudioProcessor::enableAllBuses()
     return setBusesLayout (layouts);
 }
 
+struct AudioProcessor::BusesLayoutSupportCache
+{
+    bool find (const BusesLayout& layout, bool& isSupported) const
+    {
+        const ScopedLock sl (lock);
+
+        for (auto& entry : entries)
+        {
+            if (entry.layout == layout)
+            {
+                isSupported = entry.isSupported;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void add (const BusesLayout& layout, bool isSupported)
+    {
+        const ScopedLock sl (lock);
+
+        for (auto& entry : entries)
+            if (entry.layout == layout)
+                return;
+
+        entries.add ({ layout, isSupported });
+    }
+
+    void clear()
+    {
+        const ScopedLock sl (lock);
+        entries.clear();
+    }
+
+private:
+    struct Entry
+    {
+        BusesLayout layout;
+        bool isSupported;
+    };
+
+    CriticalSection lock;
+    Array<Entry> entries;
+};
+
 bool AudioProcessor::checkBusesLayoutSupported (const BusesLayout& layouts) const
 {
-    if (layouts.inputBuses.size() == inputBuses.size()
-          && layouts.outputBuses.size() == outputBuses.size())
+    if (layouts.inputBuses.size() != inputBuses.size()
+          || layouts.outputBuses.size() != outputBuses.size())
+        return false;
+
+    auto* cache = busesLayoutSupportCache.get();
+
+    if (cache == nullptr)
         return isBusesLayoutSupported (layouts);
 
-    return false;
+    bool isSupported = false;
+
+    if (cache->find (layouts, isSupported))
+        return isSupported;
+
+    // the lock isn't held here, in case the processor calls back into this method
+    isSupported = isBusesLayoutSupported (layouts);
+    cache->add (layouts, isSupported);
+    return isSupported;
+}
+
+void AudioProcessor::setBusesLayoutSupportCacheEnabled (bool shouldCacheSupportedLayouts)
+{
+    if (shouldCacheSupportedLayouts != isBusesLayoutSupportCacheEnabled())
+        busesLayoutSupportCache.reset (shouldCacheSupportedLayouts ? new BusesLayoutSupportCache() : nullptr);
+}
+
+bool AudioProcessor::isBusesLayoutSupportCacheEnabled() const noexcept
+{
+    return busesLayoutSupportCache != nullptr;
+}
+
+void AudioProcessor::invalidateBusesLayoutSupportCache()
+{
+    if (busesLayoutSupportCache != nullptr)
+        busesLayoutSupportCache->clear();
+}
+
+Array<AudioProcessor::BusesLayout> AudioProcessor::getSupportedBusesLayouts (const Array<AudioChannelSet>& candidateSets) const
+{
+    auto candidates = candidateSets;
+
+    if (candidates.isEmpty())
+        for (int numChannels = 1; numChannels <= 8; ++numChannels)
+            candidates.add (AudioChannelSet::canonicalChannelSet (numChannels));
+
+    const auto hasInput  = getBusCount (true)  > 0;
+    const auto hasOutput = getBusCount (false) > 0;
+
+    auto layout = getBusesLayout();
+    Array<BusesLayout> supported;
+
+    for (int i = 0; i < (hasInput ? candidates.size() : 1); ++i)
+    {
+        if (hasInput)
+            layout.getChannelSet (true, 0) = candidates.getReference (i);
+
+        for (int o = 0; o < (hasOutput ? candidates.size() : 1); ++o)
+        {
+            if (hasOutput)
+                layout.getChannelSet (false, 0) = candidates.getReference (o);
+
+            if (checkBusesLayoutSupported (layout))
+                supported.add (layout);
+        }
+    }
+
+    return supported;
 }
 
 void AudioProcessor::getNextBestLayout (const BusesLayout& desiredLayout, BusesLayout& actualLayouts) const
@@ -327,6 +445,238 @@ void AudioProcessor::setPlayHead (AudioPlayHead* newPlayHead)
     playHead = newPlayHead;
 }
 
+void AudioProcessor::setParameterAutomation (const ParameterAutomation* automationForNextBlock) noexcept
+{
+    parameterAutomation = automationForNextBlock;
+}
+
+//==============================================================================
+struct AudioProcessor::ParameterNotificationQueue  : private Timer
+{
+    enum class Type
+    {
+        valueChanged,
+        gestureStarted,
+        gestureEnded
+    };
+
+    struct Notification
+    {
+        AudioProcessorParameter* parameter;
+        float value;
+        Type type;
+    };
+
+    ParameterNotificationQueue (AudioProcessor& p, int capacity)
+        : processor (p),
+          fifo (capacity + 1),
+          notifications ((size_t) capacity + 1),
+          numParameters (p.getParameters().size()),
+          parameterStates (new ParameterState[(size_t) numParameters])
+    {
+        startTimerHz (60);
+    }
+
+    ~ParameterNotificationQueue() override
+    {
+        stopTimer();
+    }
+
+    bool beginQueueing() noexcept
+    {
+        Thread::ThreadID noThread = nullptr;
+        return producerThread.compare_exchange_strong (noThread, Thread::getCurrentThreadId());
+    }
+
+    void endQueueing() noexcept
+    {
+        producerThread = nullptr;
+    }
+
+    bool push (AudioProcessorParameter* parameter, float value, Type type) noexcept
+    {
+        if (producerThread.load() != Thread::getCurrentThreadId())
+            return false;
+
+        auto* state = getState (*parameter);
+
+        // The parameter must have been added to the processor before the queue was created!
+        jassert (state != nullptr);
+
+        if (state != nullptr && type != Type::valueChanged)
+            state->isPerformingGesture = (type == Type::gestureStarted);
+
+        const auto scope = fifo.write (1);
+
+        if (scope.blockSize1 + scope.blockSize2 > 0)
+        {
+            notifications[scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2] = { parameter, value, type };
+            return true;
+        }
+
+        // The queue is full, but the listeners mustn't be called on this thread, and calling
+        // them here would also let this notification overtake the queued ones. So the next
+        // dispatch() will send the parameter's current value, and any gesture change that
+        // its listeners have missed, after the queued notifications.
+        if (state != nullptr)
+        {
+            if (type == Type::valueChanged)
+                state->valueWasDropped = true;
+            else
+                state->gestureWasDropped = true;
+
+            notificationsWereDropped = true;
+        }
+
+        return true;
+    }
+
+    int dispatch()
+    {
+        const ScopedLock sl (consumerLock);
+
+        int numDispatched = 0;
+
+        while (fifo.getNumReady() > 0)
+        {
+            Notification n;
+
+            {
+                const auto scope = fifo.read (1);
+                n = notifications[scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2];
+            }
+
+            if (n.type == Type::valueChanged)
+            {
+                n.parameter->callValueChangedListeners (n.value);
+                ++numDispatched;
+            }
+            else
+            {
+                auto isStarting = (n.type == Type::gestureStarted);
+                auto* state = getState (*n.parameter);
+
+                // if the gesture change that this one follows was dropped, send that first
+                if (state != nullptr && state->gestureWasDropped && state->listenersThinkGestureIsActive == isStarting)
+                    numDispatched += sendGestureChange (*n.parameter, state, ! isStarting);
+
+                numDispatched += sendGestureChange (*n.parameter, state, isStarting);
+            }
+        }
+
+        if (notificationsWereDropped.exchange (false))
+            numDispatched += sendDroppedNotifications();
+
+        return numDispatched;
+    }
+
+private:
+    struct ParameterState
+    {
+        std::atomic<bool> valueWasDropped { false }, gestureWasDropped { false }, isPerformingGesture { false };
+        bool listenersThinkGestureIsActive = false;
+    };
+
+    ParameterState* getState (const AudioProcessorParameter& parameter) const noexcept
+    {
+        auto index = parameter.getParameterIndex();
+        return isPositiveAndBelow (index, numParameters) ? parameterStates.get() + index : nullptr;
+    }
+
+    static int sendGestureChange (AudioProcessorParameter& parameter, ParameterState* state, bool isStarting)
+    {
+        if (state != nullptr)
+            state->listenersThinkGestureIsActive = isStarting;
+
+        parameter.callGestureListeners (isStarting);
+        return 1;
+    }
+
+    int sendDroppedNotifications()
+    {
+        auto& parameters = processor.getParameters();
+        int numSent = 0;
+
+        for (int i = 0; i < numParameters; ++i)
+        {
+            auto& state = parameterStates[(size_t) i];
+            auto valueWasDropped = state.valueWasDropped.exchange (false);
+            auto gestureWasDropped = state.gestureWasDropped.exchange (false);
+
+            if (! (valueWasDropped || gestureWasDropped))
+                continue;
+
+            auto& parameter = *parameters.getUnchecked (i);
+            auto isPerformingGesture = state.isPerformingGesture.load();
+
+            if (gestureWasDropped && isPerformingGesture && ! state.listenersThinkGestureIsActive)
+                numSent += sendGestureChange (parameter, &state, true);
+
+            if (valueWasDropped)
+            {
+                parameter.callValueChangedListeners (parameter.getValue());
+                ++numSent;
+            }
+
+            if (gestureWasDropped && ! isPerformingGesture && state.listenersThinkGestureIsActive)
+                numSent += sendGestureChange (parameter, &state, false);
+        }
+
+        return numSent;
+    }
+
+    void timerCallback() override
+    {
+        dispatch();
+    }
+
+    AudioProcessor& processor;
+    AbstractFifo fifo;
+    HeapBlock<Notification> notifications;
+    const int numParameters;
+    std::unique_ptr<ParameterState[]> parameterStates;
+    std::atomic<Thread::ThreadID> producerThread { nullptr };
+    std::atomic<bool> notificationsWereDropped { false };
+    CriticalSection consumerLock;
+
+    JUCE_DECLARE_NON_COPYABLE (ParameterNotificationQueue)
+};
+
+void AudioProcessor::setParameterNotificationQueueSize (int maxNumQueuedNotifications)
+{
+    jassert (maxNumQueuedNotifications >= 0);
+
+    // The queue's timer runs on the message thread, so it can only be safely stopped there
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (parameterNotificationQueue != nullptr)
+        parameterNotificationQueue->dispatch();
+
+    parameterNotificationQueue.reset (maxNumQueuedNotifications > 0 ? new ParameterNotificationQueue (*this, maxNumQueuedNotifications)
+                                                                    : nullptr);
+}
+
+int AudioProcessor::dispatchQueuedParameterNotifications()
+{
+    if (parameterNotificationQueue != nullptr)
+        return parameterNotificationQueue->dispatch();
+
+    return 0;
+}
+
+AudioProcessor::ScopedParameterNotificationQueueing::ScopedParameterNotificationQueueing (AudioProcessor& p) noexcept
+    : processor (p)
+{
+    if (auto* queue = processor.parameterNotificationQueue.get())
+        isQueueing = queue->beginQueueing();
+}
+
+AudioProcessor::ScopedParameterNotificationQueueing::~ScopedParameterNotificationQueueing() noexcept
+{
+    if (isQueueing)
+        processor.parameterNotificationQueue->endQueueing();
+}
+
 void AudioProcessor::addListener (AudioProcessorListener* newListener)
 {
     const ScopedLock sl (listenerLock);
@@ -1457,20 +1807,12 @@ void AudioProcessorParameter::beginChangeGesture()
     isPerformingGesture = true;
    #endif
 
-    ScopedLock lock (listenerLock);
-
-    for (int i = listeners.size(); --i >= 0;)
-        if (auto* l = listeners[i])
-            l->parameterGestureChanged (getParameterIndex(), true);
-
     if (processor != nullptr && parameterIndex >= 0)
-    {
-        // audioProcessorParameterChangeGestureBegin callbacks will shortly be deprecated and
-        // this code will be removed.
-        for (int i = processor->listeners.size(); --i >= 0;)
-            if (auto* l = processor->listeners[i])
-                l->audioProcessorParameterChangeGestureBegin (processor, getParameterIndex());
-    }
+        if (auto* queue = processor->parameterNotificationQueue.get())
+            if (queue->push (this, 0.0f, AudioProcessor::ParameterNotificationQueue::Type::gestureStarted))
+                return;
+
+    callGestureListeners (true);
 }
 
 void AudioProcessorParameter::endChangeGesture()
@@ -1486,23 +1828,50 @@ void AudioProcessorParameter::endChangeGesture()
     isPerformingGesture = false;
    #endif
 
+    if (processor != nullptr && parameterIndex >= 0)
+        if (auto* queue = processor->parameterNotificationQueue.get())
+            if (queue->push (this, 0.0f, AudioProcessor::ParameterNotificationQueue::Type::gestureEnded))
+                return;
+
+    callGestureListeners (false);
+}
+
+void AudioProcessorParameter::sendValueChangedMessageToListeners (float newValue)
+{
+    if (processor != nullptr && parameterIndex >= 0)
+        if (auto* queue = processor->parameterNotificationQueue.get())
+            if (queue->push (this, newValue, AudioProcessor::ParameterNotificationQueue::Type::valueChanged))
+                return;
+
+    callValueChangedListeners (newValue);
+}
+
+void AudioProcessorParameter::callGestureListeners (bool gestureIsStarting)
+{
     ScopedLock lock (listenerLock);
 
     for (int i = listeners.size(); --i >= 0;)
         if (auto* l = listeners[i])
-            l->parameterGestureChanged (getParameterIndex(), false);
+            l->parameterGestureChanged (getParameterIndex(), gestureIsStarting);
 
     if (processor != nullptr && parameterIndex >= 0)
     {
-        // audioProcessorParameterChangeGestureEnd callbacks will shortly be deprecated and
+        // audioProcessorParameterChangeGestureBegin/End callbacks will shortly be deprecated and
         // this code will be removed.
         for (int i = processor->listeners.size(); --i >= 0;)
+        {
             if (auto* l = processor->listeners[i])
-                l->audioProcessorParameterChangeGestureEnd (processor, getParameterIndex());
+            {
+                if (gestureIsStarting)
+                    l->audioProcessorParameterChangeGestureBegin (processor, getParameterIndex());
+                else
+                    l->audioProcessorParameterChangeGestureEnd (processor, getParameterIndex());
+            }
+        }
     }
 }
 
-void AudioProcessorParameter::sendValueChangedMessageToListeners (float newValue)
+void AudioProcessorParameter::callValueChangedListeners (float newValue)
 {
     ScopedLock lock (listenerLock);
 
@@ -1563,4 +1932,255 @@ void AudioProcessorParameter::removeListener (AudioProcessorParameter::Listener*
     listeners.removeFirstMatchingValue (listenerToRemove);
 }
 
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+struct ParameterNotificationQueueTests  : public UnitTest
+{
+    ParameterNotificationQueueTests()
+        : UnitTest ("Parameter notification queue", UnitTestCategories::audioProcessorParameters)
+    {}
+
+    struct TestProcessor  : public UnitTestAudioProcessor
+    {
+        TestProcessor()
+        {
+            addParameter (gain = new AudioParameterFloat ("gain", "Gain", 0.0f, 1.0f, 0.0f));
+        }
+
+        AudioParameterFloat* gain;
+    };
+
+    struct CountingListener  : public AudioProcessorParameter::Listener
+    {
+        void parameterValueChanged (int, float newValue) override
+        {
+            ++numValueChanges;
+            lastValue = newValue;
+        }
+
+        void parameterGestureChanged (int, bool gestureIsStarting) override
+        {
+            ++numGestures;
+
+            const ScopedLock sl (gestureLock);
+            gestures += gestureIsStarting ? "s" : "e";
+        }
+
+        String getGestures() const
+        {
+            const ScopedLock sl (gestureLock);
+            return gestures;
+        }
+
+        std::atomic<int> numValueChanges { 0 }, numGestures { 0 };
+        std::atomic<float> lastValue { 0.0f };
+        CriticalSection gestureLock;
+        String gestures;
+    };
+
+    struct AudioThread  : public Thread
+    {
+        AudioThread (TestProcessor& p, int numChangesToMake)
+            : Thread ("Parameter notification test"), processor (p), numChanges (numChangesToMake)
+        {}
+
+        void run() override
+        {
+            const AudioProcessor::ScopedParameterNotificationQueueing queueing (processor);
+
+            processor.gain->beginChangeGesture();
+
+            for (int i = 1; i <= numChanges; ++i)
+                processor.gain->setValueNotifyingHost ((float) i / (float) numChanges);
+
+            processor.gain->endChangeGesture();
+        }
+
+        TestProcessor& processor;
+        const int numChanges;
+    };
+
+    void runTest() override
+    {
+        TestProcessor processor;
+        CountingListener listener;
+        processor.gain->addListener (&listener);
+
+        beginTest ("Notifications are synchronous without a queue");
+        {
+            AudioThread thread (processor, 4);
+            thread.startThread();
+            thread.waitForThreadToExit (-1);
+
+            expectEquals (listener.numValueChanges.load(), 4);
+            expectEquals (listener.numGestures.load(), 2);
+            expectEquals (processor.dispatchQueuedParameterNotifications(), 0);
+        }
+
+        beginTest ("Notifications from a queueing thread are deferred until dispatch");
+        {
+            listener.numValueChanges = 0;
+            listener.numGestures = 0;
+            processor.setParameterNotificationQueueSize (16);
+
+            AudioThread thread (processor, 4);
+            thread.startThread();
+            thread.waitForThreadToExit (-1);
+
+            expectEquals (listener.numValueChanges.load(), 0);
+            expectEquals (listener.numGestures.load(), 0);
+
+            expectEquals (processor.dispatchQueuedParameterNotifications(), 6);
+            expectEquals (listener.numValueChanges.load(), 4);
+            expectEquals (listener.numGestures.load(), 2);
+            expectEquals (listener.lastValue.load(), 1.0f);
+        }
+
+        beginTest ("Notifications from other threads are still synchronous");
+        {
+            listener.numValueChanges = 0;
+            processor.gain->setValueNotifyingHost (0.25f);
+
+            expectEquals (listener.numValueChanges.load(), 1);
+            expectEquals (processor.dispatchQueuedParameterNotifications(), 0);
+        }
+
+        beginTest ("A full queue sends the latest value, and keeps gestures in order");
+        {
+            listener.numValueChanges = 0;
+            listener.numGestures = 0;
+            listener.gestures.clear();
+            processor.setParameterNotificationQueueSize (3);
+
+            // the gesture start and the first two values fit in the queue
+            AudioThread thread (processor, 4);
+            thread.startThread();
+            thread.waitForThreadToExit (-1);
+
+            expectEquals (listener.numValueChanges.load() + listener.numGestures.load(), 0);
+            expectEquals (processor.dispatchQueuedParameterNotifications(), 5);
+            expectEquals (listener.numValueChanges.load(), 3);
+            expectEquals (listener.lastValue.load(), 1.0f);
+            expectEquals (listener.getGestures(), String ("se"));
+
+            // if a gesture start is dropped while the gesture is still going, it's sent
+            // before the parameter's latest value
+            listener.gestures.clear();
+
+            {
+                const AudioProcessor::ScopedParameterNotificationQueueing queueing (processor);
+
+                for (int i = 0; i < 3; ++i)
+                    processor.gain->setValueNotifyingHost (0.5f);
+
+                processor.gain->beginChangeGesture();
+                processor.gain->setValueNotifyingHost (0.75f);
+
+                expectEquals (processor.dispatchQueuedParameterNotifications(), 5);
+                expectEquals (listener.lastValue.load(), 0.75f);
+                expectEquals (listener.getGestures(), String ("s"));
+
+                processor.gain->endChangeGesture();
+            }
+
+            expectEquals (processor.dispatchQueuedParameterNotifications(), 1);
+            expectEquals (listener.getGestures(), String ("se"));
+        }
+
+        processor.setParameterNotificationQueueSize (0);
+        processor.gain->removeListener (&listener);
+    }
+};
+
+static ParameterNotificationQueueTests parameterNotificationQueueTests;
+
+//==============================================================================
+struct BusesLayoutSupportCacheTests  : public UnitTest
+{
+    BusesLayoutSupportCacheTests()
+        : UnitTest ("Buses layout support cache", UnitTestCategories::audio)
+    {}
+
+    struct CountingProcessor  : public UnitTestAudioProcessor
+    {
+        bool isBusesLayoutSupported (const BusesLayout& layout) const override
+        {
+            ++numQueries;
+            return layout.getMainInputChannelSet() == layout.getMainOutputChannelSet()
+                && layout.getMainOutputChannelSet().size() <= maxNumChannels;
+        }
+
+        mutable int numQueries = 0;
+        int maxNumChannels = 2;
+    };
+
+    static AudioProcessor::BusesLayout makeLayout (const AudioChannelSet& in, const AudioChannelSet& out)
+    {
+        AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (in);
+        layout.outputBuses.add (out);
+        return layout;
+    }
+
+    void runTest() override
+    {
+        const auto mono = AudioChannelSet::mono(), stereo = AudioChannelSet::stereo();
+
+        beginTest ("Without the cache, every check queries the processor");
+        {
+            CountingProcessor processor;
+
+            expect (processor.checkBusesLayoutSupported (makeLayout (mono, mono)));
+            expect (processor.checkBusesLayoutSupported (makeLayout (mono, mono)));
+            expectEquals (processor.numQueries, 2);
+        }
+
+        beginTest ("With the cache, each layout is only queried once until invalidated");
+        {
+            CountingProcessor processor;
+            processor.setBusesLayoutSupportCacheEnabled (true);
+
+            for (int i = 0; i < 3; ++i)
+            {
+                expect (processor.checkBusesLayoutSupported (makeLayout (mono, mono)));
+                expect (! processor.checkBusesLayoutSupported (makeLayout (mono, stereo)));
+            }
+
+            expectEquals (processor.numQueries, 2);
+
+            processor.maxNumChannels = 0;
+            expect (processor.checkBusesLayoutSupported (makeLayout (mono, mono)));
+
+            processor.invalidateBusesLayoutSupportCache();
+            expect (! processor.checkBusesLayoutSupported (makeLayout (mono, mono)));
+            expectEquals (processor.numQueries, 3);
+        }
+
+        beginTest ("Supported layouts can be enumerated in one go");
+        {
+            CountingProcessor processor;
+            processor.setBusesLayoutSupportCacheEnabled (true);
+
+            auto supported = processor.getSupportedBusesLayouts ({ mono, stereo, AudioChannelSet::createLCR() });
+
+            expectEquals (supported.size(), 2);
+            expect (supported.contains (makeLayout (mono, mono)));
+            expect (supported.contains (makeLayout (stereo, stereo)));
+            expectEquals (processor.numQueries, 9);
+
+            expect (processor.setChannelLayoutOfBus (true, 0, mono));
+            expect (processor.getChannelLayoutOfBus (false, 0) == mono);
+            expectEquals (processor.numQueries, 9);
+
+            expectEquals (processor.getSupportedBusesLayouts ({}).size(), 2);
+        }
+    }
+};
+
+static BusesLayoutSupportCacheTests busesLayoutSupportCacheTests;
+
+#endif
+
 } // namespace juce
@@ -654,6 +654,48 @@ public:
     */
     bool checkBusesLayoutSupported (const BusesLayout&) const;
 
+    /** Makes checkBusesLayoutSupported() remember the answer it gets for each layout.
+
+        Some processors, such as hosted plug-ins, can take a long time to answer
+        isBusesLayoutSupported(), and methods like getNextBestLayout() and
+        setChannelLayoutOfBus() may ask about the same layouts many times. With the cache
+        enabled, isBusesLayoutSupported() is only called once for each distinct layout,
+        until invalidateBusesLayoutSupportCache() is called.
+
+        Only enable this for processors whose supported layouts don't change by themselves.
+        If they do change, call invalidateBusesLayoutSupportCache() afterwards.
+        canApplyBusesLayout() is never cached, so a processor can still reject a layout
+        just before it's applied.
+
+        @see invalidateBusesLayoutSupportCache, getSupportedBusesLayouts
+    */
+    void setBusesLayoutSupportCacheEnabled (bool shouldCacheSupportedLayouts);
+
+    /** Returns true if checkBusesLayoutSupported() is caching its results.
+        @see setBusesLayoutSupportCacheEnabled
+    */
+    bool isBusesLayoutSupportCacheEnabled() const noexcept;
+
+    /** Forgets any layouts that checkBusesLayoutSupported() has cached.
+        @see setBusesLayoutSupportCacheEnabled
+    */
+    void invalidateBusesLayoutSupportCache();
+
+    /** Returns every layout made from the given channel sets that the processor supports.
+
+        Every combination of the candidate sets is tried on the main input and main
+        output buses, while any other buses keep their current layout. If the processor
+        has no input or no output buses, only the other direction is varied. An empty
+        array of candidates means the canonical channel sets of 1 to 8 channels.
+
+        This lets a host find all the layouts it can use in one go. If the cache is
+        enabled, any later call to checkBusesLayoutSupported() for one of these layouts
+        won't need to ask the processor again.
+
+        @see checkBusesLayoutSupported, setBusesLayoutSupportCacheEnabled
+    */
+    Array<BusesLayout> getSupportedBusesLayouts (const Array<AudioChannelSet>& candidateSets) const;
+
     //==============================================================================
     /** Returns true if the Audio processor supports double precision floating point processing.
         The default implementation will always return false.
@@ -709,6 +751,22 @@ public:
     */
     AudioPlayHead* getPlayHead() const noexcept                 { return playHead; }
 
+    /** Returns any sample-accurate parameter changes that the host has provided for
+        the block currently being processed, or nullptr if there aren't any.
+
+        As with getPlayHead(), you can ONLY call this from your processBlock() method,
+        and mustn't keep the pointer after it returns.
+
+        Each lane holds the changes to the parameter with that index in getParameters().
+        The parameters themselves still have the values they had before the block began,
+        so you can pass getValue() to ParameterAutomation::Lane::render() to get the value
+        for every sample of the block. Hosts that don't support this won't provide any,
+        and will just change the parameter values between blocks as usual.
+
+        @see ParameterAutomation, setParameterAutomation
+    */
+    const ParameterAutomation* getParameterAutomation() const noexcept     { return parameterAutomation; }
+
     //==============================================================================
     /** Returns the total number of input channels.
 
@@ -1123,6 +1181,71 @@ public:
     /** Removes a previously added listener. */
     virtual void removeListener (AudioProcessorListener* listenerToRemove);
 
+    //==============================================================================
+    /** Gives the processor a queue for the parameter notifications it makes while processing.
+
+        Normally, when a parameter changes or a gesture starts or ends, the parameter's
+        listeners and this processor's AudioProcessorListeners are called synchronously.
+        When a processor automates its own parameters, that means taking a lock and making
+        virtual calls on the audio thread.
+
+        With a queue, notifications made on a thread that's inside a
+        ScopedParameterNotificationQueueing block are pushed onto a lock-free, single-producer
+        single-consumer queue instead. The listeners are called later, on the message thread,
+        or on whichever thread calls dispatchQueuedParameterNotifications().
+
+        If the queue is full, the listeners still aren't called on the queueing thread.
+        Instead, the next dispatch sends the current value of each parameter whose changes
+        didn't fit, after the notifications that did. It also sends any gesture starts or
+        ends that are needed so that the listeners see them in pairs, and end up knowing
+        whether a gesture is in progress. So when the queue overflows, some intermediate
+        values are skipped, but the listeners always finish on the latest value.
+
+        The queue keeps some state for each parameter, so all of the processor's parameters
+        must have been added before this is called.
+
+        Passing 0 removes the queue. This mustn't be called while the processor is being
+        used to process audio.
+
+        The queue is emptied by a timer on the message thread, and stopping a timer from
+        another thread doesn't wait for a callback that's already running. So this method
+        must be called on the message thread, and a processor that has a queue must also
+        be deleted on the message thread.
+
+        @see dispatchQueuedParameterNotifications, ScopedParameterNotificationQueueing
+    */
+    void setParameterNotificationQueueSize (int maxNumQueuedNotifications);
+
+    /** Calls the listeners for any queued parameter notifications, on the calling thread.
+
+        This is called regularly on the message thread, but a host that wants to receive
+        the notifications on one of its own threads can call it as often as it likes.
+        Returns the number of notifications that were delivered.
+
+        @see setParameterNotificationQueueSize
+    */
+    int dispatchQueuedParameterNotifications();
+
+    /** While one of these exists, parameter notifications made on the thread that created
+        it are queued, if the processor has a notification queue.
+
+        Hosts should create one around each call to processBlock(), on the audio thread.
+
+        @see setParameterNotificationQueueSize
+    */
+    class JUCE_API  ScopedParameterNotificationQueueing
+    {
+    public:
+        explicit ScopedParameterNotificationQueueing (AudioProcessor&) noexcept;
+        ~ScopedParameterNotificationQueueing() noexcept;
+
+    private:
+        AudioProcessor& processor;
+        bool isQueueing = false;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedParameterNotificationQueueing)
+    };
+
     //==============================================================================
     /** Tells the processor to use this playhead object.
         The processor will not take ownership of the object, so the caller must delete it when
@@ -1130,6 +1253,16 @@ public:
     */
     virtual void setPlayHead (AudioPlayHead* newPlayHead);
 
+    /** Gives the processor some sample-accurate parameter changes to use while
+        processing the next block.
+
+        A host should call this just before processBlock(), and pass nullptr once the
+        block has been processed. The processor doesn't take ownership of the object.
+
+        @see getParameterAutomation
+    */
+    void setParameterAutomation (const ParameterAutomation* automationForNextBlock) noexcept;
+
     //==============================================================================
     /** This is called by the processor to specify its details before being played. Use this
         version of the function if you are not interested in any sidechain and/or aux buses
@@ -1469,6 +1602,13 @@ private:
     std::atomic<bool> nonRealtime { false };
     ProcessingPrecision processingPrecision = singlePrecision;
     CriticalSection callbackLock, listenerLock, activeEditorLock;
+    std::atomic<const ParameterAutomation*> parameterAutomation { nullptr };
+
+    struct ParameterNotificationQueue;
+    std::unique_ptr<ParameterNotificationQueue> parameterNotificationQueue;
+
+    struct BusesLayoutSupportCache;
+    std::unique_ptr<BusesLayoutSupportCache> busesLayoutSupportCache;
 
     friend class Bus;
     mutable OwnedArray<Bus> inputBuses, outputBuses;
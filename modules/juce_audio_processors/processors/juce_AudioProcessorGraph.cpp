@@ -9,6 +9,7 @@ struct GraphRenderSequence
     struct Context
     {
         FloatType** audioBuffers;
+        float** floatAudioBuffers;
         MidiBuffer* midiBuffers;
         AudioPlayHead* audioPlayHead;
         int numSamples;
@@ -57,7 +58,8 @@ struct GraphRenderSequence
         currentMidiOutputBuffer.clear();
 
         {
-            const Context context { renderingBuffer.getArrayOfWritePointers(), midiBuffers.begin(), audioPlayHead, numSamples };
+            const Context context { renderingBuffer.getArrayOfWritePointers(), floatRenderingBuffer.getArrayOfWritePointers(),
+                                    midiBuffers.begin(), audioPlayHead, numSamples };
             if (renderOps.size() > 0)
                 for (int i = 0; i < renderOps.size(); i++)
                 {
@@ -115,21 +117,45 @@ struct GraphRenderSequence
 
     void addClearChannelOp (int index)
     {
-        createOp ([=] (const Context& c)    { FloatVectorOperations::clear (c.audioBuffers[index], c.numSamples); });
+        if (opsUseFloatChannels())
+            createOp ([=] (const Context& c)    { FloatVectorOperations::clear (c.floatAudioBuffers[index], c.numSamples); });
+        else
+            createOp ([=] (const Context& c)    { FloatVectorOperations::clear (c.audioBuffers[index], c.numSamples); });
+
+        markChannelWritten (index);
     }
 
     void addCopyChannelOp (int srcIndex, int dstIndex)
     {
-        createOp ([=] (const Context& c)    { FloatVectorOperations::copy (c.audioBuffers[dstIndex],
-                                                                           c.audioBuffers[srcIndex],
-                                                                           c.numSamples); });
+        makeChannelReadable (srcIndex);
+
+        if (opsUseFloatChannels())
+            createOp ([=] (const Context& c)    { FloatVectorOperations::copy (c.floatAudioBuffers[dstIndex],
+                                                                               c.floatAudioBuffers[srcIndex],
+                                                                               c.numSamples); });
+        else
+            createOp ([=] (const Context& c)    { FloatVectorOperations::copy (c.audioBuffers[dstIndex],
+                                                                               c.audioBuffers[srcIndex],
+                                                                               c.numSamples); });
+
+        markChannelWritten (dstIndex);
     }
 
     void addAddChannelOp (int srcIndex, int dstIndex)
     {
-        createOp ([=] (const Context& c)    { FloatVectorOperations::add (c.audioBuffers[dstIndex],
-                                                                          c.audioBuffers[srcIndex],
-                                                                          c.numSamples); });
+        makeChannelReadable (srcIndex);
+        makeChannelReadable (dstIndex);
+
+        if (opsUseFloatChannels())
+            createOp ([=] (const Context& c)    { FloatVectorOperations::add (c.floatAudioBuffers[dstIndex],
+                                                                              c.floatAudioBuffers[srcIndex],
+                                                                              c.numSamples); });
+        else
+            createOp ([=] (const Context& c)    { FloatVectorOperations::add (c.audioBuffers[dstIndex],
+                                                                              c.audioBuffers[srcIndex],
+                                                                              c.numSamples); });
+
+        markChannelWritten (dstIndex);
     }
 
     void addClearMidiBufferOp (int index)
@@ -142,29 +168,58 @@ struct GraphRenderSequence
         createOp ([=] (const Context& c)    { c.midiBuffers[dstIndex] = c.midiBuffers[srcIndex]; });
     }
 
-    void addAddMidiBufferOp (int srcIndex, int dstIndex)
+    void addAddMidiBufferOp (const Array<int>& srcIndexes, int dstIndex)
     {
-        createOp ([=] (const Context& c)    { c.midiBuffers[dstIndex].addEvents (c.midiBuffers[srcIndex],
-                                                                                 0, c.numSamples, 0); });
+        renderOps.add (new AddMidiBuffersOp (srcIndexes, dstIndex));
+        sequenceChanged = true;
     }
 
     void addDelayChannelOp (int chan, int delaySize)
     {
-         renderOps.add (new DelayChannelOp (chan, delaySize));
-         sequenceChanged = true;
+        makeChannelReadable (chan);
+
+        if (opsUseFloatChannels())
+            renderOps.add (new DelayChannelOp<float> (&Context::floatAudioBuffers, chan, delaySize));
+        else
+            renderOps.add (new DelayChannelOp<FloatType> (&Context::audioBuffers, chan, delaySize));
 
+        markChannelWritten (chan);
+        sequenceChanged = true;
     }
 
     void addProcessOp (const AudioProcessorGraph::Node::Ptr& node, const Array<int>& audioChannelsUsed, int totalNumChans, int midiBuffer)
     {
-        renderOps.add (new ProcessOp (node, audioChannelsUsed, totalNumChans, midiBuffer));
+        for (auto index : audioChannelsUsed)
+            makeChannelReadable (index);
+
+        renderOps.add (new ProcessOp (node, audioChannelsUsed, totalNumChans, midiBuffer, opsUseFloatChannels()));
+
+        for (auto index : audioChannelsUsed)
+            markChannelWritten (index);
+
         sequenceChanged = true;
     }
 
+    /*  When a double precision graph contains nodes that can only process floats, each
+        channel buffer has a float twin, and the channel ops that feed a float-only node
+        work on those twins. The sequence keeps track of which of the two copies of each
+        channel is up to date, so that a run of float-only nodes only converts the
+        channels it reads on the way in, and the ones it has written on the way out.
+    */
+    void setNextOpsAreForSinglePrecisionNode (bool isSinglePrecisionOnly) noexcept
+    {
+        nextOpsUseFloatChannels = isSinglePrecisionOnly && ! std::is_same<FloatType, float>::value;
+    }
+
+    bool opsUseFloatChannels() const noexcept       { return nextOpsUseFloatChannels; }
+    int getNumConversionOps() const noexcept        { return numConversionOps; }
+
     void prepareBuffers (int blockSize)
     {
         renderingBuffer.setSize (numBuffersNeeded + 1, blockSize);
         renderingBuffer.clear();
+        floatRenderingBuffer.setSize (usesFloatChannels ? numBuffersNeeded + 1 : 0, blockSize);
+        floatRenderingBuffer.clear();
         currentAudioOutputBuffer.setSize (numBuffersNeeded + 1, blockSize);
         currentAudioOutputBuffer.clear();
 
@@ -189,6 +244,7 @@ struct GraphRenderSequence
     void releaseBuffers()
     {
         renderingBuffer.setSize (1, 1);
+        floatRenderingBuffer.setSize (0, 1);
         currentAudioOutputBuffer.setSize (1, 1);
         currentAudioInputBuffer = nullptr;
         currentMidiInputBuffer = nullptr;
@@ -199,6 +255,7 @@ struct GraphRenderSequence
     int numBuffersNeeded = 0, numMidiBuffersNeeded = 0;
 
     AudioBuffer<FloatType> renderingBuffer, currentAudioOutputBuffer, endNodeBuffer;
+    AudioBuffer<float> floatRenderingBuffer;
     AudioBuffer<FloatType>* currentAudioInputBuffer = nullptr;
     HeapBlock<FloatType*> audioChannels;
     
@@ -215,6 +272,61 @@ struct GraphRenderSequence
     std::atomic<bool> sequenceChanged = false;
 
 private:
+    enum
+    {
+        nativeChannelIsValid = 1,
+        floatChannelIsValid  = 2
+    };
+
+    Array<uint8> channelStates;
+    bool nextOpsUseFloatChannels = false, usesFloatChannels = false;
+    int numConversionOps = 0;
+
+    uint8& getChannelState (int index)
+    {
+        while (channelStates.size() <= index)
+            channelStates.add ((uint8) nativeChannelIsValid);
+
+        return channelStates.getReference (index);
+    }
+
+    static void convertChannel (float* dest, const double* src, int num) noexcept   { FloatVectorOperations::convert (dest, src, num); }
+    static void convertChannel (double* dest, const float* src, int num) noexcept   { FloatVectorOperations::convert (dest, src, num); }
+    static void convertChannel (float* dest, const float* src, int num) noexcept    { FloatVectorOperations::copy (dest, src, num); }
+
+    void makeChannelReadable (int index)
+    {
+        // the first channel is the read-only empty buffer, which is silent in both precisions
+        if (index == 0)
+            return;
+
+        auto& state = getChannelState (index);
+
+        if (opsUseFloatChannels())
+        {
+            usesFloatChannels = true;
+
+            if ((state & floatChannelIsValid) == 0)
+            {
+                createOp ([=] (const Context& c)    { convertChannel (c.floatAudioBuffers[index], c.audioBuffers[index], c.numSamples); });
+                state |= floatChannelIsValid;
+                ++numConversionOps;
+            }
+        }
+        else if ((state & nativeChannelIsValid) == 0)
+        {
+            createOp ([=] (const Context& c)    { convertChannel (c.audioBuffers[index], c.floatAudioBuffers[index], c.numSamples); });
+            state |= nativeChannelIsValid;
+            ++numConversionOps;
+        }
+    }
+
+    void markChannelWritten (int index)
+    {
+        if (index != 0)
+            getChannelState (index) = (uint8) (opsUseFloatChannels() ? floatChannelIsValid : nativeChannelIsValid);
+    }
+
     struct RenderingOp
     {
         RenderingOp() noexcept {}
@@ -241,10 +353,12 @@ private:
         sequenceChanged = true;
     }
 
+    template <typename SampleType>
     struct DelayChannelOp  : public RenderingOp
     {
-        DelayChannelOp (int chan, int delaySize)
-            : channel (chan),
+        DelayChannelOp (SampleType** Context::* channelsToUse, int chan, int delaySize)
+            : channels (channelsToUse),
+              channel (chan),
               bufferSize (delaySize + 1),
               writeIndex (delaySize)
         {
@@ -253,7 +367,7 @@ private:
 
         void perform (const Context& c) override
         {
-            auto* data = c.audioBuffers[channel];
+            auto* data = (c.*channels)[channel];
 
             for (int i = c.numSamples; --i >= 0;)
             {
@@ -265,25 +379,59 @@ private:
             }
         }
 
-        HeapBlock<FloatType> buffer;
+        SampleType** Context::* const channels;
+        HeapBlock<SampleType> buffer;
         const int channel, bufferSize;
         int readIndex = 0, writeIndex;
 
         JUCE_DECLARE_NON_COPYABLE (DelayChannelOp)
     };
 
+    struct AddMidiBuffersOp  : public RenderingOp
+    {
+        AddMidiBuffersOp (const Array<int>& srcIndexes, int dstIndex)
+            : sourceIndexes (srcIndexes),
+              destIndex (dstIndex)
+        {
+            sourceRanges.calloc ((size_t) sourceIndexes.size());
+        }
+
+        void perform (const Context& c) override
+        {
+            // only the events inside the block being rendered are passed on
+            for (int i = 0; i < sourceIndexes.size(); ++i)
+            {
+                auto& range = sourceRanges[i];
+                range.buffer = c.midiBuffers + sourceIndexes.getUnchecked (i);
+                range.startSample = 0;
+                range.numSamples = c.numSamples;
+                range.sampleDeltaToAdd = 0;
+            }
+
+            c.midiBuffers[destIndex].mergeEventsFrom (sourceRanges.get(), sourceIndexes.size());
+        }
+
+        const Array<int> sourceIndexes;
+        HeapBlock<MidiBuffer::EventRange> sourceRanges;
+        const int destIndex;
+
+        JUCE_DECLARE_NON_COPYABLE (AddMidiBuffersOp)
+    };
+
     struct ProcessOp   : public RenderingOp
     {
         ProcessOp (const AudioProcessorGraph::Node::Ptr& n,
                    const Array<int>& audioChannelsUsed,
-                   int totalNumChans, int midiBuffer)
+                   int totalNumChans, int midiBuffer, bool useFloatChannels)
             : node (n),
               processor (*n->getProcessor()),
               audioChannelsToUse (audioChannelsUsed),
               totalChans (jmax (1, totalNumChans)),
-              midiBufferToUse (midiBuffer)
+              midiBufferToUse (midiBuffer),
+              usesFloatChannels (useFloatChannels)
         {
             audioChannels.calloc ((size_t) totalChans);
+            floatAudioChannels.calloc ((size_t) totalChans);
 
             while (audioChannelsToUse.size() < totalChans)
                 audioChannelsToUse.add (0);
@@ -292,19 +440,25 @@ private:
         void perform (const Context& c) override
         {
             processor.setPlayHead (c.audioPlayHead);
-            
-            for (int i = 0; i < totalChans; ++i) 
-                audioChannels[i] = c.audioBuffers[audioChannelsToUse.getUnchecked(i)];
-            
-            AudioBuffer<FloatType> buffer (audioChannels, totalChans, c.numSamples);
-            
-            if (processor.isSuspended())
-                buffer.clear();
+
+            if (usesFloatChannels)
+                process (c.floatAudioBuffers, floatAudioChannels, c);
             else
-                callProcess(buffer, c.midiBuffers[midiBufferToUse]);
+                process (c.audioBuffers, audioChannels, c);
+        }
 
+        template <typename SampleType>
+        void process (SampleType** channelBuffers, HeapBlock<SampleType*>& channels, const Context& c)
+        {
+            for (int i = 0; i < totalChans; ++i)
+                channels[i] = channelBuffers[audioChannelsToUse.getUnchecked(i)];
 
-             
+            AudioBuffer<SampleType> buffer (channels, totalChans, c.numSamples);
+
+            if (processor.isSuspended())
+                buffer.clear();
+            else
+                callProcess (buffer, c.midiBuffers[midiBufferToUse]);
         }
 
         void callProcess (AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
@@ -332,24 +486,14 @@ private:
 
         void callProcess (AudioBuffer<double>& buffer, MidiBuffer& midiMessages)
         {
-            if (processor.isUsingDoublePrecision())
-            {
-                if (node->isBypassed())
-                    node->processBlockBypassed (buffer, midiMessages);
-                else
-                    node->processBlock (buffer, midiMessages);
-            }
-            else
-            {
-                tempBufferFloat.makeCopyOf (buffer, true);
+            // float-only nodes in a double precision graph are given the float copies
+            // of their channels, so they never get here
+            jassert (processor.isUsingDoublePrecision());
 
-                if (node->isBypassed())
-                    node->processBlockBypassed (tempBufferFloat, midiMessages);
-                else
-                    node->processBlock (tempBufferFloat, midiMessages);
-
-                buffer.makeCopyOf (tempBufferFloat, true);
-            }
+            if (node->isBypassed())
+                node->processBlockBypassed (buffer, midiMessages);
+            else
+                node->processBlock (buffer, midiMessages);
         }
 
         const AudioProcessorGraph::Node::Ptr node;
@@ -357,9 +501,10 @@ private:
 
         Array<int> audioChannelsToUse;
         HeapBlock<FloatType*> audioChannels;
-        AudioBuffer<float> tempBufferFloat;
+        HeapBlock<float*> floatAudioChannels;
         AudioBuffer<double> tempBufferDouble; //CHANGED FROM AudioBuffer<float> in original Juce version
         const int totalChans, midiBufferToUse;
+        const bool usesFloatChannels;
 
         JUCE_DECLARE_NON_COPYABLE (ProcessOp)
     };
@@ -768,14 +913,20 @@ struct RenderSequenceBuilder
             reusableInputIndex = 0;
         }
 
+        // all the remaining inputs get merged into the buffer in a single op
+        Array<int> otherSourceBuffers;
+
         for (int i = 0; i < sources.size(); ++i)
             if (i != reusableInputIndex)
             {
                 auto srcIndex = getBufferContaining (sources.getUnchecked(i));
 
                 if (srcIndex >= 0)
-                    sequence.addAddMidiBufferOp (srcIndex, midiBufferToUse);
+                    otherSourceBuffers.add (srcIndex);
             }
+
+        if (! otherSourceBuffers.isEmpty())
+            sequence.addAddMidiBufferOp (otherSourceBuffers, midiBufferToUse);
      
         return midiBufferToUse;
     }
@@ -787,6 +938,8 @@ struct RenderSequenceBuilder
         auto numOuts = processor.getMainBusNumOutputChannels();
         auto totalChans = jmax (numIns, numOuts);
 
+        sequence.setNextOpsAreForSinglePrecisionNode (! processor.supportsDoublePrecisionProcessing());
+
         Array<int> audioChannelsToUse;
         auto maxLatency = getInputLatencyForNode (node.nodeID);
 
@@ -1013,6 +1166,25 @@ bool AudioProcessorGraph::Node::isBypassed() const noexcept
     return bypassed;
 }
 
+void AudioProcessorGraph::Node::setParameterAutomation (const ParameterAutomation* automation) noexcept
+{
+    parameterAutomation = automation;
+}
+
+const ParameterAutomation* AudioProcessorGraph::Node::getParameterAutomation() const noexcept
+{
+    return parameterAutomation;
+}
+
+void AudioProcessorGraph::Node::applyAutomation (const ParameterAutomation* automation)
+{
+    if (automation != nullptr)
+    {
+        processor->setParameterAutomation (nullptr);
+        automation->applyFinalValues (*processor);
+    }
+}
+
 void AudioProcessorGraph::Node::setBypassed (bool shouldBeBypassed) noexcept
 {
     if (processor)
@@ -1481,7 +1653,7 @@ AudioProcessorGraph::Node* AudioProcessorGraph::getAudioOutputNode()
         if (node->getProcessor()->getName() == "Audio Output")
             return node;
 
-    return nullptr; audioOutputNode
+    return nullptr;
 }
 
 AudioProcessorGraph::Node* AudioProcessorGraph::getDummyNode()
@@ -1585,21 +1757,33 @@ bool AudioProcessorGraph::anyNodesNeedPreparing() const noexcept
 
 void AudioProcessorGraph::buildRenderingSequence()
 {
-    auto newSequenceF = std::make_unique<RenderSequenceFloat>();
-    auto newSequenceD = std::make_unique<RenderSequenceDouble>();
+    // Only the sequence for the current precision is built. In double precision, any
+    // float-only nodes are rendered from float copies of their channels, so there's
+    // no need for a separate float sequence.
+    std::unique_ptr<RenderSequenceFloat> newSequenceF;
+    std::unique_ptr<RenderSequenceDouble> newSequenceD;
 
-    RenderSequenceBuilder<RenderSequenceFloat>  builderF (*this, *newSequenceF);
-    RenderSequenceBuilder<RenderSequenceDouble> builderD (*this, *newSequenceD);
-    
-    builderF.setSender(isSender);
-    builderD.setSender(isSender);
+    if (getProcessingPrecision() == doublePrecision)
+    {
+        newSequenceD = std::make_unique<RenderSequenceDouble>();
+        RenderSequenceBuilder<RenderSequenceDouble> builderD (*this, *newSequenceD);
+    }
+    else
+    {
+        newSequenceF = std::make_unique<RenderSequenceFloat>();
+        RenderSequenceBuilder<RenderSequenceFloat> builderF (*this, *newSequenceF);
+    }
 
     const ScopedLock sl (getCallbackLock());
 
     const auto currentBlockSize = getBlockSize();
-    newSequenceF->prepareBuffers (currentBlockSize);
-    newSequenceD->prepareBuffers (currentBlockSize);
-    
+
+    if (newSequenceF != nullptr)
+        newSequenceF->prepareBuffers (currentBlockSize);
+
+    if (newSequenceD != nullptr)
+        newSequenceD->prepareBuffers (currentBlockSize);
+
 
     if (anyNodesNeedPreparing())// || sampleRateChanged)
     {
@@ -1749,6 +1933,10 @@ static void processBlockForBuffer (AudioBuffer<FloatType>& buffer, MidiBuffer& m
 
 void AudioProcessorGraph::processBlock (AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
 {
+    // Only the rendering sequence for the graph's processing precision is built, so
+    // make sure you call the version of processBlock that matches it!
+    jassert (! isUsingDoublePrecision());
+
     if ((! isPrepared) && MessageManager::getInstance()->isThisTheMessageThread())
         handleAsyncUpdate();
     processBlockForBuffer<float> (buffer, midiMessages, *this, renderSequenceFloat, isPrepared);
@@ -1756,6 +1944,8 @@ void AudioProcessorGraph::processBlock (AudioBuffer<float>& buffer, MidiBuffer&
 
 void AudioProcessorGraph::processBlock (AudioBuffer<double>& buffer, MidiBuffer& midiMessages)
 {
+    jassert (isUsingDoublePrecision());
+
     if ((! isPrepared) && MessageManager::getInstance()->isThisTheMessageThread())
         handleAsyncUpdate();
 
@@ -1960,4 +2150,158 @@ void AudioProcessorGraph::AudioGraphIOProcessor::setParentGraph (AudioProcessorG
     }
 }
 
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+struct AudioProcessorGraphPrecisionTests  : public UnitTest
+{
+    AudioProcessorGraphPrecisionTests()
+        : UnitTest ("Audio processor graph precision", UnitTestCategories::audio)
+    {}
+
+    struct GainProcessor  : public UnitTestAudioProcessor
+    {
+        GainProcessor (double gainToApply, bool canProcessDoubles)
+            : gain (gainToApply), supportsDoubles (canProcessDoubles)
+        {}
+
+        void processBlock (AudioBuffer<float>& buffer, MidiBuffer&) override
+        {
+            buffer.applyGain ((float) gain);
+            ++numFloatBlocks;
+        }
+
+        void processBlock (AudioBuffer<double>& buffer, MidiBuffer&) override
+        {
+            buffer.applyGain (gain);
+            ++numDoubleBlocks;
+        }
+
+        bool supportsDoublePrecisionProcessing() const override  { return supportsDoubles; }
+
+        const double gain;
+        const bool supportsDoubles;
+        int numFloatBlocks = 0, numDoubleBlocks = 0;
+    };
+
+    Array<GainProcessor*> createChain (AudioProcessorGraph& graph, const Array<bool>& nodesSupportDoubles)
+    {
+        graph.setSender (true);
+        graph.setPlayConfigDetails (2, 2, 44100.0, 64);
+        graph.setProcessingPrecision (AudioProcessor::doublePrecision);
+
+        using IOProcessor = AudioProcessorGraph::AudioGraphIOProcessor;
+        auto previous = graph.addNode (std::make_unique<IOProcessor> (IOProcessor::audioInputNode));
+        auto output = graph.addNode (std::make_unique<IOProcessor> (IOProcessor::audioOutputNode));
+
+        Array<GainProcessor*> processors;
+
+        for (auto supportsDoubles : nodesSupportDoubles)
+        {
+            auto node = graph.addNode (std::make_unique<GainProcessor> (2.0, supportsDoubles));
+            processors.add (dynamic_cast<GainProcessor*> (node->getProcessor()));
+
+            for (int ch = 0; ch < 2; ++ch)
+                graph.addConnection ({ { previous->nodeID, ch }, { node->nodeID, ch } });
+
+            previous = node;
+        }
+
+        for (int ch = 0; ch < 2; ++ch)
+            graph.addConnection ({ { previous->nodeID, ch }, { output->nodeID, ch } });
+
+        graph.prepareToPlay (44100.0, 64);
+        return processors;
+    }
+
+    static int getNumConversionOps (AudioProcessorGraph& graph)
+    {
+        return graph.renderSequenceDouble->getNumConversionOps();
+    }
+
+    void runTest() override
+    {
+        const double input = 1.0 + 1.0e-12;
+
+        beginTest ("Double precision nodes keep full precision");
+        {
+            AudioProcessorGraph graph;
+            auto processors = createChain (graph, { true, true });
+
+            AudioBuffer<double> buffer (2, 64);
+            buffer.clear();
+            buffer.setSample (0, 10, input);
+
+            MidiBuffer midi;
+            graph.processBlock (buffer, midi);
+
+            expectEquals (buffer.getSample (0, 10), input * 4.0);
+            expectEquals (processors[0]->numDoubleBlocks, 1);
+            expectEquals (processors[1]->numDoubleBlocks, 1);
+
+            graph.releaseResources();
+        }
+
+        beginTest ("Float-only nodes in a double precision graph process floats");
+        {
+            AudioProcessorGraph graph;
+            auto processors = createChain (graph, { false, false, true });
+
+            AudioBuffer<double> buffer (2, 64);
+            buffer.clear();
+            buffer.setSample (0, 10, 0.25);
+            buffer.setSample (1, 20, input);
+
+            MidiBuffer midi;
+            graph.processBlock (buffer, midi);
+
+            expectEquals (buffer.getSample (0, 10), 2.0);
+            expectEquals (buffer.getSample (1, 20), (double) (float) input * 8.0);
+            expectEquals (buffer.getSample (0, 11), 0.0);
+
+            expectEquals (processors[0]->numFloatBlocks, 1);
+            expectEquals (processors[1]->numFloatBlocks, 1);
+            expectEquals (processors[2]->numDoubleBlocks, 1);
+
+            // both channels are converted to float on the way into the first node, and
+            // back on the way into the last one
+            expectEquals (getNumConversionOps (graph), 4);
+
+            graph.releaseResources();
+        }
+
+        beginTest ("Channels are only converted where the precision changes");
+        {
+            AudioProcessorGraph doublesOnly;
+            createChain (doublesOnly, { true, true });
+            expectEquals (getNumConversionOps (doublesOnly), 0);
+            doublesOnly.releaseResources();
+
+            // the output node reads the float-only node's channels, so they are converted back
+            AudioProcessorGraph endsWithFloats;
+            auto processors = createChain (endsWithFloats, { true, false, false });
+            expectEquals (getNumConversionOps (endsWithFloats), 4);
+
+            AudioBuffer<double> buffer (2, 64);
+            buffer.clear();
+            buffer.setSample (0, 10, input);
+
+            MidiBuffer midi;
+            endsWithFloats.processBlock (buffer, midi);
+
+            expectEquals (buffer.getSample (0, 10), (double) (float) (input * 2.0) * 4.0);
+            expectEquals (processors[0]->numDoubleBlocks, 1);
+            expectEquals (processors[1]->numFloatBlocks, 1);
+            expectEquals (processors[2]->numFloatBlocks, 1);
+
+            endsWithFloats.releaseResources();
+        }
+    }
+};
+
+static AudioProcessorGraphPrecisionTests audioProcessorGraphPrecisionTests;
+
+#endif
+
 } // namespace juce
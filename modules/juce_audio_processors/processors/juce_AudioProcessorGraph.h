@@ -107,6 +107,22 @@ namespace juce
             /** Tell this node to bypass processing. */
             void setBypassed (bool shouldBeBypassed) noexcept;
 
+            //==============================================================================
+            /** Sets some sample-accurate parameter changes that will be passed to this node's
+                processor with each block it processes.
+
+                The processor can get them from AudioProcessor::getParameterAutomation(), and
+                after each block, its parameters are set to the final values of their lanes.
+
+                The node doesn't take ownership of the object, which must stay valid until it's
+                removed by passing nullptr. Its contents should only be changed on the audio
+                thread, before the graph's processBlock() is called.
+            */
+            void setParameterAutomation (const ParameterAutomation* automation) noexcept;
+
+            /** Returns the automation set with setParameterAutomation(). */
+            const ParameterAutomation* getParameterAutomation() const noexcept;
+
             //==============================================================================
             /** A convenient typedef for referring to a pointer to a node object. */
             using Ptr = ReferenceCountedObjectPtr<Node>;
@@ -134,6 +150,7 @@ namespace juce
             const std::unique_ptr<AudioProcessor> processor;
             bool isPrepared = false;
             std::atomic<bool> bypassed { false };
+            std::atomic<const ParameterAutomation*> parameterAutomation { nullptr };
 
             Node (NodeID, std::unique_ptr<AudioProcessor>) noexcept;
 
@@ -145,16 +162,28 @@ namespace juce
             void processBlock (AudioBuffer<Sample>& audio, MidiBuffer& midi)
             {
                 const ScopedLock lock (processorLock);
+                const AudioProcessor::ScopedParameterNotificationQueueing queueing (*processor);
+                auto* automation = parameterAutomation.load();
+
+                processor->setParameterAutomation (automation);
                 processor->processBlock (audio, midi);
+                applyAutomation (automation);
             }
 
             template <typename Sample>
             void processBlockBypassed (AudioBuffer<Sample>& audio, MidiBuffer& midi)
             {
                 const ScopedLock lock (processorLock);
+                const AudioProcessor::ScopedParameterNotificationQueueing queueing (*processor);
+                auto* automation = parameterAutomation.load();
+
+                processor->setParameterAutomation (automation);
                 processor->processBlockBypassed (audio, midi);
+                applyAutomation (automation);
             }
 
+            void applyAutomation (const ParameterAutomation*);
+
             CriticalSection processorLock;
 
             JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Node)
@@ -276,8 +305,8 @@ namespace juce
 
         void disconnectNode(AudioProcessorGraph::Node * node);
 
-        AudioProcessorGraph::Node*  AudioProcessorGraph::getStartNode(AudioProcessorGraph::Node* endNode);
-        AudioProcessorGraph::Node* AudioProcessorGraph::getOutputBusNode();
+        AudioProcessorGraph::Node* getStartNode(AudioProcessorGraph::Node* endNode);
+        AudioProcessorGraph::Node* getOutputBusNode();
         AudioProcessorGraph::Node* getAudioInputNode();
         AudioProcessorGraph::Node* getAudioOutputNode();
         AudioProcessorGraph::Node* getDummyNode();
@@ -456,6 +485,10 @@ namespace juce
 
         friend class AudioGraphIOProcessor;
 
+       #if JUCE_UNIT_TESTS
+        friend struct AudioProcessorGraphPrecisionTests;
+       #endif
+
         std::atomic<bool> isPrepared { false };
 
         void topologyChanged(bool ignoreCallback = false);
@@ -293,6 +293,9 @@ private:
     Array<Listener*> listeners;
     mutable StringArray valueStrings;
 
+    void callValueChangedListeners (float newValue);
+    void callGestureListeners (bool gestureIsStarting);
+
    #if JUCE_DEBUG
     bool isPerformingGesture = false;
    #endif
@@ -0,0 +1,610 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   By using JUCE, you agree to the terms of both the JUCE 6 End-User License
+   Agreement and JUCE Privacy Policy (both effective as of the 16th June 2020).
+
+   End User License Agreement: www.juce.com/juce-6-licence
+   Privacy Policy: www.juce.com/juce-privacy-policy
+
+   Or: You may also use this code under the terms of the GPL v3 (see
+   www.gnu.org/licenses).
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+namespace StateStoreHelpers
+{
+    enum
+    {
+        snapshotFileMagic   = 0x53535041,   // "APSS"
+        snapshotFileVersion = 1
+    };
+
+    // Chunks end where the top bits of the rolling hash are all zero, which happens
+    // every 4KB on average, but never before minChunkSize or after maxChunkSize.
+    static constexpr size_t minChunkSize = 512, maxChunkSize = 32768;
+    static constexpr uint64 boundaryMask = (uint64) 0xfff << 52;
+
+    static const uint64* getGearTable()
+    {
+        // A fixed table of pseudo-random values, one per byte value. This mustn't
+        // change, or chunks saved by an older version would no longer be shared.
+        struct Table
+        {
+            Table()
+            {
+                uint64 state = 0;
+
+                for (auto& v : values)
+                {
+                    state += 0x9e3779b97f4a7c15ull;
+                    auto z = state;
+                    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+                    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+                    v = z ^ (z >> 31);
+                }
+            }
+
+            uint64 values[256];
+        };
+
+        static const Table table;
+        return table.values;
+    }
+
+    static const char* const chunkFileSuffix = ".chunk";
+    static const char* const snapshotFileSuffix = ".snapshot";
+}
+
+//==============================================================================
+AudioProcessorStateStore::AudioProcessorStateStore() {}
+AudioProcessorStateStore::~AudioProcessorStateStore() {}
+
+//==============================================================================
+size_t AudioProcessorStateStore::getNextChunkSize (const uint8* data, size_t numBytesLeft) noexcept
+{
+    using namespace StateStoreHelpers;
+
+    if (numBytesLeft <= minChunkSize)
+        return numBytesLeft;
+
+    auto* gear = getGearTable();
+    auto limit = jmin (numBytesLeft, maxChunkSize);
+    uint64 hash = 0;
+
+    for (size_t i = 0; i < limit; ++i)
+    {
+        hash = (hash << 1) + gear[data[i]];
+
+        if (i >= minChunkSize && (hash & boundaryMask) == 0)
+            return i + 1;
+    }
+
+    return limit;
+}
+
+uint64 AudioProcessorStateStore::hashChunk (const void* data, size_t size) noexcept
+{
+    // 64-bit FNV-1a
+    auto* bytes = static_cast<const uint8*> (data);
+    uint64 hash = 0xcbf29ce484222325ull;
+
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+
+    return hash;
+}
+
+String AudioProcessorStateStore::getChunkFileName (uint64 key)
+{
+    return String::toHexString ((int64) key).paddedLeft ('0', 16) + StateStoreHelpers::chunkFileSuffix;
+}
+
+uint64 AudioProcessorStateStore::addChunk (const void* data, size_t size)
+{
+    for (auto key = hashChunk (data, size);; ++key)
+    {
+        auto found = chunks.find (key);
+
+        if (found == chunks.end())
+        {
+            auto& chunk = chunks[key];
+            chunk.data.append (data, size);
+            chunk.numReferences = 1;
+            storedDataSize += (int64) size;
+            return key;
+        }
+
+        if (found->second.data.matches (data, size))
+        {
+            ++found->second.numReferences;
+            return key;
+        }
+
+        // A different chunk has the same hash, so try the next key along
+    }
+}
+
+void AudioProcessorStateStore::releaseChunk (uint64 key)
+{
+    auto found = chunks.find (key);
+
+    if (found == chunks.end())
+    {
+        jassertfalse;
+        return;
+    }
+
+    if (--found->second.numReferences <= 0)
+    {
+        storedDataSize -= (int64) found->second.data.getSize();
+        chunks.erase (found);
+    }
+}
+
+//==============================================================================
+int AudioProcessorStateStore::takeSnapshot (AudioProcessor& processor)
+{
+    MemoryBlock state;
+    processor.getStateInformation (state);
+    return addSnapshot (state.getData(), state.getSize());
+}
+
+int AudioProcessorStateStore::addSnapshot (const void* stateData, size_t stateSize)
+{
+    jassert (stateData != nullptr || stateSize == 0);
+
+    auto* bytes = static_cast<const uint8*> (stateData);
+
+    const ScopedLock sl (lock);
+
+    Snapshot snapshot;
+    snapshot.size = (int64) stateSize;
+
+    for (size_t pos = 0; pos < stateSize;)
+    {
+        auto chunkSize = getNextChunkSize (bytes + pos, stateSize - pos);
+        snapshot.chunkKeys.push_back (addChunk (bytes + pos, chunkSize));
+        pos += chunkSize;
+    }
+
+    auto snapshotID = nextSnapshotID++;
+    snapshots[snapshotID] = std::move (snapshot);
+    return snapshotID;
+}
+
+bool AudioProcessorStateStore::getSnapshot (int snapshotID, MemoryBlock& destData) const
+{
+    const ScopedLock sl (lock);
+
+    auto found = snapshots.find (snapshotID);
+
+    if (found == snapshots.end())
+        return false;
+
+    destData.setSize ((size_t) found->second.size);
+    size_t pos = 0;
+
+    for (auto key : found->second.chunkKeys)
+    {
+        auto& chunk = chunks.at (key).data;
+        destData.copyFrom (chunk.getData(), (int) pos, chunk.getSize());
+        pos += chunk.getSize();
+    }
+
+    jassert (pos == destData.getSize());
+    return true;
+}
+
+bool AudioProcessorStateStore::restoreSnapshot (int snapshotID, AudioProcessor& processor) const
+{
+    MemoryBlock state;
+
+    if (! getSnapshot (snapshotID, state))
+        return false;
+
+    processor.setStateInformation (state.getData(), (int) state.getSize());
+    return true;
+}
+
+void AudioProcessorStateStore::removeSnapshot (int snapshotID)
+{
+    const ScopedLock sl (lock);
+
+    auto found = snapshots.find (snapshotID);
+
+    if (found != snapshots.end())
+    {
+        for (auto key : found->second.chunkKeys)
+            releaseChunk (key);
+
+        snapshots.erase (found);
+    }
+}
+
+void AudioProcessorStateStore::clear()
+{
+    const ScopedLock sl (lock);
+    snapshots.clear();
+    chunks.clear();
+    storedDataSize = 0;
+}
+
+bool AudioProcessorStateStore::containsSnapshot (int snapshotID) const
+{
+    const ScopedLock sl (lock);
+    return snapshots.find (snapshotID) != snapshots.end();
+}
+
+Array<int> AudioProcessorStateStore::getSnapshotIDs() const
+{
+    const ScopedLock sl (lock);
+    Array<int> ids;
+
+    for (auto& s : snapshots)
+        ids.add (s.first);
+
+    return ids;
+}
+
+int64 AudioProcessorStateStore::getTotalSnapshotSize() const
+{
+    const ScopedLock sl (lock);
+    int64 total = 0;
+
+    for (auto& s : snapshots)
+        total += s.second.size;
+
+    return total;
+}
+
+int64 AudioProcessorStateStore::getStoredDataSize() const
+{
+    const ScopedLock sl (lock);
+    return storedDataSize;
+}
+
+int AudioProcessorStateStore::getNumChunks() const
+{
+    const ScopedLock sl (lock);
+    return (int) chunks.size();
+}
+
+//==============================================================================
+bool AudioProcessorStateStore::saveToDirectory (const File& directory) const
+{
+    using namespace StateStoreHelpers;
+
+    // Copy everything that's going to be written, so that the lock isn't held while
+    // the files are being written
+    std::map<uint64, MemoryBlock> chunkData;
+    std::map<int, MemoryBlock> snapshotData;
+
+    {
+        const ScopedLock sl (lock);
+
+        for (auto& c : chunks)
+            chunkData.emplace (c.first, c.second.data);
+
+        for (auto& s : snapshots)
+        {
+            MemoryOutputStream out (snapshotData[s.first], false);
+            out.writeInt (snapshotFileMagic);
+            out.writeInt (snapshotFileVersion);
+            out.writeInt64 (s.second.size);
+            out.writeCompressedInt ((int) s.second.chunkKeys.size());
+
+            for (auto key : s.second.chunkKeys)
+                out.writeInt64 ((int64) key);
+        }
+    }
+
+    if (! directory.createDirectory())
+        return false;
+
+    // The directory might hold files with the same names from a different store, so
+    // rather than assuming that an existing file is ours, compare it (a chunk file
+    // with the right name never needs rewriting, but one that's been truncated or
+    // left behind by another store does)
+    auto fileMatches = [] (const File& file, const MemoryBlock& data)
+    {
+        MemoryBlock existing;
+
+        return file.getSize() == (int64) data.getSize()
+                && file.loadFileAsData (existing)
+                && existing == data;
+    };
+
+    bool ok = true;
+
+    for (auto& c : chunkData)
+    {
+        auto file = directory.getChildFile (getChunkFileName (c.first));
+
+        if (! fileMatches (file, c.second))
+            ok = file.replaceWithData (c.second.getData(), c.second.getSize()) && ok;
+    }
+
+    for (auto& s : snapshotData)
+    {
+        auto file = directory.getChildFile (String (s.first) + snapshotFileSuffix);
+
+        if (! fileMatches (file, s.second))
+            ok = file.replaceWithData (s.second.getData(), s.second.getSize()) && ok;
+    }
+
+    for (const auto& entry : RangedDirectoryIterator (directory, false, "*", File::findFiles))
+    {
+        auto file = entry.getFile();
+        auto name = file.getFileNameWithoutExtension();
+
+        if (file.hasFileExtension (chunkFileSuffix))
+        {
+            if (chunkData.find ((uint64) name.getHexValue64()) == chunkData.end())
+                file.deleteFile();
+        }
+        else if (file.hasFileExtension (snapshotFileSuffix))
+        {
+            if (snapshotData.find (name.getIntValue()) == snapshotData.end())
+                file.deleteFile();
+        }
+    }
+
+    return ok;
+}
+
+bool AudioProcessorStateStore::loadSnapshot (const File& directory, const File& snapshotFile)
+{
+    using namespace StateStoreHelpers;
+
+    FileInputStream in (snapshotFile);
+
+    if (! in.openedOk()
+         || in.readInt() != snapshotFileMagic
+         || in.readInt() > snapshotFileVersion)
+        return false;
+
+    Snapshot snapshot;
+    snapshot.size = in.readInt64();
+    auto numChunks = in.readCompressedInt();
+
+    if (snapshot.size < 0 || numChunks < 0 || in.getNumBytesRemaining() < (int64) numChunks * 8)
+        return false;
+
+    int64 totalSize = 0;
+
+    for (int i = 0; i < numChunks; ++i)
+    {
+        auto key = (uint64) in.readInt64();
+
+        if (chunks.find (key) == chunks.end())
+        {
+            MemoryBlock data;
+
+            if (! directory.getChildFile (getChunkFileName (key)).loadFileAsData (data))
+                break;
+
+            chunks[key].data = std::move (data);
+            storedDataSize += (int64) chunks[key].data.getSize();
+        }
+
+        ++chunks[key].numReferences;
+        snapshot.chunkKeys.push_back (key);
+        totalSize += (int64) chunks[key].data.getSize();
+    }
+
+    if ((int) snapshot.chunkKeys.size() != numChunks || totalSize != snapshot.size)
+    {
+        for (auto key : snapshot.chunkKeys)
+            releaseChunk (key);
+
+        return false;
+    }
+
+    auto snapshotID = snapshotFile.getFileNameWithoutExtension().getIntValue();
+    snapshots[snapshotID] = std::move (snapshot);
+    nextSnapshotID = jmax (nextSnapshotID, snapshotID + 1);
+    return true;
+}
+
+bool AudioProcessorStateStore::loadFromDirectory (const File& directory)
+{
+    using namespace StateStoreHelpers;
+
+    const ScopedLock sl (lock);
+
+    clear();
+    bool ok = true;
+
+    for (const auto& entry : RangedDirectoryIterator (directory, false, String ("*") + snapshotFileSuffix, File::findFiles))
+        ok = loadSnapshot (directory, entry.getFile()) && ok;
+
+    return ok;
+}
+
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+struct AudioProcessorStateStoreTests  : public UnitTest
+{
+    AudioProcessorStateStoreTests()
+        : UnitTest ("Audio processor state store", UnitTestCategories::audio)
+    {}
+
+    struct ScopedTestDirectory
+    {
+        ~ScopedTestDirectory()  { directory.deleteRecursively(); }
+
+        const File directory { File::getSpecialLocation (File::tempDirectory).getNonexistentChildFile ("StateStoreTest", {}) };
+    };
+
+    static MemoryBlock createRandomState (Random& r, size_t size)
+    {
+        MemoryBlock block (size);
+
+        for (size_t i = 0; i < size; ++i)
+            block[i] = (char) r.nextInt (256);
+
+        return block;
+    }
+
+    static void insertBytes (MemoryBlock& block, size_t position, const char* text)
+    {
+        block.insert (text, strlen (text), position);
+    }
+
+    int addSnapshot (AudioProcessorStateStore& store, const MemoryBlock& state)
+    {
+        auto snapshotID = store.addSnapshot (state.getData(), state.getSize());
+
+        MemoryBlock restored;
+        expect (store.getSnapshot (snapshotID, restored));
+        expect (restored == state);
+
+        return snapshotID;
+    }
+
+    void runTest() override
+    {
+        auto r = getRandom();
+        const size_t stateSize = 256 * 1024;
+
+        beginTest ("Similar snapshots share most of their data");
+        {
+            AudioProcessorStateStore store;
+            auto state = createRandomState (r, stateSize);
+            auto first = addSnapshot (store, state);
+
+            expectEquals (store.getStoredDataSize(), (int64) stateSize);
+            expect (store.getNumChunks() > 1);
+
+            state[stateSize / 2] = (char) ~state[stateSize / 2];
+            insertBytes (state, 1000, "some extra data");
+            addSnapshot (store, state);
+
+            expectEquals (store.getTotalSnapshotSize(), (int64) (2 * stateSize) + 15);
+            expect (store.getStoredDataSize() < (int64) stateSize + 2 * 32768);
+
+            auto storedSize = store.getStoredDataSize();
+            addSnapshot (store, state);
+            expectEquals (store.getStoredDataSize(), storedSize);
+
+            store.removeSnapshot (first);
+            expect (! store.containsSnapshot (first));
+            expectEquals (store.getSnapshotIDs().size(), 2);
+            expect (store.getStoredDataSize() <= (int64) stateSize + 15);
+
+            MemoryBlock empty;
+            auto emptyID = addSnapshot (store, empty);
+            expect (store.containsSnapshot (emptyID));
+
+            store.clear();
+            expectEquals (store.getNumChunks(), 0);
+            expectEquals (store.getStoredDataSize(), (int64) 0);
+        }
+
+        beginTest ("Snapshots can be saved to and loaded from a directory");
+        {
+            ScopedTestDirectory tempDirectory;
+            auto directory = tempDirectory.directory;
+
+            AudioProcessorStateStore store;
+            auto state = createRandomState (r, stateSize);
+            auto first = addSnapshot (store, state);
+            expect (store.saveToDirectory (directory));
+
+            auto numFilesAfterFirstSave = directory.getNumberOfChildFiles (File::findFiles);
+
+            insertBytes (state, stateSize / 3, "a small change");
+            auto second = addSnapshot (store, state);
+            expect (store.saveToDirectory (directory));
+
+            auto numNewChunkFiles = directory.getNumberOfChildFiles (File::findFiles) - numFilesAfterFirstSave - 1;
+            expect (numNewChunkFiles > 0 && numNewChunkFiles < store.getNumChunks() / 4);
+
+            AudioProcessorStateStore loaded;
+            expect (loaded.loadFromDirectory (directory));
+            expectEquals (loaded.getSnapshotIDs().size(), 2);
+            expectEquals (loaded.getStoredDataSize(), store.getStoredDataSize());
+
+            MemoryBlock restored;
+            expect (loaded.getSnapshot (second, restored));
+            expect (restored == state);
+
+            expect (loaded.addSnapshot (state.getData(), state.getSize()) > second);
+
+            store.removeSnapshot (first);
+            expect (store.saveToDirectory (directory));
+            expectEquals (directory.getNumberOfChildFiles (File::findFiles), store.getNumChunks() + 1);
+        }
+
+        beginTest ("A new store can be saved over another store's directory");
+        {
+            ScopedTestDirectory tempDirectory;
+            auto directory = tempDirectory.directory;
+
+            AudioProcessorStateStore oldStore, newStore;
+            addSnapshot (oldStore, createRandomState (r, stateSize));
+            expect (oldStore.saveToDirectory (directory));
+
+            // the new store's first snapshot has the same ID as the old store's one
+            auto state = createRandomState (r, stateSize);
+            auto id = addSnapshot (newStore, state);
+            expect (newStore.saveToDirectory (directory));
+
+            AudioProcessorStateStore loaded;
+            expect (loaded.loadFromDirectory (directory));
+            expect (loaded.getSnapshotIDs() == Array<int> { id });
+
+            MemoryBlock restored;
+            expect (loaded.getSnapshot (id, restored));
+            expect (restored == state);
+        }
+
+        beginTest ("Chunk files with the wrong contents are rewritten");
+        {
+            ScopedTestDirectory tempDirectory;
+            auto directory = tempDirectory.directory;
+
+            AudioProcessorStateStore store;
+            auto state = createRandomState (r, stateSize);
+            auto id = addSnapshot (store, state);
+            expect (store.saveToDirectory (directory));
+
+            // overwrite a chunk with garbage of the same size
+            auto chunkFile = directory.findChildFiles (File::findFiles, false, "*.chunk").getFirst();
+            MemoryBlock garbage ((size_t) chunkFile.getSize(), true);
+            expect (chunkFile.replaceWithData (garbage.getData(), garbage.getSize()));
+
+            expect (store.saveToDirectory (directory));
+
+            AudioProcessorStateStore loaded;
+            expect (loaded.loadFromDirectory (directory));
+
+            MemoryBlock restored;
+            expect (loaded.getSnapshot (id, restored));
+            expect (restored == state);
+        }
+    }
+};
+
+static AudioProcessorStateStoreTests audioProcessorStateStoreTests;
+
+#endif
+
+} // namespace juce
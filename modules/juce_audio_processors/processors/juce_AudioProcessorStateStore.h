@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   By using JUCE, you agree to the terms of both the JUCE 6 End-User License
+   Agreement and JUCE Privacy Policy (both effective as of the 16th June 2020).
+
+   End User License Agreement: www.juce.com/juce-6-licence
+   Privacy Policy: www.juce.com/juce-privacy-policy
+
+   Or: You may also use this code under the terms of the GPL v3 (see
+   www.gnu.org/licenses).
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+//==============================================================================
+/**
+    Keeps snapshots of plugin states, only storing the data that differs between them.
+
+    Each state is cut into chunks at boundaries chosen by a rolling hash of its
+    contents, so changing one part of a state only changes the chunks around that
+    part. Chunks are keyed on a hash of their data and shared by every snapshot that
+    contains them, which means that a long undo history or a series of autosaves of a
+    large state costs little more than the changes between the snapshots.
+
+    A store can also be written to a directory, with each chunk in its own file.
+    Saving again only writes the chunks that aren't already there.
+
+    All the methods are thread-safe.
+
+    @tags{Audio}
+*/
+class JUCE_API  AudioProcessorStateStore
+{
+public:
+    //==============================================================================
+    /** Creates an empty store. */
+    AudioProcessorStateStore();
+
+    /** Destructor. */
+    ~AudioProcessorStateStore();
+
+    //==============================================================================
+    /** Gets the processor's state with getStateInformation(), and adds it as a new snapshot.
+        Returns the ID of the new snapshot.
+    */
+    int takeSnapshot (AudioProcessor& processor);
+
+    /** Adds a block of state data as a new snapshot, and returns the snapshot's ID. */
+    int addSnapshot (const void* stateData, size_t stateSize);
+
+    /** Reassembles the data for a snapshot.
+        Returns false if there's no snapshot with this ID.
+    */
+    bool getSnapshot (int snapshotID, MemoryBlock& destData) const;
+
+    /** Passes the data for a snapshot to the processor's setStateInformation().
+        Returns false if there's no snapshot with this ID.
+    */
+    bool restoreSnapshot (int snapshotID, AudioProcessor& processor) const;
+
+    /** Removes a snapshot, freeing any chunks that no other snapshot uses. */
+    void removeSnapshot (int snapshotID);
+
+    /** Removes all the snapshots. */
+    void clear();
+
+    /** Returns true if there's a snapshot with this ID. */
+    bool containsSnapshot (int snapshotID) const;
+
+    /** Returns the IDs of all the snapshots, oldest first. */
+    Array<int> getSnapshotIDs() const;
+
+    //==============================================================================
+    /** Returns the combined size of all the snapshots, as if each one were stored in full. */
+    int64 getTotalSnapshotSize() const;
+
+    /** Returns the number of bytes of chunk data that are actually being stored. */
+    int64 getStoredDataSize() const;
+
+    /** Returns the number of distinct chunks in the store. */
+    int getNumChunks() const;
+
+    //==============================================================================
+    /** Writes the store to a directory, creating it if necessary.
+
+        Files that are already in the directory with the right contents aren't written
+        again, and any chunk or snapshot files that the store no longer uses are deleted.
+        Any other files are rewritten, so the directory always ends up matching this
+        store, even if it was last saved by a different one. The store is only locked
+        while its contents are copied, not while the files are written. Returns false if
+        something couldn't be written.
+    */
+    bool saveToDirectory (const File& directory) const;
+
+    /** Replaces the contents of the store with the snapshots saved in a directory.
+
+        Returns false if any of the snapshots couldn't be read. The ones that could be
+        read are still loaded.
+    */
+    bool loadFromDirectory (const File& directory);
+
+private:
+    //==============================================================================
+    struct Chunk
+    {
+        MemoryBlock data;
+        int numReferences = 0;
+    };
+
+    struct Snapshot
+    {
+        std::vector<uint64> chunkKeys;
+        int64 size = 0;
+    };
+
+    uint64 addChunk (const void* data, size_t size);
+    void releaseChunk (uint64 key);
+    static size_t getNextChunkSize (const uint8* data, size_t numBytesLeft) noexcept;
+    static uint64 hashChunk (const void* data, size_t size) noexcept;
+    static String getChunkFileName (uint64 key);
+    bool loadSnapshot (const File& directory, const File& snapshotFile);
+
+    std::map<uint64, Chunk> chunks;
+    std::map<int, Snapshot> snapshots;
+    int nextSnapshotID = 1;
+    int64 storedDataSize = 0;
+    CriticalSection lock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioProcessorStateStore)
+};
+
+} // namespace juce
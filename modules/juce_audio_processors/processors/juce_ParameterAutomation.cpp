@@ -0,0 +1,350 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   By using JUCE, you agree to the terms of both the JUCE 6 End-User License
+   Agreement and JUCE Privacy Policy (both effective as of the 16th June 2020).
+
+   End User License Agreement: www.juce.com/juce-6-licence
+   Privacy Policy: www.juce.com/juce-privacy-policy
+
+   Or: You may also use this code under the terms of the GPL v3 (see
+   www.gnu.org/licenses).
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+namespace ParameterAutomationHelpers
+{
+    struct RampTable
+    {
+        enum { size = 64 };
+
+        RampTable() noexcept
+        {
+            for (int i = 0; i < size; ++i)
+                values[i] = (float) i;
+        }
+
+        float values[size];
+    };
+
+    static const RampTable rampTable;
+
+    // Fills a buffer with a straight line by scaling and offsetting a table of
+    // ascending integers, so that it can all be done with vector operations.
+    static void fillRamp (float* dest, int numSamples, float startValue, float increment) noexcept
+    {
+        if (increment == 0.0f)
+        {
+            FloatVectorOperations::fill (dest, startValue, numSamples);
+            return;
+        }
+
+        for (int i = 0; i < numSamples; i += RampTable::size)
+        {
+            auto num = jmin ((int) RampTable::size, numSamples - i);
+
+            FloatVectorOperations::copyWithMultiply (dest + i, rampTable.values, increment, num);
+            FloatVectorOperations::add (dest + i, startValue + increment * (float) i, num);
+        }
+    }
+}
+
+//==============================================================================
+float ParameterAutomation::Lane::getValueAt (int sampleOffset, float valueBeforeBlock) const noexcept
+{
+    auto next = std::upper_bound (points.begin(), points.end(), sampleOffset,
+                                  [] (int offset, const Point& p) { return offset < p.sampleOffset; });
+
+    if (next == points.end())
+        return points.empty() ? valueBeforeBlock : points.back().value;
+
+    auto startOffset = next == points.begin() ? 0 : std::prev (next)->sampleOffset;
+    auto startValue  = next == points.begin() ? valueBeforeBlock : std::prev (next)->value;
+
+    return startValue + (next->value - startValue) * (float) (sampleOffset - startOffset)
+                                                   / (float) (next->sampleOffset - startOffset);
+}
+
+float ParameterAutomation::Lane::getFinalValue (float valueBeforeBlock) const noexcept
+{
+    return points.empty() ? valueBeforeBlock : points.back().value;
+}
+
+void ParameterAutomation::Lane::render (float* destination, int numSamples, float valueBeforeBlock) const noexcept
+{
+    int position = 0;
+    auto value = valueBeforeBlock;
+
+    for (auto& p : points)
+    {
+        if (p.sampleOffset > position)
+        {
+            auto increment = (p.value - value) / (float) (p.sampleOffset - position);
+            ParameterAutomationHelpers::fillRamp (destination + position, jmin (p.sampleOffset, numSamples) - position,
+                                                  value, increment);
+        }
+
+        if (p.sampleOffset >= numSamples)
+            return;
+
+        position = p.sampleOffset;
+        value = p.value;
+    }
+
+    FloatVectorOperations::fill (destination + position, value, numSamples - position);
+}
+
+//==============================================================================
+ParameterAutomation::ParameterAutomation (int maxNumLanes, int maxNumPointsPerLane)
+    : lanes ((size_t) jmax (0, maxNumLanes)),
+      maxNumPoints ((size_t) jmax (0, maxNumPointsPerLane))
+{
+    for (auto& lane : lanes)
+        lane.points.reserve (maxNumPoints);
+}
+
+ParameterAutomation::~ParameterAutomation()
+{
+}
+
+void ParameterAutomation::clear() noexcept
+{
+    for (int i = 0; i < numLanesInUse; ++i)
+        lanes[(size_t) i].points.clear();
+
+    numLanesInUse = 0;
+}
+
+bool ParameterAutomation::addPoint (int parameterIndex, int sampleOffset, float normalisedValue) noexcept
+{
+    jassert (parameterIndex >= 0 && sampleOffset >= 0);
+
+    auto* lane = const_cast<Lane*> (getLaneForParameter (parameterIndex));
+
+    if (lane == nullptr)
+    {
+        if (numLanesInUse >= (int) lanes.size())
+            return false;
+
+        lane = &lanes[(size_t) numLanesInUse++];
+        lane->parameterIndex = parameterIndex;
+    }
+
+    auto& points = lane->points;
+
+    if (points.size() >= maxNumPoints)
+        return false;
+
+    Point point { jmax (0, sampleOffset), normalisedValue };
+
+    // (the storage was reserved up-front, so neither of these will allocate)
+    if (points.empty() || points.back().sampleOffset <= point.sampleOffset)
+        points.push_back (point);
+    else
+        points.insert (std::upper_bound (points.begin(), points.end(), point.sampleOffset,
+                                         [] (int offset, const Point& p) { return offset < p.sampleOffset; }),
+                       point);
+
+    return true;
+}
+
+const ParameterAutomation::Lane* ParameterAutomation::getLaneForParameter (int parameterIndex) const noexcept
+{
+    for (int i = 0; i < numLanesInUse; ++i)
+        if (lanes[(size_t) i].parameterIndex == parameterIndex)
+            return &lanes[(size_t) i];
+
+    return nullptr;
+}
+
+void ParameterAutomation::applyFinalValues (AudioProcessor& processor) const
+{
+    auto& parameters = processor.getParameters();
+
+    for (int i = 0; i < numLanesInUse; ++i)
+    {
+        auto& lane = lanes[(size_t) i];
+
+        if (auto* param = parameters[lane.parameterIndex])
+        {
+            auto newValue = lane.getFinalValue (param->getValue());
+
+            if (newValue != param->getValue())
+            {
+                param->setValue (newValue);
+                param->sendValueChangedMessageToListeners (newValue);
+            }
+        }
+    }
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+struct ParameterAutomationTests  : public UnitTest
+{
+    ParameterAutomationTests()
+        : UnitTest ("Parameter Automation", UnitTestCategories::audioProcessorParameters)
+    {}
+
+    struct AutomatedProcessor  : public UnitTestAudioProcessor
+    {
+        AutomatedProcessor()
+        {
+            addParameter (gain = new AudioParameterFloat ("gain", "Gain", 0.0f, 1.0f, 0.0f));
+        }
+
+        void processBlock (AudioBuffer<float>& buffer, MidiBuffer&) override
+        {
+            rendered.setSize (1, buffer.getNumSamples(), false, false, true);
+
+            if (auto* automation = getParameterAutomation())
+            {
+                if (auto* lane = automation->getLaneForParameter (gain->getParameterIndex()))
+                {
+                    lane->render (rendered.getWritePointer (0), buffer.getNumSamples(), gain->convertTo0to1 (gain->get()));
+                    ++numAutomatedBlocks;
+                    return;
+                }
+            }
+
+            rendered.clear();
+        }
+
+        using UnitTestAudioProcessor::processBlock;
+
+        AudioParameterFloat* gain;
+        AudioBuffer<float> rendered;
+        int numAutomatedBlocks = 0;
+    };
+
+    void runTest() override
+    {
+        beginTest ("Points are kept in order");
+        {
+            ParameterAutomation automation;
+            automation.addPoint (3, 100, 0.5f);
+            automation.addPoint (3, 20, 0.1f);
+            automation.addPoint (3, 60, 0.3f);
+            automation.addPoint (1, 10, 1.0f);
+
+            expectEquals (automation.getNumLanes(), 2);
+            expect (automation.getLaneForParameter (2) == nullptr);
+
+            auto* lane = automation.getLaneForParameter (3);
+            expect (lane != nullptr);
+            expectEquals (lane->getNumPoints(), 3);
+
+            int lastOffset = -1;
+
+            for (auto& p : *lane)
+            {
+                expect (p.sampleOffset > lastOffset);
+                lastOffset = p.sampleOffset;
+            }
+
+            expectEquals (lane->getFinalValue (0.0f), 0.5f);
+
+            automation.clear();
+            expectEquals (automation.getNumLanes(), 0);
+        }
+
+        beginTest ("Running out of space fails without allocating");
+        {
+            ParameterAutomation automation (1, 2);
+            expect (automation.addPoint (0, 0, 0.0f));
+            expect (automation.addPoint (0, 10, 1.0f));
+            expect (! automation.addPoint (0, 20, 0.5f));
+            expect (! automation.addPoint (1, 0, 0.5f));
+        }
+
+        beginTest ("Rendered values match the interpolated values");
+        {
+            ParameterAutomation automation;
+            Random r (42);
+            const int numSamples = 517;
+
+            for (int i = 0; i < 12; ++i)
+                automation.addPoint (0, r.nextInt (numSamples + 40), r.nextFloat());
+
+            automation.addPoint (0, 200, 0.75f);
+            automation.addPoint (0, 200, 0.25f);
+
+            auto& lane = automation.getLane (0);
+            HeapBlock<float> values ((size_t) numSamples);
+            lane.render (values, numSamples, 0.6f);
+
+            int numErrors = 0;
+
+            for (int i = 0; i < numSamples; ++i)
+                if (std::abs (values[i] - lane.getValueAt (i, 0.6f)) > 1.0e-5f)
+                    ++numErrors;
+
+            expectEquals (numErrors, 0);
+            expectEquals (lane.getValueAt (200, 0.6f), 0.25f);
+        }
+
+        beginTest ("A graph passes automation to its nodes");
+        {
+            AudioProcessorGraph graph;
+            graph.setSender (true);
+            graph.setPlayConfigDetails (2, 2, 44100.0, 128);
+
+            using IOProcessor = AudioProcessorGraph::AudioGraphIOProcessor;
+            auto input  = graph.addNode (std::make_unique<IOProcessor> (IOProcessor::audioInputNode));
+            auto output = graph.addNode (std::make_unique<IOProcessor> (IOProcessor::audioOutputNode));
+            auto node = graph.addNode (std::make_unique<AutomatedProcessor>());
+
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                graph.addConnection ({ { input->nodeID, ch }, { node->nodeID, ch } });
+                graph.addConnection ({ { node->nodeID, ch }, { output->nodeID, ch } });
+            }
+
+            auto* processor = dynamic_cast<AutomatedProcessor*> (node->getProcessor());
+
+            ParameterAutomation automation;
+            automation.addPoint (processor->gain->getParameterIndex(), 0, 0.0f);
+            automation.addPoint (processor->gain->getParameterIndex(), 64, 1.0f);
+            node->setParameterAutomation (&automation);
+
+            graph.prepareToPlay (44100.0, 128);
+
+            AudioBuffer<float> buffer (2, 128);
+            MidiBuffer midi;
+            graph.processBlock (buffer, midi);
+
+            expectEquals (processor->numAutomatedBlocks, 1);
+            expectEquals (processor->rendered.getSample (0, 32), 0.5f);
+            expectEquals (processor->rendered.getSample (0, 100), 1.0f);
+            expectEquals (processor->gain->get(), 1.0f);
+            expect (processor->getParameterAutomation() == nullptr);
+
+            node->setParameterAutomation (nullptr);
+            graph.processBlock (buffer, midi);
+            expectEquals (processor->numAutomatedBlocks, 1);
+
+            graph.releaseResources();
+        }
+    }
+};
+
+static ParameterAutomationTests parameterAutomationTests;
+
+#endif
+
+} // namespace juce
@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   By using JUCE, you agree to the terms of both the JUCE 6 End-User License
+   Agreement and JUCE Privacy Policy (both effective as of the 16th June 2020).
+
+   End User License Agreement: www.juce.com/juce-6-licence
+   Privacy Policy: www.juce.com/juce-privacy-policy
+
+   Or: You may also use this code under the terms of the GPL v3 (see
+   www.gnu.org/licenses).
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+class AudioProcessor;
+
+//==============================================================================
+/**
+    Holds sample-accurate changes to some of a processor's parameters, for a single
+    block of audio.
+
+    A host fills one of these with the changes it wants to make during the next block,
+    and passes it to the processor with AudioProcessor::setParameterAutomation(). The
+    processor can then pick it up with AudioProcessor::getParameterAutomation() in its
+    processBlock() method, and use Lane::render() to turn each lane into a per-sample
+    buffer of values, instead of the host having to split the block at every change.
+
+    All the storage is allocated by the constructor, so filling and clearing one of
+    these on the audio thread is realtime-safe.
+
+    @see AudioProcessor::getParameterAutomation, AudioProcessorGraph::Node::setParameterAutomation
+
+    @tags{Audio}
+*/
+class JUCE_API  ParameterAutomation
+{
+public:
+    //==============================================================================
+    /** A change to a parameter's value at a position within the block. */
+    struct Point
+    {
+        int sampleOffset;   /**< The position of the change, in samples from the start of the block. */
+        float value;        /**< The parameter's new normalised value, from 0 to 1. */
+    };
+
+    //==============================================================================
+    /** The changes to one parameter, sorted by their position in the block.
+
+        The value is treated as moving in a straight line from one point to the next,
+        and from the parameter's value before the block began to the first point.
+        After the last point, it stays at that point's value.
+    */
+    class JUCE_API  Lane
+    {
+    public:
+        /** Returns the index of the parameter in AudioProcessor::getParameters(). */
+        int getParameterIndex() const noexcept              { return parameterIndex; }
+
+        /** Returns the number of points in the lane. */
+        int getNumPoints() const noexcept                   { return (int) points.size(); }
+
+        /** Returns one of the points. */
+        const Point& getPoint (int index) const noexcept    { return points[(size_t) index]; }
+
+        /** Iterates the points. */
+        const Point* begin() const noexcept                 { return points.data(); }
+
+        /** Iterates the points. */
+        const Point* end() const noexcept                   { return points.data() + points.size(); }
+
+        /** Returns the parameter's value at a position in the block. */
+        float getValueAt (int sampleOffset, float valueBeforeBlock) const noexcept;
+
+        /** Returns the value the parameter should have at the end of the block. */
+        float getFinalValue (float valueBeforeBlock) const noexcept;
+
+        /** Fills a buffer with the parameter's value at each sample of the block.
+            The straight sections between points are filled with vector operations.
+        */
+        void render (float* destination, int numSamples, float valueBeforeBlock) const noexcept;
+
+    private:
+        friend class ParameterAutomation;
+
+        int parameterIndex = -1;
+        std::vector<Point> points;
+    };
+
+    //==============================================================================
+    /** Creates an empty set of lanes, with room for the given number of lanes and
+        points in each lane.
+    */
+    explicit ParameterAutomation (int maxNumLanes = 32, int maxNumPointsPerLane = 256);
+
+    /** Destructor. */
+    ~ParameterAutomation();
+
+    //==============================================================================
+    /** Removes all the lanes, without freeing any memory. */
+    void clear() noexcept;
+
+    /** Adds a change to a parameter.
+
+        The point is inserted in the right place in the parameter's lane, creating the
+        lane if needed. Points at the same position are kept in the order they were
+        added, so the last one wins.
+
+        @returns false if the point couldn't be added because there's no more room
+                 for lanes, or for points in this lane
+    */
+    bool addPoint (int parameterIndex, int sampleOffset, float normalisedValue) noexcept;
+
+    //==============================================================================
+    /** Returns the number of parameters that have any changes. */
+    int getNumLanes() const noexcept                    { return numLanesInUse; }
+
+    /** Returns one of the lanes. */
+    const Lane& getLane (int index) const noexcept      { return lanes[(size_t) index]; }
+
+    /** Returns the lane for a parameter, or nullptr if it has no changes. */
+    const Lane* getLaneForParameter (int parameterIndex) const noexcept;
+
+    //==============================================================================
+    /** Sets each of a processor's automated parameters to its lane's final value, and
+        notifies the parameter's listeners.
+
+        A host can call this after processing the block, so that the parameters end up
+        where the automation left them, just as they would if the host had split the
+        block and set the values itself.
+    */
+    void applyFinalValues (AudioProcessor& processor) const;
+
+private:
+    //==============================================================================
+    std::vector<Lane> lanes;
+    int numLanesInUse = 0;
+    size_t maxNumPoints;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParameterAutomation)
+};
+
+} // namespace juce
@@ -26,7 +26,119 @@
 namespace juce
 {
 
-KnownPluginList::KnownPluginList()  {}
+//==============================================================================
+/*  Hashed lookups of the types in the list, by their file and by the part of their
+    identifier string that matchesIdentifierString() checks. These hold positions in
+    the types array rather than copies of the descriptions, and are only used while
+    holding the typesArrayLock.
+
+    New types are inserted at the start of the array, so the positions are counted back
+    from the end of it, which means that adding a type doesn't move any of the others.
+    Anything else that changes the order of the array needs to call rebuild().
+*/
+struct KnownPluginList::TypeIndex
+{
+    explicit TypeIndex (Array<PluginDescription>& typesToIndex)  : types (typesToIndex) {}
+
+    void clear()
+    {
+        byFile.clear();
+        bySuffix.clear();
+    }
+
+    /*  Re-indexes the whole array, removing any duplicates (keeping the first of each). */
+    void rebuild()
+    {
+        for (;;)
+        {
+            clear();
+            Array<int> duplicates;
+
+            for (int i = 0; i < types.size(); ++i)
+            {
+                auto& type = types.getReference (i);
+
+                if (findDuplicateOf (type) != nullptr)
+                {
+                    duplicates.add (i);
+                    continue;
+                }
+
+                auto key = types.size() - 1 - i;
+                byFile[type.fileOrIdentifier].add (key);
+                bySuffix[getSuffix (type)].add (key);
+            }
+
+            if (duplicates.isEmpty())
+                return;
+
+            for (int i = duplicates.size(); --i >= 0;)
+                types.remove (duplicates.getUnchecked (i));
+        }
+    }
+
+    /*  Indexes a type that has just been inserted at the start of the array. */
+    void addFirstType()
+    {
+        auto key = types.size() - 1;
+        auto& type = getType (key);
+
+        byFile[type.fileOrIdentifier].insert (0, key);
+        bySuffix[getSuffix (type)].insert (0, key);
+    }
+
+    PluginDescription& getType (int key) const
+    {
+        return types.getReference (types.size() - 1 - key);
+    }
+
+    /*  Returns the keys of the types in a file, in the order they appear in the array. */
+    const Array<int>* getTypesForFile (const String& fileOrIdentifier) const
+    {
+        auto file = byFile.find (fileOrIdentifier);
+        return file != byFile.end() ? &file->second : nullptr;
+    }
+
+    PluginDescription* findDuplicateOf (const PluginDescription& type) const
+    {
+        if (auto* typesInFile = getTypesForFile (type.fileOrIdentifier))
+            for (auto key : *typesInFile)
+                if (getType (key).isDuplicateOf (type))
+                    return &getType (key);
+
+        return nullptr;
+    }
+
+    const PluginDescription* findIdentifierString (const String& identifierString) const
+    {
+        auto uidPart = identifierString.fromLastOccurrenceOf ("-", true, false);
+        auto hashPart = identifierString.upToLastOccurrenceOf ("-", false, false)
+                                        .fromLastOccurrenceOf ("-", true, false);
+
+        // (matchesIdentifierString() only looks at this suffix, so any type that
+        // matches the string will be in this list)
+        auto suffix = bySuffix.find ((hashPart + uidPart).toLowerCase());
+
+        if (suffix != bySuffix.end())
+            for (auto key : suffix->second)
+                if (getType (key).matchesIdentifierString (identifierString))
+                    return &getType (key);
+
+        return nullptr;
+    }
+
+    static String getSuffix (const PluginDescription& d)
+    {
+        return "-" + String::toHexString (d.fileOrIdentifier.hashCode())
+             + "-" + String::toHexString (d.uid);
+    }
+
+    Array<PluginDescription>& types;
+    std::unordered_map<String, Array<int>> byFile, bySuffix;
+};
+
+//==============================================================================
+KnownPluginList::KnownPluginList()  : typeIndex (std::make_unique<TypeIndex> (types)) {}
 KnownPluginList::~KnownPluginList() {}
 
 void KnownPluginList::clear()
@@ -36,6 +148,7 @@ void KnownPluginList::clear()
     if (! types.isEmpty())
     {
         types.clear();
+        typeIndex->clear();
         sendChangeMessage();
     }
 }
@@ -67,9 +180,8 @@ std::unique_ptr<PluginDescription> KnownPluginList::getTypeForFile (const String
 {
     ScopedLock lock (typesArrayLock);
 
-    for (auto& desc : types)
-        if (desc.fileOrIdentifier == fileOrIdentifier)
-            return std::make_unique<PluginDescription> (desc);
+    if (auto* typesInFile = typeIndex->getTypesForFile (fileOrIdentifier))
+        return std::make_unique<PluginDescription> (typeIndex->getType (typesInFile->getFirst()));
 
     return {};
 }
@@ -78,9 +190,8 @@ std::unique_ptr<PluginDescription> KnownPluginList::getTypeForIdentifierString (
 {
     ScopedLock lock (typesArrayLock);
 
-    for (auto& desc : types)
-        if (desc.matchesIdentifierString (identifierString))
-            return std::make_unique<PluginDescription> (desc);
+    if (auto* desc = typeIndex->findIdentifierString (identifierString))
+        return std::make_unique<PluginDescription> (*desc);
 
     return {};
 }
@@ -90,20 +201,18 @@ bool KnownPluginList::addType (const PluginDescription& type)
     {
         ScopedLock lock (typesArrayLock);
 
-        for (auto& desc : types)
+        if (auto* existing = typeIndex->findDuplicateOf (type))
         {
-            if (desc.isDuplicateOf (type))
-            {
-                // strange - found a duplicate plugin with different info..
-                jassert (desc.name == type.name);
-                jassert (desc.isInstrument == type.isInstrument);
+            // strange - found a duplicate plugin with different info..
+            jassert (existing->name == type.name);
+            jassert (existing->isInstrument == type.isInstrument);
 
-                desc = type;
-                return false;
-            }
+            *existing = type;
+            return false;
         }
 
         types.insert (0, type);
+        typeIndex->addFirstType();
     }
 
     sendChangeMessage();
@@ -115,9 +224,11 @@ void KnownPluginList::removeType (const PluginDescription& type)
     {
         ScopedLock lock (typesArrayLock);
 
-        for (int i = types.size(); --i >= 0;)
-            if (types.getUnchecked (i).isDuplicateOf (type))
-                types.remove (i);
+        if (auto* existing = typeIndex->findDuplicateOf (type))
+        {
+            types.remove (existing);
+            typeIndex->rebuild();
+        }
     }
 
     sendChangeMessage();
@@ -126,13 +237,15 @@ void KnownPluginList::removeType (const PluginDescription& type)
 bool KnownPluginList::isListingUpToDate (const String& fileOrIdentifier,
                                          AudioPluginFormat& formatToUse) const
 {
-    if (getTypeForFile (fileOrIdentifier) == nullptr)
-        return false;
-
     ScopedLock lock (typesArrayLock);
 
-    for (auto& d : types)
-        if (d.fileOrIdentifier == fileOrIdentifier && formatToUse.pluginNeedsRescanning (d))
+    auto* typesInFile = typeIndex->getTypesForFile (fileOrIdentifier);
+
+    if (typesInFile == nullptr)
+        return false;
+
+    for (auto key : *typesInFile)
+        if (formatToUse.pluginNeedsRescanning (typeIndex->getType (key)))
             return false;
 
     return true;
@@ -158,10 +271,15 @@ bool KnownPluginList::scanAndAddFile (const String& fileOrIdentifier,
 
         ScopedLock lock (typesArrayLock);
 
-        for (auto& d : types)
+        if (auto* typesInFile = typeIndex->getTypesForFile (fileOrIdentifier))
         {
-            if (d.fileOrIdentifier == fileOrIdentifier && d.pluginFormatName == format.getName())
+            for (auto key : *typesInFile)
             {
+                auto& d = typeIndex->getType (key);
+
+                if (d.pluginFormatName != format.getName())
+                    continue;
+
                 if (format.pluginNeedsRescanning (d))
                     needsRescanning = true;
                 else
@@ -336,6 +454,7 @@ void KnownPluginList::sort (const SortMethod method, bool forwards)
 
             oldOrder.addArray (types);
             std::stable_sort (types.begin(), types.end(), PluginSorter (method, forwards));
+            typeIndex->rebuild();
             newOrder.addArray (types);
         }
 
@@ -390,6 +509,157 @@ void KnownPluginList::recreateFromXml (const XmlElement& xml)
     }
 }
 
+//==============================================================================
+// Identifies data written by writeToStream(), and the version of its layout.
+static constexpr int knownPluginListMagicNumber = 0x424c504b; // "KPLB"
+static constexpr int knownPluginListVersion = 1;
+
+void KnownPluginList::writeToStream (OutputStream& output) const
+{
+    auto typesToWrite = getTypes();
+
+    // Each distinct string gets written once, and the plugins refer to them by index
+    StringArray strings;
+    std::unordered_map<String, int> stringIndexes;
+    std::vector<int> stringIndexesForTypes;
+    stringIndexesForTypes.reserve ((size_t) typesToWrite.size() * 7);
+
+    for (auto& type : typesToWrite)
+    {
+        for (auto* str : { &type.name, &type.descriptiveName, &type.pluginFormatName, &type.category,
+                           &type.manufacturerName, &type.version, &type.fileOrIdentifier })
+        {
+            auto added = stringIndexes.emplace (*str, strings.size());
+
+            if (added.second)
+                strings.add (*str);
+
+            stringIndexesForTypes.push_back (added.first->second);
+        }
+    }
+
+    output.writeInt (knownPluginListMagicNumber);
+    output.writeInt (knownPluginListVersion);
+
+    output.writeCompressedInt (strings.size());
+
+    for (auto& str : strings)
+        output.writeString (str);
+
+    output.writeCompressedInt (typesToWrite.size());
+    auto nextStringIndex = stringIndexesForTypes.begin();
+
+    for (auto& type : typesToWrite)
+    {
+        for (int i = 0; i < 7; ++i)
+            output.writeCompressedInt (*nextStringIndex++);
+
+        output.writeInt (type.uid);
+        output.writeByte ((char) ((type.isInstrument ? 1 : 0) | (type.hasSharedContainer ? 2 : 0)));
+        output.writeCompressedInt (type.numInputChannels);
+        output.writeCompressedInt (type.numOutputChannels);
+        output.writeInt64 (type.lastFileModTime.toMilliseconds());
+        output.writeInt64 (type.lastInfoUpdateTime.toMilliseconds());
+    }
+
+    output.writeCompressedInt (blacklist.size());
+
+    for (auto& b : blacklist)
+        output.writeString (b);
+
+    // (marks the end, so that truncated data can be spotted)
+    output.writeInt (knownPluginListMagicNumber);
+}
+
+bool KnownPluginList::recreateFromStream (InputStream& input)
+{
+    if (input.readInt() != knownPluginListMagicNumber || input.readInt() > knownPluginListVersion)
+        return false;
+
+    auto isPlausibleCount = [&input] (int count)
+    {
+        auto bytesRemaining = input.getNumBytesRemaining();
+        return count >= 0 && (bytesRemaining < 0 || count <= bytesRemaining);
+    };
+
+    auto numStrings = input.readCompressedInt();
+
+    if (! isPlausibleCount (numStrings))
+        return false;
+
+    StringArray strings;
+    strings.ensureStorageAllocated (numStrings);
+
+    for (int i = 0; i < numStrings; ++i)
+        strings.add (input.readString());
+
+    auto numTypes = input.readCompressedInt();
+
+    if (! isPlausibleCount (numTypes))
+        return false;
+
+    bool ok = true;
+
+    auto readString = [&]
+    {
+        auto i = input.readCompressedInt();
+        ok = ok && isPositiveAndBelow (i, strings.size());
+        return strings[i];
+    };
+
+    Array<PluginDescription> newTypes;
+    newTypes.ensureStorageAllocated (numTypes);
+
+    for (int i = 0; i < numTypes; ++i)
+    {
+        PluginDescription type;
+        type.name               = readString();
+        type.descriptiveName    = readString();
+        type.pluginFormatName   = readString();
+        type.category           = readString();
+        type.manufacturerName   = readString();
+        type.version            = readString();
+        type.fileOrIdentifier   = readString();
+        type.uid                = input.readInt();
+
+        auto flags = input.readByte();
+        type.isInstrument       = (flags & 1) != 0;
+        type.hasSharedContainer = (flags & 2) != 0;
+
+        type.numInputChannels   = input.readCompressedInt();
+        type.numOutputChannels  = input.readCompressedInt();
+        type.lastFileModTime    = Time (input.readInt64());
+        type.lastInfoUpdateTime = Time (input.readInt64());
+
+        newTypes.add (type);
+    }
+
+    auto numBlacklisted = input.readCompressedInt();
+
+    if (! isPlausibleCount (numBlacklisted))
+        return false;
+
+    StringArray newBlacklist;
+
+    for (int i = 0; i < numBlacklisted; ++i)
+        newBlacklist.add (input.readString());
+
+    if (! ok || input.readInt() != knownPluginListMagicNumber)
+        return false;
+
+    {
+        ScopedLock lock (typesArrayLock);
+
+        types.swapWith (newTypes);
+        typeIndex->rebuild();
+
+        blacklist.swapWith (newBlacklist);
+    }
+
+    sendChangeMessage();
+    return true;
+}
+
 //==============================================================================
 struct PluginTreeUtils
 {
@@ -633,5 +903,155 @@ std::unique_ptr<KnownPluginList::PluginTree> KnownPluginList::createTree (const
     return createTree (getTypes(), sortMethod);
 }
 
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class KnownPluginListTests  : public UnitTest
+{
+public:
+    KnownPluginListTests()
+        : UnitTest ("Known plugin list", UnitTestCategories::audio)
+    {}
+
+    static PluginDescription createType (int fileIndex, int uid)
+    {
+        PluginDescription type;
+        type.name = "Plugin " + String (uid);
+        type.descriptiveName = type.name;
+        type.pluginFormatName = "VST3";
+        type.category = uid % 2 == 0 ? "Fx" : "Instrument";
+        type.manufacturerName = "Manufacturer " + String (fileIndex % 10);
+        type.version = "1.0";
+        type.fileOrIdentifier = "/plugins/file" + String (fileIndex) + ".vst3";
+        type.uid = uid;
+        type.isInstrument = uid % 2 != 0;
+        type.numOutputChannels = 2;
+        type.lastFileModTime = Time (1600000000000 + uid);
+        return type;
+    }
+
+    void runTest() override
+    {
+        const int numFiles = 500;
+        KnownPluginList list;
+
+        // every file holds two plugins, like a shell plugin
+        for (int i = 0; i < numFiles; ++i)
+        {
+            list.addType (createType (i, i * 2));
+            list.addType (createType (i, i * 2 + 1));
+        }
+
+        list.addToBlacklist ("/plugins/crashes.vst3");
+
+        beginTest ("Types can be found by file and identifier");
+        {
+            expectEquals (list.getNumTypes(), numFiles * 2);
+            expect (! list.addType (createType (7, 15)));
+            expectEquals (list.getNumTypes(), numFiles * 2);
+
+            int numFailures = 0;
+
+            for (int i = 0; i < numFiles; ++i)
+            {
+                auto type = createType (i, i * 2 + 1);
+                auto fromFile = list.getTypeForFile (type.fileOrIdentifier);
+                auto fromIdentifier = list.getTypeForIdentifierString (type.createIdentifierString());
+
+                if (fromFile == nullptr || fromFile->fileOrIdentifier != type.fileOrIdentifier
+                     || fromIdentifier == nullptr || ! fromIdentifier->isDuplicateOf (type))
+                    ++numFailures;
+            }
+
+            expectEquals (numFailures, 0);
+            expect (list.getTypeForFile ("/plugins/missing.vst3") == nullptr);
+            expect (list.getTypeForIdentifierString ("VST3-Missing-12345678-1") == nullptr);
+
+            list.removeType (createType (3, 6));
+            expect (list.getTypeForIdentifierString (createType (3, 6).createIdentifierString()) == nullptr);
+            expect (list.getTypeForFile (createType (3, 6).fileOrIdentifier) != nullptr);
+
+            list.removeType (createType (3, 7));
+            expect (list.getTypeForFile (createType (3, 6).fileOrIdentifier) == nullptr);
+        }
+
+        beginTest ("Types can still be found after the list has been sorted");
+        {
+            list.sort (KnownPluginList::sortByManufacturer, false);
+            auto sorted = list.getTypes();
+
+            int numFailures = 0;
+
+            for (auto& type : sorted)
+            {
+                auto fromIdentifier = list.getTypeForIdentifierString (type.createIdentifierString());
+
+                if (fromIdentifier == nullptr || ! fromIdentifier->isDuplicateOf (type))
+                    ++numFailures;
+            }
+
+            // the type for a file should be whichever of its types comes first in the list
+            for (auto& type : sorted)
+            {
+                auto fromFile = list.getTypeForFile (type.fileOrIdentifier);
+
+                for (auto& other : sorted)
+                {
+                    if (other.fileOrIdentifier == type.fileOrIdentifier)
+                    {
+                        if (fromFile == nullptr || ! fromFile->isDuplicateOf (other))
+                            ++numFailures;
+
+                        break;
+                    }
+                }
+            }
+
+            expectEquals (numFailures, 0);
+
+            list.removeType (sorted.getFirst());
+            expectEquals (list.getNumTypes(), sorted.size() - 1);
+            expect (list.getTypeForIdentifierString (sorted.getFirst().createIdentifierString()) == nullptr);
+            expect (list.getTypeForIdentifierString (sorted.getLast().createIdentifierString()) != nullptr);
+        }
+
+        beginTest ("The list can be written to a stream and read back");
+        {
+            MemoryOutputStream binary;
+            list.writeToStream (binary);
+
+            auto xml = list.createXml()->toString();
+            expect (binary.getDataSize() * 4 < xml.getNumBytesAsUTF8());
+
+            KnownPluginList restored;
+            MemoryInputStream input (binary.getData(), binary.getDataSize(), false);
+            expect (restored.recreateFromStream (input));
+
+            auto original = list.getTypes();
+            auto copy = restored.getTypes();
+            expectEquals (copy.size(), original.size());
+
+            int numMismatches = 0;
+
+            for (int i = 0; i < jmin (original.size(), copy.size()); ++i)
+                if (! original[i].createXml()->isEquivalentTo (copy[i].createXml().get(), false))
+                    ++numMismatches;
+
+            expectEquals (numMismatches, 0);
+            expect (restored.getBlacklistedFiles() == list.getBlacklistedFiles());
+            expect (restored.getTypeForIdentifierString (createType (9, 18).createIdentifierString()) != nullptr);
+
+            MemoryInputStream truncated (binary.getData(), binary.getDataSize() - 10, false);
+            expect (! restored.recreateFromStream (truncated));
+            expectEquals (restored.getNumTypes(), original.size());
+        }
+    }
+};
+
+static KnownPluginListTests knownPluginListTests;
+
+#endif
+
 
 } // namespace juce
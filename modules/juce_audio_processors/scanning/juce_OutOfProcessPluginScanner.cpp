@@ -0,0 +1,571 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   By using JUCE, you agree to the terms of both the JUCE 6 End-User License
+   Agreement and JUCE Privacy Policy (both effective as of the 16th June 2020).
+
+   End User License Agreement: www.juce.com/juce-6-licence
+   Privacy Policy: www.juce.com/juce-privacy-policy
+
+   Or: You may also use this code under the terms of the GPL v3 (see
+   www.gnu.org/licenses).
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+static const char* const pluginScanWorkerCommandLineUID = "pluginScanWorker";
+
+static MemoryBlock createMessageFromXml (const XmlElement& xml)
+{
+    auto text = xml.toString (XmlElement::TextFormat().singleLine());
+    return { text.toRawUTF8(), text.getNumBytesAsUTF8() };
+}
+
+//==============================================================================
+static MemoryBlock createScanReply (const XmlElement& request, AudioPluginFormatManager& formatManager)
+{
+    XmlElement reply ("RESULT");
+    auto formatName = request.getStringAttribute ("format");
+
+    for (auto* format : formatManager.getFormats())
+    {
+        if (format->getName() == formatName)
+        {
+            OwnedArray<PluginDescription> found;
+            format->findAllTypesForFile (found, request.getStringAttribute ("file"));
+
+            for (auto* desc : found)
+                reply.addChildElement (desc->createXml().release());
+
+            break;
+        }
+    }
+
+    return createMessageFromXml (reply);
+}
+
+//==============================================================================
+/*  Sends scan requests to a worker and waits for its replies. The process itself is
+    managed by a subclass.
+*/
+struct OutOfProcessPluginScanner::WorkerProcess
+{
+    WorkerProcess() = default;
+    virtual ~WorkerProcess() = default;
+
+    enum class Result
+    {
+        succeeded,
+        crashed,
+        abandoned,
+        couldNotLaunch
+    };
+
+    Result scan (AudioPluginFormat& format, const String& fileOrIdentifier,
+                 OwnedArray<PluginDescription>& results, int timeoutMs,
+                 const KnownPluginList::CustomScanner& owner)
+    {
+        XmlElement request ("SCAN");
+        request.setAttribute ("format", format.getName());
+        request.setAttribute ("file", fileOrIdentifier);
+
+        {
+            const ScopedLock sl (replyLock);
+            reply.reset();
+            connectionLost = false;
+        }
+
+        replyReceived.reset();
+
+        // if the process has died while it was idle, it gets one chance to restart
+        if (! (isRunning && sendRequest (createMessageFromXml (request))))
+        {
+            stop();
+
+            isRunning = launch();
+
+            if (! isRunning)
+                return Result::couldNotLaunch;
+
+            if (! sendRequest (createMessageFromXml (request)))
+            {
+                stop();
+                return Result::crashed;
+            }
+        }
+
+        // wait in short slices, so that the scan can be abandoned
+        for (int elapsed = 0; ! replyReceived.wait (100); elapsed += 100)
+        {
+            if (owner.shouldExit())
+            {
+                stop();
+                return Result::abandoned;
+            }
+
+            if (elapsed >= timeoutMs)
+            {
+                stop();
+                return Result::crashed;
+            }
+        }
+
+        const ScopedLock sl (replyLock);
+
+        if (connectionLost || reply == nullptr)
+        {
+            isRunning = false;
+            return Result::crashed;
+        }
+
+        forEachXmlChildElement (*reply, e)
+        {
+            auto desc = std::make_unique<PluginDescription>();
+
+            if (desc->loadFromXml (*e))
+                results.add (desc.release());
+        }
+
+        return Result::succeeded;
+    }
+
+    void stop()
+    {
+        kill();
+        isRunning = false;
+    }
+
+protected:
+    /** Starts the process, returning false if it couldn't be launched. */
+    virtual bool launch() = 0;
+    /** Sends a request to the process, returning false if it couldn't be sent. */
+    virtual bool sendRequest (const MemoryBlock&) = 0;
+    /** Stops the process, if it's running. */
+    virtual void kill() = 0;
+
+    void handleReply (const MemoryBlock& message)
+    {
+        const ScopedLock sl (replyLock);
+        reply = parseXML (message.toString());
+        replyReceived.signal();
+    }
+
+    void handleProcessLost()
+    {
+        const ScopedLock sl (replyLock);
+        connectionLost = true;
+        replyReceived.signal();
+    }
+
+private:
+    bool isRunning = false;
+
+    CriticalSection replyLock;
+    std::unique_ptr<XmlElement> reply;
+    bool connectionLost = false;
+    WaitableEvent replyReceived;
+
+    JUCE_DECLARE_NON_COPYABLE (WorkerProcess)
+};
+
+//==============================================================================
+struct OutOfProcessPluginScanner::ChildWorkerProcess  : public WorkerProcess,
+                                                        private ChildProcessMaster
+{
+    explicit ChildWorkerProcess (const File& executableToUse)  : executable (executableToUse) {}
+
+    ~ChildWorkerProcess() override
+    {
+        stop();
+    }
+
+private:
+    bool launch() override
+    {
+        return executable.existsAsFile()
+                && launchSlaveProcess (executable, pluginScanWorkerCommandLineUID, 0, 0);
+    }
+
+    bool sendRequest (const MemoryBlock& message) override      { return sendMessageToSlave (message); }
+    void kill() override                                        { killSlaveProcess(); }
+
+    void handleMessageFromSlave (const MemoryBlock& message) override   { handleReply (message); }
+    void handleConnectionLost() override                                { handleProcessLost(); }
+
+    const File executable;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChildWorkerProcess)
+};
+
+//==============================================================================
+OutOfProcessPluginScanner::OutOfProcessPluginScanner (const File& executable, int numWorkers, const File& cacheFile)
+    : workerExecutable (executable),
+      maxNumWorkers (jmax (1, numWorkers)),
+      cache (cacheFile),
+      createWorkerProcess ([this] { return new ChildWorkerProcess (workerExecutable); })
+{
+}
+
+OutOfProcessPluginScanner::~OutOfProcessPluginScanner()
+{
+    workers.clear();
+}
+
+void OutOfProcessPluginScanner::setScanTimeout (int milliseconds) noexcept
+{
+    scanTimeoutMs = milliseconds;
+}
+
+bool OutOfProcessPluginScanner::findPluginTypesFor (AudioPluginFormat& format,
+                                                    OwnedArray<PluginDescription>& result,
+                                                    const String& fileOrIdentifier)
+{
+    if (cache.getTypesFor (format, fileOrIdentifier, result))
+        return true;
+
+    auto* worker = getIdleWorker();
+
+    // (the scan is being abandoned)
+    if (worker == nullptr)
+        return true;
+
+    auto outcome = worker->scan (format, fileOrIdentifier, result, scanTimeoutMs, *this);
+    returnWorker (worker);
+
+    switch (outcome)
+    {
+        case WorkerProcess::Result::succeeded:
+            cache.setTypesFor (format, fileOrIdentifier, result);
+            return true;
+
+        case WorkerProcess::Result::crashed:
+            return false;
+
+        case WorkerProcess::Result::abandoned:
+            return true;
+
+        case WorkerProcess::Result::couldNotLaunch:
+        default:
+            break;
+    }
+
+    // Without any worker processes, the best we can do is to scan the file here
+    format.findAllTypesForFile (result, fileOrIdentifier);
+    cache.setTypesFor (format, fileOrIdentifier, result);
+    return true;
+}
+
+void OutOfProcessPluginScanner::scanFinished()
+{
+    cache.save();
+
+    const ScopedLock sl (workerLock);
+
+    for (auto* worker : idleWorkers)
+        worker->stop();
+}
+
+OutOfProcessPluginScanner::WorkerProcess* OutOfProcessPluginScanner::getIdleWorker()
+{
+    for (;;)
+    {
+        {
+            const ScopedLock sl (workerLock);
+
+            if (! idleWorkers.isEmpty())
+                return idleWorkers.removeAndReturn (idleWorkers.size() - 1);
+
+            if (workers.size() < maxNumWorkers)
+                return workers.add (createWorkerProcess());
+        }
+
+        if (shouldExit())
+            return nullptr;
+
+        workerReturned.wait (100);
+    }
+}
+
+void OutOfProcessPluginScanner::returnWorker (WorkerProcess* worker)
+{
+    {
+        const ScopedLock sl (workerLock);
+        idleWorkers.add (worker);
+    }
+
+    workerReturned.signal();
+}
+
+//==============================================================================
+OutOfProcessPluginScanner::Worker::Worker()
+{
+    formatManager.addDefaultFormats();
+}
+
+OutOfProcessPluginScanner::Worker::~Worker()
+{
+    cancelPendingUpdate();
+}
+
+bool OutOfProcessPluginScanner::Worker::initialiseFromCommandLine (const String& commandLine)
+{
+    return ChildProcessSlave::initialiseFromCommandLine (commandLine, pluginScanWorkerCommandLineUID);
+}
+
+void OutOfProcessPluginScanner::Worker::handleMessageFromMaster (const MemoryBlock& message)
+{
+    // Plugins are scanned on the message thread, as many formats expect that
+    {
+        const ScopedLock sl (requestLock);
+        pendingRequests.add (message.toString());
+    }
+
+    triggerAsyncUpdate();
+}
+
+void OutOfProcessPluginScanner::Worker::handleConnectionLost()
+{
+    JUCEApplicationBase::quit();
+}
+
+void OutOfProcessPluginScanner::Worker::handleAsyncUpdate()
+{
+    for (;;)
+    {
+        String requestText;
+
+        {
+            const ScopedLock sl (requestLock);
+
+            if (pendingRequests.isEmpty())
+                return;
+
+            requestText = pendingRequests[0];
+            pendingRequests.remove (0);
+        }
+
+        auto request = parseXML (requestText);
+
+        if (request != nullptr && request->hasTagName ("SCAN"))
+            sendMessageToMaster (createScanReply (*request, formatManager));
+    }
+}
+
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class OutOfProcessPluginScannerTests  : public UnitTest
+{
+public:
+    OutOfProcessPluginScannerTests()
+        : UnitTest ("Out-of-process plugin scanner", UnitTestCategories::audio)
+    {}
+
+    struct CountingFormat  : public AudioPluginFormat
+    {
+        String getName() const override                                     { return "Counting"; }
+        bool canScanForPlugins() const override                             { return true; }
+        bool isTrivialToScan() const override                               { return false; }
+        bool fileMightContainThisPluginType (const String&) override        { return true; }
+        String getNameOfPluginFromIdentifier (const String& f) override     { return f; }
+        bool pluginNeedsRescanning (const PluginDescription&) override      { return false; }
+        bool doesPluginStillExist (const PluginDescription&) override       { return true; }
+        FileSearchPath getDefaultLocationsToSearch() override               { return {}; }
+        bool requiresUnblockedMessageThreadDuringCreation (const PluginDescription&) const override  { return false; }
+
+        StringArray searchPathsForPlugins (const FileSearchPath&, bool, bool) override  { return {}; }
+
+        void findAllTypesForFile (OwnedArray<PluginDescription>& results, const String& file) override
+        {
+            ++numScans;
+
+            if (File (file).getFileExtension() == ".plugin")
+            {
+                auto* desc = results.add (new PluginDescription());
+                desc->name = File (file).getFileNameWithoutExtension();
+                desc->pluginFormatName = getName();
+                desc->fileOrIdentifier = file;
+            }
+        }
+
+        void createPluginInstance (const PluginDescription&, double, int, PluginCreationCallback callback) override
+        {
+            callback (nullptr, "Not supported");
+        }
+
+        int numScans = 0;
+    };
+
+    struct ScopedTestDirectory
+    {
+        ~ScopedTestDirectory()  { directory.deleteRecursively(); }
+
+        const File directory { File::getSpecialLocation (File::tempDirectory).getNonexistentChildFile ("PluginScannerTest", {}) };
+    };
+
+    void runTest() override
+    {
+        ScopedTestDirectory tempDirectory;
+        auto directory = tempDirectory.directory;
+        directory.createDirectory();
+
+        auto pluginFile = directory.getChildFile ("Reverb.plugin");
+        auto otherFile = directory.getChildFile ("readme.txt");
+        pluginFile.replaceWithText ("plugin");
+        otherFile.replaceWithText ("text");
+
+        auto cacheFile = directory.getChildFile ("scancache.xml");
+        CountingFormat format;
+
+        beginTest ("Unchanged files are only scanned once");
+        {
+            KnownPluginList list;
+            list.setCustomScanner (std::make_unique<OutOfProcessPluginScanner> (directory.getChildFile ("nonexistent"), 2, cacheFile));
+
+            OwnedArray<PluginDescription> found;
+            expect (list.scanAndAddFile (pluginFile.getFullPathName(), false, found, format));
+            expect (! list.scanAndAddFile (otherFile.getFullPathName(), false, found, format));
+            expectEquals (format.numScans, 2);
+
+            list.clear();
+            found.clear();
+            expect (list.scanAndAddFile (pluginFile.getFullPathName(), false, found, format));
+            expect (! list.scanAndAddFile (otherFile.getFullPathName(), false, found, format));
+            expectEquals (format.numScans, 2);
+            expectEquals (list.getNumTypes(), 1);
+            expectEquals (found.size(), 1);
+            expectEquals (found[0]->name, String ("Reverb"));
+
+            list.scanFinished();
+        }
+
+        beginTest ("The cache is kept between sessions, and notices changed files");
+        {
+            PluginScanCache cache (cacheFile);
+            expectEquals (cache.getNumEntries(), 2);
+
+            OwnedArray<PluginDescription> found;
+            expect (cache.getTypesFor (format, pluginFile.getFullPathName(), found));
+            expectEquals (found.size(), 1);
+
+            pluginFile.replaceWithText ("a newer version of the plugin");
+            expect (! cache.getTypesFor (format, pluginFile.getFullPathName(), found));
+            expect (cache.getTypesFor (format, otherFile.getFullPathName(), found));
+            expect (! cache.getTypesFor (format, "NotAFile", found));
+        }
+
+        beginTest ("Workers that crash or hang get their files blacklisted, and are restarted");
+        {
+            std::atomic<StubWorker::Behaviour> behaviour { StubWorker::Behaviour::reply };
+            std::atomic<int> numLaunches { 0 };
+
+            auto scanner = std::make_unique<OutOfProcessPluginScanner> (File(), 1);
+            scanner->setScanTimeout (200);
+            scanner->createWorkerProcess = [&] { return new StubWorker (behaviour, numLaunches); };
+
+            KnownPluginList list;
+            list.setCustomScanner (std::move (scanner));
+
+            auto scan = [&] (const String& fileName, StubWorker::Behaviour newBehaviour)
+            {
+                auto file = directory.getChildFile (fileName);
+                file.replaceWithText (fileName);
+                behaviour = newBehaviour;
+
+                OwnedArray<PluginDescription> found;
+                list.scanAndAddFile (file.getFullPathName(), false, found, format);
+                return list.getBlacklistedFiles().contains (file.getFullPathName());
+            };
+
+            auto numInProcessScans = format.numScans;
+
+            expect (! scan ("First.plugin", StubWorker::Behaviour::reply));
+            expect (! scan ("Second.plugin", StubWorker::Behaviour::reply));
+            expectEquals (list.getNumTypes(), 2);
+            expectEquals (numLaunches.load(), 1);
+
+            expect (scan ("Crashing.plugin", StubWorker::Behaviour::crash));
+            expect (scan ("Hanging.plugin", StubWorker::Behaviour::hang));
+            expectEquals (numLaunches.load(), 2);
+
+            expect (! scan ("Third.plugin", StubWorker::Behaviour::reply));
+            expectEquals (numLaunches.load(), 3);
+            expectEquals (list.getNumTypes(), 3);
+            expectEquals (format.numScans, numInProcessScans);
+
+            // if the worker has died and can't be restarted, the file is scanned in-process
+            expect (! scan ("Unlaunchable.plugin", StubWorker::Behaviour::failToLaunch));
+            expectEquals (numLaunches.load(), 4);
+            expectEquals (format.numScans, numInProcessScans + 1);
+            expectEquals (list.getNumTypes(), 4);
+        }
+    }
+
+private:
+    /*  Stands in for a worker process. Its replies are made with the same code that a real
+        worker uses, with a format manager that holds a CountingFormat.
+    */
+    struct StubWorker  : public OutOfProcessPluginScanner::WorkerProcess
+    {
+        enum class Behaviour { reply, crash, hang, failToLaunch };
+
+        StubWorker (std::atomic<Behaviour>& b, std::atomic<int>& launchCounter)
+            : behaviour (b), numLaunches (launchCounter)
+        {
+            formatManager.addFormat (new CountingFormat());
+        }
+
+        ~StubWorker() override
+        {
+            stop();
+        }
+
+        bool launch() override
+        {
+            ++numLaunches;
+            return behaviour != Behaviour::failToLaunch;
+        }
+
+        bool sendRequest (const MemoryBlock& message) override
+        {
+            if (behaviour == Behaviour::reply)
+            {
+                if (auto request = parseXML (message.toString()))
+                    handleReply (createScanReply (*request, formatManager));
+            }
+            else if (behaviour == Behaviour::crash)
+            {
+                handleProcessLost();
+            }
+
+            // (a worker that can't be launched has also stopped responding)
+            return behaviour != Behaviour::failToLaunch;
+        }
+
+        void kill() override {}
+
+        std::atomic<Behaviour>& behaviour;
+        std::atomic<int>& numLaunches;
+        AudioPluginFormatManager formatManager;
+    };
+};
+
+static OutOfProcessPluginScannerTests outOfProcessPluginScannerTests;
+
+#endif
+
+} // namespace juce
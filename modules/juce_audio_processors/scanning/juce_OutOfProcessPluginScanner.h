@@ -0,0 +1,173 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   By using JUCE, you agree to the terms of both the JUCE 6 End-User License
+   Agreement and JUCE Privacy Policy (both effective as of the 16th June 2020).
+
+   End User License Agreement: www.juce.com/juce-6-licence
+   Privacy Policy: www.juce.com/juce-privacy-policy
+
+   Or: You may also use this code under the terms of the GPL v3 (see
+   www.gnu.org/licenses).
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+//==============================================================================
+/**
+    A KnownPluginList::CustomScanner that loads plugins in separate worker processes,
+    so that a plugin which crashes or hangs while being scanned can't take the host
+    down with it.
+
+    The scanner keeps a pool of worker processes, each of which scans one file at a
+    time, so when it's used from several threads at once (e.g. by calling
+    PluginListComponent::setNumberOfThreadsForScanning() with the same number of
+    threads as workers), files are scanned in parallel. A file whose worker crashes
+    or stops responding is reported as having failed, which blacklists it, and the
+    worker is restarted for the next file.
+
+    Results are kept in a PluginScanCache, so a file that hasn't changed since it was
+    last scanned is never loaded again.
+
+    The workers are launched by running an executable with a special command-line.
+    Usually this is the host itself: at startup, the host should create an
+    OutOfProcessPluginScanner::Worker and call its initialiseFromCommandLine() method.
+    If that returns true, the process is a worker and should do nothing else except run
+    its message loop until the worker quits the app.
+
+    @code
+    void initialise (const String& commandLine) override
+    {
+        auto worker = std::make_unique<OutOfProcessPluginScanner::Worker>();
+
+        if (worker->initialiseFromCommandLine (commandLine))
+        {
+            scannerWorker = std::move (worker);
+            return;
+        }
+
+        // ...normal startup...
+        knownPluginList.setCustomScanner (std::make_unique<OutOfProcessPluginScanner> (File::getSpecialLocation (File::currentExecutableFile),
+                                                                                        4, cacheFile));
+    }
+    @endcode
+
+    If the worker processes can't be launched, files are scanned in-process instead.
+
+    @see KnownPluginList::setCustomScanner, PluginScanCache
+
+    @tags{Audio}
+*/
+class JUCE_API  OutOfProcessPluginScanner  : public KnownPluginList::CustomScanner
+{
+public:
+    //==============================================================================
+    /** Creates a scanner.
+
+        @param workerExecutable     the executable to launch for each worker process. This
+                                    must create a Worker when it starts, as shown above
+        @param maxNumWorkers        the maximum number of processes to run at once
+        @param cacheFile            where the results of previous scans are kept. If this is
+                                    File(), results are only cached for the lifetime of the
+                                    scanner
+    */
+    OutOfProcessPluginScanner (const File& workerExecutable, int maxNumWorkers,
+                               const File& cacheFile = {});
+
+    /** Destructor. */
+    ~OutOfProcessPluginScanner() override;
+
+    //==============================================================================
+    /** Sets how long a worker may spend scanning a file before it's assumed to have hung.
+        The default is 60 seconds.
+    */
+    void setScanTimeout (int milliseconds) noexcept;
+
+    /** Returns the maximum number of worker processes. */
+    int getMaxNumWorkers() const noexcept               { return maxNumWorkers; }
+
+    /** Returns the cache that holds the results of previous scans. */
+    PluginScanCache& getCache() noexcept                { return cache; }
+
+    //==============================================================================
+    /** @internal */
+    bool findPluginTypesFor (AudioPluginFormat&, OwnedArray<PluginDescription>&, const String&) override;
+    /** Saves the cache and shuts down the worker processes. */
+    void scanFinished() override;
+
+    //==============================================================================
+    /**
+        The part of the scanner that runs in each worker process.
+
+        The worker finds plugins using the formats in its AudioPluginFormatManager, which
+        are the default formats unless you change them. It scans files on the message
+        thread, and quits the app when the scanner disconnects from it.
+    */
+    class JUCE_API  Worker  : private ChildProcessSlave,
+                              private AsyncUpdater
+    {
+    public:
+        /** Creates a worker, with the default set of plugin formats. */
+        Worker();
+
+        /** Destructor. */
+        ~Worker() override;
+
+        /** Checks the command-line for the arguments used to launch a worker, and if they're
+            present, connects to the scanner that launched this process.
+            Returns true if this process is a worker.
+        */
+        bool initialiseFromCommandLine (const String& commandLine);
+
+        /** Returns the formats that the worker will look for. */
+        AudioPluginFormatManager& getFormatManager() noexcept   { return formatManager; }
+
+    private:
+        void handleMessageFromMaster (const MemoryBlock&) override;
+        void handleConnectionLost() override;
+        void handleAsyncUpdate() override;
+
+        AudioPluginFormatManager formatManager;
+        CriticalSection requestLock;
+        StringArray pendingRequests;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Worker)
+    };
+
+private:
+    //==============================================================================
+    struct WorkerProcess;
+    struct ChildWorkerProcess;
+    friend class OutOfProcessPluginScannerTests;
+
+    WorkerProcess* getIdleWorker();
+    void returnWorker (WorkerProcess*);
+
+    const File workerExecutable;
+    const int maxNumWorkers;
+    PluginScanCache cache;
+    std::atomic<int> scanTimeoutMs { 60000 };
+    std::function<WorkerProcess*()> createWorkerProcess;
+
+    OwnedArray<WorkerProcess> workers;
+    Array<WorkerProcess*> idleWorkers;
+    CriticalSection workerLock;
+    WaitableEvent workerReturned;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OutOfProcessPluginScanner)
+};
+
+} // namespace juce
@@ -0,0 +1,222 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   By using JUCE, you agree to the terms of both the JUCE 6 End-User License
+   Agreement and JUCE Privacy Policy (both effective as of the 16th June 2020).
+
+   End User License Agreement: www.juce.com/juce-6-licence
+   Privacy Policy: www.juce.com/juce-privacy-policy
+
+   Or: You may also use this code under the terms of the GPL v3 (see
+   www.gnu.org/licenses).
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+PluginScanCache::PluginScanCache (const File& file)  : cacheFile (file)
+{
+    if (cacheFile.existsAsFile())
+        if (auto xml = parseXML (cacheFile))
+            restoreFromXml (*xml);
+}
+
+PluginScanCache::~PluginScanCache()
+{
+    save();
+}
+
+//==============================================================================
+bool PluginScanCache::getFileDetails (const String& fileOrIdentifier, int64& modificationTime, int64& size)
+{
+    if (! File::isAbsolutePath (fileOrIdentifier))
+        return false;
+
+    File file (fileOrIdentifier);
+
+    if (file.existsAsFile())
+    {
+        modificationTime = file.getLastModificationTime().toMilliseconds();
+        size = file.getSize();
+        return true;
+    }
+
+    if (file.isDirectory())
+    {
+        // Bundles can change without their directory being touched, so use
+        // the newest and total size of everything inside them
+        modificationTime = file.getLastModificationTime().toMilliseconds();
+        size = 0;
+
+        for (const auto& entry : RangedDirectoryIterator (file, true, "*", File::findFiles))
+        {
+            modificationTime = jmax (modificationTime, entry.getModificationTime().toMilliseconds());
+            size += entry.getFileSize();
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+String PluginScanCache::createKey (const String& formatName, const String& fileOrIdentifier)
+{
+    return formatName + "|" + fileOrIdentifier;
+}
+
+//==============================================================================
+bool PluginScanCache::getTypesFor (AudioPluginFormat& format, const String& fileOrIdentifier,
+                                   OwnedArray<PluginDescription>& results) const
+{
+    int64 modificationTime, size;
+
+    if (! getFileDetails (fileOrIdentifier, modificationTime, size))
+        return false;
+
+    const ScopedLock sl (lock);
+    auto entry = entries.find (createKey (format.getName(), fileOrIdentifier));
+
+    if (entry == entries.end()
+         || entry->second.modificationTime != modificationTime
+         || entry->second.size != size)
+        return false;
+
+    for (auto& type : entry->second.types)
+        results.add (new PluginDescription (type));
+
+    return true;
+}
+
+void PluginScanCache::setTypesFor (AudioPluginFormat& format, const String& fileOrIdentifier,
+                                   const OwnedArray<PluginDescription>& types)
+{
+    Entry entry;
+
+    if (! getFileDetails (fileOrIdentifier, entry.modificationTime, entry.size))
+        return;
+
+    for (auto* type : types)
+        entry.types.add (*type);
+
+    const ScopedLock sl (lock);
+    entries[createKey (format.getName(), fileOrIdentifier)] = std::move (entry);
+    needsSaving = true;
+}
+
+void PluginScanCache::removeTypesFor (AudioPluginFormat& format, const String& fileOrIdentifier)
+{
+    const ScopedLock sl (lock);
+
+    if (entries.erase (createKey (format.getName(), fileOrIdentifier)) > 0)
+        needsSaving = true;
+}
+
+void PluginScanCache::clear()
+{
+    const ScopedLock sl (lock);
+
+    if (! entries.empty())
+    {
+        entries.clear();
+        needsSaving = true;
+    }
+}
+
+int PluginScanCache::getNumEntries() const
+{
+    const ScopedLock sl (lock);
+    return (int) entries.size();
+}
+
+//==============================================================================
+bool PluginScanCache::save()
+{
+    if (cacheFile == File())
+        return true;
+
+    std::unique_ptr<XmlElement> xml;
+
+    {
+        const ScopedLock sl (lock);
+
+        if (! needsSaving)
+            return true;
+
+        xml = createXml();
+        needsSaving = false;
+    }
+
+    TemporaryFile temp (cacheFile);
+
+    if (xml->writeTo (temp.getFile()) && temp.overwriteTargetFileWithTemporary())
+        return true;
+
+    const ScopedLock sl (lock);
+    needsSaving = true;
+    return false;
+}
+
+std::unique_ptr<XmlElement> PluginScanCache::createXml() const
+{
+    auto xml = std::make_unique<XmlElement> ("PLUGINSCANCACHE");
+    xml->setAttribute ("version", 1);
+
+    const ScopedLock sl (lock);
+
+    for (auto& entry : entries)
+    {
+        auto* e = xml->createNewChildElement ("FILE");
+        e->setAttribute ("format", entry.first.upToFirstOccurrenceOf ("|", false, false));
+        e->setAttribute ("file", entry.first.fromFirstOccurrenceOf ("|", false, false));
+        e->setAttribute ("modified", String (entry.second.modificationTime));
+        e->setAttribute ("size", String (entry.second.size));
+
+        for (auto& type : entry.second.types)
+            e->addChildElement (type.createXml().release());
+    }
+
+    return xml;
+}
+
+void PluginScanCache::restoreFromXml (const XmlElement& xml)
+{
+    const ScopedLock sl (lock);
+    entries.clear();
+
+    if (xml.hasTagName ("PLUGINSCANCACHE") && xml.getIntAttribute ("version") == 1)
+    {
+        forEachXmlChildElementWithTagName (xml, e, "FILE")
+        {
+            Entry entry;
+            entry.modificationTime = e->getStringAttribute ("modified").getLargeIntValue();
+            entry.size = e->getStringAttribute ("size").getLargeIntValue();
+
+            forEachXmlChildElement (*e, child)
+            {
+                PluginDescription type;
+
+                if (type.loadFromXml (*child))
+                    entry.types.add (type);
+            }
+
+            entries[createKey (e->getStringAttribute ("format"), e->getStringAttribute ("file"))] = std::move (entry);
+        }
+    }
+
+    needsSaving = false;
+}
+
+} // namespace juce
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   JUCE is an open source library subject to commercial or open-source
+   licensing.
+
+   By using JUCE, you agree to the terms of both the JUCE 6 End-User License
+   Agreement and JUCE Privacy Policy (both effective as of the 16th June 2020).
+
+   End User License Agreement: www.juce.com/juce-6-licence
+   Privacy Policy: www.juce.com/juce-privacy-policy
+
+   Or: You may also use this code under the terms of the GPL v3 (see
+   www.gnu.org/licenses).
+
+   JUCE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+   EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+   DISCLAIMED.
+
+  ==============================================================================
+*/
+
+namespace juce
+{
+
+//==============================================================================
+/**
+    A persistent record of the plugin types that were found in each plugin file.
+
+    Entries are keyed on the format, the file's path, its modification time and its
+    size, so once a file has been scanned it never needs to be loaded again until it
+    changes. Files that turned out not to contain any plugins are remembered too.
+
+    Only files are cached - identifiers that don't refer to a file, such as those
+    used by AudioUnits, are always reported as missing from the cache.
+
+    All the methods are thread-safe.
+
+    @see OutOfProcessPluginScanner
+
+    @tags{Audio}
+*/
+class JUCE_API  PluginScanCache
+{
+public:
+    //==============================================================================
+    /** Creates a cache, loading any entries that were previously saved to the given file.
+        If the file is File(), the cache will only be held in memory.
+    */
+    explicit PluginScanCache (const File& cacheFile = {});
+
+    /** Destructor. This will save any new entries to the cache file. */
+    ~PluginScanCache();
+
+    //==============================================================================
+    /** Looks for a cached set of types for a plugin file.
+
+        If the file has a valid entry, this adds the types to the results array (which
+        may mean adding nothing, if it was found to have no plugins in it) and returns
+        true. If the file isn't in the cache, or it has changed since its entry was
+        added, this returns false.
+    */
+    bool getTypesFor (AudioPluginFormat& format, const String& fileOrIdentifier,
+                      OwnedArray<PluginDescription>& results) const;
+
+    /** Stores the types that were found when a plugin file was scanned. */
+    void setTypesFor (AudioPluginFormat& format, const String& fileOrIdentifier,
+                      const OwnedArray<PluginDescription>& types);
+
+    /** Removes any entry for the given file. */
+    void removeTypesFor (AudioPluginFormat& format, const String& fileOrIdentifier);
+
+    /** Removes all the entries. */
+    void clear();
+
+    /** Returns the number of files that have entries in the cache. */
+    int getNumEntries() const;
+
+    //==============================================================================
+    /** Writes the cache to its file, if anything has changed since it was loaded.
+        Returns false if the file couldn't be written.
+    */
+    bool save();
+
+    /** Creates some XML that can be used to store the contents of the cache. */
+    std::unique_ptr<XmlElement> createXml() const;
+
+    /** Replaces the contents of the cache with entries stored by createXml(). */
+    void restoreFromXml (const XmlElement&);
+
+private:
+    //==============================================================================
+    struct Entry
+    {
+        int64 modificationTime = 0, size = 0;
+        Array<PluginDescription> types;
+    };
+
+    static bool getFileDetails (const String& fileOrIdentifier, int64& modificationTime, int64& size);
+    static String createKey (const String& formatName, const String& fileOrIdentifier);
+
+    File cacheFile;
+    std::map<String, Entry> entries;
+    CriticalSection lock;
+    bool needsSaving = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginScanCache)
+};
+
+} // namespace juce
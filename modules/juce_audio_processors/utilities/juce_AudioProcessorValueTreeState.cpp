@@ -82,15 +82,19 @@ private:
     using Listener = AudioProcessorValueTreeState::Listener;
 
 public:
-    explicit ParameterAdapter (RangedAudioParameter& parameterIn)
+    explicit ParameterAdapter (RangedAudioParameter& parameterIn,
+                               std::atomic<ParameterAdapter*>* dirtyListToUse = nullptr)
         : parameter (parameterIn),
           // For legacy reasons, the unnormalised value should *not* be snapped on construction
-          unnormalisedValue (getRange().convertFrom0to1 (parameter.getDefaultValue()))
+          unnormalisedValue (getRange().convertFrom0to1 (parameter.getDefaultValue())),
+          dirtyList (dirtyListToUse)
     {
         parameter.addListener (this);
 
         if (auto* ptr = dynamic_cast<Parameter*> (&parameter))
             ptr->onValueChanged = [this] { parameterValueChanged ({}, {}); };
+
+        markNeedsUpdate();
     }
 
     ~ParameterAdapter() override        { parameter.removeListener (this); }
@@ -149,8 +153,29 @@ public:
         return true;
     }
 
+    /*  Flags this adapter as needing its value copying to the tree, and if it wasn't
+        already flagged, pushes it onto the owner's list of changed parameters. This
+        can be called on any thread, and doesn't lock or allocate.
+    */
+    void markNeedsUpdate() noexcept
+    {
+        if (needsUpdate.exchange (true) || dirtyList == nullptr)
+            return;
+
+        auto* head = dirtyList->load();
+
+        do
+        {
+            nextDirty = head;
+        }
+        while (! dirtyList->compare_exchange_weak (head, this));
+    }
+
     ValueTree tree;
 
+    // the next adapter in the owner's list of changed parameters
+    ParameterAdapter* nextDirty = nullptr;
+
 private:
     void parameterGestureChanged (int, bool) override {}
 
@@ -164,7 +189,7 @@ private:
         unnormalisedValue = newValue;
         listeners.call ([=] (Listener& l) { l.parameterChanged (parameter.paramID, unnormalisedValue); });
         listenersNeedCalling = false;
-        needsUpdate = true;
+        markNeedsUpdate();
     }
 
     float denormalise (float normalised) const
@@ -215,7 +240,8 @@ private:
     RangedAudioParameter& parameter;
     LockedListeners listeners;
     std::atomic<float> unnormalisedValue { 0.0f };
-    std::atomic<bool> needsUpdate { true }, listenersNeedCalling { true };
+    std::atomic<bool> needsUpdate { false }, listenersNeedCalling { true };
+    std::atomic<ParameterAdapter*>* dirtyList;
     bool ignoreParameterChangedCallbacks { false };
 };
 
@@ -338,7 +364,7 @@ RangedAudioParameter* AudioProcessorValueTreeState::createAndAddParameter (std::
 //==============================================================================
 void AudioProcessorValueTreeState::addParameterAdapter (RangedAudioParameter& param)
 {
-    adapterTable.emplace (param.paramID, std::make_unique<ParameterAdapter> (param));
+    adapterTable.emplace (param.paramID, std::make_unique<ParameterAdapter> (param, &dirtyAdapters));
 }
 
 AudioProcessorValueTreeState::ParameterAdapter* AudioProcessorValueTreeState::getParameterAdapter (StringRef paramID) const
@@ -409,6 +435,190 @@ void AudioProcessorValueTreeState::replaceState (const ValueTree& newState)
         undoManager->clearUndoHistory();
 }
 
+void AudioProcessorValueTreeState::replaceStateKeepingTreeIfPossible (const ValueTree& newState)
+{
+    // The caller mustn't hold on to newState, because if it only contains new parameter
+    // values they're copied into the existing tree, and later changes to newState won't
+    // affect the processor
+    ScopedLock lock (valueTreeChanging);
+
+    if (! updateParameterValuesFrom (newState))
+        state = newState;
+
+    if (undoManager != nullptr)
+        undoManager->clearUndoHistory();
+}
+
+bool AudioProcessorValueTreeState::isPlainParameterTree (const ValueTree& v) const
+{
+    return v.hasType (valueType)
+            && v.getNumChildren() == 0
+            && v.getNumProperties() == 2
+            && v.hasProperty (idPropertyID)
+            && v.hasProperty (valuePropertyID);
+}
+
+bool AudioProcessorValueTreeState::updateParameterValuesFrom (const ValueTree& newState)
+{
+    if (state == newState)
+        return true;
+
+    if (! state.isValid()
+         || ! newState.hasType (state.getType())
+         || newState.getNumChildren() != state.getNumChildren()
+         || newState.getNumProperties() != state.getNumProperties())
+        return false;
+
+    for (int i = 0; i < state.getNumProperties(); ++i)
+    {
+        auto name = state.getPropertyName (i);
+
+        if (! newState.hasProperty (name) || newState[name] != state[name])
+            return false;
+    }
+
+    // make sure the tree holds the current parameter values before comparing them
+    flushParameterValuesToValueTree();
+
+    Array<int> changedParameters;
+
+    for (int i = 0; i < state.getNumChildren(); ++i)
+    {
+        auto current  = state.getChild (i);
+        auto incoming = newState.getChild (i);
+
+        if (isPlainParameterTree (current) && isPlainParameterTree (incoming)
+             && current[idPropertyID] == incoming[idPropertyID])
+        {
+            if (current[valuePropertyID] != incoming[valuePropertyID])
+                changedParameters.add (i);
+        }
+        else if (! current.isEquivalentTo (incoming))
+        {
+            return false;
+        }
+    }
+
+    // setting the property will update the parameter via valueTreePropertyChanged()
+    for (auto i : changedParameters)
+        state.getChild (i).setProperty (valuePropertyID, newState.getChild (i)[valuePropertyID], nullptr);
+
+    return true;
+}
+
+//==============================================================================
+// Identifies data written by copyStateToBinary(), and the version of its layout.
+static constexpr int binaryStateMagicNumber = 0x42565041; // "APVB"
+static constexpr int binaryStateVersion = 1;
+
+void AudioProcessorValueTreeState::copyStateToBinary (MemoryBlock& destData)
+{
+    ScopedLock lock (valueTreeChanging);
+    flushParameterValuesToValueTree();
+
+    // The parameters are written as a table of IDs and values, and everything
+    // else goes into a separate tree, along with its position in the original.
+    ValueTree remainder (state.getType());
+    remainder.copyPropertiesFrom (state, nullptr);
+
+    Array<int> parameterIndexes;
+
+    for (int i = 0; i < state.getNumChildren(); ++i)
+    {
+        auto child = state.getChild (i);
+
+        if (isPlainParameterTree (child))
+            parameterIndexes.add (i);
+        else
+            remainder.appendChild (child.createCopy(), nullptr);
+    }
+
+    MemoryOutputStream out (destData, false);
+    out.writeInt (binaryStateMagicNumber);
+    out.writeInt (binaryStateVersion);
+    out.writeCompressedInt (parameterIndexes.size());
+
+    for (auto i : parameterIndexes)
+    {
+        auto child = state.getChild (i);
+        out.writeCompressedInt (i);
+        out.writeString (child[idPropertyID].toString());
+        out.writeFloat ((float) child[valuePropertyID]);
+    }
+
+    remainder.writeToStream (out);
+}
+
+bool AudioProcessorValueTreeState::replaceStateFromBinary (const void* data, int sizeInBytes)
+{
+    if (data == nullptr || sizeInBytes < 8)
+        return false;
+
+    MemoryInputStream in (data, (size_t) sizeInBytes, false);
+
+    if (in.readInt() != binaryStateMagicNumber)
+    {
+        if (auto xml = AudioProcessor::getXmlFromBinary (data, sizeInBytes))
+        {
+            auto newState = ValueTree::fromXml (*xml);
+
+            if (newState.isValid())
+            {
+                replaceStateKeepingTreeIfPossible (newState);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // data from a newer version can't be read
+    if (in.readInt() > binaryStateVersion)
+        return false;
+
+    struct StoredParameter
+    {
+        int index;
+        String id;
+        float value;
+    };
+
+    auto numParameters = in.readCompressedInt();
+
+    if (numParameters < 0 || numParameters > in.getNumBytesRemaining())
+        return false;
+
+    std::vector<StoredParameter> parameters;
+    parameters.reserve ((size_t) numParameters);
+
+    for (int i = 0; i < numParameters; ++i)
+    {
+        auto index = in.readCompressedInt();
+        auto id = in.readString();
+        auto value = in.readFloat();
+        parameters.push_back ({ index, id, value });
+    }
+
+    if (in.isExhausted())
+        return false;
+
+    auto newState = ValueTree::readFromStream (in);
+
+    if (! newState.isValid())
+        return false;
+
+    for (auto& p : parameters)
+    {
+        ValueTree child (valueType);
+        child.setProperty (idPropertyID, p.id, nullptr);
+        child.setProperty (valuePropertyID, p.value, nullptr);
+        newState.addChild (child, p.index, nullptr);
+    }
+
+    replaceStateKeepingTreeIfPossible (newState);
+    return true;
+}
+
 void AudioProcessorValueTreeState::setNewState (ValueTree vt)
 {
     jassert (vt.getParent() == state);
@@ -440,6 +650,9 @@ void AudioProcessorValueTreeState::updateParameterConnectionsToChildTrees()
             adapter.tree.setProperty (idPropertyID, adapter.getParameter().paramID, nullptr);
             state.appendChild (adapter.tree, nullptr);
         }
+
+        // the new trees all need to be given their parameter's current value
+        adapter.markNeedsUpdate();
     }
 
     flushParameterValuesToValueTree();
@@ -467,20 +680,48 @@ bool AudioProcessorValueTreeState::flushParameterValuesToValueTree()
 {
     ScopedLock lock (valueTreeChanging);
 
+    // Take all the parameters that have changed since the last flush in one go. They
+    // come off the list in the reverse of the order in which they changed, so it gets
+    // turned around before their values are copied to the tree.
+    ParameterAdapter* reversed = nullptr;
+
+    for (auto* adapter = dirtyAdapters.exchange (nullptr); adapter != nullptr;)
+    {
+        auto* next = adapter->nextDirty;
+        adapter->nextDirty = reversed;
+        reversed = adapter;
+        adapter = next;
+    }
+
     bool anyUpdated = false;
 
-    for (auto& p : adapterTable)
-        anyUpdated |= p.second->flushToTree (valuePropertyID, undoManager);
+    while (reversed != nullptr)
+    {
+        // (an adapter can be pushed onto the list again as soon as it has been
+        // flushed, so its next pointer must be read before that happens)
+        auto* next = reversed->nextDirty;
+        anyUpdated |= reversed->flushToTree (valuePropertyID, undoManager);
+        reversed = next;
+    }
 
     return anyUpdated;
 }
 
+void AudioProcessorValueTreeState::setParameterFlushRate (int activeRateHz, int idleIntervalMs)
+{
+    jassert (activeRateHz > 0 && idleIntervalMs > 0);
+
+    activeFlushIntervalMs = 1000 / jlimit (1, 1000, activeRateHz);
+    idleFlushIntervalMs = jmax (activeFlushIntervalMs.load(), idleIntervalMs);
+}
+
 void AudioProcessorValueTreeState::timerCallback()
 {
     auto anythingUpdated = flushParameterValuesToValueTree();
+    auto activeInterval = activeFlushIntervalMs.load();
 
-    startTimer (anythingUpdated ? 1000 / 50
-                                : jlimit (50, 500, getTimerInterval() + 20));
+    startTimer (anythingUpdated ? activeInterval
+                                : jlimit (activeInterval, idleFlushIntervalMs.load(), getTimerInterval() + 20));
 }
 
 //==============================================================================
@@ -951,6 +1192,188 @@ public:
             expectEquals (listener.value, newValue);
             expectEquals (listener.id, String (key));
         }
+
+        beginTest ("Only parameters that have changed are copied to the state");
+        {
+            TestAudioProcessor proc (createFloatParameters (100));
+
+            struct PropertyCounter  : public ValueTree::Listener
+            {
+                void valueTreePropertyChanged (ValueTree&, const Identifier& property) override
+                {
+                    if (property == Identifier ("value"))
+                        ++numChanges;
+                }
+
+                int numChanges = 0;
+            };
+
+            proc.state.copyState();
+
+            PropertyCounter counter;
+            proc.state.state.addListener (&counter);
+
+            for (auto index : { 3, 50, 97 })
+                proc.getParameters()[index]->setValueNotifyingHost (0.25f);
+
+            auto copy = proc.state.copyState();
+            expectEquals (counter.numChanges, 3);
+
+            for (auto index : { 3, 50, 97 })
+                expectEquals ((float) copy.getChildWithProperty ("id", String (index)).getProperty ("value"), 0.25f);
+
+            proc.state.copyState();
+            expectEquals (counter.numChanges, 3);
+
+            proc.state.state.removeListener (&counter);
+        }
+
+        beginTest ("Parameter changes made on several threads all reach the state");
+        {
+            const int numThreads = 4;
+            const int numParameters = 200;
+            TestAudioProcessor proc (createFloatParameters (numParameters));
+            proc.state.setParameterFlushRate (100, 100);
+
+            struct ChangingThread  : public Thread
+            {
+                ChangingThread (AudioProcessor& p, int seed)
+                    : Thread ("Parameter changer"), processor (p), random (seed) {}
+
+                void run() override
+                {
+                    for (int i = 0; i < 5000; ++i)
+                        processor.getParameters()[random.nextInt (processor.getParameters().size())]->setValueNotifyingHost (random.nextFloat());
+                }
+
+                AudioProcessor& processor;
+                Random random;
+            };
+
+            OwnedArray<ChangingThread> threads;
+
+            for (int t = 0; t < numThreads; ++t)
+            {
+                threads.add (new ChangingThread (proc, t));
+                threads.getLast()->startThread();
+            }
+
+            for (int i = 0; i < 20; ++i)
+                proc.state.copyState();
+
+            for (auto* t : threads)
+                t->stopThread (-1);
+
+            auto copy = proc.state.copyState();
+            int numMismatches = 0;
+
+            for (int i = 0; i < numParameters; ++i)
+                if ((float) copy.getChildWithProperty ("id", String (i)).getProperty ("value")
+                      != proc.state.getRawParameterValue (String (i))->load())
+                    ++numMismatches;
+
+            expectEquals (numMismatches, 0);
+        }
+
+        beginTest ("Binary state can be restored, and is smaller than XML");
+        {
+            const int numParameters = 100;
+            TestAudioProcessor source (createFloatParameters (numParameters));
+            source.state.state.setProperty ("version", 3, nullptr);
+            source.state.state.appendChild (ValueTree ("EXTRA").setProperty ("name", "something", nullptr), nullptr);
+
+            for (int i = 0; i < numParameters; i += 3)
+                source.getParameters()[i]->setValueNotifyingHost ((float) i / (float) numParameters);
+
+            MemoryBlock binary, xml;
+            source.state.copyStateToBinary (binary);
+            AudioProcessor::copyXmlToBinary (*source.state.copyState().createXml(), xml);
+            expect (binary.getSize() * 2 < xml.getSize());
+
+            TestAudioProcessor dest (createFloatParameters (numParameters));
+            dest.state.state.setProperty ("version", 3, nullptr);
+            expect (dest.state.replaceStateFromBinary (binary.getData(), (int) binary.getSize()));
+            expect (dest.state.copyState().isEquivalentTo (source.state.copyState()));
+
+            int numMismatches = 0;
+
+            for (int i = 0; i < numParameters; ++i)
+                if (dest.state.getRawParameterValue (String (i))->load() != source.state.getRawParameterValue (String (i))->load())
+                    ++numMismatches;
+
+            expectEquals (numMismatches, 0);
+
+            TestAudioProcessor legacy (createFloatParameters (numParameters));
+            expect (legacy.state.replaceStateFromBinary (xml.getData(), (int) xml.getSize()));
+            expectWithinAbsoluteError (legacy.state.getRawParameterValue ("33")->load(), 0.33f, 1.0e-6f);
+
+            expect (! legacy.state.replaceStateFromBinary (binary.getData(), 6));
+        }
+
+        beginTest ("Loading a state with new parameter values only updates those parameters");
+        {
+            TestAudioProcessor proc (createFloatParameters (10));
+            auto originalTree = proc.state.state;
+
+            auto newState = proc.state.copyState();
+            newState.getChildWithProperty ("id", "4").setProperty ("value", 0.25f, nullptr);
+
+            auto loadState = [&proc] (const ValueTree& stateToLoad)
+            {
+                MemoryBlock binary;
+                AudioProcessor::copyXmlToBinary (*stateToLoad.createXml(), binary);
+                return proc.state.replaceStateFromBinary (binary.getData(), (int) binary.getSize());
+            };
+
+            struct ChangeCounter  : public ValueTree::Listener
+            {
+                void valueTreePropertyChanged (ValueTree&, const Identifier&) override  { ++numChanges; }
+                void valueTreeRedirected (ValueTree&) override                          { ++numRedirects; }
+                int numChanges = 0, numRedirects = 0;
+            };
+
+            ChangeCounter counter;
+            originalTree.addListener (&counter);
+
+            Listener listener;
+            proc.state.addParameterListener ("4", &listener);
+
+            expect (loadState (newState));
+
+            expect (proc.state.state == originalTree);
+            expectEquals (counter.numChanges, 1);
+            expectEquals (counter.numRedirects, 0);
+            expectEquals (listener.id, String ("4"));
+            expectEquals (proc.state.getRawParameterValue ("4")->load(), 0.25f);
+
+            newState.appendChild (ValueTree ("EXTRA"), nullptr);
+            expect (loadState (newState));
+            expect (proc.state.state != originalTree);
+            expect (proc.state.state.getChildWithName ("EXTRA").isValid());
+
+            proc.state.removeParameterListener ("4", &listener);
+            originalTree.removeListener (&counter);
+        }
+
+        beginTest ("After replaceState(), the state is the tree that was passed in");
+        {
+            TestAudioProcessor proc (createFloatParameters (2));
+
+            auto newState = proc.state.copyState();
+            proc.state.replaceState (newState);
+            expect (proc.state.state == newState);
+        }
+    }
+
+private:
+    static ParameterLayout createFloatParameters (int numParameters)
+    {
+        ParameterLayout layout;
+
+        for (int i = 0; i < numParameters; ++i)
+            layout.add (std::make_unique<AudioParameterFloat> (String (i), String (i), 0.0f, 1.0f, 0.5f));
+
+        return layout;
     }
 };
 
@@ -344,6 +344,46 @@ public:
     */
     void replaceState (const ValueTree& newState);
 
+    /** Writes a copy of the state to a block of binary data.
+
+        This is a more compact and much quicker alternative to converting the result
+        of copyState() to XML and using AudioProcessor::copyXmlToBinary(), so it's a
+        good choice for use in AudioProcessor::getStateInformation(). Each parameter
+        is stored as its ID and a 32-bit float, and the rest of the tree is written
+        with ValueTree::writeToStream().
+
+        The data is versioned, and can be read back with replaceStateFromBinary().
+
+        @see replaceStateFromBinary, copyState
+    */
+    void copyStateToBinary (MemoryBlock& destData);
+
+    /** Replaces the state with one that was stored with copyStateToBinary().
+
+        This will also accept data that was written by AudioProcessor::copyXmlToBinary(),
+        so it can load sessions saved in the older XML format.
+
+        Unlike replaceState(), if the stored state only differs from the current one in
+        the values of its parameters, the current tree is kept and just the parameters
+        whose values have changed are updated. Otherwise the state is replaced by a new
+        tree.
+
+        Returns false, leaving the state unchanged, if the data isn't recognised.
+
+        @see copyStateToBinary, replaceState
+    */
+    bool replaceStateFromBinary (const void* data, int sizeInBytes);
+
+    /** Sets how often changes to the parameters are copied into the state ValueTree.
+
+        Parameter changes are collected as they happen, on whichever thread they're made,
+        and only the parameters that have changed are copied into the tree on the message
+        thread. While changes keep arriving this happens activeRateHz times per second,
+        and when they stop, the checks gradually slow down until they're idleIntervalMs
+        apart. The defaults are 50Hz and 500ms.
+    */
+    void setParameterFlushRate (int activeRateHz, int idleIntervalMs = 500);
+
     //==============================================================================
     /** A reference to the processor with which this state is associated. */
     AudioProcessor& processor;
@@ -533,6 +573,9 @@ private:
     ParameterAdapter* getParameterAdapter (StringRef) const;
 
     bool flushParameterValuesToValueTree();
+    bool updateParameterValuesFrom (const ValueTree&);
+    void replaceStateKeepingTreeIfPossible (const ValueTree&);
+    bool isPlainParameterTree (const ValueTree&) const;
     void setNewState (ValueTree);
     void timerCallback() override;
 
@@ -549,6 +592,8 @@ private:
     };
 
     std::map<StringRef, std::unique_ptr<ParameterAdapter>, StringRefLessThan> adapterTable;
+    std::atomic<ParameterAdapter*> dirtyAdapters { nullptr };
+    std::atomic<int> activeFlushIntervalMs { 1000 / 50 }, idleFlushIntervalMs { 500 };
 
     CriticalSection valueTreeChanging;
 
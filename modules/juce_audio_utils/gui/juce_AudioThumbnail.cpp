@@ -100,6 +100,9 @@ public:
     ~LevelDataSource() override
     {
         owner.cache.getTimeSliceThread().removeTimeSliceClient (this);
+
+        for (auto* job : chunkJobs)
+            workerPool->removeJob (job, true, -1);
     }
 
     enum { timeBeforeDeletingReader = 3000 };
@@ -155,6 +158,7 @@ public:
     {
         const ScopedLock sl (readerLock);
         reader.reset();
+        readBuffer.setSize (0, 0);
     }
 
     int useTimeSlice() override
@@ -174,6 +178,19 @@ public:
 
         bool justFinished = false;
 
+        // a source that can open more than one stream can be scanned by several threads at once
+        if (workerPool == nullptr && source != nullptr)
+            workerPool = owner.cache.getWorkerThreadPool();
+
+        if (workerPool != nullptr)
+        {
+            if (! readChunksInParallel())
+                return 20;
+
+            numSamplesFinished = lengthInSamples;
+            justFinished = true;
+        }
+        else
         {
             const ScopedLock sl (readerLock);
             createReader();
@@ -209,12 +226,149 @@ public:
     int64 hashCode = 0;
 
 private:
+    //==============================================================================
+    struct ChunkJob  : public ThreadPoolJob
+    {
+        ChunkJob (LevelDataSource& s, int firstIndex, int numValues)
+            : ThreadPoolJob ("Thumbnail chunk"), levelSource (s),
+              firstThumbIndex (firstIndex), numThumbSamples (numValues)
+        {
+        }
+
+        JobStatus runJob() override
+        {
+            levelSource.readChunk (*this);
+            return jobHasFinished;
+        }
+
+        LevelDataSource& levelSource;
+        const int firstThumbIndex, numThumbSamples;
+        bool isFinished = false;
+    };
+
+    enum { thumbSamplesPerBlock = 256, thumbSamplesPerChunk = 16 * thumbSamplesPerBlock };
+
     AudioThumbnail& owner;
     std::unique_ptr<InputSource> source;
     std::unique_ptr<AudioFormatReader> reader;
+    AudioBuffer<float> readBuffer;
     CriticalSection readerLock;
     std::atomic<uint32> lastReaderUseTime { 0 };
 
+    std::shared_ptr<ThreadPool> workerPool;
+    OwnedArray<ChunkJob> chunkJobs;
+    CriticalSection chunkLock;
+    int numChunksFinishedInOrder = 0;
+    std::atomic<int> numChunksFinished { 0 };
+
+    //==============================================================================
+    /*  Reads a run of the source in one go and finds the level of each thumbnail
+        sample with a vectorised search, which is much quicker than making a separate
+        readMaxLevels() call for each one.
+    */
+    static void readLevels (AudioFormatReader& r, AudioBuffer<float>& buffer, int samplesPerThumbSample,
+                            int firstThumbIndex, int numThumbSamps, MinMaxValue* const* levels)
+    {
+        auto numChans = (int) r.numChannels;
+        auto startSample = firstThumbIndex * (int64) samplesPerThumbSample;
+        auto numSamples = (int) jlimit ((int64) 0, numThumbSamps * (int64) samplesPerThumbSample,
+                                        r.lengthInSamples - startSample);
+
+        buffer.setSize (numChans, jmax (1, numSamples), false, false, true);
+
+        if (numSamples > 0)
+            r.read (&buffer, 0, numSamples, startSample, true, true);
+
+        for (int chan = 0; chan < numChans; ++chan)
+        {
+            auto* sourceData = buffer.getReadPointer (chan);
+
+            for (int i = 0; i < numThumbSamps; ++i)
+            {
+                auto start = i * samplesPerThumbSample;
+                auto num = jmin (samplesPerThumbSample, numSamples - start);
+
+                levels[chan][i].setFloat (num > 0 ? FloatVectorOperations::findMinAndMax (sourceData + start, num)
+                                                  : Range<float>());
+            }
+        }
+    }
+
+    /*  Splits the source into chunks which are scanned by the cache's worker threads,
+        each with its own reader. Returns true once they've all finished.
+    */
+    bool readChunksInParallel()
+    {
+        if (chunkJobs.isEmpty())
+        {
+            auto numThumbSamples = sampleToThumbSample (lengthInSamples);
+
+            {
+                const ScopedLock sl (chunkLock);
+
+                for (int i = sampleToThumbSample (numSamplesFinished); i < numThumbSamples; i += thumbSamplesPerChunk)
+                    chunkJobs.add (new ChunkJob (*this, i, jmin ((int) thumbSamplesPerChunk, numThumbSamples - i)));
+            }
+
+            for (auto* job : chunkJobs)
+                workerPool->addJob (job, false);
+        }
+
+        return numChunksFinished == chunkJobs.size();
+    }
+
+    void readChunk (ChunkJob& job)
+    {
+        std::unique_ptr<AudioFormatReader> chunkReader;
+
+        if (auto* audioFileStream = source->createInputStream())
+            chunkReader.reset (owner.formatManagerToUse.createReaderFor (std::unique_ptr<InputStream> (audioFileStream)));
+
+        if (chunkReader != nullptr)
+        {
+            AudioBuffer<float> buffer;
+            HeapBlock<MinMaxValue> levelData ((size_t) thumbSamplesPerBlock * numChannels);
+            HeapBlock<MinMaxValue*> levels (numChannels);
+
+            for (int i = 0; i < (int) numChannels; ++i)
+                levels[i] = levelData + i * thumbSamplesPerBlock;
+
+            for (int done = 0; done < job.numThumbSamples; done += thumbSamplesPerBlock)
+            {
+                if (job.shouldExit())
+                    return;
+
+                auto numToDo = jmin ((int) thumbSamplesPerBlock, job.numThumbSamples - done);
+                readLevels (*chunkReader, buffer, owner.samplesPerThumbSample, job.firstThumbIndex + done, numToDo, levels);
+                owner.setLevels (levels, job.firstThumbIndex + done, (int) numChannels, numToDo);
+            }
+        }
+
+        // the chunks can finish in any order, but the thumbnail's finished position
+        // can only move on past the ones that are complete
+        int64 finishedUpTo;
+
+        {
+            const ScopedLock sl (chunkLock);
+            job.isFinished = true;
+
+            while (numChunksFinishedInOrder < chunkJobs.size() && chunkJobs.getUnchecked (numChunksFinishedInOrder)->isFinished)
+                ++numChunksFinishedInOrder;
+
+            finishedUpTo = numChunksFinishedInOrder < chunkJobs.size()
+                               ? chunkJobs.getUnchecked (numChunksFinishedInOrder)->firstThumbIndex * (int64) owner.samplesPerThumbSample
+                               : lengthInSamples;
+        }
+
+        {
+            const ScopedLock sl (owner.lock);
+            owner.numSamplesFinished = jmax (owner.numSamplesFinished, finishedUpTo);
+        }
+
+        ++numChunksFinished;
+        owner.sendChangeMessage();
+    }
+
     void createReader()
     {
         if (reader == nullptr && source != nullptr)
@@ -228,7 +382,7 @@ private:
 
         if (! isFullyLoaded())
         {
-            auto numToDo = (int) jmin (256 * (int64) owner.samplesPerThumbSample, lengthInSamples - numSamplesFinished);
+            auto numToDo = (int) jmin (thumbSamplesPerBlock * (int64) owner.samplesPerThumbSample, lengthInSamples - numSamplesFinished);
 
             if (numToDo > 0)
             {
@@ -244,16 +398,7 @@ private:
                 for (int i = 0; i < (int) numChannels; ++i)
                     levels[i] = levelData + i * numThumbSamps;
 
-                HeapBlock<Range<float>> levelsRead (numChannels);
-
-                for (int i = 0; i < numThumbSamps; ++i)
-                {
-                    reader->readMaxLevels ((firstThumbIndex + i) * owner.samplesPerThumbSample,
-                                           owner.samplesPerThumbSample, levelsRead, (int) numChannels);
-
-                    for (int j = 0; j < (int) numChannels; ++j)
-                        levels[j][i].setFloat (levelsRead[j]);
-                }
+                readLevels (*reader, readBuffer, owner.samplesPerThumbSample, firstThumbIndex, numThumbSamps, levels);
 
                 {
                     const ScopedUnlock su (readerLock);
@@ -300,12 +445,26 @@ public:
 
             while (startSample <= endSample)
             {
-                auto& v = data.getReference (startSample);
+                // use the coarsest level whose values lie entirely within the range
+                int level = 0;
+
+                while (level < mipLevels.size())
+                {
+                    auto nextSize = 1 << (levelBits * (level + 1));
+
+                    if ((startSample & (nextSize - 1)) != 0 || startSample + nextSize - 1 > endSample)
+                        break;
+
+                    ++level;
+                }
+
+                auto& v = level == 0 ? data.getReference (startSample)
+                                     : mipLevels.getReference (level - 1).getReference (startSample >> (levelBits * level));
 
                 if (v.getMinValue() < mn)  mn = v.getMinValue();
                 if (v.getMaxValue() > mx)  mx = v.getMaxValue();
 
-                ++startSample;
+                startSample += 1 << (levelBits * level);
             }
 
             if (mn <= mx)
@@ -329,6 +488,43 @@ public:
 
         for (int i = 0; i < numValues; ++i)
             dest[i] = values[i];
+
+        updateLevels (startIndex, numValues);
+    }
+
+    /** Recalculates the lower-resolution levels that cover a range of values. */
+    void updateLevels (int startIndex, int numValues)
+    {
+        resetPeak();
+
+        for (int level = 0; level < mipLevels.size() && numValues > 0; ++level)
+        {
+            auto& source = level == 0 ? data : mipLevels.getReference (level - 1);
+            auto& dest = mipLevels.getReference (level);
+
+            auto first = startIndex >> levelBits;
+            auto last  = (startIndex + numValues - 1) >> levelBits;
+
+            for (int i = first; i <= last; ++i)
+            {
+                auto start = i << levelBits;
+                auto end = jmin (start + (1 << levelBits), source.size());
+
+                int8 mn = 127, mx = -128;
+
+                for (int j = start; j < end; ++j)
+                {
+                    auto& v = source.getReference (j);
+                    mn = jmin (mn, v.getMinValue());
+                    mx = jmax (mx, v.getMaxValue());
+                }
+
+                dest.getReference (i).set (mn, mx);
+            }
+
+            startIndex = first;
+            numValues = last - first + 1;
+        }
     }
 
     void resetPeak() noexcept
@@ -340,7 +536,7 @@ public:
     {
         if (peakLevel < 0)
         {
-            for (auto& s : data)
+            for (auto& s : mipLevels.isEmpty() ? data : mipLevels.getReference (mipLevels.size() - 1))
             {
                 auto peak = s.getPeak();
 
@@ -353,15 +549,37 @@ public:
     }
 
 private:
+    // Each level holds the combined range of 16 values from the level below it, so
+    // that finding the range of a long stretch of the thumbnail only has to look at
+    // a few values, however far the view is zoomed out.
+    enum { levelBits = 4 };
+
     Array<MinMaxValue> data;
+    Array<Array<MinMaxValue>> mipLevels;
     int peakLevel = -1;
 
     void ensureSize (int thumbSamples)
     {
-        auto extraNeeded = thumbSamples - data.size();
+        auto oldSize = data.size();
+        auto extraNeeded = thumbSamples - oldSize;
 
         if (extraNeeded > 0)
+        {
             data.insertMultiple (-1, MinMaxValue(), extraNeeded);
+
+            for (int level = 0, size = data.size(); size > (1 << levelBits); ++level)
+            {
+                size = (size + (1 << levelBits) - 1) >> levelBits;
+
+                if (level == mipLevels.size())
+                    mipLevels.add ({});
+
+                auto& values = mipLevels.getReference (level);
+                values.insertMultiple (-1, MinMaxValue(), size - values.size());
+            }
+
+            updateLevels (jmax (0, oldSize - 1), data.size() - jmax (0, oldSize - 1));
+        }
     }
 };
 
@@ -614,6 +832,9 @@ bool AudioThumbnail::loadFrom (InputStream& rawInput)
         for (int chan = 0; chan < numChannels; ++chan)
             channels.getUnchecked(chan)->getData(i)->read (input);
 
+    for (auto* c : channels)
+        c->updateLevels (0, numThumbnailSamples);
+
     return true;
 }
 
@@ -823,4 +1044,146 @@ void AudioThumbnail::drawChannels (Graphics& g, const Rectangle<int>& area, doub
     }
 }
 
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+struct AudioThumbnailTests  : public UnitTest
+{
+    AudioThumbnailTests()  : UnitTest ("AudioThumbnail", UnitTestCategories::audio) {}
+
+    struct ScopedTestDirectory
+    {
+        ~ScopedTestDirectory()  { directory.deleteRecursively(); }
+
+        const File directory { File::getSpecialLocation (File::tempDirectory).getNonexistentChildFile ("AudioThumbnailTest", {}) };
+    };
+
+    static bool waitUntilLoaded (AudioThumbnail& thumb)
+    {
+        for (int i = 0; i < 2000 && ! thumb.isFullyLoaded(); ++i)
+            Thread::sleep (5);
+
+        return thumb.isFullyLoaded();
+    }
+
+    static MemoryBlock getThumbData (const AudioThumbnail& thumb)
+    {
+        MemoryOutputStream out;
+        thumb.saveTo (out);
+        return out.getMemoryBlock();
+    }
+
+    void runTest() override
+    {
+        const int samplesPerThumbSample = 16, numChannels = 2;
+        const double sampleRate = 44100.0;
+        const int numSamples = (int) sampleRate * 20;
+
+        ScopedTestDirectory tempDir;
+        auto dir = tempDir.directory;
+        dir.createDirectory();
+        auto audioFile = dir.getChildFile ("test.wav");
+
+        {
+            AudioBuffer<float> buffer (numChannels, numSamples);
+            Random r (1234);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int i = 0; i < numSamples; ++i)
+                    buffer.setSample (ch, i, (r.nextFloat() * 2.0f - 1.0f) * (float) ((i / 10000 + ch) % 7) / 7.0f);
+
+            WavAudioFormat wav;
+            std::unique_ptr<AudioFormatWriter> writer (wav.createWriterFor (audioFile.createOutputStream().release(),
+                                                                            sampleRate, (unsigned int) numChannels, 16, {}, 0));
+            expect (writer != nullptr);
+            writer->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+        }
+
+        AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        AudioThumbnailCache sequentialCache (4);
+        AudioThumbnail sequentialThumb (samplesPerThumbSample, formatManager, sequentialCache);
+        sequentialThumb.setSource (new FileInputSource (audioFile));
+        expect (waitUntilLoaded (sequentialThumb));
+
+        auto sequentialData = getThumbData (sequentialThumb);
+
+        beginTest ("Parallel generation matches sequential generation");
+        {
+            AudioThumbnailCache cache (4);
+            cache.setNumWorkerThreads (4);
+            expectEquals (cache.getNumWorkerThreads(), 4);
+
+            AudioThumbnail thumb (samplesPerThumbSample, formatManager, cache);
+            thumb.setSource (new FileInputSource (audioFile));
+            expect (waitUntilLoaded (thumb));
+            expect (getThumbData (thumb) == sequentialData);
+        }
+
+        beginTest ("Level lookups match a linear scan");
+        {
+            auto* raw = static_cast<const int8*> (sequentialData.getData()) + 52;
+            auto numThumbSamples = (int) ((sequentialData.getSize() - 52) / (size_t) (2 * numChannels));
+            Random r (4321);
+
+            for (int i = 0; i < 500; ++i)
+            {
+                auto startTime = r.nextDouble() * 20.0;
+                auto endTime = startTime + r.nextDouble() * (20.0 - startTime);
+                auto channel = r.nextInt (numChannels);
+
+                auto first = (int) ((startTime * sampleRate) / samplesPerThumbSample);
+                auto last = jmin (numThumbSamples - 1, (int) (((endTime * sampleRate) + samplesPerThumbSample - 1) / samplesPerThumbSample));
+
+                int mn = 127, mx = -128;
+
+                for (int j = first; j <= last; ++j)
+                {
+                    mn = jmin (mn, (int) raw[(j * numChannels + channel) * 2]);
+                    mx = jmax (mx, (int) raw[(j * numChannels + channel) * 2 + 1]);
+                }
+
+                float minValue, maxValue;
+                sequentialThumb.getApproximateMinMax (startTime, endTime, channel, minValue, maxValue);
+
+                expectEquals (minValue, (float) mn / 128.0f);
+                expectEquals (maxValue, (float) mx / 128.0f);
+            }
+        }
+
+        beginTest ("Thumbnails are re-loaded from the cache directory");
+        {
+            auto cacheDir = dir.getChildFile ("cache");
+
+            {
+                AudioThumbnailCache cache (4);
+                cache.setCacheDirectory (cacheDir);
+                cache.setNumWorkerThreads (2);
+
+                AudioThumbnail thumb (samplesPerThumbSample, formatManager, cache);
+                thumb.setSource (new FileInputSource (audioFile, true));
+                expect (waitUntilLoaded (thumb));
+
+                for (int i = 0; i < 2000 && cacheDir.getNumberOfChildFiles (File::findFiles) == 0; ++i)
+                    Thread::sleep (5);
+            }
+
+            expectEquals (cacheDir.getNumberOfChildFiles (File::findFiles), 1);
+
+            AudioThumbnailCache cache (4);
+            cache.setCacheDirectory (cacheDir);
+
+            AudioThumbnail thumb (samplesPerThumbSample, formatManager, cache);
+            thumb.setSource (new FileInputSource (audioFile, true));
+            expect (thumb.isFullyLoaded());
+            expect (getThumbData (thumb) == sequentialData);
+        }
+    }
+};
+
+static AudioThumbnailTests audioThumbnailTests;
+
+#endif
+
 } // namespace juce
@@ -99,6 +99,26 @@ int AudioThumbnailCache::findOldestThumb() const
     return oldest;
 }
 
+AudioThumbnailCache::ThumbnailCacheEntry* AudioThumbnailCache::addEntryFor (const int64 hash)
+{
+    auto* te = new ThumbnailCacheEntry (hash);
+
+    if (thumbs.size() < maxNumThumbsToStore)
+        thumbs.add (te);
+    else
+        thumbs.set (findOldestThumb(), te);
+
+    return te;
+}
+
+File AudioThumbnailCache::getFileForThumb (const int64 hash) const
+{
+    if (cacheDirectory == File())
+        return {};
+
+    return cacheDirectory.getChildFile (String::toHexString (hash) + ".thumb");
+}
+
 bool AudioThumbnailCache::loadThumb (AudioThumbnailBase& thumb, const int64 hashCode)
 {
     const ScopedLock sl (lock);
@@ -112,6 +132,24 @@ bool AudioThumbnailCache::loadThumb (AudioThumbnailBase& thumb, const int64 hash
         return true;
     }
 
+    auto file = getFileForThumb (hashCode);
+
+    if (file.existsAsFile())
+    {
+        MemoryBlock data;
+
+        if (file.loadFileAsData (data))
+        {
+            MemoryInputStream in (data, false);
+
+            if (thumb.loadFrom (in))
+            {
+                addEntryFor (hashCode)->data = std::move (data);
+                return true;
+            }
+        }
+    }
+
     return loadNewThumb (thumb, hashCode);
 }
 
@@ -122,23 +160,69 @@ void AudioThumbnailCache::storeThumb (const AudioThumbnailBase& thumb,
     ThumbnailCacheEntry* te = findThumbFor (hashCode);
 
     if (te == nullptr)
-    {
-        te = new ThumbnailCacheEntry (hashCode);
-
-        if (thumbs.size() < maxNumThumbsToStore)
-            thumbs.add (te);
-        else
-            thumbs.set (findOldestThumb(), te);
-    }
+        te = addEntryFor (hashCode);
 
     {
         MemoryOutputStream out (te->data, false);
         thumb.saveTo (out);
     }
 
+    auto file = getFileForThumb (hashCode);
+
+    if (file != File() && thumb.isFullyLoaded())
+    {
+        TemporaryFile temp (file);
+
+        if (temp.getFile().replaceWithData (te->data.getData(), te->data.getSize()))
+            temp.overwriteTargetFileWithTemporary();
+    }
+
     saveNewlyFinishedThumbnail (thumb, hashCode);
 }
 
+//==============================================================================
+void AudioThumbnailCache::setCacheDirectory (const File& directory)
+{
+    const ScopedLock sl (lock);
+    cacheDirectory = directory;
+
+    if (cacheDirectory != File())
+        cacheDirectory.createDirectory();
+}
+
+File AudioThumbnailCache::getCacheDirectory() const
+{
+    const ScopedLock sl (lock);
+    return cacheDirectory;
+}
+
+void AudioThumbnailCache::setNumWorkerThreads (int numThreads)
+{
+    const ScopedLock sl (lock);
+
+    numThreads = jmax (0, numThreads);
+
+    if (numThreads != numWorkerThreads)
+    {
+        numWorkerThreads = numThreads;
+
+        // thumbnails that are still using the old pool keep it alive until they're done
+        workerPool = numThreads > 0 ? std::make_shared<ThreadPool> (numThreads) : nullptr;
+    }
+}
+
+int AudioThumbnailCache::getNumWorkerThreads() const noexcept
+{
+    return numWorkerThreads;
+}
+
+std::shared_ptr<ThreadPool> AudioThumbnailCache::getWorkerThreadPool() const
+{
+    const ScopedLock sl (lock);
+    return workerPool;
+}
+
+//==============================================================================
 void AudioThumbnailCache::clear()
 {
     const ScopedLock sl (lock);
@@ -89,6 +89,40 @@ public:
     /** Returns the thread that client thumbnails can use. */
     TimeSliceThread& getTimeSliceThread() noexcept      { return thread; }
 
+    //==============================================================================
+    /** Sets a directory in which finished thumbnails will be saved, so that they can
+        be re-loaded quickly the next time they're needed, even by a different session.
+
+        Each thumbnail is stored in its own file, named after its hash code, so if your
+        sources can change, make sure their hash codes change with them (e.g. by creating
+        a FileInputSource with useFileTimeInHashGeneration set to true).
+
+        Pass File() to stop using a directory, which is the default.
+    */
+    void setCacheDirectory (const File& directory);
+
+    /** Returns the directory set with setCacheDirectory(). */
+    File getCacheDirectory() const;
+
+    //==============================================================================
+    /** Sets the number of threads that thumbnails can use to scan their sources.
+
+        By default this is 0, and each thumbnail reads its source sequentially on the
+        cache's TimeSliceThread. With some worker threads, thumbnails created with
+        AudioThumbnail::setSource() will split their source into chunks that are scanned
+        in parallel, each with its own reader. Thumbnails that were given an
+        AudioFormatReader with AudioThumbnail::setReader() are always read sequentially.
+    */
+    void setNumWorkerThreads (int numThreads);
+
+    /** Returns the number of worker threads set with setNumWorkerThreads(). */
+    int getNumWorkerThreads() const noexcept;
+
+    /** Returns the pool of worker threads that thumbnails can use, or nullptr if
+        there aren't any.
+    */
+    std::shared_ptr<ThreadPool> getWorkerThreadPool() const;
+
 protected:
     /** This can be overridden to provide a custom callback for saving thumbnails
         once they have finished being loaded.
@@ -108,9 +142,14 @@ private:
     OwnedArray<ThumbnailCacheEntry> thumbs;
     CriticalSection lock;
     int maxNumThumbsToStore;
+    File cacheDirectory;
+    std::shared_ptr<ThreadPool> workerPool;
+    int numWorkerThreads = 0;
 
     ThumbnailCacheEntry* findThumbFor (int64 hash) const;
+    ThumbnailCacheEntry* addEntryFor (int64 hash);
     int findOldestThumb() const;
+    File getFileForThumb (int64 hash) const;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioThumbnailCache)
 };
@@ -26,14 +26,113 @@
 namespace juce
 {
 
+//==============================================================================
+/*  Releases processors that the audio thread has finished with, so that the audio
+    thread never has to call releaseResources() itself.
+*/
+struct AudioProcessorPlayer::ProcessorRetirer  : private Thread
+{
+    explicit ProcessorRetirer (AudioProcessorPlayer& p)  : Thread ("Processor retirer"), owner (p)
+    {
+    }
+
+    ~ProcessorRetirer() override
+    {
+        // The retired callback might be deleting a processor, which can take a while, so
+        // this waits for it rather than risking the thread being killed part-way through
+        signalThreadShouldExit();
+        notify();
+        waitForThreadToExit (-1);
+
+        releaseRetiredProcessors();
+    }
+
+    // the thread is only started once it's needed, so players that never retire
+    // processors don't have one
+    void start()
+    {
+        startThread();
+    }
+
+    bool push (AudioProcessor* processorToRetire) noexcept
+    {
+        const SpinLock::ScopedLockType sl (pushLock);
+        const auto scope = fifo.write (1);
+
+        if (scope.blockSize1 + scope.blockSize2 == 0)
+            return false;
+
+        retired[scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2] = processorToRetire;
+        return true;
+    }
+
+    void setCallback (std::function<void (AudioProcessor*)> callback)
+    {
+        const ScopedLock sl (callbackLock);
+        onRetired = std::move (callback);
+    }
+
+private:
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            releaseRetiredProcessors();
+            wait (10);
+        }
+    }
+
+    void releaseRetiredProcessors()
+    {
+        while (fifo.getNumReady() > 0)
+        {
+            AudioProcessor* p;
+
+            {
+                const auto scope = fifo.read (1);
+                p = retired[scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2];
+            }
+
+            p->releaseResources();
+            owner.processorReleased (p);
+
+            std::function<void (AudioProcessor*)> callback;
+
+            {
+                const ScopedLock sl (callbackLock);
+                callback = onRetired;
+            }
+
+            if (callback != nullptr)
+                callback (p);
+        }
+    }
+
+    enum { capacity = 128 };
+
+    AudioProcessorPlayer& owner;
+    AbstractFifo fifo { capacity };
+    AudioProcessor* retired[capacity] = {};
+    SpinLock pushLock;
+    CriticalSection callbackLock;
+    std::function<void (AudioProcessor*)> onRetired;
+
+    JUCE_DECLARE_NON_COPYABLE (ProcessorRetirer)
+};
+
+//==============================================================================
 AudioProcessorPlayer::AudioProcessorPlayer (bool doDoublePrecisionProcessing)
-    : isDoublePrecision (doDoublePrecisionProcessing)
+    : retirer (new ProcessorRetirer (*this)),
+      isDoublePrecision (doDoublePrecisionProcessing)
 {
 }
 
 AudioProcessorPlayer::~AudioProcessorPlayer()
 {
     setProcessor (nullptr);
+
+    // this waits for any processors that are being retired to be released
+    retirer.reset();
 }
 
 //==============================================================================
@@ -41,6 +140,18 @@ void AudioProcessorPlayer::setProcessor (AudioProcessor* const processorToPlay)
 {
     if (processor != processorToPlay)
     {
+        if (processorToPlay != nullptr)
+        {
+            // If the processor is fading out, waiting to be swapped in or waiting to be
+            // released, it has to be released before it can be prepared again
+            {
+                const ScopedLock sl (lock);
+                retireProcessorsBeingReplaced();
+            }
+
+            waitUntilReleased (processorToPlay);
+        }
+
         if (processorToPlay != nullptr && sampleRate > 0 && blockSize > 0)
         {
             processorToPlay->setPlayConfigDetails (numInputChans, numOutputChans, sampleRate, blockSize);
@@ -52,17 +163,215 @@ void AudioProcessorPlayer::setProcessor (AudioProcessor* const processorToPlay)
             processorToPlay->prepareToPlay (sampleRate, blockSize);
         }
 
-        AudioProcessor* oldOne;
+        AudioProcessor* previous;
+        bool wasPrepared;
 
         {
             const ScopedLock sl (lock);
-            oldOne = isPrepared ? processor : nullptr;
-            processor = processorToPlay;
+            retireProcessorsBeingReplaced();
+            previous = processor.exchange (processorToPlay);
+            wasPrepared = isPrepared;
             isPrepared = true;
         }
 
-        if (oldOne != nullptr)
-            oldOne->releaseResources();
+        {
+            const ScopedLock sl (processorsInUseLock);
+            processorsInUse.removeFirstMatchingValue (previous);
+
+            if (processorToPlay != nullptr)
+                processorsInUse.addIfNotAlreadyThere (processorToPlay);
+        }
+
+        if (previous != nullptr && wasPrepared)
+            previous->releaseResources();
+    }
+}
+
+bool AudioProcessorPlayer::setProcessorWithoutBlocking (AudioProcessor* processorToPlay, int crossfadeLengthSamples)
+{
+    double rate;
+    int size, numIns, numOuts;
+    bool useDoublePrecision;
+
+    {
+        const ScopedLock sl (configLock);
+        rate = sampleRate;
+        size = blockSize;
+        numIns = numInputChans;
+        numOuts = numOutputChans;
+        useDoublePrecision = isDoublePrecision;
+    }
+
+    // The audio thread needs a processor to swap in, so to stop playing, use setProcessor (nullptr).
+    // If the device isn't running, there's no audio thread to block.
+    if (processorToPlay == nullptr || rate <= 0 || size <= 0)
+    {
+        setProcessor (processorToPlay);
+        return true;
+    }
+
+    {
+        const ScopedLock sl (processorsInUseLock);
+
+        if (processorsInUse.contains (processorToPlay))
+            return false;
+
+        processorsInUse.add (processorToPlay);
+    }
+
+    retirer->start();
+
+    processorToPlay->setPlayConfigDetails (numIns, numOuts, rate, size);
+    processorToPlay->setProcessingPrecision (processorToPlay->supportsDoublePrecisionProcessing() && useDoublePrecision
+                                                ? AudioProcessor::doublePrecision
+                                                : AudioProcessor::singlePrecision);
+    processorToPlay->prepareToPlay (rate, size);
+
+    pendingCrossfadeLength = jmax (0, crossfadeLengthSamples);
+
+    // if a previous swap hasn't happened yet, the audio thread has never seen that processor
+    if (auto* previous = pendingProcessor.exchange (processorToPlay))
+        retireProcessor (previous);
+
+    return true;
+}
+
+void AudioProcessorPlayer::setProcessorRetiredCallback (std::function<void (AudioProcessor*)> callback)
+{
+    retirer->setCallback (std::move (callback));
+}
+
+void AudioProcessorPlayer::retireProcessor (AudioProcessor* processorToRetire)
+{
+    // A processor that's playing or about to play must never be released! The checks in
+    // setProcessorWithoutBlocking() should make this impossible.
+    if (processorToRetire == processor.load() || processorToRetire == pendingProcessor.load())
+    {
+        jassertfalse;
+        return;
+    }
+
+    // If the push fails, then more than a hundred processors are waiting to be released,
+    // so something has gone badly wrong!
+    if (! retirer->push (processorToRetire))
+        jassertfalse;
+}
+
+void AudioProcessorPlayer::processorReleased (AudioProcessor* releasedProcessor)
+{
+    {
+        const ScopedLock sl (processorsInUseLock);
+        processorsInUse.removeFirstMatchingValue (releasedProcessor);
+    }
+
+    processorReleasedEvent.signal();
+}
+
+void AudioProcessorPlayer::waitUntilReleased (AudioProcessor* processorToWaitFor)
+{
+    for (;;)
+    {
+        {
+            const ScopedLock sl (processorsInUseLock);
+
+            if (! processorsInUse.contains (processorToWaitFor))
+                return;
+        }
+
+        processorReleasedEvent.wait (10);
+    }
+}
+
+void AudioProcessorPlayer::retireProcessorsBeingReplaced()
+{
+    if (auto* pending = pendingProcessor.exchange (nullptr))
+        retireProcessor (pending);
+
+    if (fadingProcessor != nullptr)
+    {
+        retireProcessor (fadingProcessor);
+        fadingProcessor = nullptr;
+    }
+}
+
+void AudioProcessorPlayer::beginPendingSwap()
+{
+    auto* incoming = pendingProcessor.exchange (nullptr);
+
+    if (incoming == nullptr)
+        return;
+
+    auto* outgoing = processor.exchange (incoming);
+
+    // if the last crossfade hasn't finished, the processor that was fading out is dropped
+    if (fadingProcessor != nullptr)
+        retireProcessor (fadingProcessor);
+
+    crossfadeLength = pendingCrossfadeLength;
+    crossfadePosition = 0;
+    fadingProcessor = crossfadeLength > 0 ? outgoing : nullptr;
+
+    if (outgoing != nullptr && fadingProcessor == nullptr)
+        retireProcessor (outgoing);
+}
+
+void AudioProcessorPlayer::processWith (AudioProcessor& p, AudioBuffer<float>& buffer,
+                                        AudioBuffer<double>& conversion, MidiBuffer& midi)
+{
+    const AudioProcessor::ScopedParameterNotificationQueueing queueing (p);
+
+    if (p.isUsingDoublePrecision())
+    {
+        conversion.makeCopyOf (buffer, true);
+        p.processBlock (conversion, midi);
+        buffer.makeCopyOf (conversion, true);
+    }
+    else
+    {
+        p.processBlock (buffer, midi);
+    }
+}
+
+void AudioProcessorPlayer::processCrossfade (AudioProcessor& incoming, AudioBuffer<float>& buffer)
+{
+    auto numChannels = buffer.getNumChannels();
+    auto numSamples = buffer.getNumSamples();
+
+    // the outgoing processor gets its own copy of the input
+    fadeBuffer.setSize (numChannels, numSamples, false, false, true);
+
+    for (int i = 0; i < numChannels; ++i)
+        fadeBuffer.copyFrom (i, 0, buffer, i, 0, numSamples);
+
+    fadeMidi.clear();
+    fadeMidi.addEvents (incomingMidi, 0, -1, 0);
+
+    processWith (incoming, buffer, conversionBuffer, incomingMidi);
+
+    {
+        auto& outgoing = *fadingProcessor;
+        const ScopedLock sl (outgoing.getCallbackLock());
+
+        if (outgoing.isSuspended())
+            fadeBuffer.clear();
+        else
+            processWith (outgoing, fadeBuffer, fadeConversionBuffer, fadeMidi);
+    }
+
+    auto startGain = (float) crossfadePosition / (float) crossfadeLength;
+    crossfadePosition = jmin (crossfadeLength, crossfadePosition + numSamples);
+    auto endGain = (float) crossfadePosition / (float) crossfadeLength;
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        buffer.applyGainRamp (i, 0, numSamples, startGain, endGain);
+        buffer.addFromWithRamp (i, 0, fadeBuffer.getReadPointer (i), numSamples, 1.0f - startGain, 1.0f - endGain);
+    }
+
+    if (crossfadePosition >= crossfadeLength)
+    {
+        retireProcessor (fadingProcessor);
+        fadingProcessor = nullptr;
     }
 }
 
@@ -72,17 +381,18 @@ void AudioProcessorPlayer::setDoublePrecisionProcessing (bool doublePrecision)
     {
         const ScopedLock sl (lock);
 
-        if (processor != nullptr)
+        if (auto* current = processor.load())
         {
-            processor->releaseResources();
+            current->releaseResources();
 
-            bool supportsDouble = processor->supportsDoublePrecisionProcessing() && doublePrecision;
+            bool supportsDouble = current->supportsDoublePrecisionProcessing() && doublePrecision;
 
-            processor->setProcessingPrecision (supportsDouble ? AudioProcessor::doublePrecision
-                                                              : AudioProcessor::singlePrecision);
-            processor->prepareToPlay (sampleRate, blockSize);
+            current->setProcessingPrecision (supportsDouble ? AudioProcessor::doublePrecision
+                                                            : AudioProcessor::singlePrecision);
+            current->prepareToPlay (sampleRate, blockSize);
         }
 
+        const ScopedLock csl (configLock);
         isDoublePrecision = doublePrecision;
     }
 }
@@ -154,22 +464,19 @@ void AudioProcessorPlayer::audioDeviceIOCallback (const float** const inputChann
     {
         const ScopedLock sl (lock);
 
-        if (processor != nullptr)
+        if (pendingProcessor.load() != nullptr)
+            beginPendingSwap();
+
+        if (auto* current = processor.load())
         {
-            const ScopedLock sl2 (processor->getCallbackLock());
+            const ScopedLock sl2 (current->getCallbackLock());
 
-            if (! processor->isSuspended())
+            if (! current->isSuspended())
             {
-                if (processor->isUsingDoublePrecision())
-                {
-                    conversionBuffer.makeCopyOf (buffer, true);
-                    processor->processBlock (conversionBuffer, incomingMidi);
-                    buffer.makeCopyOf (conversionBuffer, true);
-                }
+                if (fadingProcessor != nullptr)
+                    processCrossfade (*current, buffer);
                 else
-                {
-                    processor->processBlock (buffer, incomingMidi);
-                }
+                    processWith (*current, buffer, conversionBuffer, incomingMidi);
 
                 if (midiOutput != nullptr)
                 {
@@ -203,20 +510,40 @@ void AudioProcessorPlayer::audioDeviceAboutToStart (AudioIODevice* const device)
 
     const ScopedLock sl (lock);
 
-    sampleRate = newSampleRate;
-    blockSize  = newBlockSize;
-    numInputChans  = numChansIn;
-    numOutputChans = numChansOut;
+    {
+        const ScopedLock csl (configLock);
+        sampleRate = newSampleRate;
+        blockSize  = newBlockSize;
+        numInputChans  = numChansIn;
+        numOutputChans = numChansOut;
+    }
 
     messageCollector.reset (sampleRate);
     channels.calloc (jmax (numChansIn, numChansOut) + 2);
 
+    fadeBuffer.setSize (jmax (numChansIn, numChansOut), newBlockSize);
+    fadeConversionBuffer.setSize (jmax (numChansIn, numChansOut), newBlockSize);
+    fadeMidi.ensureSize (2048);
+
+    if (fadingProcessor != nullptr)
+    {
+        retireProcessor (fadingProcessor);
+        fadingProcessor = nullptr;
+    }
+
+    // a processor that was waiting to be swapped in gets prepared again below
+    if (auto* pending = pendingProcessor.exchange (nullptr))
+    {
+        if (auto* current = processor.exchange (pending))
+            retireProcessor (current);
+    }
+
     if (processor != nullptr)
     {
         if (isPrepared)
-            processor->releaseResources();
+            processor.load()->releaseResources();
 
-        auto* oldProcessor = processor;
+        auto* oldProcessor = processor.load();
         setProcessor (nullptr);
         setProcessor (oldProcessor);
     }
@@ -227,10 +554,20 @@ void AudioProcessorPlayer::audioDeviceStopped()
     const ScopedLock sl (lock);
 
     if (processor != nullptr && isPrepared)
-        processor->releaseResources();
+        processor.load()->releaseResources();
+
+    if (fadingProcessor != nullptr)
+    {
+        retireProcessor (fadingProcessor);
+        fadingProcessor = nullptr;
+    }
+
+    {
+        const ScopedLock csl (configLock);
+        sampleRate = 0.0;
+        blockSize = 0;
+    }
 
-    sampleRate = 0.0;
-    blockSize = 0;
     isPrepared = false;
     tempBuffer.setSize (1, 1);
 }
@@ -240,4 +577,153 @@ void AudioProcessorPlayer::handleIncomingMidiMessage (MidiInput*, const MidiMess
     messageCollector.addMessageToQueue (message);
 }
 
+//==============================================================================
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+struct AudioProcessorPlayerTests  : public UnitTest
+{
+    AudioProcessorPlayerTests()
+        : UnitTest ("Audio processor player", UnitTestCategories::audio)
+    {}
+
+    struct ConstantProcessor  : public UnitTestAudioProcessor
+    {
+        ConstantProcessor (float valueToOutput)
+            : value (valueToOutput)
+        {}
+
+        void releaseResources() override    { ++numReleases; }
+
+        void processBlock (AudioBuffer<float>& buffer, MidiBuffer&) override
+        {
+            for (int i = 0; i < buffer.getNumChannels(); ++i)
+                FloatVectorOperations::fill (buffer.getWritePointer (i), value, buffer.getNumSamples());
+        }
+
+        using UnitTestAudioProcessor::processBlock;
+
+        const float value;
+        std::atomic<int> numReleases { 0 };
+    };
+
+    struct DummyDevice  : public AudioIODevice
+    {
+        DummyDevice (double rate, int size)  : AudioIODevice ("Dummy", "Dummy"), sampleRate (rate), bufferSize (size) {}
+
+        StringArray getOutputChannelNames() override            { return { "Left", "Right" }; }
+        StringArray getInputChannelNames() override             { return { "Left", "Right" }; }
+        Array<double> getAvailableSampleRates() override        { return { sampleRate }; }
+        Array<int> getAvailableBufferSizes() override           { return { bufferSize }; }
+        int getDefaultBufferSize() override                     { return bufferSize; }
+        String open (const BigInteger&, const BigInteger&, double, int) override  { return {}; }
+        void close() override                                   {}
+        bool isOpen() override                                  { return true; }
+        void start (AudioIODeviceCallback*) override            {}
+        void stop() override                                    {}
+        bool isPlaying() override                               { return true; }
+        String getLastError() override                          { return {}; }
+        int getCurrentBufferSizeSamples() override              { return bufferSize; }
+        double getCurrentSampleRate() override                  { return sampleRate; }
+        int getCurrentBitDepth() override                       { return 32; }
+        BigInteger getActiveOutputChannels() const override     { return 3; }
+        BigInteger getActiveInputChannels() const override      { return 3; }
+        int getOutputLatencyInSamples() override                { return 0; }
+        int getInputLatencyInSamples() override                 { return 0; }
+
+        const double sampleRate;
+        const int bufferSize;
+    };
+
+    void runTest() override
+    {
+        beginTest ("Non-blocking swap with crossfade");
+
+        constexpr int blockSize = 32;
+
+        ConstantProcessor first (1.0f), second (0.0f);
+        DummyDevice device (44100.0, blockSize);
+        AudioProcessorPlayer player;
+
+        WaitableEvent retired;
+        std::atomic<AudioProcessor*> lastRetired { nullptr };
+
+        player.setProcessorRetiredCallback ([&] (AudioProcessor* p)
+        {
+            lastRetired = p;
+            retired.signal();
+        });
+
+        player.setProcessor (&first);
+        player.audioDeviceAboutToStart (&device);
+
+        AudioBuffer<float> input (2, blockSize), output (2, blockSize);
+        input.clear();
+
+        auto processNextBlock = [&]
+        {
+            player.audioDeviceIOCallback (input.getArrayOfReadPointers(), 2,
+                                          output.getArrayOfWritePointers(), 2, blockSize);
+        };
+
+        processNextBlock();
+        expectEquals (output.getSample (0, blockSize - 1), 1.0f);
+
+        auto numReleasesBeforeSwap = first.numReleases.load();
+        player.setProcessorWithoutBlocking (&second, 2 * blockSize);
+        expect (player.getCurrentProcessor() == &first);
+
+        processNextBlock();
+        expect (player.getCurrentProcessor() == &second);
+        expectEquals (output.getSample (0, 0), 1.0f);
+        expect (output.getSample (1, blockSize - 1) > 0.0f && output.getSample (1, blockSize - 1) < 1.0f);
+
+        processNextBlock();
+        expect (output.getSample (0, blockSize - 1) < output.getSample (0, 0));
+
+        expect (retired.wait (5000));
+        expect (lastRetired.load() == &first);
+        expectEquals (first.numReleases.load(), numReleasesBeforeSwap + 1);
+
+        processNextBlock();
+        expectEquals (output.findMinMax (0, 0, blockSize).getEnd(), 0.0f);
+
+        beginTest ("Swapping back to a processor that's still fading out");
+
+        retired.reset();
+        auto numReleasesBeforeSwapBack = first.numReleases.load();
+
+        expect (player.setProcessorWithoutBlocking (&first, 4 * blockSize));
+        processNextBlock();
+        expect (player.getCurrentProcessor() == &first);
+
+        expect (! player.setProcessorWithoutBlocking (&second));
+        expect (! player.setProcessorWithoutBlocking (&first));
+
+        for (int i = 0; i < 3; ++i)
+            processNextBlock();
+
+        expect (retired.wait (5000));
+        expect (lastRetired.load() == &second);
+        expectEquals (first.numReleases.load(), numReleasesBeforeSwapBack);
+
+        retired.reset();
+        expect (player.setProcessorWithoutBlocking (&second));
+        processNextBlock();
+        expect (player.getCurrentProcessor() == &second);
+        expectEquals (output.getSample (0, blockSize - 1), 0.0f);
+
+        expect (retired.wait (5000));
+        expect (lastRetired.load() == &first);
+        expectEquals (first.numReleases.load(), numReleasesBeforeSwapBack + 1);
+
+        player.audioDeviceStopped();
+        player.setProcessor (nullptr);
+    }
+};
+
+static AudioProcessorPlayerTests audioProcessorPlayerTests;
+
+#endif
+
 } // namespace juce
@@ -60,7 +60,52 @@ public:
     void setProcessor (AudioProcessor* processorToPlay);
 
     /** Returns the current audio processor that is being played. */
-    AudioProcessor* getCurrentProcessor() const noexcept            { return processor; }
+    AudioProcessor* getCurrentProcessor() const noexcept            { return processor.load(); }
+
+    /** Replaces the processor that's being played, without blocking the audio thread.
+
+        The new processor is prepared on the calling thread, and the audio thread swaps
+        it in at the start of its next block. If crossfadeLengthSamples is greater than
+        zero, the old and new processors both run for that many samples while the output
+        fades from one to the other.
+
+        When the audio thread has finished with the old processor, its releaseResources()
+        method is called on a background thread, followed by the function that was set
+        with setProcessorRetiredCallback().
+
+        As with setProcessor(), the processors aren't owned by the player. If the audio
+        device isn't running, the new processor is swapped in straight away.
+
+        A processor can't be prepared again while the player is still using it, so this
+        returns false, and does nothing, if the processor is currently playing, fading out,
+        waiting to be swapped in, or waiting to be released. Once it has been passed to the
+        retired callback, it can be used again.
+
+        @see setProcessor, setProcessorRetiredCallback
+    */
+    bool setProcessorWithoutBlocking (AudioProcessor* processorToPlay, int crossfadeLengthSamples = 0);
+
+    /** Sets a function to call when a processor that was replaced by setProcessorWithoutBlocking()
+        is no longer being used.
+
+        The function is called on a background thread, after the processor's
+        releaseResources() method, and the player won't touch the processor again.
+
+        Most processors, including hosted plugin instances and any processor with a
+        parameter notification queue, have to be deleted on the message thread, so the
+        function shouldn't delete the processor itself. Instead, it can hand the processor
+        over to the message thread, e.g.
+        @code
+        player.setProcessorRetiredCallback ([] (AudioProcessor* p)
+        {
+            MessageManager::callAsync ([p] { delete p; });
+        });
+        @endcode
+
+        The player's destructor waits for this function to return, so the function mustn't
+        block while it waits for the message thread.
+    */
+    void setProcessorRetiredCallback (std::function<void (AudioProcessor*)> callback);
 
     /** Returns a midi message collector that you can pass midi messages to if you
         want them to be injected into the midi stream that is being sent to the
@@ -102,8 +147,28 @@ public:
 
 private:
     //==============================================================================
-    AudioProcessor* processor = nullptr;
-    CriticalSection lock;
+    struct ProcessorRetirer;
+
+    void retireProcessor (AudioProcessor*);
+    void retireProcessorsBeingReplaced();
+    void processorReleased (AudioProcessor*);
+    void waitUntilReleased (AudioProcessor*);
+    void beginPendingSwap();
+    void processWith (AudioProcessor&, AudioBuffer<float>&, AudioBuffer<double>& conversion, MidiBuffer&);
+    void processCrossfade (AudioProcessor& incoming, AudioBuffer<float>&);
+
+    std::atomic<AudioProcessor*> processor { nullptr }, pendingProcessor { nullptr };
+    AudioProcessor* fadingProcessor = nullptr;
+    std::atomic<int> pendingCrossfadeLength { 0 };
+    int crossfadeLength = 0, crossfadePosition = 0;
+    std::unique_ptr<ProcessorRetirer> retirer;
+
+    // the processors that the audio thread or the retirer might still be using
+    Array<AudioProcessor*> processorsInUse;
+    CriticalSection processorsInUseLock;
+    WaitableEvent processorReleasedEvent;
+
+    CriticalSection lock, configLock;
     double sampleRate = 0;
     int blockSize = 0;
     bool isPrepared = false, isDoublePrecision = false;
@@ -111,7 +176,9 @@ private:
     int numInputChans = 0, numOutputChans = 0;
     HeapBlock<float*> channels;
     AudioBuffer<float> tempBuffer;
-    AudioBuffer<double> conversionBuffer;
+    AudioBuffer<double> conversionBuffer, fadeConversionBuffer;
+    AudioBuffer<float> fadeBuffer;
+    MidiBuffer fadeMidi;
 
     MidiBuffer incomingMidi;
     MidiMessageCollector messageCollector;